@@ -82,12 +82,36 @@ static OFBool checkForNonASCIICharacters(DcmItem& dataset)
   return OFFalse;
 }
 
+static OFBool parseTagKey(const char *tagName, DcmTagKey &key)
+{
+    unsigned int group = 0xffff;
+    unsigned int elem = 0xffff;
+    if (sscanf(tagName, "%x,%x", &group, &elem) != 2)
+    {
+        /* it is a name */
+        const DcmDataDictionary& globalDataDict = dcmDataDict.rdlock();
+        const DcmDictEntry *dicent = globalDataDict.findEntry(tagName);
+        if (dicent == NULL)
+        {
+            dcmDataDict.unlock();
+            CERR << "error: unrecognised tag name: '" << tagName << "'" << endl;
+            return OFFalse;
+        }
+        key = dicent->getKey();
+        dcmDataDict.unlock();
+    } else
+        key.set(OFstatic_cast(Uint16, group), OFstatic_cast(Uint16, elem));
+    return OFTrue;
+}
+
+
 static OFCondition writeFile(ostream &out,
                              const char *ifname,
                              const E_FileReadMode readMode,
                              const E_TransferSyntax xfer,
                              const OFBool loadIntoMemory,
                              const Uint32 maxReadLength,
+                             const DcmTagKey &stopParsingAtElement,
                              const char *defaultCharset,
                              const size_t writeFlags)
 {
@@ -101,7 +125,8 @@ static OFCondition writeFile(ostream &out,
 
     /* read DICOM file or data set */
     DcmFileFormat dfile;
-    result = dfile.loadFile(ifname, xfer, EGL_noChange, maxReadLength, readMode);
+    result = dfile.loadFile(ifname, xfer, EGL_noChange, maxReadLength, readMode,
+                            OFFalse /* readSequencesOnDemand */, stopParsingAtElement);
 
     if (result.bad())
     {
@@ -262,6 +287,8 @@ int main(int argc, char *argv[])
     E_FileReadMode opt_readMode = ERM_autoDetect;
     E_TransferSyntax opt_ixfer = EXS_Unknown;
     OFCmdUnsignedInt maxReadLength = 4096; // default is 4 KB
+    DcmTagKey opt_stopParsingAtElement = DCM_UndefinedTagKey;
+    const char *opt_tagName = NULL;
 
     SetDebugLevel(( 0 ));
 
@@ -294,6 +321,11 @@ int main(int argc, char *argv[])
         cmd.addOption("--load-short",          "-M",     "do not load very long values (default)");
         cmd.addOption("--max-read-length",     "+R",  1, "[k]bytes: integer [4..4194302] (default: 4)",
                                                          "set threshold for long values to k kbytes");
+      cmd.addSubGroup("parsing of the data set:");
+        cmd.addOption("--read-all-elements",   "+ra",    "parse all elements of the data set (default)");
+        cmd.addOption("--stop-before-pixel",   "+sp",    "stop parsing before the pixel data element");
+        cmd.addOption("--stop-before-elem",    "+st", 1, "[t]ag: \"xxxx,xxxx\" or a data dictionary name",
+                                                         "stop parsing before element with tag t");
     cmd.addGroup("processing options:");
       cmd.addSubGroup("character set:");
         cmd.addOption("--charset-require",     "+Cr",    "require declaration of extended charset (default)");
@@ -375,6 +407,19 @@ int main(int argc, char *argv[])
             loadIntoMemory = OFFalse;
         cmd.endOptionBlock();
 
+        cmd.beginOptionBlock();
+        if (cmd.findOption("--read-all-elements"))
+            opt_stopParsingAtElement = DCM_UndefinedTagKey;
+        if (cmd.findOption("--stop-before-pixel"))
+            opt_stopParsingAtElement = DCM_PixelData;
+        if (cmd.findOption("--stop-before-elem"))
+        {
+            app.checkValue(cmd.getValue(opt_tagName));
+            if (!parseTagKey(opt_tagName, opt_stopParsingAtElement))
+                return 1;
+        }
+        cmd.endOptionBlock();
+
         cmd.beginOptionBlock();
         if (cmd.findOption("--charset-require"))
         {
@@ -443,12 +488,12 @@ int main(int argc, char *argv[])
         ofstream stream(ofname);
         if (stream.good())
         {
-            if (writeFile(stream, ifname, opt_readMode, opt_ixfer, loadIntoMemory, maxReadLength, opt_defaultCharset, opt_writeFlags).bad())
+            if (writeFile(stream, ifname, opt_readMode, opt_ixfer, loadIntoMemory, maxReadLength, opt_stopParsingAtElement, opt_defaultCharset, opt_writeFlags).bad())
                 result = 2;
         } else
             result = 1;
     } else {
-        if (writeFile(COUT, ifname, opt_readMode, opt_ixfer, loadIntoMemory, maxReadLength, opt_defaultCharset, opt_writeFlags).bad())
+        if (writeFile(COUT, ifname, opt_readMode, opt_ixfer, loadIntoMemory, maxReadLength, opt_stopParsingAtElement, opt_defaultCharset, opt_writeFlags).bad())
             result = 3;
     }
 
@@ -45,8 +45,9 @@
 #include "dcmtk/dcmdata/dcdebug.h"
 #include "dcmtk/dcmdata/cmdlnarg.h"
 #include "dcmtk/ofstd/ofconapp.h"
+#include "dcmtk/ofstd/ofstd.h"
 #include "dcmtk/dcmdata/dcuid.h"       /* for dcmtk version name */
-#include "dcmtk/dcmdata/dcostrmz.h"    /* for dcmZlibCompressionLevel */
+#include "dcmtk/dcmdata/dcostrmz.h"    /* for dcmZlibCompressionLevel, dcmZlibCompressionThreads */
 #include "dcmtk/dcmdata/dcistrmz.h"    /* for dcmZlibExpectRFC1950Encoding */
 
 #ifdef WITH_ZLIB
@@ -90,6 +91,7 @@ int main(int argc, char *argv[])
   OFCmdUnsignedInt opt_itempad = 0;
 #ifdef WITH_ZLIB
   OFCmdUnsignedInt opt_compressionLevel = 0;
+  OFCmdUnsignedInt opt_compressionThreads = 1;
 #endif
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION , "Convert DICOM file encoding", rcsid);
@@ -163,9 +165,11 @@ int main(int argc, char *argv[])
       cmd.addOption("--padding-create",      "+p",  2, "[f]ile-pad [i]tem-pad: integer",
                                                        "align file on multiple of f bytes\nand items on multiple of i bytes");
 #ifdef WITH_ZLIB
-    cmd.addSubGroup("deflate compression level (only with --write-xfer-deflated):");
+    cmd.addSubGroup("deflate compression options (only with --write-xfer-deflated):");
       cmd.addOption("--compression-level",   "+cl", 1, "compression level: 0-9 (default 6)",
                                                        "0=uncompressed, 1=fastest, 9=best compression");
+      cmd.addOption("--compression-threads", "+ct", 1, "[n]umber: integer",
+                                                       "compress blocks of 128 kB with n threads\n(default: 1)");
 #endif
 
     /* evaluate command line */
@@ -346,6 +350,13 @@ int main(int argc, char *argv[])
           dcmZlibCompressionLevel.set(OFstatic_cast(int, opt_compressionLevel));
       }
       cmd.endOptionBlock();
+
+      if (cmd.findOption("--compression-threads"))
+      {
+          app.checkDependence("--compression-threads", "--write-xfer-deflated", opt_oxfer == EXS_DeflatedLittleEndianExplicit);
+          app.checkValue(cmd.getValueAndCheckMin(opt_compressionThreads, OFstatic_cast(OFCmdUnsignedInt, 1)));
+          dcmZlibCompressionThreads.set(OFstatic_cast(Uint32, opt_compressionThreads));
+      }
 #endif
 
     }
@@ -383,10 +394,15 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    if (opt_verbose)
-        COUT << "load all data into memory" << endl;
-    /* make sure that pixel data is loaded before output file is created */
-    dataset->loadAllDataIntoMemory();
+    /* make sure that pixel data is loaded before output file is created if the */
+    /* output file might be the input file. Otherwise large values are copied */
+    /* from the input file while writing, without loading them into memory. */
+    if (OFStandard::fileExists(opt_ofname))
+    {
+        if (opt_verbose)
+            COUT << "load all data into memory" << endl;
+        dataset->loadAllDataIntoMemory();
+    }
 
     if (opt_oxfer == EXS_Unknown)
     {
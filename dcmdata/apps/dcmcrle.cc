@@ -92,6 +92,7 @@ int main(int argc, char *argv[])
   OFBool           opt_createOffsetTable = OFTrue;
   OFBool           opt_uidcreation = OFFalse;
   OFBool           opt_secondarycapture = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION , "Encode DICOM file to RLE transfer syntax", rcsid);
   OFCommandLine cmd;
@@ -127,6 +128,9 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("basic offset table encoding options:");
      cmd.addOption("--offset-table-create",     "+ot",       "create offset table (default)");
      cmd.addOption("--offset-table-empty",      "-ot",       "leave offset table empty");
+    cmd.addSubGroup("multi-frame processing options:");
+     cmd.addOption("--threads",                 "+mt",    1, "[n]umber: integer",
+                                                             "process up to n frames concurrently (default: 1)");
 
     cmd.addSubGroup("SOP Class UID options:");
      cmd.addOption("--class-default",      "+cd",     "keep SOP Class UID (default)");
@@ -225,6 +229,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--offset-table-empty")) opt_createOffsetTable = OFFalse;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMin(opt_threads, OFstatic_cast(OFCmdUnsignedInt, 1)));
+      }
+
 
       cmd.beginOptionBlock();
       if (cmd.findOption("--class-default")) opt_secondarycapture = OFFalse;
@@ -277,7 +286,7 @@ int main(int argc, char *argv[])
 
     // register RLE compression codec
     DcmRLEEncoderRegistration::registerCodecs(opt_uidcreation, opt_verbose,
-      opt_fragmentSize, opt_createOffsetTable, opt_secondarycapture);
+      opt_fragmentSize, opt_createOffsetTable, opt_secondarycapture, OFstatic_cast(Uint32, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
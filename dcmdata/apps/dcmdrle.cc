@@ -91,6 +91,7 @@ int main(int argc, char *argv[])
   // RLE parameters
   OFBool opt_uidcreation = OFFalse;
   OFBool opt_reversebyteorder = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION , "Decode RLE-compressed DICOM file", rcsid);
   OFCommandLine cmd;
@@ -123,6 +124,10 @@ int main(int argc, char *argv[])
      cmd.addOption("--byte-order-default",      "+bd",     "most significant byte first (default)");
      cmd.addOption("--byte-order-reverse",      "+br",     "least significant byte first");
 
+    cmd.addSubGroup("multi-frame processing options:");
+     cmd.addOption("--threads",                 "+mt",    1, "[n]umber: integer",
+                                                             "process up to n frames concurrently (default: 1)");
+
   cmd.addGroup("output options:");
     cmd.addSubGroup("output file format:");
       cmd.addOption("--write-file",             "+F",        "write file format (default)");
@@ -186,6 +191,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--byte-order-reverse")) opt_reversebyteorder = OFTrue;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMin(opt_threads, OFstatic_cast(OFCmdUnsignedInt, 1)));
+      }
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--read-file"))
       {
@@ -260,7 +270,7 @@ int main(int argc, char *argv[])
     SetDebugLevel((opt_debugMode));
 
     // register global decompression codecs
-    DcmRLEDecoderRegistration::registerCodecs(opt_uidcreation, opt_verbose, opt_reversebyteorder);
+    DcmRLEDecoderRegistration::registerCodecs(opt_uidcreation, opt_verbose, opt_reversebyteorder, OFstatic_cast(Uint32, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
@@ -77,6 +77,29 @@ static const int MAX_PRINT_TAG_NAMES = 1024;
 static const char* printTagNames[MAX_PRINT_TAG_NAMES];
 static const DcmTagKey* printTagKeys[MAX_PRINT_TAG_NAMES];
 static OFCmdUnsignedInt maxReadLength = 4096; // default is 4 KB
+static DcmTagKey stopParsingAtElement = DCM_UndefinedTagKey;
+
+static OFBool parseTagKey(const char *tagName, DcmTagKey &key)
+{
+    unsigned int group = 0xffff;
+    unsigned int elem = 0xffff;
+    if (sscanf(tagName, "%x,%x", &group, &elem) != 2)
+    {
+        /* it is a name */
+        const DcmDataDictionary& globalDataDict = dcmDataDict.rdlock();
+        const DcmDictEntry *dicent = globalDataDict.findEntry(tagName);
+        if (dicent == NULL)
+        {
+            dcmDataDict.unlock();
+            CERR << "error: unrecognised tag name: '" << tagName << "'" << endl;
+            return OFFalse;
+        }
+        key = dicent->getKey();
+        dcmDataDict.unlock();
+    } else
+        key.set(OFstatic_cast(Uint16, group), OFstatic_cast(Uint16, elem));
+    return OFTrue;
+}
 
 static OFBool addPrintTagName(const char* tagName)
 {
@@ -181,6 +204,11 @@ int main(int argc, char *argv[])
       cmd.addSubGroup("automatic data correction:");
         cmd.addOption("--enable-correction",  "+dc",    "enable automatic data correction (default)");
         cmd.addOption("--disable-correction", "-dc",    "disable automatic data correction");
+      cmd.addSubGroup("parsing of the data set:");
+        cmd.addOption("--read-all-elements",  "+ra",    "parse all elements of the data set (default)");
+        cmd.addOption("--stop-before-pixel",  "+sp",    "stop parsing before the pixel data element");
+        cmd.addOption("--stop-before-elem",   "+st", 1, "[t]ag: \"xxxx,xxxx\" or a data dictionary name",
+                                                        "stop parsing before element with tag t");
 #ifdef WITH_ZLIB
     cmd.addSubGroup("bitstream format of deflated input:");
      cmd.addOption("--bitstream-deflated",    "+bd",    "expect deflated bitstream (default)");
@@ -332,6 +360,16 @@ int main(int argc, char *argv[])
       cmd.endOptionBlock();
 #endif
 
+      cmd.beginOptionBlock();
+      if (cmd.findOption("--read-all-elements")) stopParsingAtElement = DCM_UndefinedTagKey;
+      if (cmd.findOption("--stop-before-pixel")) stopParsingAtElement = DCM_PixelData;
+      if (cmd.findOption("--stop-before-elem"))
+      {
+          app.checkValue(cmd.getValue(current));
+          if (!parseTagKey(current, stopParsingAtElement)) return 1;
+      }
+      cmd.endOptionBlock();
+
       if (cmd.findOption("--max-read-length"))
       {
           app.checkValue(cmd.getValueAndCheckMinMax(maxReadLength, 4, 4194302));
@@ -477,7 +515,8 @@ static int dumpFile(ostream & out,
     DcmFileFormat dfile;
     DcmObject *dset = &dfile;
     if (readMode == ERM_dataset) dset = dfile.getDataset();
-    OFCondition cond = dfile.loadFile(ifname, xfer, EGL_noChange, maxReadLength, readMode);
+    OFCondition cond = dfile.loadFile(ifname, xfer, EGL_noChange, maxReadLength, readMode,
+                                      OFFalse /* readSequencesOnDemand */, stopParsingAtElement);
     if (! cond.good())
     {
         CERR << OFFIS_CONSOLE_APPLICATION << ": error: " << dfile.error().text()
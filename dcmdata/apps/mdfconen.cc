@@ -591,10 +591,24 @@ OFCondition MdfConsoleEngine::loadFile(const char *filename)
     delete ds_man;
     ds_man = new MdfDatasetManager(debug_option);
     debugMsg(verbose_option,"Processing file: ", filename, "");
-    //load file into dataset manager
-    result=ds_man->loadFile(filename, read_mode_option, input_xfer_option);
+    //backup file first and load the backup, so that values that were not
+    //loaded into memory can be copied from the backup when saving
+    result=backupFile(filename);
     if (result.good())
-        result=backupFile(filename);
+    {
+        OFString backup = filename;
+        backup+=".bak";
+        //load file into dataset manager
+        result=ds_man->loadFile(backup.c_str(), read_mode_option, input_xfer_option);
+        if (result.bad())
+        {
+            //release the backup file before it is renamed again
+            delete ds_man;
+            ds_man = new MdfDatasetManager(debug_option);
+            if (restoreFile(filename).bad())
+                debugMsg(OFTrue, "error: couldnt restore file!", "", "");
+        }
+    }
     return result;
 }
 
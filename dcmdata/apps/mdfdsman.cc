@@ -91,12 +91,11 @@ OFCondition MdfDatasetManager::loadFile(const char *file_name,
         //get dataset from file
         debugMsg(debug_option,"Getting dataset from loaded file ", file_name,"");
         dset=dfile->getDataset();
-        /*load also pixeldata into memory:
-         *Without this command pixeldata wouldn't be included into the file,
-         *that's saved after modifying, because original filename was renamed
-         *meanwhile
+        /*large values like pixel data are not loaded into memory here, they
+         *are copied from the loaded file when saving to a different file.
+         *Therefore the loaded file must not be renamed or deleted before
+         *the dataset was saved.
          */
-        dset->loadAllDataIntoMemory();
         //save filename to member variable
         act_file=file_name;
     }
@@ -624,6 +623,9 @@ OFCondition MdfDatasetManager::saveFile(const char *file_name,
             debugMsg(OFTrue, "Warning: encapsulated pixel data require file format, ignoring --write-dataset", "","");
             opt_dataset = OFFalse;
         }
+        /* the loaded file is overwritten, so all values must be in memory */
+        if (act_file == file_name)
+            dfile->loadAllDataIntoMemory();
         /* write DICOM file */
         result = dfile->saveFile(file_name, opt_xfer, opt_enctype, opt_glenc,
                                  opt_padenc,
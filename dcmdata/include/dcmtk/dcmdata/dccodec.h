@@ -39,6 +39,7 @@
 #include "dcmtk/dcmdata/dcerror.h"
 #include "dcmtk/dcmdata/dcxfer.h"
 #include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofstring.h"
 
 class DcmStack;
 class DcmRepresentationParameter;
@@ -113,6 +114,38 @@ public:
       const DcmCodecParameter * cp,
       const DcmStack& objStack) const = 0;
 
+  /** decompresses a single frame from the given pixel sequence and
+   *  stores the result in the given buffer. Only the fragments of the
+   *  given frame are accessed.
+   *  @param fromParam current representation parameter of compressed data, may be NULL
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to the dataset in which the pixel data element is contained
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param startFragment index of the fragment that contains the first part
+   *    of the compressed frame, 0 if unknown (see determineStartFragment()).
+   *    Upon successful return, this parameter contains the index of the first
+   *    fragment of the next frame, i.e. frames decompressed in increasing order
+   *    never depend on the offset table.
+   *  @param buffer pointer to the buffer where the uncompressed frame is stored.
+   *    Samples with more than 8 bits are stored as words in local byte order.
+   *  @param bufSize size of the buffer in bytes
+   *  @param decompressedColorModel upon successful return, the photometric
+   *    interpretation of the uncompressed frame (which may differ from the one
+   *    of the compressed frame) is returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrame(
+      const DcmRepresentationParameter * fromParam,
+      DcmPixelSequence * fromPixSeq,
+      const DcmCodecParameter * cp,
+      DcmItem * dataset,
+      Uint32 frameNo,
+      Uint32& startFragment,
+      void * buffer,
+      Uint32 bufSize,
+      OFString& decompressedColorModel) const = 0;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -226,6 +259,25 @@ public:
     const char *codeValue,
     const char *codeMeaning);
 
+  /** determine the index of the fragment that contains the first part of
+   *  the given frame. The first frame always starts with fragment 1. If the
+   *  number of fragments equals the number of frames, each frame is stored in
+   *  one fragment. Otherwise, the Basic Offset Table (the first item of the
+   *  pixel sequence) is evaluated.
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param numberOfFrames number of frames of the image
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param currentItem index of the first fragment of the frame returned in
+   *    this parameter upon success
+   *  @return EC_Normal if successful, an error code otherwise, in particular
+   *    if the offset table is empty and frames span multiple fragments
+   */
+  static OFCondition determineStartFragment(
+    Uint32 frameNo,
+    Sint32 numberOfFrames,
+    DcmPixelSequence * fromPixSeq,
+    Uint32& currentItem);
+
 };
 
 
@@ -298,6 +350,35 @@ public:
     DcmPolymorphOBOW& uncompressedPixelData,
     DcmStack & pixelStack);
 
+  /** looks for a codec that is able to decode from the given transfer syntax
+   *  and calls the decodeFrame() method of the codec.  A read lock on the list of
+   *  codecs is acquired until this method returns.
+   *  @param fromType transfer syntax to decode from
+   *  @param fromParam representation parameter of current compressed
+   *    representation, may be NULL.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param dataset pointer to the dataset in which the pixel data element is contained
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param startFragment index of the fragment that contains the first part of
+   *    the compressed frame, 0 if unknown. Upon successful return, the index of
+   *    the first fragment of the next frame is returned in this parameter.
+   *  @param buffer pointer to the buffer where the uncompressed frame is stored
+   *  @param bufSize size of the buffer in bytes
+   *  @param decompressedColorModel upon successful return, the photometric
+   *    interpretation of the uncompressed frame is returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition decodeFrame(
+    const DcmXfer & fromType,
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel);
+
   /** looks for a codec that is able to encode from the given transfer syntax
    *  and calls the encode() method of the codec.  A read lock on the list of
    *  codecs is acquired until this method returns.
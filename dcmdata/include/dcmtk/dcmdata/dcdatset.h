@@ -200,12 +200,19 @@ class DcmDataset
      *  @param maxReadLength maximum number of bytes to be read for an element value.
      *    Element values with a larger size are not loaded until their value is retrieved
      *    (with getXXX()) or loadAllDataElements() is called.
+     *  @param readSequencesOnDemand parse the items of sequences with explicit length
+     *    only when they are accessed, see DcmItem::setReadSequencesOnDemand()
+     *  @param stopParsingAtElement stop reading before the element with this tag,
+     *    see DcmItem::setStopParsingAtElement(). DCM_UndefinedTagKey (default)
+     *    reads all elements.
      *  @return status, EC_Normal if successful, an error code otherwise
      */
     virtual OFCondition loadFile(const char *fileName,
                                  const E_TransferSyntax readXfer = EXS_Unknown,
                                  const E_GrpLenEncoding groupLength = EGL_noChange,
-                                 const Uint32 maxReadLength = DCM_MaxReadLength);
+                                 const Uint32 maxReadLength = DCM_MaxReadLength,
+                                 const OFBool readSequencesOnDemand = OFFalse,
+                                 const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey);
 
     /** save object to a DICOM file.
      *  This method only supports DICOM objects stored as a dataset, i.e. without meta header.
@@ -44,6 +44,8 @@
 
 // forward declarations
 class DcmInputStreamFactory;
+class DcmInputStream;
+class DcmMappedFile;
 
 
 /** abstract base class for all DICOM elements
@@ -92,6 +94,7 @@ class DcmElement
     inline OFBool valueLoaded() { return fValue != NULL || Length == 0; }
 
     virtual void transferInit();
+    virtual void transferEnd();
 
     virtual OFBool canWriteXfer(const E_TransferSyntax newXfer,
                                 const E_TransferSyntax oldXfer);
@@ -215,6 +218,10 @@ class DcmElement
     // The DICOM element remains a copy of the value if the copy
     // parameter is OFTrue else the value is erased in the DICOM
     // element.
+    // A value that refers to a memory mapped file (see dcmUseMemoryMappedFiles)
+    // is copied to the heap first. Since the element may have returned a pointer
+    // into the mapped file before, call loadAllDataIntoMemory() before retrieving
+    // the value that is to be detached.
     OFCondition detachValueField(OFBool copy = OFFalse);
 
 
@@ -311,11 +318,72 @@ class DcmElement
 
   private:
 
+    /** delete the value field, or release the memory mapped file
+     *  if the value field refers to it.
+     */
+    void deleteValue();
+
+    /** try to map the value field from the given stream instead of reading it.
+     *  Only possible if the stream reads from a memory mapped file, the value
+     *  has even length, is not a string (which requires a terminating zero byte)
+     *  and is in local byte order unless it consists of single bytes. If the
+     *  mapped value is not properly aligned for the VR, it is copied.
+     *  @param inStream stream positioned at the start of the value field
+     *  @return OFTrue if the value field has been mapped or copied, OFFalse otherwise
+     */
+    OFBool mapValue(DcmInputStream &inStream);
+
+    /** copy a value field that refers to a memory mapped file to the heap,
+     *  so that the element no longer depends on the file.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition unmapValue();
+
+    /** check whether the value field can be written by copying it from the
+     *  stream it has been read from, without loading it into memory. This is
+     *  the case if the value has not been loaded yet, has even length and
+     *  does not need to be byte swapped for the given byte order.
+     *  @param outByteOrder byte order of the output transfer syntax
+     *  @return OFTrue if the value field can be copied, OFFalse otherwise
+     */
+    OFBool canWriteValueFromSource(const E_ByteOrder outByteOrder) const;
+
+    /** copy as much as possible of the remaining value field from the stream
+     *  it has been read from to the given output stream, without loading it
+     *  into memory. If the source is a plain file, DcmOutputStream::copyFromFile()
+     *  is tried first, otherwise the value is copied through a buffer of at
+     *  most the size the output stream currently accepts. Source stream and
+     *  buffer are kept for the next call, see releaseValueSource().
+     *  @param outStream stream to which the value is written
+     *  @return status, EC_Normal if the complete value has been written,
+     *    EC_StreamNotifyClient if the output stream is full, an error code otherwise
+     */
+    OFCondition writeValueFromSource(DcmOutputStream &outStream);
+
+    /** delete the source stream and the copy buffer used by writeValueFromSource()
+     */
+    void releaseValueSource();
+
     /// required information to load value later
     DcmInputStreamFactory *fLoadValue;
 
     /// value of the element
     Uint8 *fValue;
+
+    /// memory mapped file fValue points into, NULL if fValue is allocated on the heap
+    DcmMappedFile *fMappedFile;
+
+    /// stream the value is copied from by writeValueFromSource(), NULL if none
+    DcmInputStream *fSourceStream;
+
+    /// number of value bytes that have been read from fSourceStream
+    Uint32 fSourcePosition;
+
+    /// buffer used by writeValueFromSource()
+    Uint8 *fSourceBuffer;
+
+    /// size of fSourceBuffer in bytes
+    Uint32 fSourceBufferSize;
 };
 
 
@@ -162,13 +162,20 @@ class DcmFileFormat
      *    (with getXXX()) or loadAllDataElements() is called.
      *  @param readMode read file with or without meta header, i.e. as a fileformat or a
      *    dataset.  Use ERM_fileOnly in order to force the presence of a meta header.
+     *  @param readSequencesOnDemand parse the items of sequences with explicit length
+     *    in the dataset only when they are accessed, see DcmItem::setReadSequencesOnDemand()
+     *  @param stopParsingAtElement stop reading the dataset before the element with this
+     *    tag, e.g. DCM_PixelData, so that the following elements are not read at all, see
+     *    DcmItem::setStopParsingAtElement(). DCM_UndefinedTagKey (default) reads all elements.
      *  @return status, EC_Normal if successful, an error code otherwise
      */
     virtual OFCondition loadFile(const char *fileName,
                                  const E_TransferSyntax readXfer = EXS_Unknown,
                                  const E_GrpLenEncoding groupLength = EGL_noChange,
                                  const Uint32 maxReadLength = DCM_MaxReadLength,
-                                 const E_FileReadMode readMode = ERM_autoDetect);
+                                 const E_FileReadMode readMode = ERM_autoDetect,
+                                 const OFBool readSequencesOnDemand = OFFalse,
+                                 const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey);
 
     /** save object to a DICOM file.
      *  @param fileName name of the file to save
@@ -0,0 +1,189 @@
+/*
+ *
+ *  Copyright (C) 1994-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  agent
+ *
+ *  Purpose: classes DcmFrameProcessor, DcmFrameWorkerPool, DcmFragmentTable,
+ *    helpers for codecs that process the frames of an image concurrently.
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#ifndef DCFRMPOL_H
+#define DCFRMPOL_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/ofstd/ofcond.h"
+#include "dcmtk/ofstd/ofthread.h"
+
+class DcmPixelSequence;
+class DcmPixelItem;
+class DcmFrameWorker;
+
+
+/** abstract base class for the per-frame work of a codec.
+ *  processFrame() is called concurrently for different frames by
+ *  the threads of a DcmFrameWorkerPool, so implementations must not
+ *  modify shared state (e.g. the dataset or the pixel sequence)
+ *  without synchronization.
+ */
+class DcmFrameProcessor
+{
+public:
+
+  /// destructor
+  virtual ~DcmFrameProcessor() {}
+
+  /** processes one frame.
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  virtual OFCondition processFrame(Uint32 frameNo) = 0;
+};
+
+
+/** a pool of worker threads that process a range of frames concurrently.
+ *  Each thread repeatedly takes the next unprocessed frame, so frames
+ *  of different complexity are balanced between the threads. The calling
+ *  thread takes part in the work. If threads are not supported or cannot
+ *  be created, all frames are processed by the calling thread.
+ */
+class DcmFrameWorkerPool
+{
+public:
+
+  /** constructor.
+   *  @param processor object that processes the frames
+   *  @param numberOfThreads maximum number of threads including the calling thread
+   */
+  DcmFrameWorkerPool(DcmFrameProcessor& processor, Uint32 numberOfThreads);
+
+  /// destructor
+  ~DcmFrameWorkerPool();
+
+  /** processes the given range of frames and returns when all of them have
+   *  been processed. After the first error no further frames are started.
+   *  @param firstFrame number of the first frame to process
+   *  @param numberOfFrames number of frames to process
+   *  @return EC_Normal if all frames were processed successfully, otherwise
+   *    the error code of the failed frame with the lowest number
+   */
+  OFCondition run(Uint32 firstFrame, Uint32 numberOfFrames);
+
+private:
+
+  friend class DcmFrameWorker;
+
+  /// private undefined copy constructor
+  DcmFrameWorkerPool(const DcmFrameWorkerPool&);
+
+  /// private undefined copy assignment operator
+  DcmFrameWorkerPool& operator=(const DcmFrameWorkerPool&);
+
+  /// processes frames until none is left or an error has occured
+  void work();
+
+  /// object that processes the frames
+  DcmFrameProcessor& processor_;
+
+  /// maximum number of threads including the calling thread
+  Uint32 numberOfThreads_;
+
+  /// next frame to be processed
+  Uint32 nextFrame_;
+
+  /// end of the range of frames to be processed
+  Uint32 endFrame_;
+
+  /// number of the failed frame with the lowest number, endFrame_ if none
+  Uint32 failedFrame_;
+
+  /// error code of the failed frame
+  OFCondition result_;
+
+  /// protects the frame counters and the result
+  OFMutex mutex_;
+};
+
+
+/** table of the fragments of a compressed pixel sequence.
+ *  Unlike DcmPixelSequence::getItem(), which moves the current position
+ *  of the sequence, the table can be read by several threads at a time.
+ */
+class DcmFragmentTable
+{
+public:
+
+  /// constructor, creates an empty table
+  DcmFragmentTable();
+
+  /// destructor
+  ~DcmFragmentTable();
+
+  /** fills the table with the items of the given pixel sequence,
+   *  including the offset table.
+   *  @param pixSeq pixel sequence
+   *  @param loadValues if true, the values of all items are loaded into
+   *    memory, which must be done before the table is accessed by
+   *    several threads
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition create(DcmPixelSequence *pixSeq, OFBool loadValues);
+
+  /** gets an item from the table.
+   *  @param item pointer to the item returned in this parameter
+   *  @param num index of the item, 0 for the offset table
+   *  @return EC_Normal if successful, EC_IllegalCall if there is no such item
+   */
+  OFCondition getItem(DcmPixelItem *&item, Uint32 num) const;
+
+  /// returns the number of items in the table
+  Uint32 card() const { return count_; }
+
+private:
+
+  /// private undefined copy constructor
+  DcmFragmentTable(const DcmFragmentTable&);
+
+  /// private undefined copy assignment operator
+  DcmFragmentTable& operator=(const DcmFragmentTable&);
+
+  /// array of items
+  DcmPixelItem **items_;
+
+  /// number of items
+  Uint32 count_;
+};
+
+
+#endif
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
@@ -37,9 +37,11 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/ofstd/oftypes.h"  /* for OFBool */
 #include "dcmtk/ofstd/ofcond.h"   /* for OFCondition */
+#include "dcmtk/ofstd/ofstring.h" /* for OFString */
 #include "dcmtk/dcmdata/dcxfer.h"   /* for E_StreamCompression */
 
 class DcmInputStream;
+class DcmMappedFile;
 
 /** pure virtual abstract base class for producers, i.e. the initial node 
  *  of a filter chain in an input stream.
@@ -98,6 +100,21 @@ public:
    */
   virtual void putback(Uint32 num) = 0;
 
+  /** returns a pointer to the next bytes of the stream in a memory mapped
+   *  file and advances the stream position past these bytes, without copying
+   *  any data. Producers that do not read from a memory mapped file, and all
+   *  filters, do not support this operation and return NULL.
+   *  @param length number of bytes to map
+   *  @param mapping reference to the mapped file returned in this parameter
+   *    if successful. The caller must call DcmMappedFile::addReference()
+   *    before using the pointer beyond the lifetime of the producer.
+   *  @return pointer to the data if successful, NULL otherwise
+   */
+  virtual Uint8 *mapData(Uint32 /* length */, DcmMappedFile *& /* mapping */)
+  {
+    return NULL;
+  }
+
 };
 
 
@@ -143,6 +160,18 @@ public:
   /** returns a pointer to a copy of this object
    */
   virtual DcmInputStreamFactory *clone() const = 0;
+
+  /** checks whether the streams created by this factory read the
+   *  uncompressed content of a plain file and if so, returns the name of
+   *  the file and the position at which the streams start.
+   *  @param filename name of the file returned in this parameter
+   *  @param offset byte offset from the start of file returned in this parameter
+   *  @return OFTrue if the streams read from a plain file, OFFalse otherwise
+   */
+  virtual OFBool getFileAndOffset(OFString& /* filename */, Uint32& /* offset */) const
+  {
+    return OFFalse;
+  }
 };
 
 
@@ -199,6 +228,15 @@ public:
    */
   virtual Uint32 tell() const;
 
+  /** returns a pointer to the next bytes of the stream if the stream reads
+   *  from a memory mapped file and no compression filter is active, and
+   *  advances the stream position past these bytes. See DcmProducer::mapData().
+   *  @param length number of bytes to map
+   *  @param mapping reference to the mapped file returned in this parameter
+   *  @return pointer to the data if successful, NULL otherwise
+   */
+  virtual Uint8 *mapData(Uint32 length, DcmMappedFile *& mapping);
+
   /** installs a compression filter for the given stream compression type,
    *  which should be neither ESC_none nor ESC_unsupported. Once a compression
    *  filter is active, it cannot be deactivated or replaced during the
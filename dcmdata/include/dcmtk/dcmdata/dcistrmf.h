@@ -150,6 +150,19 @@ public:
     return new DcmInputFileStreamFactory(*this);
   }
 
+  /** returns the name of the file and the position at which the streams
+   *  created by this factory start.
+   *  @param filename name of the file returned in this parameter
+   *  @param offset byte offset from the start of file returned in this parameter
+   *  @return always OFTrue
+   */
+  virtual OFBool getFileAndOffset(OFString& filename, Uint32& offset) const
+  {
+    filename = filename_;
+    offset = offset_;
+    return OFTrue;
+  }
+
 private:
 
 
@@ -203,6 +216,9 @@ private:
 
   /// filename
   OFString filename_;
+
+  /// offset in file at which this stream starts
+  Uint32 offset_;
 };
 
 
@@ -0,0 +1,327 @@
+/*
+ *
+ *  Copyright (C) 1994-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  agent
+ *
+ *  Purpose: DcmInputMappedFileStream and related classes,
+ *    implements streamed input from memory mapped files.
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#ifndef DCISTRMM_H
+#define DCISTRMM_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dcistrma.h"
+#include "dcmtk/ofstd/ofglobal.h"
+#include "dcmtk/ofstd/ofthread.h"
+
+
+/** global flag defining whether DcmFileFormat::loadFile() and
+ *  DcmDataset::loadFile() map the file into memory instead of reading it.
+ *  Element values that would otherwise be loaded on demand then refer
+ *  to the mapped file directly. If memory mapped files are not supported
+ *  on this platform, or a file cannot be mapped, the file is read as usual.
+ *  Only enable this flag if the files are not truncated or rewritten by
+ *  another process while they are in use; accessing a mapped value beyond
+ *  the end of a truncated file terminates the process (SIGBUS).
+ *  Default is false.
+ */
+extern OFGlobal<OFBool> dcmUseMemoryMappedFiles; /* default OFFalse */
+
+
+/** a file mapped into memory, shared by the producers, stream factories
+ *  and element values that refer to it. The file is mapped copy-on-write,
+ *  i.e. modifications of the mapped data (e.g. byte swapping of element
+ *  values) are private to the process and never written to the file.
+ *  The mapping is removed when the last reference has been released.
+ *  Reference counting is thread-safe.
+ */
+class DcmMappedFile
+{
+public:
+
+  /** map the given file into memory
+   *  @param filename name of file to be mapped, must not be NULL or empty
+   *  @param status status returned in this parameter, EC_Normal if successful
+   *  @return pointer to mapped file with one reference if successful, NULL otherwise
+   */
+  static DcmMappedFile *create(const char *filename, OFCondition& status);
+
+  /// adds a reference to the mapped file
+  void addReference();
+
+  /// releases a reference to the mapped file, deletes the object if it was the last one
+  void release();
+
+  /** returns a pointer to the mapped data
+   *  @return pointer to the mapped data, NULL if the file is empty
+   */
+  Uint8 *data() const
+  {
+    return data_;
+  }
+
+  /** returns the size of the mapped data
+   *  @return number of bytes in file
+   */
+  Uint32 size() const
+  {
+    return size_;
+  }
+
+private:
+
+  /** private constructor, use create()
+   *  @param data pointer to the mapped data
+   *  @param size number of bytes mapped
+   */
+  DcmMappedFile(Uint8 *data, Uint32 size);
+
+  /// private destructor, use release()
+  ~DcmMappedFile();
+
+  /// private unimplemented copy constructor
+  DcmMappedFile(const DcmMappedFile&);
+
+  /// private unimplemented copy assignment operator
+  DcmMappedFile& operator=(const DcmMappedFile&);
+
+  /// pointer to the mapped data
+  Uint8 *data_;
+
+  /// number of bytes mapped
+  Uint32 size_;
+
+  /// reference counter
+  unsigned long references_;
+
+  /// protects the reference counter
+  OFMutex mutex_;
+};
+
+
+/** producer class that reads data from a memory mapped file.
+ */
+class DcmMappedFileProducer: public DcmProducer
+{
+public:
+  /** constructor
+   *  @param filename name of file to be mapped, must not be NULL or empty
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmMappedFileProducer(const char *filename, Uint32 offset = 0);
+
+  /** constructor
+   *  @param file mapped file to read from, must not be NULL
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmMappedFileProducer(DcmMappedFile *file, Uint32 offset = 0);
+
+  /// destructor
+  virtual ~DcmMappedFileProducer();
+
+  /** returns the status of the producer. Unless the status is good,
+   *  the producer will not permit any operation.
+   *  @return status, true if good
+   */
+  virtual OFBool good() const;
+
+  /** returns the status of the producer as an OFCondition object.
+   *  Unless the status is good, the producer will not permit any operation.
+   *  @return status, EC_Normal if good
+   */
+  virtual OFCondition status() const;
+
+  /** returns true if the producer is at the end of stream.
+   *  @return true if end of stream, false otherwise
+   */
+  virtual OFBool eos() const;
+
+  /** returns the minimum number of bytes that can be read with the
+   *  next call to read(). The DcmObject read methods rely on avail
+   *  to return a value > 0 if there is no I/O suspension since certain
+   *  data such as tag and length are only read "en bloc", i.e. all
+   *  or nothing.
+   *  @return minimum of data available in producer
+   */
+  virtual Uint32 avail() const;
+
+  /** reads as many bytes as possible into the given block.
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually read.
+   */
+  virtual Uint32 read(void *buf, Uint32 buflen);
+
+  /** skips over the given number of bytes (or less)
+   *  @param skiplen number of bytes to skip
+   *  @return number of bytes actually skipped.
+   */
+  virtual Uint32 skip(Uint32 skiplen);
+
+  /** resets the stream to the position by the given number of bytes.
+   *  @param num number of bytes to putback. If the putback operation
+   *    fails, the producer status becomes bad.
+   */
+  virtual void putback(Uint32 num);
+
+  /** returns a pointer to the next bytes of the mapped file and
+   *  advances the stream position past these bytes.
+   *  @param length number of bytes to map
+   *  @param mapping reference to the mapped file returned in this parameter
+   *  @return pointer to the data, NULL if less than length bytes are available
+   */
+  virtual Uint8 *mapData(Uint32 length, DcmMappedFile *& mapping);
+
+  /** returns the mapped file this producer reads from
+   *  @return pointer to mapped file, NULL if the status is bad
+   */
+  DcmMappedFile *mappedFile() const
+  {
+    return file_;
+  }
+
+private:
+
+  /// private unimplemented copy constructor
+  DcmMappedFileProducer(const DcmMappedFileProducer&);
+
+  /// private unimplemented copy assignment operator
+  DcmMappedFileProducer& operator=(const DcmMappedFileProducer&);
+
+  /// the mapped file we're reading from, one reference held by this object
+  DcmMappedFile *file_;
+
+  /// status
+  OFCondition status_;
+
+  /// current position in file
+  Uint32 position_;
+};
+
+
+/** input stream factory for memory mapped files
+ */
+class DcmInputMappedFileStreamFactory: public DcmInputStreamFactory
+{
+public:
+
+  /** constructor
+   *  @param file mapped file, must not be NULL
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStreamFactory(DcmMappedFile *file, Uint32 offset);
+
+  /// copy constructor
+  DcmInputMappedFileStreamFactory(const DcmInputMappedFileStreamFactory &arg);
+
+  /// destructor
+  virtual ~DcmInputMappedFileStreamFactory();
+
+  /** create a new input stream object
+   *  @return pointer to new input stream object
+   */
+  virtual DcmInputStream *create() const;
+
+  /** returns a pointer to a copy of this object
+   */
+  virtual DcmInputStreamFactory *clone() const
+  {
+    return new DcmInputMappedFileStreamFactory(*this);
+  }
+
+private:
+
+  /// private unimplemented copy assignment operator
+  DcmInputMappedFileStreamFactory& operator=(const DcmInputMappedFileStreamFactory&);
+
+  /// mapped file, one reference held by this object
+  DcmMappedFile *file_;
+
+  /// offset in file
+  Uint32 offset_;
+
+};
+
+
+/** input stream that reads from a memory mapped file. Element values
+ *  read from this stream may refer to the mapped file instead of being
+ *  copied, see DcmInputStream::mapData().
+ */
+class DcmInputMappedFileStream: public DcmInputStream
+{
+public:
+  /** constructor
+   *  @param filename name of file to be mapped, must not be NULL or empty
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStream(const char *filename, Uint32 offset = 0);
+
+  /** constructor
+   *  @param file mapped file to read from, must not be NULL
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStream(DcmMappedFile *file, Uint32 offset = 0);
+
+  /// destructor
+  virtual ~DcmInputMappedFileStream();
+
+  /** creates a new factory object for the current stream
+   *  and stream position.  When activated, the factory will be
+   *  able to create new DcmInputStream delivering the same
+   *  data as the current stream.  Used to defer loading of
+   *  value fields until accessed.
+   *  If no factory object can be created (e.g. because a
+   *  compression filter is installed), returns NULL.
+   *  @return pointer to new factory object if successful, NULL otherwise.
+   */
+  virtual DcmInputStreamFactory *newFactory() const;
+
+private:
+
+  /// private unimplemented copy constructor
+  DcmInputMappedFileStream(const DcmInputMappedFileStream&);
+
+  /// private unimplemented copy assignment operator
+  DcmInputMappedFileStream& operator=(const DcmInputMappedFileStream&);
+
+  /// the final producer of the filter chain
+  DcmMappedFileProducer producer_;
+
+  /// offset in file at which this stream starts
+  Uint32 offset_;
+};
+
+
+#endif
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
@@ -51,6 +51,14 @@ END_EXTERN_C
  */
 extern OFGlobal<OFBool> dcmZlibExpectRFC1950Encoding;
 
+/** global flag defining the size of the input and output buffers of the
+ *  zlib decompressor in bytes, i.e. the size of the chunks in which compressed
+ *  data is read and inflated. Values below 2048 are increased to 2048.
+ *  The value is evaluated when a decompression filter is created.
+ *  Default is 65536.
+ */
+extern OFGlobal<Uint32> dcmZlibInputBufferSize;
+
 /** zlib compression filter for input streams
  */
 class DcmZLibInputFilter: public DcmInputFilter
@@ -181,6 +189,9 @@ private:
   /// true if the zlib object has reported Z_STREAM_END
   OFBool eos_;
 
+  /// size of the input and output ring buffers
+  Uint32 bufSize_;
+
   /// input ring buffer
   unsigned char *inputBuf_;
 
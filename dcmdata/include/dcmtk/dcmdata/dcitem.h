@@ -213,6 +213,53 @@ class DcmItem
     virtual OFCondition searchErrors( DcmStack &resultStack );     // inout
     virtual OFCondition loadAllDataIntoMemory();
 
+    /** specifies whether sequences read into this item are parsed on demand.
+     *  If enabled, read() only remembers the stream position of the items of
+     *  a sequence with explicit length and skips them, provided that the
+     *  stream has random access (e.g. a file). The items are parsed when
+     *  they are first accessed, e.g. by search() descending into the sequence,
+     *  getItem() or card(). The setting is passed on to all nested sequences
+     *  and items. Sequences with undefined length are always parsed
+     *  immediately since their end is only known after parsing them.
+     *  The file read from must not be modified while items have not been parsed,
+     *  call loadAllDataIntoMemory() before overwriting it.
+     *  @param onDemand true if sequences are parsed on demand, false otherwise
+     */
+    void setReadSequencesOnDemand(const OFBool onDemand)
+    {
+        fReadSequencesOnDemand = onDemand;
+    }
+
+    /** returns whether sequences read into this item are parsed on demand
+     *  @return true if sequences are parsed on demand, false otherwise
+     */
+    OFBool getReadSequencesOnDemand() const
+    {
+        return fReadSequencesOnDemand;
+    }
+
+    /** specifies an element before which read() stops parsing this item.
+     *  As soon as an element with this tag or a larger tag is encountered,
+     *  reading ends successfully and the remaining elements, e.g. the pixel
+     *  data, are neither parsed nor read from the stream. This only applies
+     *  to this item, not to the items of nested sequences. An item read in
+     *  this way is incomplete and should not be written back to a file.
+     *  @param tag tag of the element before which parsing stops,
+     *    DCM_UndefinedTagKey (default) to read all elements
+     */
+    void setStopParsingAtElement(const DcmTagKey &tag)
+    {
+        fStopParsingAtElement = tag;
+    }
+
+    /** returns the element before which read() stops parsing this item
+     *  @return tag of the element, DCM_UndefinedTagKey if all elements are read
+     */
+    const DcmTagKey &getStopParsingAtElement() const
+    {
+        return fStopParsingAtElement;
+    }
+
     /** This function takes care of group length and padding elements
      *  in the current element list according to what is specified in
      *  glenc and padenc. If required, this function does the following
@@ -771,7 +818,9 @@ class DcmItem
 
   protected:
 
-    /// the list of elements maintained by this object
+    /** the list of elements maintained by this object, kept in ascending
+     *  tag order without duplicates by insert()
+     */
     DcmList *elementList;
 
     /** flag used during suspended I/O. Indicates whether the last element
@@ -786,6 +835,25 @@ class DcmItem
      */
     Uint32 fStartPosition;
 
+    /// true if sequences read into this item are parsed on demand
+    OFBool fReadSequencesOnDemand;
+
+    /// element before which read() stops parsing, DCM_UndefinedTagKey if none
+    DcmTagKey fStopParsingAtElement;
+
+    /** This function searches elementList for an element with the given tag
+     *  (on this level only). Since elementList is sorted by tag, a binary
+     *  search is performed.
+     *  @param tag      The tag to search for.
+     *  @param position Contains in the end the position of the element in
+     *                  elementList if found, otherwise the position at which
+     *                  an element with this tag would have to be inserted.
+     *  @return pointer to the element if found (elementList is then positioned
+     *    at the element), NULL otherwise
+     */
+    DcmObject *seekTag(const DcmTagKey &tag,
+                       unsigned long &position);
+
     /** This function reads tag and length information from inStream and
      *  returns this information to the caller. When reading information,
      *  the transfer syntax which was passed is accounted for. If the
@@ -49,24 +49,6 @@ const unsigned long DCM_EndOfListIndex = OFstatic_cast(unsigned long, -1L);
 class DcmObject;    // forward declaration
 
 
-class DcmListNode {
-    friend class DcmList;
-    DcmListNode *nextNode;
-    DcmListNode *prevNode;
-    DcmObject *objNodeValue;
-
- // --- declarations to avoid compiler warnings
- 
-    DcmListNode(const DcmListNode &);
-    DcmListNode &operator=(const DcmListNode &);
-
-public:
-    DcmListNode( DcmObject *obj );
-    ~DcmListNode();
-    inline DcmObject *value() { return objNodeValue; } 
-};
-
-
 typedef enum
 {
     ELP_atpos,
@@ -79,12 +61,16 @@ typedef enum
 /* this class only manages pointers to elements.
  * remove() does not delete the element pointed to.
  * Upon destruction of the list, all elements pointed to are also deleted.
+ * The pointers are kept in a contiguous array in list order, so that
+ * seek_to() takes constant time and appending takes amortized constant time.
+ * Inserting and removing elements in the middle of the list moves the
+ * pointers behind the current position.
  */
 
 class DcmList {
-    DcmListNode *firstNode;
-    DcmListNode *lastNode;
-    DcmListNode *currentNode;
+    DcmObject **objArray;
+    unsigned long arraySize;
+    unsigned long currentIndex;
     unsigned long cardinality;
 
  // --- declarations to avoid compiler warnings
@@ -92,6 +78,9 @@ class DcmList {
     DcmList &operator=(const DcmList &);
     DcmList(const DcmList &newList);
 
+    // make room for one more element at the given position
+    void makeRoom(unsigned long position);
+
 public:
     DcmList();
     ~DcmList();
@@ -105,8 +94,8 @@ public:
     DcmObject *seek(    E_ListPos pos = ELP_next );
     DcmObject *seek_to(unsigned long absolute_position);
     inline unsigned long card() const { return cardinality; }
-    inline OFBool empty(void) const { return firstNode == NULL; }
-    inline OFBool valid(void) const { return currentNode != NULL; }
+    inline OFBool empty(void) const { return cardinality == 0; }
+    inline OFBool valid(void) const { return currentIndex < cardinality; }
 };
 
 #endif  // DCLIST_H
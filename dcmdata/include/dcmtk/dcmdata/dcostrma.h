@@ -93,6 +93,30 @@ public:
    *  behaviour.
    */
   virtual void flush() = 0;
+
+  /** writes data that a filter holds back because its consumer was full,
+   *  as far as the consumer now permits, and makes room for further input.
+   *  Callers that empty the final consumer between calls to write() call
+   *  this before they check avail() again. The default does nothing.
+   */
+  virtual void writePending()
+  {
+  }
+
+  /** copies a block of data from a plain file to the consumer without
+   *  passing it through a user space buffer, if the consumer and the
+   *  operating system support this. Consumers that do not write to a
+   *  plain file, and all filters, do not support this operation and
+   *  return 0, in which case the caller has to read and write the data.
+   *  @param filename name of the file to copy from
+   *  @param offset byte offset of the block from the start of file
+   *  @param length number of bytes to copy
+   *  @return number of bytes actually copied
+   */
+  virtual Uint32 copyFromFile(const char * /* filename */, Uint32 /* offset */, Uint32 /* length */)
+  {
+    return 0;
+  }
 };
 
 
@@ -170,6 +194,22 @@ public:
    */
   virtual void flush();
 
+  /** writes data held back by a compression filter, as far as the
+   *  consumer permits. See DcmConsumer::writePending().
+   */
+  virtual void writePending();
+
+  /** copies a block of data from a plain file to the stream without
+   *  passing it through a user space buffer, if possible. This is only
+   *  supported if no compression filter is active and the stream writes
+   *  to a plain file, see DcmConsumer::copyFromFile().
+   *  @param filename name of the file to copy from
+   *  @param offset byte offset of the block from the start of file
+   *  @param length number of bytes to copy
+   *  @return number of bytes actually copied, 0 if not supported
+   */
+  virtual Uint32 copyFromFile(const char *filename, Uint32 offset, Uint32 length);
+
   /** returns the total number of bytes written to the stream so far
    *  @return total number of bytes written to the stream
    */
@@ -102,6 +102,17 @@ public:
    */
   virtual void flush();
 
+  /** copies a block of data from a plain file to the consumer. Where
+   *  available, copy_file_range() or sendfile() are used so that the data
+   *  is copied by the operating system without passing through a user
+   *  space buffer.
+   *  @param filename name of the file to copy from
+   *  @param offset byte offset of the block from the start of file
+   *  @param length number of bytes to copy
+   *  @return number of bytes actually copied, 0 if not supported
+   */
+  virtual Uint32 copyFromFile(const char *filename, Uint32 offset, Uint32 length);
+
 private:
 
   /// private unimplemented copy constructor
@@ -50,6 +50,18 @@ END_EXTERN_C
  */
 extern OFGlobal<int> dcmZlibCompressionLevel;
 
+/** global flag defining the number of threads used for zlib (deflate)
+ *  compression. If larger than 1, the input is split into blocks of 128 kBytes
+ *  that are compressed concurrently, each block primed with the last 32 kBytes
+ *  of its predecessor as preset dictionary. The result is a single RFC 1951
+ *  bitstream that any inflate implementation can decode, but it is slightly
+ *  larger than and not byte identical to the output of a single thread.
+ *  Default is 1, i.e. the whole stream is compressed by the calling thread.
+ */
+extern OFGlobal<Uint32> dcmZlibCompressionThreads;
+
+class DcmZLibBlockCompressor;
+
 /** zlib compression filter for output streams
  */
 class DcmZLibOutputFilter: public DcmOutputFilter
@@ -104,6 +116,11 @@ public:
    */
   virtual void flush();
 
+  /** writes compressed output that did not fit into the consumer and
+   *  compresses buffered input, as far as the consumer permits.
+   */
+  virtual void writePending();
+
   /** determines the consumer to which the filter is supposed
    *  to write it's output.  Once a consumer for the output filter has 
    *  been defined, it cannot be changed anymore during the lifetime
@@ -155,6 +172,12 @@ private:
    */   
   void compressInputBuffer(OFBool finalize);
 
+  /** writes the compressed output of the block compressor to the
+   *  next filter stage until all output is written or the next
+   *  filter stage becomes full
+   */
+  void flushBlockOutput();
+
   /// pointer to consumer to which compressed output is written
   DcmConsumer *current_;
 
@@ -185,6 +208,11 @@ private:
   /// number of bytes in output ring buffer
   Uint32 outputBufCount_;
 
+  /** block compressor used instead of zstream_ and the ring buffers
+   *  if dcmZlibCompressionThreads is larger than 1, NULL otherwise
+   */
+  DcmZLibBlockCompressor *blocks_;
+
 };
 
 #endif
@@ -38,6 +38,7 @@
 #include "dcmtk/ofstd/ofconsol.h"
 #include "dcmtk/dcmdata/dcvrpobw.h"
 #include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofstring.h"
 
 class DcmCodec;
 class DcmCodecList;
@@ -45,6 +46,7 @@ class DcmStack;
 class DcmPixelSequence;
 class DcmPixelData;
 class DcmRepresentationEntry;
+class DcmItem;
 
 
 class DcmRepresentationParameter
@@ -447,6 +449,44 @@ public:
         const E_TransferSyntax repType,
         const DcmRepresentationParameter * repParam);
 
+    /** determine the number of bytes required to store a single uncompressed
+     *  frame of this pixel data element, i.e. the buffer size for decodeFrame().
+     *  @param dataset pointer to the dataset or item containing this element
+     *  @param frameSize size of a frame in bytes returned in this parameter
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    OFCondition getUncompressedFrameSize(
+        DcmItem * dataset,
+        Uint32 & frameSize) const;
+
+    /** decompress a single frame of this pixel data element into the given
+     *  buffer without decompressing (or even accessing) the other frames.
+     *  If an uncompressed representation exists, the frame is copied from it.
+     *  Otherwise the frame is decompressed from the original representation,
+     *  using the Basic Offset Table or the fragment layout to locate it.
+     *  This element and the dataset are not modified.
+     *  @param dataset pointer to the dataset or item containing this element
+     *  @param frameNo number of the frame, starting with 0 for the first frame
+     *  @param startFragment index of the fragment that contains the first part
+     *    of the compressed frame, 0 if unknown. Upon successful return, the index
+     *    of the first fragment of the next frame is returned in this parameter,
+     *    so that passing it to the next call avoids searching for the next frame.
+     *    Not used for uncompressed pixel data.
+     *  @param buffer pointer to the buffer where the uncompressed frame is stored.
+     *    Samples with more than 8 bits are stored as words in local byte order.
+     *  @param bufSize size of the buffer in bytes, see getUncompressedFrameSize()
+     *  @param decompressedColorModel upon successful return, the photometric
+     *    interpretation of the uncompressed frame is returned in this parameter
+     *  @return EC_Normal if successful, an error code otherwise
+     */
+    OFCondition decodeFrame(
+        DcmItem * dataset,
+        Uint32 frameNo,
+        Uint32 & startFragment,
+        void * buffer,
+        Uint32 bufSize,
+        OFString & decompressedColorModel);
+
     /** set or clear the flag that indicates that this pixel data element will be 
      *  written in uncompressed (defined length) format even if the dataset 
      *  itself is written in a compressed syntax where pixel data is normally 
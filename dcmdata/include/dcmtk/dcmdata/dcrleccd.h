@@ -38,6 +38,9 @@
 #include "dcmtk/ofstd/oftypes.h"
 #include "dcmtk/dcmdata/dccodec.h"  /* for class DcmCodec */
 
+class DcmRLEDecoder;
+class DcmFragmentTable;
+
 /** decoder class for RLE.
  *  This class only supports decompression, it neither implements
  *  encoding nor transcoding.
@@ -69,6 +72,33 @@ public:
     const DcmCodecParameter * cp,
     const DcmStack& objStack) const;
 
+  /** decompresses a single frame from the given pixel sequence and
+   *  stores the result in the given buffer.
+   *  @param fromParam current representation parameter of compressed data, may be NULL
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to the dataset in which the pixel data element is contained
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param startFragment index of the fragment that contains the first part
+   *    of the compressed frame, 0 if unknown. Upon successful return, the index
+   *    of the first fragment of the next frame is returned in this parameter.
+   *  @param buffer pointer to the buffer where the uncompressed frame is stored
+   *  @param bufSize size of the buffer in bytes
+   *  @param decompressedColorModel upon successful return, the photometric
+   *    interpretation of the uncompressed frame is returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrame(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -127,6 +157,35 @@ public:
 
 private:
 
+  /** decompresses a single RLE compressed frame. The samples are stored
+   *  in little endian byte order.
+   *  @param fragments table of the fragments of the compressed pixel sequence
+   *  @param rledecoder RLE decoder for stripes of columns * rows bytes
+   *  @param currentItem index of the first fragment of the frame, upon return
+   *    the index of the fragment following the last one used for this frame
+   *  @param imageData8 pointer to the output buffer for the frame
+   *  @param imageColumns number of columns
+   *  @param imageRows number of rows
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @param imageBytesAllocated number of bytes allocated per sample
+   *  @param imagePlanarConfiguration planar configuration of the output
+   *  @param enableReverseByteOrder true if RLE segments are stored LSB first
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition decompressFrame(
+    const DcmFragmentTable& fragments,
+    DcmRLEDecoder& rledecoder,
+    Uint32& currentItem,
+    Uint8 * imageData8,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 imageBytesAllocated,
+    Uint16 imagePlanarConfiguration,
+    OFBool enableReverseByteOrder);
+
+  friend class DcmRLEFrameDecompressor;
+
   /// private undefined copy constructor
   DcmRLECodecDecoder(const DcmRLECodecDecoder&);
   
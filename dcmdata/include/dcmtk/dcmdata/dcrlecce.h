@@ -70,6 +70,33 @@ public:
     const DcmCodecParameter * cp,
     const DcmStack& objStack) const;
 
+  /** decompresses a single frame from the given pixel sequence and
+   *  stores the result in the given buffer.
+   *  @param fromParam current representation parameter of compressed data, may be NULL
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to the dataset in which the pixel data element is contained
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param startFragment index of the fragment that contains the first part
+   *    of the compressed frame, 0 if unknown. Upon successful return, the index
+   *    of the first fragment of the next frame is returned in this parameter.
+   *  @param buffer pointer to the buffer where the uncompressed frame is stored
+   *  @param bufSize size of the buffer in bytes
+   *  @param decompressedColorModel upon successful return, the photometric
+   *    interpretation of the uncompressed frame is returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrame(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -128,6 +155,30 @@ public:
 
 private: 
 
+  friend class DcmRLEFrameCompressor;
+
+  /** compresses a single frame into an RLE stripe set including the RLE header.
+   *  @param frameData uncompressed pixel data of the frame in little endian byte order
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param samplesPerPixel number of samples per pixel
+   *  @param bytesAllocated number of bytes allocated per sample
+   *  @param planarConfiguration planar configuration of the pixel data
+   *  @param rleData compressed frame returned in this parameter upon success,
+   *    must be deleted by the caller using delete[]
+   *  @param rleSize size of the compressed frame returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition compressFrame(
+    const Uint8 *frameData,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    Uint16 bytesAllocated,
+    Uint16 planarConfiguration,
+    Uint8 *& rleData,
+    Uint32& rleSize);
+
   /// private undefined copy constructor
   DcmRLECodecEncoder(const DcmRLECodecEncoder&);
   
@@ -54,6 +54,8 @@ public:
    *  @param pReverseDecompressionByteOrder flag indicating whether the byte order should
    *    be reversed upon decompression. Needed to correctly decode some incorrectly encoded
    *    images with more than one byte per sample.
+   *  @param pThreadCount maximum number of threads used to compress or
+   *    decompress the frames of a multi-frame image concurrently
    */
   DcmRLECodecParameter(
     OFBool pVerbose = OFFalse,
@@ -61,7 +63,8 @@ public:
     Uint32 pFragmentSize = 0,
     OFBool pCreateOffsetTable = OFTrue,
     OFBool pConvertToSC = OFFalse,
-    OFBool pReverseDecompressionByteOrder = OFFalse);
+    OFBool pReverseDecompressionByteOrder = OFFalse,
+    Uint32 pThreadCount = 1);
 
   /// copy constructor
   DcmRLECodecParameter(const DcmRLECodecParameter& arg);
@@ -128,6 +131,14 @@ public:
     return reverseDecompressionByteOrder;
   }
 
+  /** returns maximum number of threads for frame-level parallelism
+   *  @return maximum number of threads, 1 for sequential processing
+   */
+  Uint32 getThreadCount() const
+  {
+    return threadCount;
+  }
+
 
 private:
 
@@ -153,6 +164,9 @@ private:
   
   /// verbose mode flag. If true, warning messages are printed to console
   OFBool verboseMode;
+
+  /// maximum number of threads used to process the frames of an image
+  Uint32 threadCount;
 };
 
 
@@ -53,11 +53,14 @@ public:
    *  @param pReverseDecompressionByteOrder flag indicating whether the byte order should
    *    be reversed upon decompression. Needed to correctly decode some incorrectly encoded
    *    images with more than one byte per sample.
+   *  @param pThreadCount maximum number of threads used to decompress
+   *    the frames of a multi-frame image concurrently
    */   
   static void registerCodecs(
     OFBool pCreateSOPInstanceUID = OFFalse,
     OFBool pVerbose = OFFalse,
-    OFBool pReverseDecompressionByteOrder = OFFalse);
+    OFBool pReverseDecompressionByteOrder = OFFalse,
+    Uint32 pThreadCount = 1);
 
   /** deregisters decoder.
    *  Attention: Must not be called while other threads might still use
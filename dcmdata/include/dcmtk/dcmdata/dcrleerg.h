@@ -57,13 +57,16 @@ public:
    *  @param pCreateOffsetTable create offset table during image compression?
    *  @param pConvertToSC flag indicating whether image should be converted to 
    *    Secondary Capture upon compression
+   *  @param pThreadCount maximum number of threads used to compress
+   *    the frames of a multi-frame image concurrently
    */
   static void registerCodecs(
     OFBool pCreateSOPInstanceUID = OFFalse,
     OFBool pVerbose = OFFalse,
     Uint32 pFragmentSize = 0,
     OFBool pCreateOffsetTable = OFTrue,
-    OFBool pConvertToSC = OFFalse);
+    OFBool pConvertToSC = OFFalse,
+    Uint32 pThreadCount = 1);
 
   /** deregisters encoder.
    *  Attention: Must not be called while other threads might still use
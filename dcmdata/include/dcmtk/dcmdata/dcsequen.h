@@ -192,8 +192,58 @@ public:
     virtual OFCondition searchErrors(DcmStack &resultStack);      // inout
     virtual OFCondition loadAllDataIntoMemory(void);
 
+    /** specifies whether the items of this sequence and of the sequences
+     *  nested in its items are parsed on demand when read from a stream.
+     *  See DcmItem::setReadSequencesOnDemand() for details.
+     *  @param onDemand true if the items are parsed on demand
+     */
+    void setReadSequencesOnDemand(const OFBool onDemand)
+    {
+        fReadSequencesOnDemand = onDemand;
+    }
+
+    /** returns whether the items are parsed on demand when read
+     *  @return true if the items are parsed on demand, false otherwise
+     */
+    OFBool getReadSequencesOnDemand() const
+    {
+        return fReadSequencesOnDemand;
+    }
+
+    /** returns whether the items of this sequence have been parsed.
+     *  The items of a sequence read with setReadSequencesOnDemand() enabled
+     *  are only parsed when first accessed.
+     *  @return true if the items are available, false if they are still
+     *    waiting to be parsed from the stream
+     */
+    OFBool itemsLoaded() const
+    {
+        return fLoadItems == NULL;
+    }
+
+protected:
+
+    /** parses the items of this sequence from the stream if this has been
+     *  deferred during read(). Called by all methods accessing the items.
+     *  @return status, EC_Normal if successful or nothing to do, an error code otherwise
+     */
+    OFCondition loadItems();
+
 private:
 
+    /** reads items from the stream until the sequence is complete
+     *  or the stream is exhausted. Helper method for read() and loadItems().
+     *  @param inStream stream to read from
+     *  @param xfer transfer syntax of the items
+     *  @param glenc handling of group length elements
+     *  @param maxReadLength maximum read length for element values
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition readItems(DcmInputStream &inStream,
+                          const E_TransferSyntax xfer,
+                          const E_GrpLenEncoding glenc,
+                          const Uint32 maxReadLength);
+
   /* static helper method used in writeSignatureFormat().
    * This function resembles DcmObject::writeTagAndLength()
    * but only writes the tag, VR and reserved field.
@@ -213,6 +263,23 @@ private:
    */
   OFBool readAsUN_;
 
+  /// true if the items are parsed on demand when read
+  OFBool fReadSequencesOnDemand;
+
+  /** stream factory positioned at the first item if parsing of the items
+   *  has been deferred, NULL otherwise
+   */
+  DcmInputStreamFactory *fLoadItems;
+
+  /// transfer syntax used for parsing the deferred items
+  E_TransferSyntax fLoadXfer;
+
+  /// group length encoding used for parsing the deferred items
+  E_GrpLenEncoding fLoadGlenc;
+
+  /// maximum read length used for parsing the deferred items
+  Uint32 fLoadMaxReadLength;
+
 };
 
 
@@ -38,6 +38,12 @@
 #include "dcmtk/dcmdata/dcuid.h"     /* for dcmGenerateUniqueIdentifer()*/
 #include "dcmtk/dcmdata/dcitem.h"    /* for class DcmItem */
 #include "dcmtk/dcmdata/dcsequen.h"  /* for DcmSequenceOfItems */
+#include "dcmtk/dcmdata/dcpixseq.h"  /* for DcmPixelSequence */
+#include "dcmtk/dcmdata/dcpxitem.h"  /* for DcmPixelItem */
+#include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary() */
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
 
 // static member variables
 OFList<DcmCodecList *> DcmCodecList::registeredCodecs;
@@ -227,6 +233,61 @@ OFCondition DcmCodec::updateImageType(DcmItem *dataset)
   return dataset->putAndInsertString(DCM_ImageType, imageType.c_str(), OFTrue);
 }
 
+
+OFCondition DcmCodec::determineStartFragment(
+  Uint32 frameNo,
+  Sint32 numberOfFrames,
+  DcmPixelSequence * fromPixSeq,
+  Uint32& currentItem)
+{
+  if (fromPixSeq == NULL) return EC_IllegalCall;
+  Uint32 numberOfFragments = fromPixSeq->card();
+  if ((numberOfFrames < 1) || (numberOfFragments < 2) || (frameNo >= OFstatic_cast(Uint32, numberOfFrames)))
+    return EC_IllegalCall;
+
+  // the first frame always starts with the first fragment after the offset table
+  if (frameNo == 0)
+  {
+    currentItem = 1;
+    return EC_Normal;
+  }
+
+  // one fragment per frame
+  if (numberOfFragments == OFstatic_cast(Uint32, numberOfFrames) + 1)
+  {
+    currentItem = frameNo + 1;
+    return EC_Normal;
+  }
+
+  // evaluate the Basic Offset Table
+  DcmPixelItem *pixItem = NULL;
+  Uint8 *rawOffsetTable = NULL;
+  OFCondition result = fromPixSeq->getItem(pixItem, 0);
+  if (result.bad()) return result;
+  Uint32 tableLength = pixItem->getLength();
+  if (tableLength < 4 * OFstatic_cast(Uint32, numberOfFrames)) return EC_IllegalCall; // no (usable) offset table
+  result = pixItem->getUint8Array(rawOffsetTable);
+  if (result.bad() || (rawOffsetTable == NULL)) return EC_IllegalCall;
+
+  // offsets are stored in little endian byte order
+  Uint32 offset;
+  memcpy(&offset, rawOffsetTable + 4 * frameNo, sizeof(Uint32));
+  swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, &offset, sizeof(Uint32), sizeof(Uint32));
+
+  // offsets refer to the first byte of the item tag of the first fragment after the table
+  Uint32 position = 0;
+  Uint32 item = 1;
+  while ((position < offset) && (item < numberOfFragments))
+  {
+    result = fromPixSeq->getItem(pixItem, item++);
+    if (result.bad()) return result;
+    position += 8 + pixItem->getLength();
+  }
+  if ((position != offset) || (item >= numberOfFragments)) return EC_CorruptedData;
+  currentItem = item;
+  return EC_Normal;
+}
+
 /* --------------------------------------------------------------- */
 
 DcmCodecList::DcmCodecList(
@@ -378,6 +439,46 @@ OFCondition DcmCodecList::decode(
   return result;
 }
 
+OFCondition DcmCodecList::decodeFrame(
+    const DcmXfer & fromType,
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel)
+{
+#ifdef _REENTRANT
+  if (! codecLock.initialized()) return EC_IllegalCall; // should never happen
+#endif
+  OFCondition result = EC_CannotChangeRepresentation;
+
+  // acquire read lock on codec list.  Will block if some write lock is currently active.
+#ifdef _REENTRANT
+  if (0 == codecLock.rdlock())
+  {
+#endif
+    E_TransferSyntax fromXfer = fromType.getXfer();
+    OFListIterator(DcmCodecList *) first = registeredCodecs.begin();
+    OFListIterator(DcmCodecList *) last = registeredCodecs.end();
+    while (first != last)
+    {
+      if ((*first)->codec->canChangeCoding(fromXfer, EXS_LittleEndianExplicit))
+      {
+        result = (*first)->codec->decodeFrame(fromParam, fromPixSeq, (*first)->codecParameter,
+                   dataset, frameNo, startFragment, buffer, bufSize, decompressedColorModel);
+        first = last;
+      } else ++first;
+    }
+#ifdef _REENTRANT
+    codecLock.unlock();
+  } else result = EC_IllegalCall;
+#endif
+  return result;
+}
+
 OFCondition DcmCodecList::encode(
     const E_TransferSyntax fromRepType,
     const DcmRepresentationParameter * fromParam,
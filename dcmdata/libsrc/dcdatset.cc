@@ -52,6 +52,7 @@
 #include "dcmtk/dcmdata/dcostrmf.h"    /* for class DcmOutputFileStream */
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
 #include "dcmtk/dcmdata/dcistrmf.h"    /* for class DcmInputFileStream */
+#include "dcmtk/dcmdata/dcistrmm.h"    /* for class DcmInputMappedFileStream */
 
 
 // ********************************
@@ -438,17 +439,29 @@ OFCondition DcmDataset::writeSignatureFormat(DcmOutputStream &outStream,
 OFCondition DcmDataset::loadFile(const char *filename,
                                  const E_TransferSyntax readXfer,
                                  const E_GrpLenEncoding groupLength,
-                                 const Uint32 maxReadLength)
+                                 const Uint32 maxReadLength,
+                                 const OFBool readSequencesOnDemand,
+                                 const DcmTagKey &stopParsingAtElement)
 {
     OFCondition l_error = EC_IllegalParameter;
     /* check parameters first */
     if ((filename != NULL) && (strlen(filename) > 0))
     {
-        /* open file for input */
-        DcmInputFileStream fileStream(filename);
-
+        /* open file for input, map it into memory if possible */
+        DcmInputStream *fileStream = NULL;
+        if (dcmUseMemoryMappedFiles.get())
+        {
+            fileStream = new DcmInputMappedFileStream(filename);
+            if (!fileStream->good())
+            {
+                delete fileStream;
+                fileStream = NULL;
+            }
+        }
+        if (fileStream == NULL)
+            fileStream = new DcmInputFileStream(filename);
         /* check stream status */
-        l_error = fileStream.status();
+        l_error = fileStream->status();
 
         if (l_error.good())
         {
@@ -456,12 +469,15 @@ OFCondition DcmDataset::loadFile(const char *filename,
             l_error = clear();
             if (l_error.good())
             {
+                setReadSequencesOnDemand(readSequencesOnDemand);
+                setStopParsingAtElement(stopParsingAtElement);
                 /* read data from file */
                 transferInit();
-                l_error = read(fileStream, readXfer, groupLength, maxReadLength);
+                l_error = read(*fileStream, readXfer, groupLength, maxReadLength);
                 transferEnd();
             }
         }
+        delete fileStream;
     }
     return l_error;
 }
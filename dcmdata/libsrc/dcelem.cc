@@ -46,6 +46,7 @@
 #include "dcmtk/dcmdata/dcswap.h"
 #include "dcmtk/dcmdata/dcdebug.h"
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
+#include "dcmtk/dcmdata/dcistrmm.h"    /* for class DcmMappedFile */
 #include "dcmtk/dcmdata/dcostrma.h"    /* for class DcmOutputStream */
 
 
@@ -59,7 +60,12 @@ DcmElement::DcmElement(const DcmTag &tag,
   : DcmObject(tag, len),
     fByteOrder(gLocalByteOrder),
     fLoadValue(NULL),
-    fValue(NULL)
+    fValue(NULL),
+    fMappedFile(NULL),
+    fSourceStream(NULL),
+    fSourcePosition(0),
+    fSourceBuffer(NULL),
+    fSourceBufferSize(0)
 {
 }
 
@@ -68,7 +74,12 @@ DcmElement::DcmElement(const DcmElement &elem)
   : DcmObject(elem),
     fByteOrder(elem.fByteOrder),
     fLoadValue(NULL),
-    fValue(NULL)
+    fValue(NULL),
+    fMappedFile(NULL),
+    fSourceStream(NULL),
+    fSourcePosition(0),
+    fSourceBuffer(NULL),
+    fSourceBufferSize(0)
 {
     if (elem.fValue)
     {
@@ -105,6 +116,11 @@ DcmElement::DcmElement(const DcmElement &elem)
 
 DcmElement &DcmElement::operator=(const DcmElement &obj)
 {
+    if (this != &obj)
+    {
+        releaseValueSource();
+        deleteValue();
+    }
     DcmObject::operator=(obj);
     fByteOrder = obj.fByteOrder;
     fLoadValue = NULL;
@@ -148,7 +164,8 @@ DcmElement &DcmElement::operator=(const DcmElement &obj)
 
 DcmElement::~DcmElement()
 {
-    delete[] fValue;
+    releaseValueSource();
+    deleteValue();
     delete fLoadValue;
 }
 
@@ -159,8 +176,8 @@ DcmElement::~DcmElement()
 OFCondition DcmElement::clear()
 {
     errorFlag = EC_Normal;
-    delete[] fValue;
-    fValue = NULL;
+    releaseValueSource();
+    deleteValue();
     delete fLoadValue;
     fLoadValue = NULL;
     Length = 0;
@@ -191,6 +208,9 @@ OFCondition DcmElement::detachValueField(OFBool copy)
     OFCondition l_error = EC_Normal;
     if (Length != 0)
     {
+        /* the caller must be able to delete the value */
+        if (fMappedFile)
+            l_error = unmapValue();
         if (copy)
         {
             if (!fValue)
@@ -417,6 +437,9 @@ OFCondition DcmElement::loadAllDataIntoMemory()
     errorFlag = EC_Normal;
     if (!fValue && (Length != 0))
         errorFlag = loadValue();
+    /* the value must no longer depend on the file, which may be overwritten */
+    else if (fMappedFile)
+        errorFlag = unmapValue();
     return errorFlag;
 }
 
@@ -592,7 +615,7 @@ OFCondition DcmElement::changeValue(const void *value,
                 memcpy(newValue, fValue, size_t(Length));
                 // set parameter value in the extension
                 memcpy(&newValue[Length], OFstatic_cast(const Uint8 *, value), size_t(num));
-                delete[] fValue;
+                deleteValue();
                 fValue = newValue;
                 Length += num;
             }
@@ -746,9 +769,7 @@ OFCondition DcmElement::putValue(const void * newValue,
 {
     errorFlag = EC_Normal;
 
-    if (fValue)
-        delete[] fValue;
-    fValue = NULL;
+    deleteValue();
 
     if (fLoadValue)
         delete fLoadValue;
@@ -782,9 +803,7 @@ OFCondition DcmElement::putValue(const void * newValue,
 OFCondition DcmElement::createEmptyValue(const Uint32 length)
 {
     errorFlag = EC_Normal;
-    if (fValue)
-        delete[] fValue;
-    fValue = NULL;
+    deleteValue();
     if (fLoadValue)
         delete fLoadValue;
     fLoadValue = NULL;
@@ -843,7 +862,11 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
                 /* a DcmInputStreamFactory object that enables us to read this element's value later. */
                 /* This new object will be stored (together with the position where we have to start */
                 /* reading the value) in the member variable fLoadValue. */
-                if (Length > maxReadLength)
+                /* if there is already a value for this element, delete this value */
+                deleteValue();
+                /* If the stream reads from a memory mapped file, the value is not read at all */
+                /* but refers to the mapped file instead. */
+                if ((Length > maxReadLength) && !mapValue(inStream))
                 {
                     /* try to create a stream factory to read the value later */
                     delete fLoadValue;
@@ -863,14 +886,12 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
                         }
                     }
                 }
-                /* if there is already a value for this element, delete this value */
-                delete[] fValue;
                 /* set the transfer state to ERW_inWork */
                 fTransferState = ERW_inWork;
             }
-            /* if the transfer state is ERW_inWork and we are not supposed */
-            /* to read this element's value later, read the value now */
-            if (fTransferState == ERW_inWork && !fLoadValue)
+            /* if the transfer state is ERW_inWork and we are not supposed to read */
+            /* this element's value later (or have mapped it), read the value now */
+            if (fTransferState == ERW_inWork && !fLoadValue && (fTransferredBytes < Length))
                 errorFlag = loadValue(&inStream);
             /* if the amount of transferred bytes equals the Length of this element */
             /* or the object which contains information to read the value of this */
@@ -888,6 +909,69 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
 // ********************************
 
 
+void DcmElement::deleteValue()
+{
+    if (fMappedFile)
+    {
+        fMappedFile->release();
+        fMappedFile = NULL;
+    }
+    else
+        delete[] fValue;
+    fValue = NULL;
+}
+
+
+OFBool DcmElement::mapValue(DcmInputStream &inStream)
+{
+    const DcmVR vr(getVR());
+    const size_t valueWidth = vr.getValueWidth();
+    if ((Length & 1) || vr.isaString() || ((valueWidth > 1) && (fByteOrder != gLocalByteOrder)))
+        return OFFalse;
+    DcmMappedFile *mapping = NULL;
+    Uint8 *data = inStream.mapData(Length, mapping);
+    if (data == NULL)
+        return OFFalse;
+    if ((valueWidth <= 1) || (OFreinterpret_cast(size_t, data) % valueWidth == 0))
+    {
+        mapping->addReference();
+        fMappedFile = mapping;
+        fValue = data;
+    } else {
+        /* misaligned values are copied, just as if they had been read */
+        fValue = newValueField();
+        if (fValue)
+            memcpy(fValue, data, size_t(Length));
+        else
+            errorFlag = EC_MemoryExhausted;
+    }
+    fTransferredBytes = Length;
+    postLoadValue();
+    return OFTrue;
+}
+
+
+OFCondition DcmElement::unmapValue()
+{
+    OFCondition l_error = EC_Normal;
+    if (fMappedFile)
+    {
+        Uint8 *newValue = newValueField();
+        if (newValue)
+        {
+            memcpy(newValue, fValue, size_t(Length));
+            deleteValue();
+            fValue = newValue;
+        } else
+            l_error = EC_MemoryExhausted;
+    }
+    return l_error;
+}
+
+
+// ********************************
+
+
 void DcmElement::swapValueField(size_t valueWidth)
 {
     if (Length != 0)
@@ -908,6 +992,14 @@ void DcmElement::transferInit()
 {
     DcmObject::transferInit();
     fTransferredBytes = 0;
+    releaseValueSource();
+}
+
+
+void DcmElement::transferEnd()
+{
+    DcmObject::transferEnd();
+    releaseValueSource();
 }
 
 
@@ -931,9 +1023,14 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
         {
             /* create an object that represents the transfer syntax */
             DcmXfer outXfer(oxfer);
+            /* if the value has not been loaded yet and can be written as it is, */
+            /* copy it from the stream it has been read from instead of loading it */
+            const OFBool fromSource = canWriteValueFromSource(outXfer.getByteOrder());
             /* get this element's value. Mind the byte ordering (little */
             /* or big endian) of the transfer syntax which shall be used */
-            Uint8 *value = OFstatic_cast(Uint8 *, getValue(outXfer.getByteOrder()));
+            Uint8 *value = NULL;
+            if (!fromSource)
+                value = OFstatic_cast(Uint8 *, getValue(outXfer.getByteOrder()));
             /* if this element's transfer state is ERW_init (i.e. it has not yet been written to */
             /* the stream) and if the outstream provides enough space for tag and length information */
             /* write tag and length information to it, do something */
@@ -947,7 +1044,7 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
                     (outStream.avail() >= getTagAndLengthSize(oxfer)))
                 {
                     /* if there is no value, Length (member variable) shall be set to 0 */
-                    if (!value) Length = 0;
+                    if (!value && !fromSource) Length = 0;
                     /* remember how many bytes have been written to the stream, currently none so far */
                     Uint32 writtenBytes = 0;
                     /* write tag and length information (and possibly also data type information) to the stream, */
@@ -985,6 +1082,9 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
                 else if (errorFlag.good())
                     errorFlag = EC_StreamNotifyClient;
             }
+            /* otherwise copy the value from its source if this element's transfer state is ERW_inWork */
+            else if (fromSource && fTransferState == ERW_inWork)
+                errorFlag = writeValueFromSource(outStream);
         }
     }
     /* return result value */
@@ -992,6 +1092,106 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
 }
 
 
+OFBool DcmElement::canWriteValueFromSource(const E_ByteOrder outByteOrder) const
+{
+    /* an odd length value would have to be padded, see postLoadValue() */
+    if (fValue || !fLoadValue || (Length == 0) || (Length & 1))
+        return OFFalse;
+    /* single byte values never need to be swapped */
+    return (fByteOrder == outByteOrder) || (Tag.getVR().getValueWidth() == 1);
+}
+
+
+OFCondition DcmElement::writeValueFromSource(DcmOutputStream &outStream)
+{
+    OFCondition result = EC_Normal;
+    /* let the operating system copy the value if both source and destination are plain files */
+    OFString filename;
+    Uint32 offset = 0;
+    if (fLoadValue->getFileAndOffset(filename, offset))
+    {
+        fTransferredBytes += outStream.copyFromFile(filename.c_str(), offset + fTransferredBytes, Length - fTransferredBytes);
+        result = outStream.status();
+    }
+    /* otherwise copy the remaining bytes through a buffer, but */
+    /* never read more than the output stream accepts, the data could not be put back */
+    Uint32 avail = outStream.avail();
+    while (result.good() && (fTransferredBytes < Length) && (avail > 0))
+    {
+        /* the source stream is kept open between calls, a new one is only */
+        /* needed for the first block or if data has been lost on its way */
+        if (fSourceStream && (fSourcePosition > fTransferredBytes))
+        {
+            delete fSourceStream;
+            fSourceStream = NULL;
+        }
+        if (fSourceStream == NULL)
+        {
+            fSourceStream = fLoadValue->create();
+            fSourcePosition = 0;
+            result = fSourceStream->status();
+        }
+        while (result.good() && (fSourcePosition < fTransferredBytes))
+        {
+            Uint32 len = fSourceStream->skip(fTransferredBytes - fSourcePosition);
+            if (len == 0)
+                result = EC_InvalidStream;
+            fSourcePosition += len;
+        }
+        if (result.good())
+        {
+            /* a file consumer claims to accept any amount of data */
+            const Uint32 maxBufferSize = 1048576;
+            Uint32 len = Length - fTransferredBytes;
+            if (len > avail) len = avail;
+            if (len > maxBufferSize) len = maxBufferSize;
+            if (len > fSourceBufferSize)
+            {
+                delete[] fSourceBuffer;
+                fSourceBuffer = new Uint8[len];
+                fSourceBufferSize = len;
+            }
+            len = fSourceStream->read(fSourceBuffer, len);
+            fSourcePosition += len;
+            if (len == 0)
+            {
+                /* premature end of stream */
+                result = fSourceStream->status();
+                if (result.good()) result = EC_InvalidStream;
+            }
+            else
+            {
+                fTransferredBytes += outStream.write(fSourceBuffer, len);
+                result = outStream.status();
+                avail = outStream.avail();
+            }
+        }
+    }
+    if (result.good())
+    {
+        if (fTransferredBytes == Length)
+        {
+            fTransferState = ERW_ready;
+            releaseValueSource();
+        }
+        else
+            result = EC_StreamNotifyClient;
+    }
+    return result;
+}
+
+
+void DcmElement::releaseValueSource()
+{
+    delete fSourceStream;
+    fSourceStream = NULL;
+    fSourcePosition = 0;
+    delete[] fSourceBuffer;
+    fSourceBuffer = NULL;
+    fSourceBufferSize = 0;
+}
+
+
 OFCondition DcmElement::writeSignatureFormat(DcmOutputStream &outStream,
                                              const E_TransferSyntax oxfer,
                                              const E_EncodingType enctype)
@@ -58,6 +58,7 @@
 #include "dcmtk/dcmdata/dcostrmf.h"    /* for class DcmOutputFileStream */
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
 #include "dcmtk/dcmdata/dcistrmf.h"    /* for class DcmInputFileStream */
+#include "dcmtk/dcmdata/dcistrmm.h"    /* for class DcmInputMappedFileStream */
 
 
 // ********************************
@@ -707,36 +708,56 @@ OFCondition DcmFileFormat::loadFile(const char *fileName,
                                     const E_TransferSyntax readXfer,
                                     const E_GrpLenEncoding groupLength,
                                     const Uint32 maxReadLength,
-                                    const E_FileReadMode readMode)
+                                    const E_FileReadMode readMode,
+                                    const OFBool readSequencesOnDemand,
+                                    const DcmTagKey &stopParsingAtElement)
 {
     if (readMode == ERM_dataset)
-        return getDataset()->loadFile(fileName, readXfer, groupLength, maxReadLength);
+        return getDataset()->loadFile(fileName, readXfer, groupLength, maxReadLength, readSequencesOnDemand,
+                                      stopParsingAtElement);
 
     OFCondition l_error = EC_IllegalParameter;
     /* check parameters first */
     if ((fileName != NULL) && (strlen(fileName) > 0))
     {
-        /* open file for input */
-        DcmInputFileStream fileStream(fileName);
+        /* open file for input, map it into memory if possible */
+        DcmInputStream *fileStream = NULL;
+        if (dcmUseMemoryMappedFiles.get())
+        {
+            fileStream = new DcmInputMappedFileStream(fileName);
+            if (!fileStream->good())
+            {
+                delete fileStream;
+                fileStream = NULL;
+            }
+        }
+        if (fileStream == NULL)
+            fileStream = new DcmInputFileStream(fileName);
         /* check stream status */
-        l_error = fileStream.status();
+        l_error = fileStream->status();
         if (l_error.good())
         {
             /* clear this object */
             l_error = clear();
             if (l_error.good())
             {
+                if (getDataset())
+                {
+                    getDataset()->setReadSequencesOnDemand(readSequencesOnDemand);
+                    getDataset()->setStopParsingAtElement(stopParsingAtElement);
+                }
                 /* save old value */
                 const E_FileReadMode oldMode = FileReadMode;
                 FileReadMode = readMode;
                 /* read data from file */
                 transferInit();
-                l_error = read(fileStream, readXfer, groupLength, maxReadLength);
+                l_error = read(*fileStream, readXfer, groupLength, maxReadLength);
                 transferEnd();
                 /* restore old value */
                 FileReadMode = oldMode;
             }
         }
+        delete fileStream;
     }
     return l_error;
 }
@@ -0,0 +1,213 @@
+/*
+ *
+ *  Copyright (C) 1994-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  agent
+ *
+ *  Purpose: classes DcmFrameProcessor, DcmFrameWorkerPool, DcmFragmentTable,
+ *    helpers for codecs that process the frames of an image concurrently.
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dcfrmpol.h"
+#include "dcmtk/dcmdata/dcpixseq.h"  /* for class DcmPixelSequence */
+#include "dcmtk/dcmdata/dcpxitem.h"  /* for class DcmPixelItem */
+#include "dcmtk/dcmdata/dcerror.h"   /* for error codes */
+
+
+/** worker thread of a DcmFrameWorkerPool
+ */
+class DcmFrameWorker: public OFThread
+{
+public:
+
+  /** constructor.
+   *  @param pool pool that hands out the frames
+   */
+  DcmFrameWorker(DcmFrameWorkerPool& pool)
+  : OFThread()
+  , pool_(pool)
+  {
+  }
+
+  /// destructor
+  virtual ~DcmFrameWorker() {}
+
+private:
+
+  /// private undefined copy constructor
+  DcmFrameWorker(const DcmFrameWorker&);
+
+  /// private undefined copy assignment operator
+  DcmFrameWorker& operator=(const DcmFrameWorker&);
+
+  /// thread entry point
+  virtual void run()
+  {
+    pool_.work();
+  }
+
+  /// pool that hands out the frames
+  DcmFrameWorkerPool& pool_;
+};
+
+/* ======================================================================= */
+
+DcmFrameWorkerPool::DcmFrameWorkerPool(DcmFrameProcessor& processor, Uint32 numberOfThreads)
+: processor_(processor)
+, numberOfThreads_(numberOfThreads)
+, nextFrame_(0)
+, endFrame_(0)
+, failedFrame_(0)
+, result_(EC_Normal)
+, mutex_()
+{
+}
+
+DcmFrameWorkerPool::~DcmFrameWorkerPool()
+{
+}
+
+OFCondition DcmFrameWorkerPool::run(Uint32 firstFrame, Uint32 numberOfFrames)
+{
+  nextFrame_ = firstFrame;
+  endFrame_ = firstFrame + numberOfFrames;
+  failedFrame_ = endFrame_;
+  result_ = EC_Normal;
+
+  // the calling thread is one of the workers
+  Uint32 numberOfWorkers = (numberOfThreads_ < numberOfFrames) ? numberOfThreads_ : numberOfFrames;
+  DcmFrameWorker **workers = NULL;
+  Uint32 started = 0;
+  if (numberOfWorkers > 1)
+  {
+    workers = new DcmFrameWorker *[numberOfWorkers - 1];
+    for (Uint32 i = 0; i < numberOfWorkers - 1; ++i)
+    {
+      workers[started] = new DcmFrameWorker(*this);
+      if (workers[started]->start() == 0) ++started;
+      else
+      {
+        // threads not supported or resources exhausted, continue with fewer threads
+        delete workers[started];
+        break;
+      }
+    }
+  }
+
+  work();
+
+  for (Uint32 i = 0; i < started; ++i)
+  {
+    workers[i]->join();
+    delete workers[i];
+  }
+  delete[] workers;
+  return result_;
+}
+
+void DcmFrameWorkerPool::work()
+{
+  while (1)
+  {
+    mutex_.lock();
+    if ((nextFrame_ >= endFrame_) || (failedFrame_ < endFrame_))
+    {
+      mutex_.unlock();
+      break;
+    }
+    Uint32 frameNo = nextFrame_++;
+    mutex_.unlock();
+
+    OFCondition cond = processor_.processFrame(frameNo);
+    if (cond.bad())
+    {
+      mutex_.lock();
+      if (frameNo < failedFrame_)
+      {
+        failedFrame_ = frameNo;
+        result_ = cond;
+      }
+      mutex_.unlock();
+    }
+  }
+}
+
+/* ======================================================================= */
+
+DcmFragmentTable::DcmFragmentTable()
+: items_(NULL)
+, count_(0)
+{
+}
+
+DcmFragmentTable::~DcmFragmentTable()
+{
+  delete[] items_;
+}
+
+OFCondition DcmFragmentTable::create(DcmPixelSequence *pixSeq, OFBool loadValues)
+{
+  delete[] items_;
+  items_ = NULL;
+  count_ = 0;
+  if (pixSeq == NULL) return EC_IllegalCall;
+
+  Uint32 numberOfItems = pixSeq->card();
+  items_ = new DcmPixelItem *[numberOfItems > 0 ? numberOfItems : 1];
+  OFCondition result = EC_Normal;
+  DcmPixelItem *item = NULL;
+  Uint8 *data = NULL;
+  for (Uint32 i = 0; (i < numberOfItems) && result.good(); ++i)
+  {
+    result = pixSeq->getItem(item, i);
+    if (result.good())
+    {
+      if (loadValues) result = item->getUint8Array(data);
+      items_[count_++] = item;
+    }
+  }
+  return result;
+}
+
+OFCondition DcmFragmentTable::getItem(DcmPixelItem *&item, Uint32 num) const
+{
+  if (num >= count_)
+  {
+    item = NULL;
+    return EC_IllegalCall;
+  }
+  item = items_[num];
+  return EC_Normal;
+}
+
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
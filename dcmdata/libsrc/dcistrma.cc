@@ -90,6 +90,13 @@ Uint32 DcmInputStream::tell() const
   return tell_;
 }
 
+Uint8 *DcmInputStream::mapData(Uint32 length, DcmMappedFile *& mapping)
+{
+  Uint8 *result = current_->mapData(length, mapping);
+  if (result) tell_ += length;
+  return result;
+}
+
 void DcmInputStream::mark()
 {
   mark_ = tell_;
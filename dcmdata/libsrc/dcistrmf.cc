@@ -174,6 +174,7 @@ DcmInputFileStream::DcmInputFileStream(const char *filename, Uint32 offset)
 : DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
 , producer_(filename, offset)
 , filename_()
+, offset_(offset)
 {
   if (filename) filename_ = filename;
 }
@@ -188,7 +189,7 @@ DcmInputStreamFactory *DcmInputFileStream::newFactory() const
   if (currentProducer() == &producer_)
   {
     // no filter installed, can create factory object
-    result = new DcmInputFileStreamFactory(filename_.c_str(), tell());
+    result = new DcmInputFileStreamFactory(filename_.c_str(), offset_ + tell());
   }
   return result;
 }
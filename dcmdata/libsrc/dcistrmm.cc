@@ -0,0 +1,300 @@
+/*
+ *
+ *  Copyright (C) 1994-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  agent
+ *
+ *  Purpose: DcmInputMappedFileStream and related classes,
+ *    implements streamed input from memory mapped files.
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dcistrmm.h"
+#include "dcmtk/dcmdata/dcerror.h"
+
+#define INCLUDE_CSTRING
+#define INCLUDE_CERRNO
+#define INCLUDE_UNISTD
+#include "dcmtk/ofstd/ofstdinc.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+END_EXTERN_C
+
+
+OFGlobal<OFBool> dcmUseMemoryMappedFiles(OFFalse);
+
+/* ======================================================================= */
+
+DcmMappedFile::DcmMappedFile(Uint8 *data, Uint32 size)
+: data_(data)
+, size_(size)
+, references_(1)
+, mutex_()
+{
+}
+
+DcmMappedFile::~DcmMappedFile()
+{
+#ifdef HAVE_SYS_MMAN_H
+  if (data_) munmap(OFreinterpret_cast(char *, data_), size_);
+#endif
+}
+
+DcmMappedFile *DcmMappedFile::create(const char *filename, OFCondition& status)
+{
+  DcmMappedFile *result = NULL;
+#ifdef HAVE_SYS_MMAN_H
+  status = EC_Normal;
+  int fd = open(filename, O_RDONLY);
+  struct stat st;
+  if ((fd < 0) || (fstat(fd, &st) != 0))
+  {
+    const char *text = strerror(errno);
+    if (text == NULL) text = "(unknown error code)";
+    status = makeOFCondition(OFM_dcmdata, 18, OF_error, text);
+  }
+  else if (! S_ISREG(st.st_mode))
+  {
+    /* pipes and devices cannot be mapped */
+    status = makeOFCondition(OFM_dcmdata, 18, OF_error, "not a regular file");
+  }
+  else if (OFstatic_cast(unsigned long, st.st_size) != OFstatic_cast(Uint32, st.st_size))
+  {
+    /* stream positions are limited to 32 bits */
+    status = makeOFCondition(OFM_dcmdata, 18, OF_error, "file too large");
+  }
+  else if (st.st_size == 0)
+  {
+    result = new DcmMappedFile(NULL, 0);
+  }
+  else
+  {
+    /* private writable mapping, modifications are copied on write and never reach the file */
+    void *data = mmap(NULL, OFstatic_cast(size_t, st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      const char *text = strerror(errno);
+      if (text == NULL) text = "(unknown error code)";
+      status = makeOFCondition(OFM_dcmdata, 18, OF_error, text);
+    }
+    else result = new DcmMappedFile(OFstatic_cast(Uint8 *, data), OFstatic_cast(Uint32, st.st_size));
+  }
+  /* the mapping remains valid after the file has been closed */
+  if (fd >= 0) close(fd);
+#else
+  status = makeOFCondition(OFM_dcmdata, 18, OF_error, "memory mapped files not supported");
+#endif
+  return result;
+}
+
+void DcmMappedFile::addReference()
+{
+  mutex_.lock();
+  ++references_;
+  mutex_.unlock();
+}
+
+void DcmMappedFile::release()
+{
+  mutex_.lock();
+  unsigned long remaining = --references_;
+  mutex_.unlock();
+  if (remaining == 0) delete this;
+}
+
+/* ======================================================================= */
+
+DcmMappedFileProducer::DcmMappedFileProducer(const char *filename, Uint32 offset)
+: DcmProducer()
+, file_(NULL)
+, status_(EC_Normal)
+, position_(offset)
+{
+  file_ = DcmMappedFile::create(filename, status_);
+  if (file_ && (offset > file_->size())) status_ = EC_InvalidStream;
+}
+
+DcmMappedFileProducer::DcmMappedFileProducer(DcmMappedFile *file, Uint32 offset)
+: DcmProducer()
+, file_(file)
+, status_(EC_Normal)
+, position_(offset)
+{
+  if (file_)
+  {
+    file_->addReference();
+    if (offset > file_->size()) status_ = EC_InvalidStream;
+  }
+  else status_ = EC_IllegalParameter;
+}
+
+DcmMappedFileProducer::~DcmMappedFileProducer()
+{
+  if (file_) file_->release();
+}
+
+OFBool DcmMappedFileProducer::good() const
+{
+  return status_.good();
+}
+
+OFCondition DcmMappedFileProducer::status() const
+{
+  return status_;
+}
+
+OFBool DcmMappedFileProducer::eos() const
+{
+  if (status_.good()) return (position_ == file_->size()); else return OFTrue;
+}
+
+Uint32 DcmMappedFileProducer::avail() const
+{
+  if (status_.good()) return file_->size() - position_; else return 0;
+}
+
+Uint32 DcmMappedFileProducer::read(void *buf, Uint32 buflen)
+{
+  Uint32 result = 0;
+  if (status_.good() && buf && buflen)
+  {
+    result = (file_->size() - position_ < buflen) ? (file_->size() - position_) : buflen;
+    memcpy(buf, file_->data() + position_, OFstatic_cast(size_t, result));
+    position_ += result;
+  }
+  return result;
+}
+
+Uint32 DcmMappedFileProducer::skip(Uint32 skiplen)
+{
+  Uint32 result = 0;
+  if (status_.good() && skiplen)
+  {
+    result = (file_->size() - position_ < skiplen) ? (file_->size() - position_) : skiplen;
+    position_ += result;
+  }
+  return result;
+}
+
+void DcmMappedFileProducer::putback(Uint32 num)
+{
+  if (status_.good() && num)
+  {
+    if (num <= position_) position_ -= num;
+    else status_ = EC_PutbackFailed; // tried to putback before start of file
+  }
+}
+
+Uint8 *DcmMappedFileProducer::mapData(Uint32 length, DcmMappedFile *& mapping)
+{
+  Uint8 *result = NULL;
+  if (status_.good() && length && (file_->size() - position_ >= length))
+  {
+    result = file_->data() + position_;
+    mapping = file_;
+    position_ += length;
+  }
+  return result;
+}
+
+/* ======================================================================= */
+
+DcmInputMappedFileStreamFactory::DcmInputMappedFileStreamFactory(DcmMappedFile *file, Uint32 offset)
+: DcmInputStreamFactory()
+, file_(file)
+, offset_(offset)
+{
+  if (file_) file_->addReference();
+}
+
+DcmInputMappedFileStreamFactory::DcmInputMappedFileStreamFactory(const DcmInputMappedFileStreamFactory& arg)
+: DcmInputStreamFactory(arg)
+, file_(arg.file_)
+, offset_(arg.offset_)
+{
+  if (file_) file_->addReference();
+}
+
+DcmInputMappedFileStreamFactory::~DcmInputMappedFileStreamFactory()
+{
+  if (file_) file_->release();
+}
+
+DcmInputStream *DcmInputMappedFileStreamFactory::create() const
+{
+  return new DcmInputMappedFileStream(file_, offset_);
+}
+
+/* ======================================================================= */
+
+DcmInputMappedFileStream::DcmInputMappedFileStream(const char *filename, Uint32 offset)
+: DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
+, producer_(filename, offset)
+, offset_(offset)
+{
+}
+
+DcmInputMappedFileStream::DcmInputMappedFileStream(DcmMappedFile *file, Uint32 offset)
+: DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
+, producer_(file, offset)
+, offset_(offset)
+{
+}
+
+DcmInputMappedFileStream::~DcmInputMappedFileStream()
+{
+}
+
+DcmInputStreamFactory *DcmInputMappedFileStream::newFactory() const
+{
+  DcmInputStreamFactory *result = NULL;
+  if ((currentProducer() == &producer_) && producer_.good())
+  {
+    // no filter installed, can create factory object
+    result = new DcmInputMappedFileStreamFactory(producer_.mappedFile(), offset_ + tell());
+  }
+  return result;
+}
+
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
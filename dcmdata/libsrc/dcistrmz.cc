@@ -39,10 +39,10 @@
 #include "dcmtk/dcmdata/dcerror.h"
 #include "dcmtk/ofstd/ofconsol.h"
 
-#define DCMZLIBINPUTFILTER_BUFSIZE 4096
 #define DCMZLIBINPUTFILTER_PUTBACKSIZE 1024
 
 OFGlobal<OFBool> dcmZlibExpectRFC1950Encoding(OFFalse);
+OFGlobal<Uint32> dcmZlibInputBufferSize(65536);
 
 
 DcmZLibInputFilter::DcmZLibInputFilter()
@@ -51,10 +51,12 @@ DcmZLibInputFilter::DcmZLibInputFilter()
 , zstream_(new z_stream)
 , status_(EC_MemoryExhausted)
 , eos_(OFFalse)
-, inputBuf_(new unsigned char[DCMZLIBINPUTFILTER_BUFSIZE])
+, bufSize_(dcmZlibInputBufferSize.get() < 2 * DCMZLIBINPUTFILTER_PUTBACKSIZE ?
+    2 * DCMZLIBINPUTFILTER_PUTBACKSIZE : dcmZlibInputBufferSize.get())
+, inputBuf_(new unsigned char[bufSize_])
 , inputBufStart_(0)
 , inputBufCount_(0)
-, outputBuf_(new unsigned char[DCMZLIBINPUTFILTER_BUFSIZE])
+, outputBuf_(new unsigned char[bufSize_])
 , outputBufStart_(0)
 , outputBufCount_(0)
 , outputBufPutback_(0)
@@ -149,10 +151,10 @@ Uint32 DcmZLibInputFilter::read(void *buf, Uint32 buflen)
     {
       // determine next block of data in output buffer
       offset = outputBufStart_ + outputBufPutback_;
-      if (offset >= DCMZLIBINPUTFILTER_BUFSIZE) offset -= DCMZLIBINPUTFILTER_BUFSIZE;
+      if (offset >= bufSize_) offset -= bufSize_;
 
       availBytes = outputBufCount_;
-      if (offset + availBytes > DCMZLIBINPUTFILTER_BUFSIZE) availBytes = DCMZLIBINPUTFILTER_BUFSIZE - offset;
+      if (offset + availBytes > bufSize_) availBytes = bufSize_ - offset;
       if (availBytes > buflen) availBytes = buflen;
 
       if (availBytes) memcpy(target, outputBuf_ + offset, OFstatic_cast(size_t, availBytes));
@@ -166,7 +168,7 @@ Uint32 DcmZLibInputFilter::read(void *buf, Uint32 buflen)
       if (outputBufPutback_ > DCMZLIBINPUTFILTER_PUTBACKSIZE)
       {
         outputBufStart_ += outputBufPutback_ - DCMZLIBINPUTFILTER_PUTBACKSIZE;
-        if (outputBufStart_ >= DCMZLIBINPUTFILTER_BUFSIZE) outputBufStart_ -= DCMZLIBINPUTFILTER_BUFSIZE;
+        if (outputBufStart_ >= bufSize_) outputBufStart_ -= bufSize_;
         outputBufPutback_ = DCMZLIBINPUTFILTER_PUTBACKSIZE;
       }
     }
@@ -192,10 +194,10 @@ Uint32 DcmZLibInputFilter::skip(Uint32 skiplen)
     {
       // determine next block of data in output buffer
       offset = outputBufStart_ + outputBufPutback_;
-      if (offset >= DCMZLIBINPUTFILTER_BUFSIZE) offset -= DCMZLIBINPUTFILTER_BUFSIZE;
+      if (offset >= bufSize_) offset -= bufSize_;
 
       availBytes = outputBufCount_;
-      if (offset + availBytes > DCMZLIBINPUTFILTER_BUFSIZE) availBytes = DCMZLIBINPUTFILTER_BUFSIZE - offset;
+      if (offset + availBytes > bufSize_) availBytes = bufSize_ - offset;
       if (availBytes > skiplen) availBytes = skiplen;
       result += availBytes;
       skiplen -= availBytes;
@@ -207,7 +209,7 @@ Uint32 DcmZLibInputFilter::skip(Uint32 skiplen)
       {
         outputBufStart_ += outputBufPutback_ - DCMZLIBINPUTFILTER_PUTBACKSIZE;
         outputBufPutback_ = DCMZLIBINPUTFILTER_PUTBACKSIZE;
-        if (outputBufStart_ >= DCMZLIBINPUTFILTER_BUFSIZE) outputBufStart_ -= DCMZLIBINPUTFILTER_BUFSIZE;
+        if (outputBufStart_ >= bufSize_) outputBufStart_ -= bufSize_;
       }
     }
 
@@ -237,14 +239,14 @@ void DcmZLibInputFilter::append(DcmProducer& producer)
 Uint32 DcmZLibInputFilter::fillInputBuffer()
 {
   Uint32 result = 0;
-  if (status_.good() && current_ && (inputBufCount_ < DCMZLIBINPUTFILTER_BUFSIZE))
+  if (status_.good() && current_ && (inputBufCount_ < bufSize_))
   {
 
     // use first part of input buffer
-    if (inputBufStart_ + inputBufCount_ < DCMZLIBINPUTFILTER_BUFSIZE)
+    if (inputBufStart_ + inputBufCount_ < bufSize_)
     {
       result = current_->read(inputBuf_ + inputBufStart_ + inputBufCount_,
-        DCMZLIBINPUTFILTER_BUFSIZE - (inputBufStart_ + inputBufCount_));
+        bufSize_ - (inputBufStart_ + inputBufCount_));
 
       inputBufCount_ += result;
 
@@ -263,11 +265,11 @@ Uint32 DcmZLibInputFilter::fillInputBuffer()
     }
 
     // use second part of input buffer
-    if (inputBufCount_ < DCMZLIBINPUTFILTER_BUFSIZE &&
-        inputBufStart_ + inputBufCount_ >= DCMZLIBINPUTFILTER_BUFSIZE)
+    if (inputBufCount_ < bufSize_ &&
+        inputBufStart_ + inputBufCount_ >= bufSize_)
     {
-      Uint32 result2 = current_->read(inputBuf_ + (inputBufStart_ + inputBufCount_ - DCMZLIBINPUTFILTER_BUFSIZE),
-        DCMZLIBINPUTFILTER_BUFSIZE - inputBufCount_);
+      Uint32 result2 = current_->read(inputBuf_ + (inputBufStart_ + inputBufCount_ - bufSize_),
+        bufSize_ - inputBufCount_);
 
       inputBufCount_ += result2;
       result += result2;
@@ -276,7 +278,7 @@ Uint32 DcmZLibInputFilter::fillInputBuffer()
       {
          // producer has signalled eos, now append zero pad byte that makes
          // zlib recognize the end of stream when no zlib header is present
-         *(inputBuf_ + inputBufStart_ + inputBufCount_ - DCMZLIBINPUTFILTER_BUFSIZE) = 0;
+         *(inputBuf_ + inputBufStart_ + inputBufCount_ - bufSize_) = 0;
          inputBufCount_++;
          padded_ = OFTrue;
       }
@@ -295,8 +297,8 @@ Uint32 DcmZLibInputFilter::decompress(const void *buf, Uint32 buflen)
   int astatus;
 
   // decompress from inputBufStart_ to end of data or end of buffer, whatever comes first
-  Uint32 numBytes = (inputBufStart_ + inputBufCount_ > DCMZLIBINPUTFILTER_BUFSIZE) ?
-         (DCMZLIBINPUTFILTER_BUFSIZE - inputBufStart_) : inputBufCount_ ;
+  Uint32 numBytes = (inputBufStart_ + inputBufCount_ > bufSize_) ?
+         (bufSize_ - inputBufStart_) : inputBufCount_ ;
 
   if (numBytes || buflen)
   {
@@ -338,7 +340,7 @@ Uint32 DcmZLibInputFilter::decompress(const void *buf, Uint32 buflen)
     inputBufStart_ += numBytes - OFstatic_cast(Uint32, zstream_->avail_in);
     inputBufCount_ -= numBytes - OFstatic_cast(Uint32, zstream_->avail_in);
 
-    if (inputBufStart_ == DCMZLIBINPUTFILTER_BUFSIZE)
+    if (inputBufStart_ == bufSize_)
     {
       // wrapped around
       inputBufStart_ = 0;
@@ -408,10 +410,10 @@ void DcmZLibInputFilter::fillOutputBuffer()
 
     // determine next block of free space in output buffer
     offset = outputBufStart_ + outputBufPutback_ + outputBufCount_;
-    if (offset >= DCMZLIBINPUTFILTER_BUFSIZE) offset -= DCMZLIBINPUTFILTER_BUFSIZE;
+    if (offset >= bufSize_) offset -= bufSize_;
 
-    availBytes = DCMZLIBINPUTFILTER_BUFSIZE - (outputBufPutback_ + outputBufCount_);
-    if (offset + availBytes > DCMZLIBINPUTFILTER_BUFSIZE) availBytes = DCMZLIBINPUTFILTER_BUFSIZE - offset;
+    availBytes = bufSize_ - (outputBufPutback_ + outputBufCount_);
+    if (offset + availBytes > bufSize_) availBytes = bufSize_ - offset;
 
     // decompress to output buffer
     outputBytes = decompress(outputBuf_ + offset, availBytes);
@@ -90,6 +90,8 @@ DcmItem::DcmItem()
     elementList(NULL),
     lastElementComplete(OFTrue),
     fStartPosition(0),
+    fReadSequencesOnDemand(OFFalse),
+    fStopParsingAtElement(DCM_UndefinedTagKey),
     privateCreatorCache()
 {
     elementList = new DcmList;
@@ -102,6 +104,8 @@ DcmItem::DcmItem(const DcmTag &tag,
     elementList(NULL),
     lastElementComplete(OFTrue),
     fStartPosition(0),
+    fReadSequencesOnDemand(OFFalse),
+    fStopParsingAtElement(DCM_UndefinedTagKey),
     privateCreatorCache()
 {
     elementList = new DcmList;
@@ -113,6 +117,8 @@ DcmItem::DcmItem(const DcmItem &old)
     elementList(new DcmList),
     lastElementComplete(old.lastElementComplete),
     fStartPosition(old.fStartPosition),
+    fReadSequencesOnDemand(old.fReadSequencesOnDemand),
+    fStopParsingAtElement(old.fStopParsingAtElement),
     privateCreatorCache()
 {
     if (!old.elementList->empty())
@@ -835,6 +841,9 @@ OFCondition DcmItem::readSubElement(DcmInputStream &inStream,
         /* insert the new element into the (sorted) element list and */
         /* assign information which was read from the instream to it */
         subElem->transferInit();
+        /* pass on whether the items of sequences are parsed on demand */
+        if (fReadSequencesOnDemand && (subElem->ident() == EVR_SQ))
+            OFstatic_cast(DcmSequenceOfItems *, subElem)->setReadSequencesOnDemand(OFTrue);
         /* we need to read the content of the attribute, no matter if */
         /* inserting the attribute succeeds or fails */
         l_error = subElem->read(inStream, (readAsUN ? EXS_LittleEndianImplicit : xfer), glenc, maxReadLength);
@@ -908,6 +917,8 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
                 fTransferState = ERW_inWork;
             }
             DcmTag newTag;
+            /* remember whether parsing was stopped before the requested element */
+            OFBool parsingStopped = OFFalse;
             /* start a loop in order to read all elements (attributes) which are contained in the inStream */
             while (inStream.good() && (fTransferredBytes < Length || !lastElementComplete))
             {
@@ -930,6 +941,15 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
                     /* while loop will be terminated.) */
                     if (errorFlag.bad())
                         break;
+                    /* if this element is the one before which parsing shall stop (or any later */
+                    /* element), go back to the start of the element and end reading this item */
+                    if ((fStopParsingAtElement != DCM_UndefinedTagKey) && (newTag >= fStopParsingAtElement))
+                    {
+                        inStream.putback();
+                        fTransferredBytes -= bytes_tagAndLen;
+                        parsingStopped = OFTrue;
+                        break;
+                    }
                     /* If we get to this point, we just started reading the first part */
                     /* of an element; hence, lastElementComplete is not longer true */
                     lastElementComplete = OFFalse;
@@ -965,10 +985,14 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
             /* determine an appropriate result value; note that if the above called read function */
             /* encountered the end of the stream before all information for this element could be */
             /* read from the stream, the errorFlag has already been set to EC_StreamNotifyClient. */
-            if ((fTransferredBytes < Length || !lastElementComplete) && errorFlag.good())
-                errorFlag = EC_StreamNotifyClient;
-            if (errorFlag.good() && inStream.eos())
-                errorFlag = EC_EndOfStream;
+            /* If parsing was stopped on purpose, the item is complete as far as requested. */
+            if (!parsingStopped)
+            {
+                if ((fTransferredBytes < Length || !lastElementComplete) && errorFlag.good())
+                    errorFlag = EC_StreamNotifyClient;
+                if (errorFlag.good() && inStream.eos())
+                    errorFlag = EC_EndOfStream;
+            }
         } // else errorFlag
         /* modify the result value: two kinds of special error codes do not count as an error */
         if (errorFlag == EC_ItemEnd || errorFlag == EC_EndOfStream)
@@ -1172,114 +1196,91 @@ OFCondition DcmItem::insert(DcmElement *elem,
     /* do something only if the pointer which was passed does not equal NULL */
     if (elem != NULL)
     {
-        DcmElement *dE;
-        E_ListPos seekmode = ELP_last;
-        /* iterate through elementList (from the last element to the first) */
-        do {
-            /* get current element from elementList */
-            dE = OFstatic_cast(DcmElement *, elementList->seek(seekmode));
-            /* if there is no element, i.e. elementList is empty */
-            if (dE == NULL)
+        /* determine the position of the new element by binary search */
+        unsigned long position = 0;
+        DcmElement *dE = OFstatic_cast(DcmElement *, seekTag(elem->getTag(), position));
+        /* if there is no element with the same tag */
+        if (dE == NULL)
+        {
+            /* if the new element's tag is smaller than all other tags */
+            if (position == 0)
             {
                 /* insert new element at the beginning of elementList */
                 elementList->insert(elem, ELP_first);
-                if (checkInsertOrder)
-                {
-                  // check if we have inserted at the end of the list
-                  if (elem != OFstatic_cast(DcmElement *, elementList->seek(ELP_last)))
-                  {
-                    // produce diagnostics
-                    ofConsole.lockCerr()
-                       << "DcmItem: Dataset not in ascending tag order, at element "
-                       << elem->getTag() << endl;
-                    ofConsole.unlockCerr();
-                  }
-                }
                 /* dump some information if required */
                 DCM_dcmdataDebug(3, ("DcmItem::Insert() element (0x%4.4x,0x%4.4x) / VR=\"%s\" at beginning inserted",
                         elem->getGTag(), elem->getETag(), DcmVR(elem->getVR()).getVRName()));
-                /* terminate do-while-loop */
-                break;
-            }
-            /* else if the new element's tag is greater than the current element's tag */
-            /* (i.e. we have found the position where the new element shall be inserted) */
-            else if (elem->getTag() > dE->getTag())
-            {
-                /* insert the new element after the current element */
+            } else {
+                /* insert the new element after the element with the next smaller tag */
+                elementList->seek_to(position - 1);
                 elementList->insert(elem, ELP_next);
-                if (checkInsertOrder)
-                {
-                  // check if we have inserted at the end of the list
-                  if (elem != OFstatic_cast(DcmElement *, elementList->seek(ELP_last)))
-                  {
-                    // produce diagnostics
-                    ofConsole.lockCerr()
-                       << "DcmItem: Dataset not in ascending tag order, at element "
-                       << elem->getTag() << endl;
-                    ofConsole.unlockCerr();
-                  }
-                }
                 /* dump some information if required */
                 DCM_dcmdataDebug(3, ("DcmItem::Insert() element (0x%4.4x,0x%4.4x) / VR=\"%s\" inserted",
                         elem->getGTag(), elem->getETag(),
                         DcmVR(elem->getVR()).getVRName()));
-                /* terminate do-while-loop */
-                break;
             }
-            /* else if the current element and the new element show the same tag */
-            else if (elem->getTag() == dE->getTag())
+            if (checkInsertOrder)
             {
-                /* if new and current element are not identical */
-                if (elem != dE)
+              // check if we have inserted at the end of the list
+              if (position + 1 != elementList->card())
+              {
+                // produce diagnostics
+                ofConsole.lockCerr()
+                   << "DcmItem: Dataset not in ascending tag order, at element "
+                   << elem->getTag() << endl;
+                ofConsole.unlockCerr();
+              }
+            }
+        }
+        /* else the current element and the new element show the same tag */
+        else
+        {
+            /* if new and current element are not identical */
+            if (elem != dE)
+            {
+                /* if the current (old) element shall be replaced */
+                if (replaceOld)
                 {
-                    /* if the current (old) element shall be replaced */
-                    if (replaceOld)
-                    {
-                        /* remove current element from list */
-                        DcmObject *remObj = elementList->remove();
+                    /* remove current element from list */
+                    DcmObject *remObj = elementList->remove();
 
-                        /* now the following holds: remObj == dE and elementList */
-                        /* points to the element after the former current element. */
+                    /* now the following holds: remObj == dE and elementList */
+                    /* points to the element after the former current element. */
 
-                        /* dump some information if required */
-                        DCM_dcmdataDebug(3, ("DcmItem::insert:element (0x%4.4x,0x%4.4x) VR=\"%s\" p=%p removed",
-                                remObj->getGTag(), remObj->getETag(),
-                                DcmVR(remObj->getVR()).getVRName(), remObj));
+                    /* dump some information if required */
+                    DCM_dcmdataDebug(3, ("DcmItem::insert:element (0x%4.4x,0x%4.4x) VR=\"%s\" p=%p removed",
+                            remObj->getGTag(), remObj->getETag(),
+                            DcmVR(remObj->getVR()).getVRName(), remObj));
 
-                        /* if the pointer to the removed object does not */
-                        /* equal NULL (the usual case), delete this object */
-                        /* and dump some information if required */
-                        if (remObj != NULL)
-                        {
-                            delete remObj;
-                            DCM_dcmdataDebug(3, ("DcmItem::insert:element p=%p deleted", remObj));
-                        }
-                        /* insert the new element before the current element */
-                        elementList->insert(elem, ELP_prev);
-                        /* dump some information if required */
-                        DCM_dcmdataDebug(3, ("DcmItem::insert() element (0x%4.4x,0x%4.4x) VR=\"%s\" p=%p replaced older one",
-                                elem->getGTag(), elem->getETag(),
-                                DcmVR(elem->getVR()).getVRName(), elem));
-
-                    }   // if (replaceOld)
-                    /* or else, i.e. the current element shall not be replaced by the new element */
-                    else {
-                        /* set the error flag correspondingly; we do not */
-                        /* allow two elements with the same tag in elementList */
-                        errorFlag = EC_DoubledTag;
-                    }   // if (!replaceOld)
-                }   // if (elem != dE)
-                /* if the new and the current element are identical, the caller tries to insert */
-                /* one element twice. Most probably an application error. */
+                    /* if the pointer to the removed object does not */
+                    /* equal NULL (the usual case), delete this object */
+                    /* and dump some information if required */
+                    if (remObj != NULL)
+                    {
+                        delete remObj;
+                        DCM_dcmdataDebug(3, ("DcmItem::insert:element p=%p deleted", remObj));
+                    }
+                    /* insert the new element before the current element */
+                    elementList->insert(elem, ELP_prev);
+                    /* dump some information if required */
+                    DCM_dcmdataDebug(3, ("DcmItem::insert() element (0x%4.4x,0x%4.4x) VR=\"%s\" p=%p replaced older one",
+                            elem->getGTag(), elem->getETag(),
+                            DcmVR(elem->getVR()).getVRName(), elem));
+
+                }   // if (replaceOld)
+                /* or else, i.e. the current element shall not be replaced by the new element */
                 else {
+                    /* set the error flag correspondingly; we do not */
+                    /* allow two elements with the same tag in elementList */
                     errorFlag = EC_DoubledTag;
-                }
-                /* terminate do-while-loop */
-                break;
+                }   // if (!replaceOld)
+            }   // if (elem != dE)
+            /* if the new and the current element are identical, the caller tries to insert */
+            /* one element twice. Most probably an application error. */
+            else {
+                errorFlag = EC_DoubledTag;
             }
-            /* set the seek mode to "get the previous element" */
-            seekmode = ELP_prev;
-        } while (dE);
+        }
     }
     /* if the pointer which was passed equals NULL, this is an illegal call */
     else
@@ -1313,7 +1314,9 @@ DcmObject *DcmItem::nextInContainer(const DcmObject *obj)
         return elementList->get(ELP_first);
     else
     {
-        if (elementList->get() != obj)
+        unsigned long position;
+        /* find the object by its tag first, then by iterating */
+        if ((elementList->get() != obj) && (seekTag(obj->getTag(), position) != obj))
         {
             for(DcmObject * search_obj = elementList->seek(ELP_first);
                 search_obj && search_obj != obj;
@@ -1391,7 +1394,14 @@ DcmElement *DcmItem::remove(const unsigned long num)
 DcmElement *DcmItem::remove(DcmObject *elem)
 {
     errorFlag = EC_IllegalCall;
-    if (!elementList->empty() && elem != NULL)
+    unsigned long position;
+    /* find the object by its tag first */
+    if (elem != NULL && seekTag(elem->getTag(), position) == elem)
+    {
+        elementList->remove();     // removes element from list but does not delete it
+        errorFlag = EC_Normal;
+    }
+    else if (!elementList->empty() && elem != NULL)
     {
         DcmObject *dO;
         elementList->seek(ELP_first);
@@ -1418,19 +1428,12 @@ DcmElement *DcmItem::remove(DcmObject *elem)
 DcmElement *DcmItem::remove(const DcmTagKey &tag)
 {
     errorFlag = EC_TagNotFound;
-    DcmObject *dO = NULL;
-    if (!elementList->empty())
+    unsigned long position;
+    DcmObject *dO = seekTag(tag, position);
+    if (dO != NULL)
     {
-        elementList->seek(ELP_first);
-        do {
-            dO = elementList->get();
-            if (dO->getTag() == tag)
-            {
-                elementList->remove();     // removes element from list but does not delete it
-                errorFlag = EC_Normal;
-                break;
-            }
-        } while (elementList->seek(ELP_next));
+        elementList->remove();     // removes element from list but does not delete it
+        errorFlag = EC_Normal;
     }
 
     if (errorFlag == EC_TagNotFound)
@@ -1484,6 +1487,31 @@ OFCondition DcmItem::verify(const OFBool autocorrect)
 }
 
 
+// ********************************
+
+
+DcmObject *DcmItem::seekTag(const DcmTagKey &tag,
+                            unsigned long &position)
+{
+    /* binary search for the first element whose tag is not smaller than the given one */
+    unsigned long lower = 0;
+    unsigned long upper = elementList->card();
+    while (lower < upper)
+    {
+        const unsigned long middle = lower + (upper - lower) / 2;
+        if (elementList->seek_to(middle)->getTag() < tag)
+            lower = middle + 1;
+        else
+            upper = middle;
+    }
+    position = lower;
+    DcmObject *dO = elementList->seek_to(position);
+    if ((dO != NULL) && (dO->getTag() == tag))
+        return dO;
+    return NULL;
+}
+
+
 // ********************************
 
 // Precondition: elementList is non-empty!
@@ -1500,27 +1528,29 @@ OFCondition DcmItem::searchSubFromHere(const DcmTagKey &tag,
 {
     DcmObject *dO;
     OFCondition l_error = EC_TagNotFound;
-    if (!elementList->empty())
+    if (!searchIntoSub)
+    {
+        /* search this level only, no need to iterate */
+        unsigned long position;
+        dO = seekTag(tag, position);
+        if (dO != NULL)
+        {
+            resultStack.push(dO);
+            l_error = EC_Normal;
+        }
+    }
+    else if (!elementList->empty())
     {
         elementList->seek(ELP_first);
         do {
             dO = elementList->get();
-            if (searchIntoSub)
-            {
-                resultStack.push(dO);
-                if (dO->getTag() == tag)
-                    l_error = EC_Normal;
-                else
-                    l_error = dO->search(tag, resultStack, ESM_fromStackTop, OFTrue);
-                if (l_error.bad())
-                    resultStack.pop();
-            } else {
-                if (dO->getTag() == tag)
-                {
-                    resultStack.push(dO);
-                    l_error = EC_Normal;
-                }
-            }
+            resultStack.push(dO);
+            if (dO->getTag() == tag)
+                l_error = EC_Normal;
+            else
+                l_error = dO->search(tag, resultStack, ESM_fromStackTop, OFTrue);
+            if (l_error.bad())
+                resultStack.pop();
         } while (l_error.bad() && elementList->seek(ELP_next));
         DCM_dcmdataCDebug(4, l_error==EC_Normal && dO->getTag()==tag,
                ("DcmItem::searchSubFromHere() Search-Tag=(%4.4x,%4.4x)"
@@ -32,20 +32,28 @@
 
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
 #include "dcmtk/ofstd/ofstream.h"
 #include "dcmtk/dcmdata/dclist.h"
 #include "dcmtk/dcmdata/dcdebug.h"
 
 
+// initial number of elements for which memory is allocated
+#define DCMLIST_INITIAL_SIZE 8
+
+
 // *****************************************
-// *** DcmListNode *************************
+// *** DcmList *****************************
 // *****************************************
 
 
-DcmListNode::DcmListNode( DcmObject *obj )
-  : nextNode(NULL),
-    prevNode(NULL),
-    objNodeValue(obj)
+DcmList::DcmList()
+  : objArray(NULL),
+    arraySize(0),
+    currentIndex(DCM_EndOfListIndex),
+    cardinality(0)
 {
 }
 
@@ -53,41 +61,31 @@ DcmListNode::DcmListNode( DcmObject *obj )
 // ********************************
 
 
-DcmListNode::~DcmListNode()
-{
-}
-
-
-// *****************************************
-// *** DcmList *****************************
-// *****************************************
-
-
-DcmList::DcmList()
-  : firstNode(NULL),
-    lastNode(NULL),
-    currentNode(NULL),
-    cardinality(0)
+DcmList::~DcmList()
 {
+    // delete the array only, the objects are deleted by the owner
+    delete[] objArray;
 }
 
 
 // ********************************
 
 
-DcmList::~DcmList()
+void DcmList::makeRoom(unsigned long position)
 {
-    if ( !DcmList::empty() )                      // list is not empty !
+    if (cardinality == arraySize)
     {
-        lastNode->nextNode = NULL;                // set to 0 for safety reasons
-        do {
-            DcmListNode *temp = firstNode;
-            firstNode = firstNode->nextNode;
-            // delete temp->objNodeValue;;        // dangerous!
-            delete temp;
-        } while ( firstNode != NULL );
-        currentNode = firstNode = lastNode = NULL;
+        // double the size of the array
+        const unsigned long newSize = (arraySize == 0) ? DCMLIST_INITIAL_SIZE : 2 * arraySize;
+        DcmObject **newArray = new DcmObject *[newSize];
+        if (cardinality > 0)
+            memcpy(newArray, objArray, cardinality * sizeof(DcmObject *));
+        delete[] objArray;
+        objArray = newArray;
+        arraySize = newSize;
     }
+    if (position < cardinality)
+        memmove(&objArray[position + 1], &objArray[position], (cardinality - position) * sizeof(DcmObject *));
 }
 
 
@@ -98,16 +96,9 @@ DcmObject *DcmList::append( DcmObject *obj )
 {
     if ( obj != NULL )
     {
-        if ( DcmList::empty() )                        // list is empty !
-            currentNode = firstNode = lastNode = new DcmListNode(obj);
-        else
-        {
-            DcmListNode *node = new DcmListNode(obj);
-            lastNode->nextNode = node;
-            node->prevNode = lastNode;
-            currentNode = lastNode = node;
-        }
-        cardinality++;
+        makeRoom(cardinality);
+        objArray[cardinality] = obj;
+        currentIndex = cardinality++;
     } // obj == NULL
     return obj;
 }
@@ -120,15 +111,9 @@ DcmObject *DcmList::prepend( DcmObject *obj )
 {
     if ( obj != NULL )
     {
-        if ( DcmList::empty() )                        // list is empty !
-            currentNode = firstNode = lastNode = new DcmListNode(obj);
-        else
-        {
-            DcmListNode *node = new DcmListNode(obj);
-            node->nextNode = firstNode;
-            firstNode->prevNode = node;
-            currentNode = firstNode = node;
-        }
+        makeRoom(0);
+        objArray[0] = obj;
+        currentIndex = 0;
         cardinality++;
     } // obj == NULL
     return obj;
@@ -143,47 +128,25 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
     if ( obj != NULL )
     {
         if ( DcmList::empty() )                 // list is empty !
+            DcmList::append( obj );             // cardinality++;
+        else if ( pos==ELP_last )
+            DcmList::append( obj );             // cardinality++;
+        else if ( pos==ELP_first )
+            DcmList::prepend( obj );            // cardinality++;
+        else if ( !DcmList::valid() )
+            // set current node to the end if there is no predecessor or
+            // there are successors to be determined
+            DcmList::append( obj );             // cardinality++;
+        else
         {
-            currentNode = firstNode = lastNode = new DcmListNode(obj);
+            // insert before current node (ELP_prev) or after current node
+            // (ELP_next, ELP_atpos)
+            const unsigned long position = (pos == ELP_prev) ? currentIndex : currentIndex + 1;
+            makeRoom(position);
+            objArray[position] = obj;
+            currentIndex = position;
             cardinality++;
         }
-        else {
-            if ( pos==ELP_last )
-                DcmList::append( obj );         // cardinality++;
-            else if ( pos==ELP_first )
-                DcmList::prepend( obj );        // cardinality++;
-            else if ( !DcmList::valid() )
-                // set current node to the end if there is no predecessor or
-                // there are successors to be determined
-                DcmList::append( obj );         // cardinality++;
-            else if ( pos == ELP_prev )         // insert before current node
-            {
-                DcmListNode *node = new DcmListNode(obj);
-                if ( currentNode->prevNode == NULL )
-                    firstNode = node;           // insert at the beginning
-                else
-                    currentNode->prevNode->nextNode = node;
-                node->prevNode = currentNode->prevNode;
-                node->nextNode = currentNode;
-                currentNode->prevNode = node;
-                currentNode = node;
-                cardinality++;
-            }
-            else //( pos==ELP_next || pos==ELP_atpos )
-                                                // insert after current node
-            {
-                DcmListNode *node = new DcmListNode(obj);
-                if ( currentNode->nextNode == NULL )
-                    lastNode = node;            // append to the end
-                else
-                    currentNode->nextNode->prevNode = node;
-                node->nextNode = currentNode->nextNode;
-                node->prevNode = currentNode;
-                currentNode->nextNode = node;
-                currentNode = node;
-                cardinality++;
-            }
-        }
     } // obj == NULL
     return obj;
 }
@@ -194,31 +157,19 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
 
 DcmObject *DcmList::remove()
 {
-    DcmObject *tempobj;
-    DcmListNode *tempnode;
-
     if ( DcmList::empty() )                        // list is empty !
         return NULL;
     else if ( !DcmList::valid() )
         return NULL;                               // current node is 0
     else
     {
-        tempnode = currentNode;
-
-        if ( currentNode->prevNode == NULL )
-            firstNode = currentNode->nextNode;     // delete first element
-        else
-            currentNode->prevNode->nextNode = currentNode->nextNode;
-
-        if ( currentNode->nextNode == NULL )
-            lastNode = currentNode->prevNode;      // delete last element
-        else
-            currentNode->nextNode->prevNode = currentNode->prevNode;
-
-        currentNode = currentNode->nextNode;
-        tempobj = tempnode->value();
-        delete tempnode;
+        DcmObject *tempobj = objArray[currentIndex];
         cardinality--;
+        // the successor becomes the current node
+        if (currentIndex < cardinality)
+            memmove(&objArray[currentIndex], &objArray[currentIndex + 1], (cardinality - currentIndex) * sizeof(DcmObject *));
+        else
+            currentIndex = DCM_EndOfListIndex;
         return tempobj;
     }
 }
@@ -241,23 +192,23 @@ DcmObject *DcmList::seek( E_ListPos pos )
     switch (pos)
     {
         case ELP_first :
-            currentNode = firstNode;
+            currentIndex = DcmList::empty() ? DCM_EndOfListIndex : 0;
             break;
         case ELP_last :
-            currentNode = lastNode;
+            currentIndex = DcmList::empty() ? DCM_EndOfListIndex : cardinality - 1;
             break;
         case ELP_prev :
             if ( DcmList::valid() )
-                currentNode = currentNode->prevNode;
+                currentIndex = (currentIndex == 0) ? DCM_EndOfListIndex : currentIndex - 1;
             break;
         case ELP_next :
             if ( DcmList::valid() )
-                currentNode = currentNode->nextNode;
+                currentIndex = (currentIndex + 1 == cardinality) ? DCM_EndOfListIndex : currentIndex + 1;
             break;
         default:
             break;
     }
-    return DcmList::valid() ? currentNode->value() : NULL;
+    return DcmList::valid() ? objArray[currentIndex] : NULL;
 }
 
 
@@ -266,10 +217,7 @@ DcmObject *DcmList::seek( E_ListPos pos )
 
 DcmObject *DcmList::seek_to(unsigned long absolute_position)
 {
-    const unsigned long tmppos = absolute_position < cardinality ? absolute_position : cardinality;
-    seek( ELP_first );
-    for (unsigned long i = 0; i < tmppos; i++)
-        seek( ELP_next );
+    currentIndex = absolute_position < cardinality ? absolute_position : DCM_EndOfListIndex;
     return get( ELP_atpos );
 }
 
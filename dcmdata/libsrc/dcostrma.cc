@@ -109,6 +109,20 @@ void DcmOutputStream::flush()
   current_->flush();
 }
 
+void DcmOutputStream::writePending()
+{
+  current_->writePending();
+}
+
+Uint32 DcmOutputStream::copyFromFile(const char *filename, Uint32 offset, Uint32 length)
+{
+  // the compression filter needs to see all data
+  if (compressionFilter_) return 0;
+  Uint32 result = current_->copyFromFile(filename, offset, length);
+  tell_ += result;
+  return result;
+}
+
 Uint32 DcmOutputStream::tell() const
 {
   return tell_;
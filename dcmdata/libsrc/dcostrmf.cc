@@ -38,8 +38,21 @@
 
 #define INCLUDE_CSTDIO
 #define INCLUDE_CERRNO
+#define INCLUDE_UNISTD
 #include "dcmtk/ofstd/ofstdinc.h"
 
+BEGIN_EXTERN_C
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+END_EXTERN_C
+
 
 DcmFileConsumer::DcmFileConsumer(const char *filename)
 : DcmConsumer()
@@ -102,6 +115,59 @@ void DcmFileConsumer::flush()
   // nothing to flush
 }
 
+Uint32 DcmFileConsumer::copyFromFile(const char *filename, Uint32 offset, Uint32 length)
+{
+  Uint32 result = 0;
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SYS_SENDFILE_H)
+  if (status_.good() && file_ && filename && length)
+  {
+    int source = open(filename, O_RDONLY);
+    if (source < 0) return 0;
+
+    // data written with fwrite() must reach the file before we bypass the stdio buffer
+    fflush(file_);
+    int target = fileno(file_);
+    off_t targetPos = lseek(target, 0, SEEK_CUR);
+    if (targetPos >= 0)
+    {
+      off_t sourcePos = OFstatic_cast(off_t, offset);
+      ssize_t copied = 0;
+#ifdef HAVE_COPY_FILE_RANGE
+      // copies within the file system, possibly sharing the data blocks
+      while (result < length)
+      {
+        copied = copy_file_range(source, &sourcePos, target, NULL, OFstatic_cast(size_t, length - result), 0);
+        if (copied <= 0) break;
+        result += OFstatic_cast(Uint32, copied);
+      }
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+      // copy_file_range() fails e.g. across file systems, use sendfile() instead
+      while (result < length)
+      {
+        copied = sendfile(target, source, &sourcePos, OFstatic_cast(size_t, length - result));
+        if (copied <= 0) break;
+        result += OFstatic_cast(Uint32, copied);
+      }
+#endif
+      // make the stdio file position agree with the file descriptor again
+#ifdef HAVE_FSEEKO
+      if (fseeko(file_, targetPos + OFstatic_cast(off_t, result), SEEK_SET) != 0)
+#else
+      if (fseek(file_, OFstatic_cast(long, targetPos + result), SEEK_SET) != 0)
+#endif
+      {
+        const char *text = strerror(errno);
+        if (text == NULL) text = "(unknown error code)";
+        status_ = makeOFCondition(OFM_dcmdata, 19, OF_error, text);
+      }
+    }
+    close(source);
+  }
+#endif
+  return result;
+}
+
 /* ======================================================================= */
 
 DcmOutputFileStream::DcmOutputFileStream(const char *filename)
@@ -37,9 +37,22 @@
 
 #include "dcmtk/dcmdata/dcostrmz.h"
 #include "dcmtk/dcmdata/dcerror.h"
+#include "dcmtk/dcmdata/dcfrmpol.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
 
 #define DCMZLIBOUTPUTFILTER_BUFSIZE 4096
 
+/* size of the blocks compressed concurrently by DcmZLibBlockCompressor */
+#define DCMZLIBBLOCK_SIZE 131072
+
+/* size of the preset dictionary, i.e. the deflate window */
+#define DCMZLIBBLOCK_DICTSIZE 32768
+
+/* number of blocks per thread collected before compression starts */
+#define DCMZLIBBLOCK_PERTHREAD 4
+
 /* taken from zutil.h */
 #if MAX_MEM_LEVEL >= 8
 #define DEF_MEM_LEVEL 8
@@ -48,6 +61,249 @@
 #endif
 
 OFGlobal<int> dcmZlibCompressionLevel(Z_DEFAULT_COMPRESSION);
+OFGlobal<Uint32> dcmZlibCompressionThreads(1);
+
+
+static OFCondition makeZLibError(z_streamp zstream)
+{
+  OFString etext = "ZLib Error: ";
+  if (zstream->msg) etext += zstream->msg;
+  return makeOFCondition(OFM_dcmdata, 16, OF_error, etext.c_str());
+}
+
+
+/** block-parallel deflate compressor.
+ *  The input is collected in a batch of blocks which are compressed
+ *  concurrently into separate output buffers, each by a raw deflate stream
+ *  of its own that uses the 32 kBytes of input preceding the block as preset
+ *  dictionary. All blocks but the last one of the stream are terminated by a
+ *  sync flush, i.e. end on a byte boundary without the BFINAL bit set, so
+ *  that their concatenation forms a single valid RFC 1951 bitstream.
+ */
+class DcmZLibBlockCompressor: public DcmFrameProcessor
+{
+public:
+
+  /** constructor.
+   *  @param level zlib compression level
+   *  @param numberOfThreads number of threads including the calling thread
+   */
+  DcmZLibBlockCompressor(int level, Uint32 numberOfThreads)
+  : pool_(*this, numberOfThreads)
+  , numBlocks_(numberOfThreads * DCMZLIBBLOCK_PERTHREAD)
+  , input_(new unsigned char[DCMZLIBBLOCK_DICTSIZE + numBlocks_ * DCMZLIBBLOCK_SIZE])
+  , inputCount_(0)
+  , dictCount_(0)
+  , streams_(new z_stream[numBlocks_])
+  , initialized_(0)
+  , outputSize_(0)
+  , output_(new unsigned char *[numBlocks_])
+  , outputCount_(new Uint32[numBlocks_])
+  , batchBlocks_(0)
+  , finalize_(OFFalse)
+  , outputBlock_(0)
+  , outputStart_(0)
+  , finished_(OFFalse)
+  , status_(EC_Normal)
+  {
+    Uint32 i;
+    for (i = 0; i < numBlocks_; ++i) output_[i] = NULL;
+    for (i = 0; (i < numBlocks_) && status_.good(); ++i)
+    {
+      streams_[i].zalloc = Z_NULL;
+      streams_[i].zfree = Z_NULL;
+      streams_[i].opaque = Z_NULL;
+      /* windowBits is passed < 0 to suppress zlib header */
+      if (Z_OK == deflateInit2(&streams_[i], level, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY))
+        ++initialized_;
+        else status_ = makeZLibError(&streams_[i]);
+    }
+    if (status_.good())
+    {
+      /* room for the worst case expansion of a block plus the sync flush marker */
+      outputSize_ = OFstatic_cast(Uint32, deflateBound(&streams_[0], DCMZLIBBLOCK_SIZE)) + 16;
+      for (i = 0; i < numBlocks_; ++i) output_[i] = new unsigned char[outputSize_];
+    }
+  }
+
+  /// destructor
+  virtual ~DcmZLibBlockCompressor()
+  {
+    for (Uint32 i = 0; i < numBlocks_; ++i)
+    {
+      if (i < initialized_) deflateEnd(&streams_[i]);
+      delete[] output_[i];
+    }
+    delete[] output_;
+    delete[] outputCount_;
+    delete[] streams_;
+    delete[] input_;
+  }
+
+  /// returns the status of the compressor
+  OFCondition status() const { return status_; }
+
+  /// returns the number of bytes that can be added to the current batch
+  Uint32 avail() const
+  {
+    if (status_.good() && !finished_) return numBlocks_ * DCMZLIBBLOCK_SIZE - inputCount_;
+      else return 0;
+  }
+
+  /// returns true if compressed output is waiting to be written
+  OFBool outputPending() const { return outputBlock_ < batchBlocks_; }
+
+  /// returns true if the end of the stream has been compressed
+  OFBool finished() const { return finished_; }
+
+  /** copies as much of the given data as possible to the current batch
+   *  @param buf pointer to input data
+   *  @param buflen number of bytes in buf
+   *  @return number of bytes copied
+   */
+  Uint32 fill(const void *buf, Uint32 buflen)
+  {
+    Uint32 result = avail();
+    if (result > buflen) result = buflen;
+    if (result > 0)
+    {
+      memcpy(input_ + DCMZLIBBLOCK_DICTSIZE + inputCount_, buf, OFstatic_cast(size_t, result));
+      inputCount_ += result;
+    }
+    return result;
+  }
+
+  /** compresses the current batch. Must only be called if no output is pending.
+   *  @param finalize true if the current batch constitutes the end of the stream
+   */
+  void compress(OFBool finalize)
+  {
+    if (status_.bad() || finished_ || outputPending()) return;
+
+    // the end of the stream needs one block even if there is no more input
+    batchBlocks_ = (inputCount_ + DCMZLIBBLOCK_SIZE - 1) / DCMZLIBBLOCK_SIZE;
+    if (finalize && (batchBlocks_ == 0)) batchBlocks_ = 1;
+    finalize_ = finalize;
+    outputBlock_ = 0;
+    outputStart_ = 0;
+    if (batchBlocks_ > 0) status_ = pool_.run(0, batchBlocks_);
+    if (status_.bad()) batchBlocks_ = 0;
+
+    // keep the end of the batch as dictionary for the next one
+    Uint32 keep = dictCount_ + inputCount_;
+    if (keep > DCMZLIBBLOCK_DICTSIZE) keep = DCMZLIBBLOCK_DICTSIZE;
+    memmove(input_ + DCMZLIBBLOCK_DICTSIZE - keep, input_ + DCMZLIBBLOCK_DICTSIZE + inputCount_ - keep, OFstatic_cast(size_t, keep));
+    dictCount_ = keep;
+    inputCount_ = 0;
+    if (finalize) finished_ = OFTrue;
+  }
+
+  /** writes compressed output to the given consumer until all output
+   *  is written or the consumer becomes full
+   *  @param consumer consumer to write to
+   */
+  void flushOutput(DcmConsumer& consumer)
+  {
+    while (outputPending())
+    {
+      Uint32 count = outputCount_[outputBlock_] - outputStart_;
+      if (count > 0)
+      {
+        Uint32 written = consumer.write(output_[outputBlock_] + outputStart_, count);
+        outputStart_ += written;
+        if (written < count) break;
+      }
+      ++outputBlock_;
+      outputStart_ = 0;
+    }
+  }
+
+  /** compresses one block of the current batch.
+   *  @param frameNo number of the block within the batch
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  virtual OFCondition processFrame(Uint32 frameNo)
+  {
+    z_streamp zstream = &streams_[frameNo];
+    unsigned char *block = input_ + DCMZLIBBLOCK_DICTSIZE + frameNo * DCMZLIBBLOCK_SIZE;
+    Uint32 length = inputCount_ - frameNo * DCMZLIBBLOCK_SIZE;
+    if (length > DCMZLIBBLOCK_SIZE) length = DCMZLIBBLOCK_SIZE;
+    Uint32 dictLength = (frameNo == 0) ? dictCount_ : DCMZLIBBLOCK_DICTSIZE;
+    OFBool last = finalize_ && (frameNo + 1 == batchBlocks_);
+
+    if (Z_OK != deflateReset(zstream)) return makeZLibError(zstream);
+    if (dictLength > 0)
+    {
+      if (Z_OK != deflateSetDictionary(zstream, block - dictLength, dictLength))
+        return makeZLibError(zstream);
+    }
+    zstream->next_in = OFstatic_cast(Bytef *, block);
+    zstream->avail_in = OFstatic_cast(uInt, length);
+    zstream->next_out = OFstatic_cast(Bytef *, output_[frameNo]);
+    zstream->avail_out = OFstatic_cast(uInt, outputSize_);
+    int zstatus = deflate(zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((zstatus != (last ? Z_STREAM_END : Z_OK)) || (zstream->avail_in > 0))
+      return makeZLibError(zstream);
+    outputCount_[frameNo] = outputSize_ - OFstatic_cast(Uint32, zstream->avail_out);
+    return EC_Normal;
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DcmZLibBlockCompressor(const DcmZLibBlockCompressor&);
+
+  /// private undefined copy assignment operator
+  DcmZLibBlockCompressor& operator=(const DcmZLibBlockCompressor&);
+
+  /// worker threads compressing the blocks of a batch
+  DcmFrameWorkerPool pool_;
+
+  /// maximum number of blocks in a batch
+  Uint32 numBlocks_;
+
+  /// dictionary area followed by the input of the current batch
+  unsigned char *input_;
+
+  /// number of input bytes in the current batch
+  Uint32 inputCount_;
+
+  /// number of valid bytes at the end of the dictionary area
+  Uint32 dictCount_;
+
+  /// one deflate stream per block
+  z_stream *streams_;
+
+  /// number of successfully initialized deflate streams
+  Uint32 initialized_;
+
+  /// size of each output buffer
+  Uint32 outputSize_;
+
+  /// one output buffer per block
+  unsigned char **output_;
+
+  /// number of compressed bytes in each output buffer
+  Uint32 *outputCount_;
+
+  /// number of blocks in the last compressed batch
+  Uint32 batchBlocks_;
+
+  /// true if the last compressed batch ends the stream
+  OFBool finalize_;
+
+  /// block whose output is written next
+  Uint32 outputBlock_;
+
+  /// number of bytes of that block already written
+  Uint32 outputStart_;
+
+  /// true if the end of the stream has been compressed
+  OFBool finished_;
+
+  /// status
+  OFCondition status_;
+};
 
 
 DcmZLibOutputFilter::DcmZLibOutputFilter()
@@ -62,7 +318,18 @@ DcmZLibOutputFilter::DcmZLibOutputFilter()
 , outputBuf_(new unsigned char[DCMZLIBOUTPUTFILTER_BUFSIZE])
 , outputBufStart_(0)
 , outputBufCount_(0)
+, blocks_(NULL)
 {
+#ifndef ZLIB_ENCODE_RFC1950_HEADER
+  if (dcmZlibCompressionThreads.get() > 1)
+  {
+    // zstream_ and status_ are not used in this mode, see status()
+    delete zstream_;
+    zstream_ = NULL;
+    blocks_ = new DcmZLibBlockCompressor(dcmZlibCompressionLevel.get(), dcmZlibCompressionThreads.get());
+    return;
+  }
+#endif
   if (zstream_ && inputBuf_ && outputBuf_)
   {
     zstream_->zalloc = Z_NULL;
@@ -101,33 +368,44 @@ DcmZLibOutputFilter::~DcmZLibOutputFilter()
   }
   delete[] inputBuf_;
   delete[] outputBuf_;
+  delete blocks_;
 }
 
 
 OFBool DcmZLibOutputFilter::good() const
 {
-  return status_.good();
+  return status().good();
 }
 
 OFCondition DcmZLibOutputFilter::status() const
 {
+  if (blocks_) return blocks_->status();
   return status_;
 }
 
 OFBool DcmZLibOutputFilter::isFlushed() const
 {
-  if (status_.bad() || (current_ == NULL)) return OFTrue;
+  if (status().bad() || (current_ == NULL)) return OFTrue;
+  if (blocks_) return blocks_->finished() && (! blocks_->outputPending()) && current_->isFlushed();
   return (inputBufCount_ == 0) && (outputBufCount_ == 0) && flushed_ && current_->isFlushed();
 }
 
 
 Uint32 DcmZLibOutputFilter::avail() const
 {
+  // a full batch is only compressed by writePending() or write()
+  if (blocks_) return blocks_->avail();
+
   // compute number of bytes available in input buffer
   if (status_.good() ) return DCMZLIBOUTPUTFILTER_BUFSIZE - inputBufCount_;
     else return 0;
 }
 
+void DcmZLibOutputFilter::flushBlockOutput()
+{
+  blocks_->flushOutput(*current_);
+}
+
 void DcmZLibOutputFilter::flushOutputBuffer()
 {
   if (outputBufCount_)
@@ -289,16 +567,23 @@ Uint32 DcmZLibOutputFilter::compress(const void *buf, Uint32 buflen, OFBool fina
 
 Uint32 DcmZLibOutputFilter::write(const void *buf, Uint32 buflen)
 {
-  if (status_.bad() || (current_ == NULL)) return 0;
+  if (status().bad() || (current_ == NULL)) return 0;
 
-  // flush output buffer if necessary
-  if (outputBufCount_ == DCMZLIBOUTPUTFILTER_BUFSIZE) flushOutputBuffer();
+  writePending();
 
-  // compress pending input from input buffer
-  while (status_.good() && inputBufCount_ > 0 && outputBufCount_ < DCMZLIBOUTPUTFILTER_BUFSIZE)
+  if (blocks_)
   {
-    compressInputBuffer(OFFalse);
-    if (outputBufCount_ == DCMZLIBOUTPUTFILTER_BUFSIZE) flushOutputBuffer();
+    const unsigned char *data = OFstatic_cast(const unsigned char *, buf);
+    Uint32 result = 0;
+    while (blocks_->status().good() && (buflen > result))
+    {
+      result += blocks_->fill(data+result, buflen-result);
+      // compress the batch once it is full and the previous output has been written
+      if (blocks_->avail() > 0 || blocks_->outputPending()) break;
+      blocks_->compress(OFFalse);
+      flushBlockOutput();
+    }
+    return result;
   }
 
   const unsigned char *data = OFstatic_cast(const unsigned char *, buf);
@@ -322,9 +607,52 @@ Uint32 DcmZLibOutputFilter::write(const void *buf, Uint32 buflen)
 }
 
 
+void DcmZLibOutputFilter::writePending()
+{
+  if (status().bad() || (current_ == NULL)) return;
+
+  current_->writePending();
+
+  if (blocks_)
+  {
+    flushBlockOutput();
+    // a full batch is compressed once the output of the previous batch has been written
+    if ((blocks_->avail() == 0) && ! blocks_->outputPending() && ! blocks_->finished())
+    {
+      blocks_->compress(OFFalse);
+      flushBlockOutput();
+    }
+    return;
+  }
+
+  // flush output buffer if necessary
+  if (outputBufCount_ == DCMZLIBOUTPUTFILTER_BUFSIZE) flushOutputBuffer();
+
+  // compress pending input from input buffer
+  while (status_.good() && inputBufCount_ > 0 && outputBufCount_ < DCMZLIBOUTPUTFILTER_BUFSIZE)
+  {
+    compressInputBuffer(OFFalse);
+    if (outputBufCount_ == DCMZLIBOUTPUTFILTER_BUFSIZE) flushOutputBuffer();
+  }
+}
+
+
 void DcmZLibOutputFilter::flush()
 {
-  if (status_.good() && current_)
+  if (blocks_)
+  {
+    if (blocks_->status().good() && current_)
+    {
+      flushBlockOutput();
+      if (! blocks_->outputPending() && ! blocks_->finished())
+      {
+        // compress the final batch and terminate the stream
+        blocks_->compress(OFTrue);
+        flushBlockOutput();
+      }
+    }
+  }
+  else if (status_.good() && current_)
   {
     // flush output buffer first
     if (outputBufCount_ == DCMZLIBOUTPUTFILTER_BUFSIZE) flushOutputBuffer();
@@ -34,6 +34,11 @@
 #include "dcmtk/dcmdata/dcpixel.h"
 #include "dcmtk/dcmdata/dccodec.h"
 #include "dcmtk/dcmdata/dcpixseq.h"
+#include "dcmtk/dcmdata/dcitem.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
 
 //
 // class DcmRepresentationEntry
@@ -355,6 +360,88 @@ DcmPixelData::decode(
 
 
 
+OFCondition
+DcmPixelData::getUncompressedFrameSize(
+    DcmItem * dataset,
+    Uint32 & frameSize) const
+{
+    if (dataset == NULL) return EC_IllegalCall;
+    Uint16 rows = 0;
+    Uint16 columns = 0;
+    Uint16 samplesPerPixel = 0;
+    Uint16 bitsAllocated = 0;
+    OFCondition l_error = dataset->findAndGetUint16(DCM_Rows, rows);
+    if (l_error.good()) l_error = dataset->findAndGetUint16(DCM_Columns, columns);
+    if (l_error.good()) l_error = dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+    if (l_error.good()) l_error = dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    if (l_error.good())
+    {
+        if ((bitsAllocated == 0) || (bitsAllocated % 8 != 0))
+            l_error = EC_CannotChangeRepresentation;
+        else
+            frameSize = (bitsAllocated / 8) * OFstatic_cast(Uint32, rows) * columns * samplesPerPixel;
+    }
+    return l_error;
+}
+
+
+OFCondition
+DcmPixelData::decodeFrame(
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32 & startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString & decompressedColorModel)
+{
+    if ((dataset == NULL) || (buffer == NULL)) return EC_IllegalCall;
+    OFCondition l_error = EC_Normal;
+
+    if (existUnencapsulated)
+    {
+        /* copy the frame from the uncompressed representation */
+        Uint32 frameSize = 0;
+        Uint16 bitsAllocated = 0;
+        l_error = getUncompressedFrameSize(dataset, frameSize);
+        if (l_error.good()) l_error = dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+        if (l_error.good() && (bufSize < frameSize)) l_error = EC_IllegalCall;
+        if (l_error.good())
+        {
+            Uint8 *pixelData = NULL;
+            if (bitsAllocated > 8)
+            {
+                Uint16 *words = NULL;
+                l_error = getUint16Array(words);
+                pixelData = OFreinterpret_cast(Uint8 *, words);
+            }
+            else
+                l_error = getUint8Array(pixelData);
+            if (l_error.good())
+            {
+                if ((pixelData == NULL) || (OFstatic_cast(double, frameNo + 1) * frameSize > Length))
+                    l_error = EC_IllegalCall;
+                else
+                {
+                    memcpy(buffer, pixelData + frameNo * frameSize, frameSize);
+                    l_error = dataset->findAndGetOFString(DCM_PhotometricInterpretation, decompressedColorModel);
+                }
+            }
+        }
+    }
+    else if (original != repListEnd)
+    {
+        /* decompress the frame from the original representation */
+        DcmXfer fromType((*original)->repType);
+        l_error = DcmCodecList::decodeFrame(fromType, (*original)->repParam, (*original)->pixSeq,
+            dataset, frameNo, startFragment, buffer, bufSize, decompressedColorModel);
+    }
+    else
+        l_error = EC_RepresentationNotFound;
+
+    return l_error;
+}
+
+
 OFCondition
 DcmPixelData::encode(
     const DcmXfer & fromType,
@@ -44,6 +44,75 @@
 #include "dcmtk/dcmdata/dcvrpobw.h"  /* for class DcmPolymorphOBOW */
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary() */
 #include "dcmtk/dcmdata/dcuid.h"     /* for dcmGenerateUniqueIdentifer()*/
+#include "dcmtk/dcmdata/dcfrmpol.h"  /* for class DcmFrameWorkerPool */
+
+
+/** decompresses the frames of an RLE compressed image concurrently.
+ */
+class DcmRLEFrameDecompressor: public DcmFrameProcessor
+{
+public:
+
+  /** constructor.
+   *  @param fragments table of all fragments, values already loaded
+   *  @param startFragments index of the first fragment for each frame
+   *  @param imageData8 output buffer for all frames
+   *  @param frameSize size of an uncompressed frame in bytes
+   *  @param imageColumns number of columns
+   *  @param imageRows number of rows
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @param imageBytesAllocated number of bytes allocated per sample
+   *  @param imagePlanarConfiguration planar configuration of the output
+   *  @param enableReverseByteOrder true if RLE segments are stored LSB first
+   */
+  DcmRLEFrameDecompressor(
+    const DcmFragmentTable& fragments,
+    const Uint32 *startFragments,
+    Uint8 *imageData8,
+    Uint32 frameSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 imageBytesAllocated,
+    Uint16 imagePlanarConfiguration,
+    OFBool enableReverseByteOrder)
+  : fragments_(fragments)
+  , startFragments_(startFragments)
+  , imageData8_(imageData8)
+  , frameSize_(frameSize)
+  , imageColumns_(imageColumns)
+  , imageRows_(imageRows)
+  , imageSamplesPerPixel_(imageSamplesPerPixel)
+  , imageBytesAllocated_(imageBytesAllocated)
+  , imagePlanarConfiguration_(imagePlanarConfiguration)
+  , enableReverseByteOrder_(enableReverseByteOrder)
+  {
+  }
+
+  virtual OFCondition processFrame(Uint32 frameNo)
+  {
+    // each frame uses its own RLE decoder
+    DcmRLEDecoder rledecoder(imageColumns_ * imageRows_);
+    if (rledecoder.fail()) return EC_MemoryExhausted;
+    Uint32 currentItem = startFragments_[frameNo];
+    return DcmRLECodecDecoder::decompressFrame(fragments_, rledecoder, currentItem, imageData8_ + frameNo * frameSize_,
+      imageColumns_, imageRows_, imageSamplesPerPixel_, imageBytesAllocated_, imagePlanarConfiguration_, enableReverseByteOrder_);
+  }
+
+private:
+
+  const DcmFragmentTable& fragments_;
+  const Uint32 *startFragments_;
+  Uint8 *imageData8_;
+  Uint32 frameSize_;
+  Uint16 imageColumns_;
+  Uint16 imageRows_;
+  Uint16 imageSamplesPerPixel_;
+  Uint16 imageBytesAllocated_;
+  Uint16 imagePlanarConfiguration_;
+  OFBool enableReverseByteOrder_;
+};
+
 
 
 DcmRLECodecDecoder::DcmRLECodecDecoder()
@@ -97,7 +166,6 @@ OFCondition DcmRLECodecDecoder::decode(
     Uint16 imageBitsAllocated = 0;
     Uint16 imageBytesAllocated = 0;
     Uint16 imagePlanarConfiguration = 0;
-    Uint32 rleHeader[16];
     DcmItem *ditem = OFstatic_cast(DcmItem *, dataset);
 
     if (result.good()) result = ditem->findAndGetUint16(DCM_SamplesPerPixel, imageSamplesPerPixel);
@@ -120,266 +188,395 @@ OFCondition DcmRLECodecDecoder::decode(
 
     if (result.good())
     {
-      DcmPixelItem *pixItem = NULL;
-      Uint8 * rleData = NULL;
-      const size_t bytesPerStripe = imageColumns * imageRows;
+      Uint32 frameSize = imageBytesAllocated * imageRows * imageColumns * imageSamplesPerPixel;
+      Uint32 totalSize = frameSize * imageFrames;
+      if (totalSize & 1) totalSize++; // align on 16-bit word boundary
+      Uint16 *imageData16 = NULL;
+
+      // frames can only be decompressed concurrently if we know where each frame starts
+      Uint32 threadCount = djcp->getThreadCount();
+      OFBool parallel = (threadCount > 1) && (imageFrames > 1);
+      Uint32 *startFragments = NULL;
+      if (parallel)
+      {
+        startFragments = new Uint32[imageFrames];
+        for (Sint32 frame = 0; parallel && (frame < imageFrames); ++frame)
+        {
+          if (determineStartFragment(frame, imageFrames, pixSeq, startFragments[frame]).bad()) parallel = OFFalse;
+        }
+      }
 
-      DcmRLEDecoder rledecoder(bytesPerStripe);
-      if (rledecoder.fail()) result = EC_MemoryExhausted;  // RLE decoder failed to initialize
-      else
+      // the fragment table loads all fragments before they are accessed by several threads
+      DcmFragmentTable fragments;
+      result = fragments.create(pixSeq, parallel);
+
+      if (result.good()) result = uncompressedPixelData.createUint16Array(totalSize/sizeof(Uint16), imageData16);
+      if (result.good())
       {
-        Uint32 frameSize = imageBytesAllocated * imageRows * imageColumns * imageSamplesPerPixel;
-        Uint32 totalSize = frameSize * imageFrames;
-        if (totalSize & 1) totalSize++; // align on 16-bit word boundary
-        Uint16 *imageData16 = NULL;
-        Sint32 currentFrame = 0;
-        Uint32 currentItem = 1; // ignore offset table
-        Uint32 numberOfStripes = 0;
-        Uint32 fragmentLength = 0;
-        Uint32 i;
-
-        result = uncompressedPixelData.createUint16Array(totalSize/sizeof(Uint16), imageData16);
-        if (result.good())
+        Uint8 *imageData8 = OFreinterpret_cast(Uint8 *, imageData16);
+
+        if (parallel)
+        {
+          DcmRLEFrameDecompressor decompressor(fragments, startFragments, imageData8, frameSize, imageColumns, imageRows,
+            imageSamplesPerPixel, imageBytesAllocated, imagePlanarConfiguration, enableReverseByteOrder);
+          DcmFrameWorkerPool pool(decompressor, threadCount);
+          result = pool.run(0, imageFrames);
+        }
+        else
         {
-          Uint8 *imageData8 = OFreinterpret_cast(Uint8 *, imageData16);
+          DcmRLEDecoder rledecoder(imageColumns * imageRows);
+          if (rledecoder.fail()) result = EC_MemoryExhausted;  // RLE decoder failed to initialize
+          Sint32 currentFrame = 0;
+          Uint32 currentItem = 1; // ignore offset table
 
           while ((currentFrame < imageFrames) && result.good())
           {
-            // get first pixel item of this frame
-            result = pixSeq->getItem(pixItem, currentItem++);
+            result = decompressFrame(fragments, rledecoder, currentItem, imageData8, imageColumns, imageRows,
+              imageSamplesPerPixel, imageBytesAllocated, imagePlanarConfiguration, enableReverseByteOrder);
+
+            // advance by one frame
             if (result.good())
             {
-              fragmentLength = pixItem->getLength();
-              result = pixItem->getUint8Array(rleData);
-              if (result.good())
-              {
-                // we require that the RLE header must be completely
-                // contained in the first fragment; otherwise bail out
-                if (fragmentLength < 64) result = EC_CannotChangeRepresentation;
-              }
+              currentFrame++;
+              imageData8 += frameSize;
             }
 
-            if (result.good())
-            {
-              // copy RLE header to buffer and adjust byte order
-              memcpy(rleHeader, rleData, 64);
-              swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, rleHeader, 16*sizeof(Uint32), sizeof(Uint32));
+          } /* while still frames to process */
+        }
 
-              // determine number of stripes.
-              numberOfStripes = rleHeader[0];
+        // adjust byte order for uncompressed image to little endian
+        swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, imageData16, totalSize, sizeof(Uint16));
+      }
+      delete[] startFragments;
+    }
 
-              // check that number of stripes in RLE header matches our expectation
-              if ((numberOfStripes < 1) || (numberOfStripes > 15) ||
-                  (numberOfStripes != OFstatic_cast(Uint32, imageBytesAllocated) * imageSamplesPerPixel))
-                  result = EC_CannotChangeRepresentation;
-            }
+    // the following operations do not affect the Image Pixel Module
+    // but other modules such as SOP Common.  We only perform these
+    // changes if we're on the main level of the dataset,
+    // which should always identify itself as dataset, not as item.
+    if (dataset->ident() == EVR_dataset)
+    {
+        // create new SOP instance UID if codec parameters require so
+        if (result.good() && djcp->getUIDCreation()) result = 
+          DcmCodec::newInstance(OFstatic_cast(DcmItem *, dataset), NULL, NULL, NULL);
+    }
+  }
+  return result;
+}
 
-            if (result.good())
-            {
-              // this variable keeps the number of bytes we have processed
-              // for the current frame in earlier pixel fragments
-              Uint32 fragmentOffset = 0;
 
-              // this variable keeps the current position within the current fragment
-              Uint32 byteOffset = 0;
+OFCondition DcmRLECodecDecoder::decodeFrame(
+    const DcmRepresentationParameter * /* fromParam */,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel) const
+{
+  if ((fromPixSeq == NULL) || (dataset == NULL) || (buffer == NULL)) return EC_IllegalCall;
+  OFCondition result = EC_Normal;
 
-              OFBool lastStripe = OFFalse;
-              Uint32 inputBytes = 0;
+  // assume we can cast the codec parameter to what we need
+  const DcmRLECodecParameter *djcp = OFstatic_cast(const DcmRLECodecParameter *, cp);
 
-              // pointers for buffer copy operations
-              Uint8 *outputBuffer = NULL;
-              Uint8 *pixelPointer = NULL;
+  OFBool enableReverseByteOrder = djcp->getReverseDecompressionByteOrder();
 
-              // byte offset for first sample in frame
-              Uint32 sampleOffset = 0;
+  Uint16 imageSamplesPerPixel = 0;
+  Uint16 imageRows = 0;
+  Uint16 imageColumns = 0;
+  Sint32 imageFrames = 1;
+  Uint16 imageBitsAllocated = 0;
+  Uint16 imageBytesAllocated = 0;
+  Uint16 imagePlanarConfiguration = 0;
+
+  if (result.good()) result = dataset->findAndGetUint16(DCM_SamplesPerPixel, imageSamplesPerPixel);
+  if (result.good()) result = dataset->findAndGetUint16(DCM_Rows, imageRows);
+  if (result.good()) result = dataset->findAndGetUint16(DCM_Columns, imageColumns);
+  if (result.good()) result = dataset->findAndGetUint16(DCM_BitsAllocated, imageBitsAllocated);
+  if (result.good())
+  {
+    imageBytesAllocated = OFstatic_cast(Uint16, imageBitsAllocated / 8);
+    if ((imageBitsAllocated < 8)||(imageBitsAllocated % 8 != 0)) result = EC_CannotChangeRepresentation;
+  }
+  if (result.good() && (imageSamplesPerPixel > 1))
+  {
+    result = dataset->findAndGetUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
+  }
+
+  // number of frames is an optional attribute - we don't mind if it isn't present.
+  if (result.good()) (void) dataset->findAndGetSint32(DCM_NumberOfFrames, imageFrames);
+  if (imageFrames < 1) imageFrames = 1; // default in case this attribute contains garbage
+  if (result.good() && (frameNo >= OFstatic_cast(Uint32, imageFrames))) result = EC_IllegalCall;
+
+  if (result.good())
+  {
+    Uint32 frameSize = imageBytesAllocated * imageRows * imageColumns * imageSamplesPerPixel;
+    if (bufSize < frameSize) result = EC_IllegalCall;
+  }
 
-              // byte offset between samples
-              Uint32 offsetBetweenSamples = 0;
+  // locate the first fragment of the frame unless the caller knows it already
+  if (result.good() && (startFragment == 0))
+    result = determineStartFragment(frameNo, imageFrames, fromPixSeq, startFragment);
 
-              // temporary variables
-              Uint32 sample = 0;
-              Uint32 byte = 0;
-              register Uint32 pixel = 0;
+  if (result.good())
+  {
+    DcmRLEDecoder rledecoder(imageColumns * imageRows);
+    if (rledecoder.fail()) result = EC_MemoryExhausted;  // RLE decoder failed to initialize
+    else
+    {
+      Uint32 currentItem = startFragment;
+      DcmFragmentTable fragments;
+      result = fragments.create(fromPixSeq, OFFalse);
+      if (result.good()) result = decompressFrame(fragments, rledecoder, currentItem, OFstatic_cast(Uint8 *, buffer), imageColumns, imageRows,
+        imageSamplesPerPixel, imageBytesAllocated, imagePlanarConfiguration, enableReverseByteOrder);
+      if (result.good())
+      {
+        // multi-byte samples have been stored in little endian byte order
+        if (imageBytesAllocated > 1)
+          swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, buffer, imageBytesAllocated * imageRows * imageColumns * imageSamplesPerPixel, imageBytesAllocated);
 
-              // for each stripe in stripe set
-              for (i=0; (i<numberOfStripes) && result.good(); ++i)
+        // RLE does not change the color model
+        result = dataset->findAndGetOFString(DCM_PhotometricInterpretation, decompressedColorModel);
+        if (result.good()) startFragment = currentItem;
+      }
+    }
+  }
+  return result;
+}
+
+
+OFCondition DcmRLECodecDecoder::decompressFrame(
+    const DcmFragmentTable& fragments,
+    DcmRLEDecoder& rledecoder,
+    Uint32& currentItem,
+    Uint8 * imageData8,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 imageBytesAllocated,
+    Uint16 imagePlanarConfiguration,
+    OFBool enableReverseByteOrder)
+{
+  OFCondition result = EC_Normal;
+  DcmPixelItem *pixItem = NULL;
+  Uint8 * rleData = NULL;
+  Uint32 rleHeader[16];
+  Uint32 numberOfStripes = 0;
+  Uint32 fragmentLength = 0;
+  Uint32 i;
+  const size_t bytesPerStripe = imageColumns * imageRows;
+
+  // get first pixel item of this frame
+  result = fragments.getItem(pixItem, currentItem++);
+  if (result.good())
+  {
+    fragmentLength = pixItem->getLength();
+    result = pixItem->getUint8Array(rleData);
+    if (result.good())
+    {
+      // we require that the RLE header must be completely
+      // contained in the first fragment; otherwise bail out
+      if (fragmentLength < 64) result = EC_CannotChangeRepresentation;
+    }
+  }
+
+  if (result.good())
+  {
+    // copy RLE header to buffer and adjust byte order
+    memcpy(rleHeader, rleData, 64);
+    swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, rleHeader, 16*sizeof(Uint32), sizeof(Uint32));
+
+    // determine number of stripes.
+    numberOfStripes = rleHeader[0];
+
+    // check that number of stripes in RLE header matches our expectation
+    if ((numberOfStripes < 1) || (numberOfStripes > 15) ||
+        (numberOfStripes != OFstatic_cast(Uint32, imageBytesAllocated) * imageSamplesPerPixel))
+        result = EC_CannotChangeRepresentation;
+  }
+
+  if (result.good())
+  {
+    // this variable keeps the number of bytes we have processed
+    // for the current frame in earlier pixel fragments
+    Uint32 fragmentOffset = 0;
+
+    // this variable keeps the current position within the current fragment
+    Uint32 byteOffset = 0;
+
+    OFBool lastStripe = OFFalse;
+    Uint32 inputBytes = 0;
+
+    // pointers for buffer copy operations
+    Uint8 *outputBuffer = NULL;
+    Uint8 *pixelPointer = NULL;
+
+    // byte offset for first sample in frame
+    Uint32 sampleOffset = 0;
+
+    // byte offset between samples
+    Uint32 offsetBetweenSamples = 0;
+
+    // temporary variables
+    Uint32 sample = 0;
+    Uint32 byte = 0;
+    register Uint32 pixel = 0;
+
+    // for each stripe in stripe set
+    for (i=0; (i<numberOfStripes) && result.good(); ++i)
+    {
+      // reset RLE codec
+      rledecoder.clear();
+
+      // adjust start point for RLE stripe, ignoring trailing garbage from the last run
+      byteOffset = rleHeader[i+1];
+      if (byteOffset < fragmentOffset) result = EC_CannotChangeRepresentation;
+      else
+      {
+        byteOffset -= fragmentOffset; // now byteOffset is correct but may point to next fragment
+        while ((byteOffset > fragmentLength) && result.good())
+        {
+          result = fragments.getItem(pixItem, currentItem++);
+          if (result.good())
+          {
+            byteOffset -= fragmentLength;
+            fragmentOffset += fragmentLength;
+            fragmentLength = pixItem->getLength();
+            result = pixItem->getUint8Array(rleData);
+          }
+        }
+      }
+
+      // byteOffset now points to the first byte of the new RLE stripe
+      // check if the current stripe is the last one for this frame
+      if (i+1 == numberOfStripes) lastStripe = OFTrue; else lastStripe = OFFalse;
+
+      if (lastStripe)
+      {
+        // the last stripe needs special handling because we cannot use the
+        // offset table to determine the number of bytes to feed to the codec
+        // if the RLE data is split in multiple fragments. We need to feed
+        // data fragment by fragment until the RLE codec has produced
+        // sufficient output.
+        while ((rledecoder.size() < bytesPerStripe) && result.good())
+        {
+          // feed complete remaining content of fragment to RLE codec and
+          // switch to next fragment
+          result = rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, fragmentLength - byteOffset));
+
+          // special handling for zero pad byte at the end of the RLE stream
+          // which results in an EC_StreamNotifyClient return code
+          // or trailing garbage data which results in EC_CorruptedData
+          if (rledecoder.size() == bytesPerStripe) result = EC_Normal;
+
+          // Check if we're already done. If yes, don't change fragment
+          if (result.good() || result == EC_StreamNotifyClient)
+          {
+            if (rledecoder.size() < bytesPerStripe)
+            {
+              result = fragments.getItem(pixItem, currentItem++);
+              if (result.good())
               {
-                // reset RLE codec
-                rledecoder.clear();
-
-                // adjust start point for RLE stripe, ignoring trailing garbage from the last run
-                byteOffset = rleHeader[i+1];
-                if (byteOffset < fragmentOffset) result = EC_CannotChangeRepresentation;
-                else
-                {
-                  byteOffset -= fragmentOffset; // now byteOffset is correct but may point to next fragment
-                  while ((byteOffset > fragmentLength) && result.good())
-                  {
-                    result = pixSeq->getItem(pixItem, currentItem++);
-                    if (result.good())
-                    {
-                      byteOffset -= fragmentLength;
-                      fragmentOffset += fragmentLength;
-                      fragmentLength = pixItem->getLength();
-                      result = pixItem->getUint8Array(rleData);
-                    }
-                  }
-                }
-
-                // byteOffset now points to the first byte of the new RLE stripe
-                // check if the current stripe is the last one for this frame
-                if (i+1 == numberOfStripes) lastStripe = OFTrue; else lastStripe = OFFalse;
-
-                if (lastStripe)
-                {
-                  // the last stripe needs special handling because we cannot use the
-                  // offset table to determine the number of bytes to feed to the codec
-                  // if the RLE data is split in multiple fragments. We need to feed
-                  // data fragment by fragment until the RLE codec has produced
-                  // sufficient output.
-                  while ((rledecoder.size() < bytesPerStripe) && result.good())
-                  {
-                    // feed complete remaining content of fragment to RLE codec and
-                    // switch to next fragment
-                    result = rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, fragmentLength - byteOffset));
-
-                    // special handling for zero pad byte at the end of the RLE stream
-                    // which results in an EC_StreamNotifyClient return code
-                    // or trailing garbage data which results in EC_CorruptedData
-                    if (rledecoder.size() == bytesPerStripe) result = EC_Normal;
-
-                    // Check if we're already done. If yes, don't change fragment
-                    if (result.good() || result == EC_StreamNotifyClient)
-                    {
-                      if (rledecoder.size() < bytesPerStripe)
-                      {
-                        result = pixSeq->getItem(pixItem, currentItem++);
-                        if (result.good())
-                        {
-                          byteOffset = 0;
-                          fragmentOffset += fragmentLength;
-                          fragmentLength = pixItem->getLength();
-                          result = pixItem->getUint8Array(rleData);
-                        }
-                      }
-                      else byteOffset = fragmentLength;
-                    }
-                  } /* while */
-                }
-                else
-                {
-                  // not the last stripe. We can use the offset table to determine
-                  // the number of bytes to feed to the RLE codec.
-                  inputBytes = rleHeader[i+2];
-                  if (inputBytes < rleHeader[i+1]) result = EC_CannotChangeRepresentation;
-                  else
-                  {
-                    inputBytes -= rleHeader[i+1]; // number of bytes to feed to codec
-                    while ((inputBytes > (fragmentLength - byteOffset)) && result.good())
-                    {
-                      // feed complete remaining content of fragment to RLE codec and
-                      // switch to next fragment
-                      result = rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, fragmentLength - byteOffset));
-
-                      if (result.good() || result == EC_StreamNotifyClient)
-                        result = pixSeq->getItem(pixItem, currentItem++);
-                      if (result.good())
-                      {
-                        inputBytes -= fragmentLength - byteOffset;
-                        byteOffset = 0;
-                        fragmentOffset += fragmentLength;
-                        fragmentLength = pixItem->getLength();
-                        result = pixItem->getUint8Array(rleData);
-                      }
-                    } /* while */
-
-                    // last fragment for this RLE stripe
-                    result = rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, inputBytes));
-
-                    // special handling for zero pad byte at the end of the RLE stream
-                    // which results in an EC_StreamNotifyClient return code
-                    // or trailing garbage data which results in EC_CorruptedData
-                    if (rledecoder.size() == bytesPerStripe) result = EC_Normal;
-
-                    byteOffset += inputBytes;
-                  }
-                }
-
-                // make sure the RLE decoder has produced the right amount of data
-                if (result.good() && (rledecoder.size() != bytesPerStripe))
-                {
-                  // error: RLE decoder is finished but has produced insufficient data for this stripe
-                  result = EC_CannotChangeRepresentation;
-                }
-
-                // distribute decompressed bytes into output image array
-                if (result.good())
-                {
-                  // which sample and byte are we currently compressing?
-                  sample = i / imageBytesAllocated;
-                  byte = i % imageBytesAllocated;
-
-                  // raw buffer containing bytesPerStripe bytes of uncompressed data
-                  outputBuffer = OFstatic_cast(Uint8 *, rledecoder.getOutputBuffer());
-
-                  // compute byte offsets
-                  if (imagePlanarConfiguration == 0)
-                  {
-                     sampleOffset = sample * imageBytesAllocated;
-                     offsetBetweenSamples = imageSamplesPerPixel * imageBytesAllocated;
-                  }
-                  else
-                  {
-                     sampleOffset = sample * imageBytesAllocated * imageColumns * imageRows;
-                     offsetBetweenSamples = imageBytesAllocated;
-                  }
-
-                  // initialize pointer to output data
-                  if (enableReverseByteOrder)
-                  {
-                    // assume incorrect LSB to MSB order of RLE segments as produced by some tools
-                    pixelPointer = imageData8 + sampleOffset + byte;
-                  }
-                  else
-                  {
-                    pixelPointer = imageData8 + sampleOffset + imageBytesAllocated - byte - 1;
-                  }
-
-                  // loop through all pixels of the frame
-                  for (pixel = 0; pixel < bytesPerStripe; ++pixel)
-                  {
-                    *pixelPointer = *outputBuffer++;
-                    pixelPointer += offsetBetweenSamples;
-                  }
-                }
-              } /* for */
+                byteOffset = 0;
+                fragmentOffset += fragmentLength;
+                fragmentLength = pixItem->getLength();
+                result = pixItem->getUint8Array(rleData);
+              }
             }
+            else byteOffset = fragmentLength;
+          }
+        } /* while */
+      }
+      else
+      {
+        // not the last stripe. We can use the offset table to determine
+        // the number of bytes to feed to the RLE codec.
+        inputBytes = rleHeader[i+2];
+        if (inputBytes < rleHeader[i+1]) result = EC_CannotChangeRepresentation;
+        else
+        {
+          inputBytes -= rleHeader[i+1]; // number of bytes to feed to codec
+          while ((inputBytes > (fragmentLength - byteOffset)) && result.good())
+          {
+            // feed complete remaining content of fragment to RLE codec and
+            // switch to next fragment
+            result = rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, fragmentLength - byteOffset));
 
-            // advance by one frame
+            if (result.good() || result == EC_StreamNotifyClient)
+              result = fragments.getItem(pixItem, currentItem++);
             if (result.good())
             {
-              currentFrame++;
-              imageData8 += frameSize;
+              inputBytes -= fragmentLength - byteOffset;
+              byteOffset = 0;
+              fragmentOffset += fragmentLength;
+              fragmentLength = pixItem->getLength();
+              result = pixItem->getUint8Array(rleData);
             }
+          } /* while */
 
-          } /* while still frames to process */
+          // last fragment for this RLE stripe
+          result = rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, inputBytes));
 
-          // adjust byte order for uncompressed image to little endian
-          swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, imageData16, totalSize, sizeof(Uint16));
+          // special handling for zero pad byte at the end of the RLE stream
+          // which results in an EC_StreamNotifyClient return code
+          // or trailing garbage data which results in EC_CorruptedData
+          if (rledecoder.size() == bytesPerStripe) result = EC_Normal;
+
+          byteOffset += inputBytes;
         }
       }
-    }
 
-    // the following operations do not affect the Image Pixel Module
-    // but other modules such as SOP Common.  We only perform these
-    // changes if we're on the main level of the dataset,
-    // which should always identify itself as dataset, not as item.
-    if (dataset->ident() == EVR_dataset)
-    {
-        // create new SOP instance UID if codec parameters require so
-        if (result.good() && djcp->getUIDCreation()) result = 
-          DcmCodec::newInstance(OFstatic_cast(DcmItem *, dataset), NULL, NULL, NULL);
-    }
+      // make sure the RLE decoder has produced the right amount of data
+      if (result.good() && (rledecoder.size() != bytesPerStripe))
+      {
+        // error: RLE decoder is finished but has produced insufficient data for this stripe
+        result = EC_CannotChangeRepresentation;
+      }
+
+      // distribute decompressed bytes into output image array
+      if (result.good())
+      {
+        // which sample and byte are we currently compressing?
+        sample = i / imageBytesAllocated;
+        byte = i % imageBytesAllocated;
+
+        // raw buffer containing bytesPerStripe bytes of uncompressed data
+        outputBuffer = OFstatic_cast(Uint8 *, rledecoder.getOutputBuffer());
+
+        // compute byte offsets
+        if (imagePlanarConfiguration == 0)
+        {
+           sampleOffset = sample * imageBytesAllocated;
+           offsetBetweenSamples = imageSamplesPerPixel * imageBytesAllocated;
+        }
+        else
+        {
+           sampleOffset = sample * imageBytesAllocated * imageColumns * imageRows;
+           offsetBetweenSamples = imageBytesAllocated;
+        }
+
+        // initialize pointer to output data
+        if (enableReverseByteOrder)
+        {
+          // assume incorrect LSB to MSB order of RLE segments as produced by some tools
+          pixelPointer = imageData8 + sampleOffset + byte;
+        }
+        else
+        {
+          pixelPointer = imageData8 + sampleOffset + imageBytesAllocated - byte - 1;
+        }
+
+        // loop through all pixels of the frame
+        for (pixel = 0; pixel < bytesPerStripe; ++pixel)
+        {
+          *pixelPointer = *outputBuffer++;
+          pixelPointer += offsetBetweenSamples;
+        }
+      }
+    } /* for */
   }
   return result;
 }
@@ -40,6 +40,7 @@
 #include "dcmtk/dcmdata/dcpixseq.h"  /* for class DcmPixelSequence */
 #include "dcmtk/dcmdata/dcpxitem.h"  /* for class DcmPixelItem */
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary */
+#include "dcmtk/dcmdata/dcfrmpol.h"  /* for class DcmFrameWorkerPool */
 #include "dcmtk/ofstd/ofstd.h"
 
 #define INCLUDE_CSTDIO
@@ -50,6 +51,78 @@ typedef OFList<DcmRLEEncoder *> DcmRLEEncoderList;
 typedef OFListIterator(DcmRLEEncoder *) DcmRLEEncoderListIterator;
 
 
+/** compresses a range of frames of an image concurrently.
+ *  The compressed frames are stored in arrays indexed by the position
+ *  of the frame within the current range.
+ */
+class DcmRLEFrameCompressor: public DcmFrameProcessor
+{
+public:
+
+  /** constructor.
+   *  @param pixelData8 uncompressed pixel data of all frames, little endian byte order
+   *  @param frameSize size of an uncompressed frame in bytes
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param samplesPerPixel number of samples per pixel
+   *  @param bytesAllocated number of bytes allocated per sample
+   *  @param planarConfiguration planar configuration of the pixel data
+   *  @param rleData array in which the compressed frames are stored
+   *  @param rleSize array in which the sizes of the compressed frames are stored
+   */
+  DcmRLEFrameCompressor(
+    const Uint8 *pixelData8,
+    Uint32 frameSize,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    Uint16 bytesAllocated,
+    Uint16 planarConfiguration,
+    Uint8 **rleData,
+    Uint32 *rleSize)
+  : pixelData8_(pixelData8)
+  , frameSize_(frameSize)
+  , columns_(columns)
+  , rows_(rows)
+  , samplesPerPixel_(samplesPerPixel)
+  , bytesAllocated_(bytesAllocated)
+  , planarConfiguration_(planarConfiguration)
+  , rleData_(rleData)
+  , rleSize_(rleSize)
+  , firstFrame_(0)
+  {
+  }
+
+  /** sets the number of the frame stored at index 0 of the arrays
+   *  @param firstFrame number of the first frame of the current range
+   */
+  void setFirstFrame(Uint32 firstFrame)
+  {
+    firstFrame_ = firstFrame;
+  }
+
+  virtual OFCondition processFrame(Uint32 frameNo)
+  {
+    Uint32 index = frameNo - firstFrame_;
+    return DcmRLECodecEncoder::compressFrame(pixelData8_ + frameSize_ * frameNo, columns_, rows_, samplesPerPixel_,
+      bytesAllocated_, planarConfiguration_, rleData_[index], rleSize_[index]);
+  }
+
+private:
+
+  const Uint8 *pixelData8_;
+  Uint32 frameSize_;
+  Uint16 columns_;
+  Uint16 rows_;
+  Uint16 samplesPerPixel_;
+  Uint16 bytesAllocated_;
+  Uint16 planarConfiguration_;
+  Uint8 **rleData_;
+  Uint32 *rleSize_;
+  Uint32 firstFrame_;
+};
+
+
 // =======================================================================
 
 DcmRLECodecEncoder::DcmRLECodecEncoder()
@@ -89,6 +162,22 @@ OFCondition DcmRLECodecEncoder::decode(
 }
 
 
+OFCondition DcmRLECodecEncoder::decodeFrame(
+    const DcmRepresentationParameter * /* fromParam */,
+    DcmPixelSequence * /* fromPixSeq */,
+    const DcmCodecParameter * /* cp */,
+    DcmItem * /* dataset */,
+    Uint32 /* frameNo */,
+    Uint32& /* startFragment */,
+    void * /* buffer */,
+    Uint32 /* bufSize */,
+    OFString& /* decompressedColorModel */) const
+{
+  // we are an encoder only
+  return EC_IllegalCall;
+}
+
+
 OFCondition DcmRLECodecEncoder::encode(
     const E_TransferSyntax /* fromRepType */,
     const DcmRepresentationParameter * /* fromRepParam */,
@@ -119,12 +208,7 @@ OFCondition DcmRLECodecEncoder::encode(
   (void)localStack.pop();             // pop pixel data element from stack
   DcmObject *dataset = localStack.pop(); // this is the item in which the pixel data is located
   Uint8 *pixelData8 = OFreinterpret_cast(Uint8 *, OFconst_cast(Uint16 *, pixelData));
-  Uint8 *pixelPointer = NULL;
   DcmOffsetList offsetList;
-  DcmRLEEncoderList rleEncoderList;
-  DcmRLEEncoderListIterator first = rleEncoderList.begin();
-  DcmRLEEncoderListIterator last = rleEncoderList.end();
-  Uint32 rleHeader[16];
   Uint32 i;
   OFBool byteSwapped = OFFalse;  // true if we have byte-swapped the original pixel data
 
@@ -200,133 +284,65 @@ OFCondition DcmRLECodecEncoder::encode(
     // create RLE stripe sets
     if (result.good())
     {
-      const Uint32 bytesPerStripe = columns * rows;
       const Uint32 frameSize = columns * rows * samplesPerPixel * bytesAllocated;
-      Uint32 frameOffset = 0;
-      Uint32 sampleOffset = 0;
-      Uint32 offsetBetweenSamples = 0;
-      Uint32 sample = 0;
-      Uint32 byte = 0;
-      register Uint32 pixel = 0;
-      register Uint32 columnCounter = 0;
-
-      DcmRLEEncoder *rleEncoder = NULL;
-      Uint32 rleSize = 0;
-      Uint8 *rleData = NULL;
-      Uint8 *rleData2 = NULL;
-
-      // compute byte offset between samples
-      if (planarConfiguration == 0)
-         offsetBetweenSamples = samplesPerPixel * bytesAllocated;
-         else offsetBetweenSamples = bytesAllocated;
-
-      // loop through all frames of the image
-      for (Uint32 currentFrame = 0; ((currentFrame < OFstatic_cast(Uint32, numberOfFrames)) && result.good()); currentFrame++)
-      {
-        // offset to start of frame, in bytes
-        frameOffset = frameSize * currentFrame;
+      const Uint32 frameCount = OFstatic_cast(Uint32, numberOfFrames);
+      const Uint32 threadCount = djcp->getThreadCount();
 
-        // loop through all samples of one frame
-        for (sample = 0; sample < samplesPerPixel; sample++)
+      if ((threadCount > 1) && (frameCount > 1))
+      {
+        // compress a batch of frames concurrently, then store them in their original order.
+        // The batch size limits the amount of compressed data kept in memory.
+        const Uint32 batchSize = 4 * threadCount;
+        Uint8 **rleData = new Uint8 *[batchSize];
+        Uint32 *rleSize = new Uint32[batchSize];
+        for (i = 0; i < batchSize; i++) rleData[i] = NULL;
+
+        DcmRLEFrameCompressor compressor(pixelData8, frameSize, columns, rows, samplesPerPixel,
+          bytesAllocated, planarConfiguration, rleData, rleSize);
+        DcmFrameWorkerPool pool(compressor, threadCount);
+
+        for (Uint32 firstFrame = 0; (firstFrame < frameCount) && result.good(); firstFrame += batchSize)
         {
-          // compute byte offset for first sample in frame
-          if (planarConfiguration == 0)
-             sampleOffset = sample * bytesAllocated;
-             else sampleOffset = sample * bytesAllocated * columns * rows;
-
-          // loop through the bytes of one sample
-          for (byte = 0; byte < bytesAllocated; byte++)
+          Uint32 count = (frameCount - firstFrame < batchSize) ? frameCount - firstFrame : batchSize;
+          compressor.setFirstFrame(firstFrame);
+          result = pool.run(firstFrame, count);
+          for (i = 0; i < count; i++)
           {
-            pixelPointer = pixelData8 + frameOffset + sampleOffset + bytesAllocated - byte - 1;
-
-            // initialize new RLE codec for this stripe
-            rleEncoder = new DcmRLEEncoder(1 /* DICOM padding required */);
-            if (rleEncoder)
+            if (result.good())
             {
-              rleEncoderList.push_back(rleEncoder);
-              columnCounter = columns;
-
-              // loop through all pixels of the frame
-              for (pixel = 0; pixel < bytesPerStripe; ++pixel)
-              {
-                rleEncoder->add(*pixelPointer);
-
-                // enforce DICOM rule that "Each row of the image shall be encoded
-                // separately and not cross a row boundary."
-                // (see DICOM part 5 section G.3.1)
-                if (--columnCounter == 0)
-                {
-                  rleEncoder->flush();
-                  columnCounter = columns;
-                }
-                pixelPointer += offsetBetweenSamples;
-              }
-
-              rleEncoder->flush();
-              if (rleEncoder->fail()) result = EC_MemoryExhausted;
-            } else result = EC_MemoryExhausted;
+              result = pixelSequence->storeCompressedFrame(offsetList, rleData[i], rleSize[i], djcp->getFragmentSize());
+              compressedSize += rleSize[i];
+            }
+            delete[] rleData[i];
+            rleData[i] = NULL;
           }
         }
+        delete[] rleData;
+        delete[] rleSize;
+      }
+      else
+      {
+        Uint8 *rleData = NULL;
+        Uint32 rleSize = 0;
 
-        // store frame and erase RLE codec list
-        if (result.good() && (rleEncoderList.size() > 0) && (rleEncoderList.size() < 16))
+        // loop through all frames of the image
+        for (Uint32 currentFrame = 0; ((currentFrame < frameCount) && result.good()); currentFrame++)
         {
-          // compute size of compressed frame including RLE header
-          // and populate RLE header
-          for (i=0; i<16; i++) rleHeader[i] = 0;
-          rleHeader[0] = rleEncoderList.size();
-          rleSize = 64;
-          i = 1;
-          first = rleEncoderList.begin();
-          while (first != last)
-          {
-            rleHeader[i++] = rleSize;
-            rleSize += (*first)->size();
-            ++first;
-          }
-
-          // allocate buffer for compressed frame
-          rleData = new Uint8[rleSize];
+          result = compressFrame(pixelData8 + frameSize * currentFrame, columns, rows, samplesPerPixel,
+            bytesAllocated, planarConfiguration, rleData, rleSize);
 
-          if (rleData)
+          // store compressed frame, breaking into segments if necessary
+          if (result.good())
           {
-            // copy RLE header to compressed frame buffer
-            swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, rleHeader, 16*sizeof(Uint32), sizeof(Uint32));
-            memcpy(rleData, rleHeader, 64);
-
-            // store RLE stripe sets in compressed frame buffer
-            rleData2 = rleData + 64;
-            first = rleEncoderList.begin();
-            while (first != last)
-            {
-              (*first)->write(rleData2);
-              rleData2 += (*first)->size();
-              delete *first;
-              first = rleEncoderList.erase(first);
-            }
-
-            // store compressed frame, breaking into segments if necessary
             result = pixelSequence->storeCompressedFrame(offsetList, rleData, rleSize, djcp->getFragmentSize());
             compressedSize += rleSize;
-
-            // erase buffer for compressed frame
-            delete[] rleData;
-          } else result = EC_MemoryExhausted;
-        }
-        else
-        {
-          // erase RLE codec list
-          first = rleEncoderList.begin();
-          while (first != last)
-          {
-            delete *first;
-            first = rleEncoderList.erase(first);
           }
-          if (result.good()) result = EC_CannotChangeRepresentation;
-        }
 
+          // erase buffer for compressed frame
+          delete[] rleData;
+          rleData = NULL;
+        }
       }
-
     }
 
     // store pixel sequence if everything went well.
@@ -416,6 +432,136 @@ OFCondition DcmRLECodecEncoder::updateDerivationDescription(
 }
 
 
+OFCondition DcmRLECodecEncoder::compressFrame(
+        const Uint8 *frameData,
+        Uint16 columns,
+        Uint16 rows,
+        Uint16 samplesPerPixel,
+        Uint16 bytesAllocated,
+        Uint16 planarConfiguration,
+        Uint8 *& rleData,
+        Uint32& rleSize)
+{
+  OFCondition result = EC_Normal;
+  DcmRLEEncoderList rleEncoderList;
+  DcmRLEEncoderListIterator first = rleEncoderList.begin();
+  DcmRLEEncoderListIterator last = rleEncoderList.end();
+  Uint32 rleHeader[16];
+  Uint32 i;
+  const Uint8 *pixelPointer = NULL;
+  const Uint32 bytesPerStripe = columns * rows;
+  Uint32 sampleOffset = 0;
+  Uint32 offsetBetweenSamples = 0;
+  Uint32 sample = 0;
+  Uint32 byte = 0;
+  register Uint32 pixel = 0;
+  register Uint32 columnCounter = 0;
+  DcmRLEEncoder *rleEncoder = NULL;
+  Uint8 *rleData2 = NULL;
+
+  rleData = NULL;
+  rleSize = 0;
+
+  // compute byte offset between samples
+  if (planarConfiguration == 0)
+     offsetBetweenSamples = samplesPerPixel * bytesAllocated;
+     else offsetBetweenSamples = bytesAllocated;
+
+  // loop through all samples of one frame
+  for (sample = 0; sample < samplesPerPixel; sample++)
+  {
+    // compute byte offset for first sample in frame
+    if (planarConfiguration == 0)
+       sampleOffset = sample * bytesAllocated;
+       else sampleOffset = sample * bytesAllocated * columns * rows;
+
+    // loop through the bytes of one sample
+    for (byte = 0; byte < bytesAllocated; byte++)
+    {
+      pixelPointer = frameData + sampleOffset + bytesAllocated - byte - 1;
+
+      // initialize new RLE codec for this stripe
+      rleEncoder = new DcmRLEEncoder(1 /* DICOM padding required */);
+      if (rleEncoder)
+      {
+        rleEncoderList.push_back(rleEncoder);
+        columnCounter = columns;
+
+        // loop through all pixels of the frame
+        for (pixel = 0; pixel < bytesPerStripe; ++pixel)
+        {
+          rleEncoder->add(*pixelPointer);
+
+          // enforce DICOM rule that "Each row of the image shall be encoded
+          // separately and not cross a row boundary."
+          // (see DICOM part 5 section G.3.1)
+          if (--columnCounter == 0)
+          {
+            rleEncoder->flush();
+            columnCounter = columns;
+          }
+          pixelPointer += offsetBetweenSamples;
+        }
+
+        rleEncoder->flush();
+        if (rleEncoder->fail()) result = EC_MemoryExhausted;
+      } else result = EC_MemoryExhausted;
+    }
+  }
+
+  // create compressed frame and erase RLE codec list
+  if (result.good() && (rleEncoderList.size() > 0) && (rleEncoderList.size() < 16))
+  {
+    // compute size of compressed frame including RLE header
+    // and populate RLE header
+    for (i=0; i<16; i++) rleHeader[i] = 0;
+    rleHeader[0] = rleEncoderList.size();
+    rleSize = 64;
+    i = 1;
+    first = rleEncoderList.begin();
+    while (first != last)
+    {
+      rleHeader[i++] = rleSize;
+      rleSize += (*first)->size();
+      ++first;
+    }
+
+    // allocate buffer for compressed frame
+    rleData = new Uint8[rleSize];
+
+    if (rleData)
+    {
+      // copy RLE header to compressed frame buffer
+      swapIfNecessary(EBO_LittleEndian, gLocalByteOrder, rleHeader, 16*sizeof(Uint32), sizeof(Uint32));
+      memcpy(rleData, rleHeader, 64);
+
+      // store RLE stripe sets in compressed frame buffer
+      rleData2 = rleData + 64;
+      first = rleEncoderList.begin();
+      while (first != last)
+      {
+        (*first)->write(rleData2);
+        rleData2 += (*first)->size();
+        delete *first;
+        first = rleEncoderList.erase(first);
+      }
+    } else result = EC_MemoryExhausted;
+  }
+  else
+  {
+    // erase RLE codec list
+    first = rleEncoderList.begin();
+    while (first != last)
+    {
+      delete *first;
+      first = rleEncoderList.erase(first);
+    }
+    if (result.good()) result = EC_CannotChangeRepresentation;
+  }
+  return result;
+}
+
+
 /*
  * CVS/RCS Log
  * $Log: dcrlecce.cc,v $
@@ -40,7 +40,8 @@ DcmRLECodecParameter::DcmRLECodecParameter(
     Uint32 pFragmentSize,
     OFBool pCreateOffsetTable,
     OFBool pConvertToSC,
-    OFBool pReverseDecompressionByteOrder)
+    OFBool pReverseDecompressionByteOrder,
+    Uint32 pThreadCount)
 : DcmCodecParameter()
 , fragmentSize(pFragmentSize)
 , createOffsetTable(pCreateOffsetTable)
@@ -48,6 +49,7 @@ DcmRLECodecParameter::DcmRLECodecParameter(
 , createInstanceUID(pCreateSOPInstanceUID)
 , reverseDecompressionByteOrder(pReverseDecompressionByteOrder)
 , verboseMode(pVerbose)
+, threadCount(pThreadCount > 0 ? pThreadCount : 1)
 {
 }
 
@@ -60,6 +62,7 @@ DcmRLECodecParameter::DcmRLECodecParameter(const DcmRLECodecParameter& arg)
 , createInstanceUID(arg.createInstanceUID)
 , reverseDecompressionByteOrder(arg.reverseDecompressionByteOrder)
 , verboseMode(arg.verboseMode)
+, threadCount(arg.threadCount)
 {
 }
 
@@ -46,7 +46,8 @@ DcmRLECodecDecoder *DcmRLEDecoderRegistration::codec          = NULL;
 void DcmRLEDecoderRegistration::registerCodecs(
     OFBool pCreateSOPInstanceUID,
     OFBool pVerbose,
-    OFBool pReverseDecompressionByteOrder)
+    OFBool pReverseDecompressionByteOrder,
+    Uint32 pThreadCount)
 {
   if (! registered)
   {
@@ -54,7 +55,8 @@ void DcmRLEDecoderRegistration::registerCodecs(
       pVerbose,
       pCreateSOPInstanceUID,
       0, OFTrue, OFFalse,
-      pReverseDecompressionByteOrder);
+      pReverseDecompressionByteOrder,
+      pThreadCount);
       
     if (cp)
     {
@@ -48,7 +48,8 @@ void DcmRLEEncoderRegistration::registerCodecs(
     OFBool pVerbose,
     Uint32 pFragmentSize,
     OFBool pCreateOffsetTable,
-    OFBool pConvertToSC)
+    OFBool pConvertToSC,
+    Uint32 pThreadCount)
 {
   if (! registered)
   {
@@ -57,7 +58,9 @@ void DcmRLEEncoderRegistration::registerCodecs(
       pCreateSOPInstanceUID,
       pFragmentSize,
       pCreateOffsetTable,
-      pConvertToSC);
+      pConvertToSC,
+      OFFalse,
+      pThreadCount);
 
     if (cp)
     {
@@ -65,7 +65,12 @@ DcmSequenceOfItems::DcmSequenceOfItems(
   itemList(new DcmList),
   lastItemComplete(OFTrue),
   fStartPosition(0),
-  readAsUN_(readAsUN)
+  readAsUN_(readAsUN),
+  fReadSequencesOnDemand(OFFalse),
+  fLoadItems(NULL),
+  fLoadXfer(EXS_Unknown),
+  fLoadGlenc(EGL_noChange),
+  fLoadMaxReadLength(DCM_MaxReadLength)
 {
 }
 
@@ -78,8 +83,16 @@ DcmSequenceOfItems::DcmSequenceOfItems(const DcmSequenceOfItems &old)
     itemList(new DcmList),
     lastItemComplete(old.lastItemComplete),
     fStartPosition(old.fStartPosition),
-    readAsUN_(old.readAsUN_)
+    readAsUN_(old.readAsUN_),
+    fReadSequencesOnDemand(old.fReadSequencesOnDemand),
+    fLoadItems(NULL),
+    fLoadXfer(old.fLoadXfer),
+    fLoadGlenc(old.fLoadGlenc),
+    fLoadMaxReadLength(old.fLoadMaxReadLength)
 {
+    /* items not parsed yet are parsed by the copy when accessed */
+    if (old.fLoadItems)
+        fLoadItems = old.fLoadItems->clone();
     if (!old.itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -105,6 +118,7 @@ DcmSequenceOfItems::~DcmSequenceOfItems()
         delete dO;
     }
     delete itemList;
+    delete fLoadItems;
 }
 
 
@@ -117,6 +131,13 @@ DcmSequenceOfItems &DcmSequenceOfItems::operator=(const DcmSequenceOfItems &obj)
     lastItemComplete = obj.lastItemComplete;
     fStartPosition = obj.fStartPosition;
     readAsUN_ = obj.readAsUN_;
+    fReadSequencesOnDemand = obj.fReadSequencesOnDemand;
+    DcmInputStreamFactory *newLoadItems = (obj.fLoadItems) ? obj.fLoadItems->clone() : NULL;
+    delete fLoadItems;
+    fLoadItems = newLoadItems;
+    fLoadXfer = obj.fLoadXfer;
+    fLoadGlenc = obj.fLoadGlenc;
+    fLoadMaxReadLength = obj.fLoadMaxReadLength;
     
     DcmList *newList = new DcmList; // DcmList has no copy constructor. Need to copy ourselves.
     if (newList)
@@ -181,6 +202,7 @@ void DcmSequenceOfItems::print(ostream &out,
                                const char *pixelFileName,
                                size_t *pixelCounter)
 {
+    loadItems();
     /* print sequence start line */
     if (flags & DCMTypes::PF_showTreeStructure)
     {
@@ -236,6 +258,7 @@ void DcmSequenceOfItems::print(ostream &out,
 OFCondition DcmSequenceOfItems::writeXML(ostream &out,
                                          const size_t flags)
 {
+    loadItems();
     OFString xmlString;
     DcmVR vr(Tag.getVR());
     /* XML start tag for "sequence" */
@@ -282,6 +305,7 @@ OFBool DcmSequenceOfItems::canWriteXfer(const E_TransferSyntax newXfer,
                                         const E_TransferSyntax oldXfer)
 {
     OFBool canWrite = OFTrue;
+    loadItems();
 
     if (newXfer == EXS_Unknown)
         canWrite = OFFalse;
@@ -320,6 +344,7 @@ Uint32 DcmSequenceOfItems::getLength(const E_TransferSyntax xfer,
                                      const E_EncodingType enctype)
 {
     Uint32 seqlen = 0;
+    loadItems();
     if (!itemList->empty())
     {
         DcmItem *dI;
@@ -344,9 +369,9 @@ OFCondition DcmSequenceOfItems::computeGroupLengthAndPadding(const E_GrpLenEncod
                                                              const Uint32 subPadlen,
                                                              Uint32 instanceLength)
 {
-    OFCondition l_error = EC_Normal;
+    OFCondition l_error = loadItems();
 
-    if (!itemList->empty())
+    if (l_error.good() && !itemList->empty())
     {
         itemList->seek(ELP_first);
         do {
@@ -393,6 +418,9 @@ OFCondition DcmSequenceOfItems::makeSubObject(DcmObject *&subObject,
             l_error = EC_CorruptedData;
             break;
     }
+    /* sequences nested in the item are parsed on demand as well */
+    if (fReadSequencesOnDemand && subItem)
+        subItem->setReadSequencesOnDemand(OFTrue);
     subObject = subItem;
     return l_error;
 }
@@ -492,6 +520,52 @@ OFCondition DcmSequenceOfItems::readSubItem(DcmInputStream &inStream,
 // ********************************
 
 
+OFCondition DcmSequenceOfItems::readItems(DcmInputStream &inStream,
+                                          const E_TransferSyntax xfer,
+                                          const E_GrpLenEncoding glenc,
+                                          const Uint32 maxReadLength)
+{
+    itemList->seek(ELP_last); // append data at end
+    while (inStream.good() && ((fTransferredBytes < Length) || !lastItemComplete))
+    {
+        DcmTag newTag;
+        Uint32 newValueLength = 0;
+
+        if (lastItemComplete)
+        {
+            errorFlag = readTagAndLength(inStream, xfer, newTag, newValueLength);
+
+            if (errorFlag.bad())
+                break;                  // finish while loop
+            else
+                fTransferredBytes += 8;
+
+            lastItemComplete = OFFalse;
+            errorFlag = readSubItem(inStream, newTag, newValueLength, xfer, glenc, maxReadLength);
+            if (errorFlag.good())
+                lastItemComplete = OFTrue;
+        }
+        else
+        {
+            errorFlag = itemList->get()->read(inStream, xfer, glenc, maxReadLength);
+            if (errorFlag.good())
+                lastItemComplete = OFTrue;
+        }
+        fTransferredBytes = inStream.tell() - fStartPosition;
+
+        if (errorFlag.bad())
+            break;
+
+    } //while
+    if (((fTransferredBytes < Length) || !lastItemComplete) && errorFlag.good())
+        errorFlag = EC_StreamNotifyClient;
+    return errorFlag;
+}
+
+
+// ********************************
+
+
 OFCondition DcmSequenceOfItems::read(DcmInputStream &inStream,
                                      const E_TransferSyntax xfer,
                                      const E_GrpLenEncoding glenc,
@@ -507,48 +581,40 @@ OFCondition DcmSequenceOfItems::read(DcmInputStream &inStream,
             errorFlag = EC_EndOfStream;
         else if (errorFlag.good() && (fTransferState != ERW_ready))
         {
+            E_TransferSyntax readxfer = readAsUN_ ? EXS_LittleEndianImplicit : xfer;
+
             if (fTransferState == ERW_init)
             {
                 fStartPosition = inStream.tell();   // Position Sequence-Value
                 fTransferState = ERW_inWork;
-            }
 
-            E_TransferSyntax readxfer = readAsUN_ ? EXS_LittleEndianImplicit : xfer;
-            
-            itemList->seek(ELP_last); // append data at end
-            while (inStream.good() && ((fTransferredBytes < Length) || !lastItemComplete))
-            {
-                DcmTag newTag;
-                Uint32 newValueLength = 0;
-
-                if (lastItemComplete)
+                /* If requested and the stream has random access, only remember where */
+                /* the items start and skip them. They are parsed by loadItems() when */
+                /* first accessed. A sequence with undefined length must be parsed in */
+                /* order to find its end. */
+                if (fReadSequencesOnDemand && (Length != DCM_UndefinedLength) && (Length > 0) && itemList->empty())
                 {
-                    errorFlag = readTagAndLength(inStream, readxfer, newTag, newValueLength);
-
-                    if (errorFlag.bad())
-                        break;                  // finish while loop
-                    else
-                        fTransferredBytes += 8;
-
-                    lastItemComplete = OFFalse;
-                    errorFlag = readSubItem(inStream, newTag, newValueLength, readxfer, glenc, maxReadLength);
-                    if (errorFlag.good())
-                        lastItemComplete = OFTrue;
-                }
-                else
-                {
-                    errorFlag = itemList->get()->read(inStream, readxfer, glenc, maxReadLength);
-                    if (errorFlag.good())
-                        lastItemComplete = OFTrue;
+                    delete fLoadItems;
+                    fLoadItems = inStream.newFactory();
+                    if (fLoadItems)
+                    {
+                        fLoadXfer = readxfer;
+                        fLoadGlenc = glenc;
+                        fLoadMaxReadLength = maxReadLength;
+                        fTransferredBytes = inStream.skip(Length);
+                        if (fTransferredBytes < Length)
+                        {
+                            errorFlag = EC_InvalidStream;  // sequence larger than remaining bytes in file
+                            ofConsole.lockCerr() << "DcmSequenceOfItems: " << Tag.getTagName() << Tag.getXTag() << " larger ("
+                                << Length << ") that remaining bytes in file" << endl;
+                            ofConsole.unlockCerr();
+                        }
+                    }
                 }
-                fTransferredBytes = inStream.tell() - fStartPosition;
-
-                if (errorFlag.bad())
-                    break;
+            }
 
-            } //while
-            if (((fTransferredBytes < Length) || !lastItemComplete) && errorFlag.good())
-                errorFlag = EC_StreamNotifyClient;
+            if (fLoadItems == NULL)
+                errorFlag = readItems(inStream, readxfer, glenc, maxReadLength);
         } // else errorFlag
 
         if (errorFlag == EC_SequEnd)
@@ -563,6 +629,57 @@ OFCondition DcmSequenceOfItems::read(DcmInputStream &inStream,
 // ********************************
 
 
+OFCondition DcmSequenceOfItems::loadItems()
+{
+    OFCondition l_error = EC_Normal;
+    if (fLoadItems)
+    {
+        DcmInputStream *readStream = fLoadItems->create();
+        delete fLoadItems;
+        fLoadItems = NULL;
+        if (readStream)
+        {
+            /* parse the items as read() would have done, but keep the transfer */
+            /* state of this sequence since a read or write may be in progress */
+            const E_TransferState oldState = fTransferState;
+            const Uint32 oldTransferredBytes = fTransferredBytes;
+            fStartPosition = readStream->tell();
+            fTransferredBytes = 0;
+            lastItemComplete = OFTrue;
+            l_error = readStream->status();
+            if (l_error.good())
+                l_error = readItems(*readStream, fLoadXfer, fLoadGlenc, fLoadMaxReadLength);
+            if (l_error == EC_SequEnd)
+                l_error = EC_Normal;
+            /* the items have not been part of any transfer */
+            if (!itemList->empty())
+            {
+                itemList->seek(ELP_first);
+                do {
+                    itemList->get()->transferEnd();
+                } while (itemList->seek(ELP_next));
+            }
+            fTransferState = oldState;
+            fTransferredBytes = oldTransferredBytes;
+            lastItemComplete = OFTrue;
+            delete readStream;
+        } else
+            l_error = EC_InvalidStream;
+        errorFlag = l_error;
+        if (l_error.bad())
+        {
+            ofConsole.lockCerr() << "DcmSequenceOfItems: Cannot parse items of sequence " << Tag.getTagName() << Tag.getXTag()
+                << ": " << l_error.text() << endl;
+            ofConsole.unlockCerr();
+        }
+    }
+    return l_error;
+}
+
+
+// ********************************
+
+
 OFCondition DcmSequenceOfItems::write(DcmOutputStream & outStream,
                                       const E_TransferSyntax oxfer,
                                       const E_EncodingType enctype)
@@ -761,6 +878,8 @@ OFCondition DcmSequenceOfItems::writeSignatureFormat(DcmOutputStream &outStream,
 void DcmSequenceOfItems::transferInit()
 {
     DcmObject::transferInit();
+    /* a transfer includes the items, parse them if this has been deferred */
+    loadItems();
     fStartPosition = 0;
     lastItemComplete = OFTrue;
     if (!itemList->empty())
@@ -794,6 +913,7 @@ void DcmSequenceOfItems::transferEnd()
 
 unsigned long DcmSequenceOfItems::card()
 {
+    loadItems();
     return itemList->card();
 }
 
@@ -803,6 +923,7 @@ unsigned long DcmSequenceOfItems::card()
 
 OFCondition DcmSequenceOfItems::prepend(DcmItem *item)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
         itemList->prepend(item);
@@ -819,6 +940,7 @@ OFCondition DcmSequenceOfItems::insert(DcmItem *item,
                                        unsigned long where,
                                        OFBool before)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -844,6 +966,7 @@ OFCondition DcmSequenceOfItems::insert(DcmItem *item,
 OFCondition DcmSequenceOfItems::insertAtCurrentPos(DcmItem* item,
                                                    OFBool before)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -861,6 +984,7 @@ OFCondition DcmSequenceOfItems::insertAtCurrentPos(DcmItem* item,
 
 OFCondition DcmSequenceOfItems::append(DcmItem *item)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
         itemList->append(item);
@@ -875,6 +999,7 @@ OFCondition DcmSequenceOfItems::append(DcmItem *item)
 
 DcmItem* DcmSequenceOfItems::getItem(const unsigned long num)
 {
+    loadItems();
     errorFlag = EC_Normal;
     DcmItem *item;
     item = OFstatic_cast(DcmItem *, itemList->seek_to(num));  // read item from list
@@ -889,6 +1014,7 @@ DcmItem* DcmSequenceOfItems::getItem(const unsigned long num)
 
 DcmObject *DcmSequenceOfItems::nextInContainer(const DcmObject *obj)
 {
+    loadItems();
     if (!obj)
         return itemList->get(ELP_first);
     else
@@ -952,6 +1078,7 @@ OFCondition DcmSequenceOfItems::nextObject(DcmStack &stack,
 
 DcmItem *DcmSequenceOfItems::remove(const unsigned long num)
 {
+    loadItems();
     errorFlag = EC_Normal;
     DcmItem *item;
     item = OFstatic_cast(DcmItem *, itemList->seek_to(num));  // read item from list
@@ -969,6 +1096,7 @@ DcmItem *DcmSequenceOfItems::remove(const unsigned long num)
 DcmItem *DcmSequenceOfItems::remove(DcmItem *item)
 {
     DcmItem *retItem = NULL;
+    loadItems();
     errorFlag = EC_IllegalCall;
     if (!itemList->empty() && (item != NULL))
     {
@@ -1009,6 +1137,9 @@ OFCondition DcmSequenceOfItems::clear()
             dO = NULL;
         }
     }
+    /* items not parsed yet are discarded as well */
+    delete fLoadItems;
+    fLoadItems = NULL;
     Length = 0;
     return errorFlag;
 }
@@ -1019,6 +1150,7 @@ OFCondition DcmSequenceOfItems::clear()
 
 OFCondition DcmSequenceOfItems::verify(const OFBool autocorrect)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (!itemList->empty())
     {
@@ -1088,6 +1220,7 @@ OFCondition DcmSequenceOfItems::search(const DcmTagKey &tag,
 {
     DcmObject *dO = NULL;
     OFCondition l_error = EC_TagNotFound;
+    loadItems();
     if ((mode == ESM_afterStackTop) && (resultStack.top() == this))
     {
         l_error = searchSubFromHere(tag, resultStack, searchIntoSub);
@@ -1178,6 +1311,7 @@ OFCondition DcmSequenceOfItems::search(const DcmTagKey &tag,
 
 OFCondition DcmSequenceOfItems::searchErrors(DcmStack &resultStack)
 {
+    loadItems();
     OFCondition l_error = errorFlag;
     DcmObject *dO = NULL;
     if (errorFlag.bad())
@@ -1201,7 +1335,7 @@ OFCondition DcmSequenceOfItems::searchErrors(DcmStack &resultStack)
 
 OFCondition DcmSequenceOfItems::loadAllDataIntoMemory()
 {
-    OFCondition l_error = EC_Normal;
+    OFCondition l_error = loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1229,6 +1363,8 @@ OFBool DcmSequenceOfItems::isSignable() const
 
 OFBool DcmSequenceOfItems::containsUnknownVR() const
 {
+    /* the items have to be parsed in order to answer this question */
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -34,6 +34,21 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 #include "dcmtk/dcmdata/dcswap.h"
 
+/* SSE2 is part of every x86-64 processor and is used whenever the compiler
+ * targets it. AVX2 kernels are compiled with a function specific target
+ * attribute and only called if the processor supports them.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DCSWAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(DCSWAP_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define DCSWAP_AVX2
+#include <immintrin.h>
+#endif
+
 OFCondition swapIfNecessary(const E_ByteOrder newByteOrder,
 			    const E_ByteOrder oldByteOrder,
 			    void * value, const Uint32 byteLength,
@@ -79,14 +94,15 @@ OFCondition swapIfNecessary(const E_ByteOrder newByteOrder,
 
 
 
-void swapBytes(void * value, const Uint32 byteLength,
-			   const size_t valWidth)
+static void swapBytesScalar(Uint8 * base, const Uint32 byteLength,
+			    const size_t valWidth)
     /*
-     * This function swaps byteLength bytes in value. These bytes are seperated
-     * in valWidth elements which will be swapped seperately.
+     * This function swaps byteLength bytes in base one value after the other.
+     * It is used for value widths without vectorized kernel and for the bytes
+     * that remain after a vectorized kernel has processed complete vectors.
      *
      * Parameters:
-     *   value        - [in] Array that contains the actual bytes which might have to be swapped.
+     *   base         - [in] Array that contains the actual bytes which have to be swapped.
      *   byteLength   - [in] Length of the above array.
      *   valWidth     - [in] Specifies how many bytes shall be treated together as one element.
      */
@@ -97,8 +113,8 @@ void swapBytes(void * value, const Uint32 byteLength,
     /* in case valWidth equals 2, swap correspondingly */
     if (valWidth == 2)
     {
-	register Uint8 * first = &OFstatic_cast(Uint8*, value)[0];
-	register Uint8 * second = &OFstatic_cast(Uint8*, value)[1];
+	register Uint8 * first = &base[0];
+	register Uint8 * second = &base[1];
 	register Uint32 times = byteLength/2;
 	while(times--)
 	{
@@ -119,7 +135,6 @@ void swapBytes(void * value, const Uint32 byteLength,
 	register Uint8 *end;
 
 	Uint32 times = byteLength/valWidth;
-	Uint8  *base = OFstatic_cast(Uint8 *, value);
 
 	while (times--)
 	{
@@ -138,6 +153,148 @@ void swapBytes(void * value, const Uint32 byteLength,
 }
 
 
+#ifdef DCSWAP_SSE2
+
+static Uint32 swapBytesSSE2(Uint8 * base, const Uint32 byteLength,
+			    const size_t valWidth)
+    /*
+     * This function swaps the values in all complete 16 byte blocks of base
+     * using SSE2 instructions. Values are first reversed in units of 16 bits
+     * by word shuffles, then the two bytes of each word are exchanged.
+     *
+     * Parameters:
+     *   base         - [in] Array that contains the actual bytes which have to be swapped.
+     *   byteLength   - [in] Length of the above array.
+     *   valWidth     - [in] Width of the values, must be 2, 4 or 8.
+     *
+     * Returns: number of bytes that have been swapped.
+     */
+{
+    Uint32 done = 0;
+    __m128i v;
+    if (valWidth == 2)
+    {
+	for (; done + 16 <= byteLength; done += 16)
+	{
+	    v = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, base + done));
+	    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	    _mm_storeu_si128(OFreinterpret_cast(__m128i *, base + done), v);
+	}
+    }
+    else if (valWidth == 4)
+    {
+	for (; done + 16 <= byteLength; done += 16)
+	{
+	    v = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, base + done));
+	    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	    _mm_storeu_si128(OFreinterpret_cast(__m128i *, base + done), v);
+	}
+    }
+    else if (valWidth == 8)
+    {
+	for (; done + 16 <= byteLength; done += 16)
+	{
+	    v = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, base + done));
+	    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	    _mm_storeu_si128(OFreinterpret_cast(__m128i *, base + done), v);
+	}
+    }
+    return done;
+}
+
+#endif
+
+
+#ifdef DCSWAP_AVX2
+
+__attribute__((target("avx2")))
+static Uint32 swapBytesAVX2(Uint8 * base, const Uint32 byteLength,
+			    const size_t valWidth)
+    /*
+     * This function swaps the values in all complete 32 byte blocks of base
+     * using a single AVX2 byte shuffle per block. It must only be called if
+     * the processor supports AVX2.
+     *
+     * Parameters:
+     *   base         - [in] Array that contains the actual bytes which have to be swapped.
+     *   byteLength   - [in] Length of the above array.
+     *   valWidth     - [in] Width of the values, must be 2, 4 or 8.
+     *
+     * Returns: number of bytes that have been swapped.
+     */
+{
+    __m256i mask;
+    if (valWidth == 2)
+	mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+				1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    else if (valWidth == 4)
+	mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+				3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    else
+	mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+				7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+    Uint32 done = 0;
+    __m256i v;
+    __m256i w;
+    /* two vectors per iteration keep more loads in flight */
+    for (; done + 64 <= byteLength; done += 64)
+    {
+	v = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, base + done));
+	w = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, base + done + 32));
+	_mm256_storeu_si256(OFreinterpret_cast(__m256i *, base + done), _mm256_shuffle_epi8(v, mask));
+	_mm256_storeu_si256(OFreinterpret_cast(__m256i *, base + done + 32), _mm256_shuffle_epi8(w, mask));
+    }
+    if (done + 32 <= byteLength)
+    {
+	v = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, base + done));
+	_mm256_storeu_si256(OFreinterpret_cast(__m256i *, base + done), _mm256_shuffle_epi8(v, mask));
+	done += 32;
+    }
+    return done;
+}
+
+#endif
+
+
+void swapBytes(void * value, const Uint32 byteLength,
+			   const size_t valWidth)
+    /*
+     * This function swaps byteLength bytes in value. These bytes are seperated
+     * in valWidth elements which will be swapped seperately. Values of 2, 4 or
+     * 8 bytes are swapped with SSE2 or AVX2 instructions if available, the
+     * remaining bytes are swapped one value after the other.
+     *
+     * Parameters:
+     *   value        - [in] Array that contains the actual bytes which might have to be swapped.
+     *   byteLength   - [in] Length of the above array.
+     *   valWidth     - [in] Specifies how many bytes shall be treated together as one element.
+     */
+{
+    Uint8 *base = OFstatic_cast(Uint8 *, value);
+    Uint32 done = 0;
+
+    /* every vector holds a whole number of values of these widths */
+    if ((valWidth == 2) || (valWidth == 4) || (valWidth == 8))
+    {
+#ifdef DCSWAP_AVX2
+	if ((byteLength >= 32) && __builtin_cpu_supports("avx2"))
+	    done = swapBytesAVX2(base, byteLength, valWidth);
+	else
+#endif
+#ifdef DCSWAP_SSE2
+	if (byteLength >= 16)
+	    done = swapBytesSSE2(base, byteLength, valWidth);
+#endif
+    }
+    swapBytesScalar(base + done, byteLength - done, valWidth);
+}
+
+
 Uint16 swapShort(const Uint16 toSwap)
 {
 	Uint8 *swapped = OFreinterpret_cast(Uint8 *, OFconst_cast(Uint16 *, &toSwap));
@@ -228,12 +228,13 @@ void DcmOtherByteOtherWord::printPixel(ostream &out,
 OFCondition DcmOtherByteOtherWord::alignValue()
 {
     errorFlag = EC_Normal;
-    /* add padding byte in case of 8 bit data */
-    if ((Tag.getEVR() != EVR_OW && Tag.getEVR() != EVR_lt) && (Length > 0))
+    /* add padding byte in case of 8 bit data with odd length, */
+    /* only load the value if this is the case */
+    if ((Tag.getEVR() != EVR_OW && Tag.getEVR() != EVR_lt) && ((Length & 1) != 0))
     {
         Uint8 *bytes = NULL;
         bytes = OFstatic_cast(Uint8 *, getValue(fByteOrder));
-        /* check for odd length */
+        /* loading the value may already have padded it */
         if ((bytes != NULL) && ((Length & 1) != 0))
         {
             bytes[Length] = 0;
@@ -0,0 +1,140 @@
+/*
+ *
+ *  Copyright (C) 2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  agent
+ *
+ *  Purpose: test and micro-benchmark for the byte swapping functions
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/dcmdata/dcswap.h"
+#include "dcmtk/ofstd/ofconsol.h"
+#include "dcmtk/ofstd/oftimer.h"
+
+#define INCLUDE_CSTRING
+#include "dcmtk/ofstd/ofstdinc.h"
+
+
+/* reference implementation: reverse each value byte by byte */
+static void referenceSwap(Uint8 *data, Uint32 byteLength, size_t valWidth)
+{
+    for (Uint32 pos = 0; pos + valWidth <= byteLength; pos += valWidth)
+    {
+        for (size_t i = 0; i < valWidth / 2; ++i)
+        {
+            Uint8 tmp = data[pos + i];
+            data[pos + i] = data[pos + valWidth - 1 - i];
+            data[pos + valWidth - 1 - i] = tmp;
+        }
+    }
+}
+
+
+/* compare swapBytes() with the reference for all lengths up to maxLength
+ * and all start addresses within a 16 byte block
+ */
+static int checkWidth(size_t valWidth, Uint32 maxLength)
+{
+    Uint8 *data = new Uint8[maxLength + 16];
+    Uint8 *expected = new Uint8[maxLength + 16];
+    int errors = 0;
+    for (Uint32 offset = 0; offset < 16; ++offset)
+    {
+        for (Uint32 length = 0; length <= maxLength; ++length)
+        {
+            for (Uint32 i = 0; i < maxLength + 16; ++i)
+                data[i] = expected[i] = OFstatic_cast(Uint8, i * 37 + length);
+            referenceSwap(expected + offset, length, valWidth);
+            swapBytes(data + offset, length, valWidth);
+            if (memcmp(data, expected, maxLength + 16) != 0)
+            {
+                CERR << "error: swapBytes() failed for width " << valWidth
+                     << ", length " << length << ", offset " << offset << endl;
+                ++errors;
+            }
+        }
+    }
+    delete[] data;
+    delete[] expected;
+    return errors;
+}
+
+
+int main(int argc, char *argv[])
+{
+    /* size of the benchmark buffer in MB and number of passes */
+    Uint32 megabytes = 64;
+    Uint32 passes = 20;
+    if (argc > 1) megabytes = OFstatic_cast(Uint32, atoi(argv[1]));
+    if (argc > 2) passes = OFstatic_cast(Uint32, atoi(argv[2]));
+    if ((megabytes == 0) || (passes == 0))
+    {
+        CERR << "usage: " << argv[0] << " [megabytes] [passes]" << endl;
+        return 1;
+    }
+
+    int errors = 0;
+    const size_t widths[] = { 2, 3, 4, 6, 8 };
+    const size_t numWidths = sizeof(widths) / sizeof(widths[0]);
+    for (size_t w = 0; w < numWidths; ++w)
+        errors += checkWidth(widths[w], 300);
+    if (errors > 0)
+    {
+        CERR << errors << " errors" << endl;
+        return 1;
+    }
+    COUT << "swapBytes() results are correct" << endl;
+
+    const Uint32 byteLength = megabytes * 1024 * 1024;
+    Uint8 *buffer = new Uint8[byteLength];
+    memset(buffer, 0x5a, byteLength);
+    for (size_t w = 0; w < numWidths; ++w)
+    {
+        /* one untimed pass to map the pages of the buffer */
+        swapBytes(buffer, byteLength, widths[w]);
+        OFTimer timer;
+        for (Uint32 i = 0; i < passes; ++i)
+            swapBytes(buffer, byteLength, widths[w]);
+        double seconds = timer.getDiff();
+        COUT << "width " << widths[w] << ": ";
+        if (seconds > 0)
+            COUT << OFstatic_cast(unsigned long, OFstatic_cast(double, megabytes) * passes / seconds) << " MB/s" << endl;
+        else
+            COUT << "too fast to measure" << endl;
+    }
+    delete[] buffer;
+    return 0;
+}
+
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
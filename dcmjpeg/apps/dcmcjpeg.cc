@@ -107,6 +107,7 @@ int main(int argc, char *argv[])
   E_SubSampling    opt_sampleFactors = ESS_444;
   OFBool           opt_useYBR422 = OFFalse;
   OFCmdUnsignedInt opt_fragmentSize = 0; // 0=unlimited
+  OFCmdUnsignedInt opt_threads = 1;
   OFBool           opt_createOffsetTable = OFTrue;
   int              opt_windowType = 0;  /* default: no windowing; 1=Wi, 2=Wl, 3=Wm, 4=Wh, 5=Ww, 6=Wn, 7=Wr */
   OFCmdUnsignedInt opt_windowParameter = 0;
@@ -209,6 +210,9 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("basic offset table encoding options:");
      cmd.addOption("--offset-table-create",     "+ot",       "create offset table (default)");
      cmd.addOption("--offset-table-empty",      "-ot",       "leave offset table empty");
+    cmd.addSubGroup("multi-frame processing options:");
+     cmd.addOption("--threads",                 "+mt",    1, "[n]umber: integer",
+                                                             "process up to n frames concurrently (default: 1)");
 
     cmd.addSubGroup("VOI windowing options for monochrome images (not with +tl):");
      cmd.addOption("--no-windowing",       "-W",      "no VOI windowing (default)");
@@ -478,6 +482,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--offset-table-empty")) opt_createOffsetTable = OFFalse;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMin(opt_threads, (OFCmdUnsignedInt)1));
+      }
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--no-windowing")) opt_windowType = 0;
       if (cmd.findOption("--use-window"))
@@ -618,7 +627,8 @@ int main(int argc, char *argv[])
       opt_useModalityRescale,
       opt_acceptWrongPaletteTags,
       opt_acrNemaCompatibility,
-      opt_trueLossless);
+      opt_trueLossless,
+      (Uint32) opt_threads);
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
@@ -93,6 +93,7 @@ int main(int argc, char *argv[])
   E_DecompressionColorSpaceConversion opt_decompCSconversion = EDC_photometricInterpretation;
   E_UIDCreation opt_uidcreation = EUC_default;
   E_PlanarConfiguration opt_planarconfig = EPC_default;
+  OFCmdUnsignedInt opt_threads = 1;
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION , "Decode JPEG-compressed DICOM file", rcsid);
   OFCommandLine cmd;
@@ -126,6 +127,10 @@ int main(int argc, char *argv[])
       cmd.addOption("--color-by-pixel",         "+px",       "always store color-by-pixel");
       cmd.addOption("--color-by-plane",         "+pl",       "always store color-by-plane");
 
+    cmd.addSubGroup("multi-frame processing options:");
+      cmd.addOption("--threads",                "+mt",    1, "[n]umber: integer",
+                                                             "process up to n frames concurrently (default: 1)");
+
     cmd.addSubGroup("SOP Instance UID options:");
      cmd.addOption("--uid-default",        "+ud",     "keep same SOP Instance UID (default)");
      cmd.addOption("--uid-always",         "+ua",     "always assign new UID");
@@ -190,6 +195,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--color-by-plane")) opt_planarconfig = EPC_colorByPlane;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValueAndCheckMin(opt_threads, (OFCmdUnsignedInt)1));
+      }
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--conv-photometric"))  opt_decompCSconversion = EDC_photometricInterpretation;
       if (cmd.findOption("--conv-lossy"))        opt_decompCSconversion = EDC_lossyOnly;
@@ -286,7 +296,8 @@ int main(int argc, char *argv[])
       opt_decompCSconversion,
       opt_uidcreation,
       opt_planarconfig,
-      opt_verbose);
+      opt_verbose,
+      (Uint32) opt_threads);
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
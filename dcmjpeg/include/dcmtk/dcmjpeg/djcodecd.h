@@ -47,6 +47,7 @@ class DcmDataset;
 class DcmItem;
 class DJCodecParameter;
 class DJDecoder;
+class DJFrameDecompressor;
 
 /** abstract codec class for JPEG decoders.
  *  This abstract class contains most of the application logic
@@ -82,6 +83,33 @@ public:
     const DcmCodecParameter * cp,
     const DcmStack& objStack) const;
 
+  /** decompresses a single frame from the given pixel sequence and
+   *  stores the result in the given buffer.
+   *  @param fromParam current representation parameter of compressed data, may be NULL
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to the dataset in which the pixel data element is contained
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param startFragment index of the fragment that contains the first part
+   *    of the compressed frame, 0 if unknown. Upon successful return, the index
+   *    of the first fragment of the next frame is returned in this parameter.
+   *  @param buffer pointer to the buffer where the uncompressed frame is stored
+   *  @param bufSize size of the buffer in bytes
+   *  @param decompressedColorModel upon successful return, the photometric
+   *    interpretation of the uncompressed frame is returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrame(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -172,6 +200,35 @@ private:
     const Uint8 *data,
     const Uint32 fragmentLength);
 
+  /** determines the index of the fragment that contains the first part of
+   *  the given frame by counting the fragments that start with a JPEG
+   *  Start of Image marker. Used if the Basic Offset Table is empty and
+   *  frames are split into multiple fragments.
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param currentItem index of the first fragment of the frame returned in
+   *    this parameter upon success
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  static OFCondition determineStartFragmentFromMarkers(
+    Uint32 frameNo,
+    DcmPixelSequence *fromPixSeq,
+    Uint32& currentItem);
+
+  /** determines the index of the first fragment of each frame, using the
+   *  Basic Offset Table if possible and the JPEG Start of Image markers
+   *  otherwise.
+   *  @param numberOfFrames number of frames
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param startFragments array of numberOfFrames entries that is filled
+   *    with the index of the first fragment of each frame
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  static OFCondition determineStartFragments(
+    Sint32 numberOfFrames,
+    DcmPixelSequence *fromPixSeq,
+    Uint32 *startFragments);
+
   /** reads two bytes from the given array
    *  of little endian 16-bit values and returns
    *  the value as Uint16 in local byte order.
@@ -218,6 +275,8 @@ private:
     const char *sopClassUID,
     EP_Interpretation photometricInterpretation);
 
+  // the frame decompressor creates its own decoder instances
+  friend class DJFrameDecompressor;
 };
 
 #endif
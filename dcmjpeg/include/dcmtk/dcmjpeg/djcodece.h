@@ -37,6 +37,7 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/ofstd/oftypes.h"
 #include "dcmtk/dcmdata/dccodec.h"    /* for class DcmCodec */
+#include "dcmtk/dcmdata/dcofsetl.h"   /* for DcmOffsetList */
 #include "dcmtk/dcmjpeg/djutils.h"    /* for enums */
 #include "dcmtk/ofstd/oflist.h"
 #include "dcmtk/ofstd/ofstring.h"   /* for class OFString */
@@ -50,6 +51,7 @@ class DcmItem;
 class DcmPixelItem;
 class DicomImage;
 class DcmTagKey;
+class DJFrameCompressor;
 
 
 /** abstract codec class for JPEG encoders.
@@ -86,6 +88,33 @@ public:
     const DcmCodecParameter * cp,
     const DcmStack& objStack) const;
 
+  /** decompresses a single frame from the given pixel sequence and
+   *  stores the result in the given buffer.
+   *  @param fromParam current representation parameter of compressed data, may be NULL
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to the dataset in which the pixel data element is contained
+   *  @param frameNo number of the frame, starting with 0 for the first frame
+   *  @param startFragment index of the fragment that contains the first part
+   *    of the compressed frame, 0 if unknown. Upon successful return, the index
+   *    of the first fragment of the next frame is returned in this parameter.
+   *  @param buffer pointer to the buffer where the uncompressed frame is stored
+   *  @param bufSize size of the buffer in bytes
+   *  @param decompressedColorModel upon successful return, the photometric
+   *    interpretation of the uncompressed frame is returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  virtual OFCondition decodeFrame(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel) const;
+
   /** compresses the given uncompressed DICOM image and stores
    *  the result in the given pixSeq element.
    *  @param pixelData pointer to the uncompressed image data in OW format
@@ -335,6 +364,48 @@ private:
   OFCondition updatePlanarConfiguration(
     DcmItem *item,
     const Uint16 newPlanConf) const;
+
+  /** compresses the frames of an image concurrently using the number of
+   *  threads given in the codec parameters and appends the compressed
+   *  frames to the pixel sequence in the order of their frame numbers.
+   *  The frames are either rendered from the given DicomImage, which is
+   *  done sequentially, or taken from a block of uncompressed pixel data.
+   *  @param toRepParam representation parameter passed to encode()
+   *  @param cp codec parameters for this codec
+   *  @param compressedBits bit depth passed to createEncoderInstance()
+   *  @param dimage image to be rendered, NULL if pixelData is used
+   *  @param renderBits number of bits per sample for rendering dimage
+   *  @param pixelData uncompressed pixel data, used if dimage is NULL
+   *  @param frameSize size of one uncompressed frame in pixelData in bytes
+   *  @param frameCount number of frames
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param interpr photometric interpretation of the frames
+   *  @param samplesPerPixel samples per pixel of the frames
+   *  @param pixelSequence pixel sequence to which the frames are appended
+   *  @param offsetList offset list to which the frame offsets are appended
+   *  @param compressedSize incremented by the size of the compressed frames
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition compressFrames(
+    const DcmRepresentationParameter *toRepParam,
+    const DJCodecParameter *cp,
+    Uint8 compressedBits,
+    DicomImage *dimage,
+    int renderBits,
+    const Uint8 *pixelData,
+    unsigned long frameSize,
+    unsigned long frameCount,
+    Uint16 columns,
+    Uint16 rows,
+    EP_Interpretation interpr,
+    Uint16 samplesPerPixel,
+    DcmPixelSequence *pixelSequence,
+    DcmOffsetList& offsetList,
+    unsigned long& compressedSize) const;
+
+  // the frame compressor creates its own encoder instances
+  friend class DJFrameCompressor;
 };
 
 #endif
@@ -75,6 +75,8 @@ public:
    *  @param pAcceptWrongPaletteTags Accept wrong palette attribute tags (only "pseudo lossless" encoder)
    *  @param pAcrNemaCompatibility Accept old ACR-NEMA images without photometric interpretation (only "pseudo" lossless encoder)
    *  @param pTrueLosslessMode Enables true lossless compression (replaces old "pseudo lossless" encoder)
+   *  @param pThreadCount maximum number of threads used to compress or decompress
+   *    the frames of a multi-frame image concurrently
    */
   DJCodecParameter(
     E_CompressionColorSpaceConversion pCompressionCSConversion,
@@ -102,7 +104,8 @@ public:
     OFBool pUseModalityRescale = OFFalse,
     OFBool pAcceptWrongPaletteTags = OFFalse,
     OFBool pAcrNemaCompatibility = OFFalse,
-    OFBool pTrueLosslessMode = OFTrue);
+    OFBool pTrueLosslessMode = OFTrue,
+    Uint32 pThreadCount = 1);
 
   /// copy constructor
   DJCodecParameter(const DJCodecParameter& arg);
@@ -304,6 +307,14 @@ public:
     return trueLosslessMode;
   }
 
+  /** returns maximum number of threads for frame-level parallelism
+   *  @return maximum number of threads, 1 for sequential processing
+   */
+  Uint32 getThreadCount() const
+  {
+    return threadCount;
+  }
+
   /** returns verbose mode flag
    *  @return verbose mode flag
    */
@@ -396,6 +407,9 @@ private:
 
   /// verbose mode flag. If true, warning messages are printed to console
   OFBool verboseMode;
+
+  /// maximum number of threads used to process the frames of an image
+  Uint32 threadCount;
 };
 
 
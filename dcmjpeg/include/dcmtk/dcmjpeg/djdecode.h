@@ -59,12 +59,15 @@ public:
    *  @param pPlanarConfiguration flag indicating how planar configuration
    *    of color images should be encoded upon decompression.
    *  @param pVerbose verbose mode flag
+   *  @param pThreadCount maximum number of threads used to decompress
+   *    the frames of a multi-frame image concurrently
    */   
   static void registerCodecs(
     E_DecompressionColorSpaceConversion pDecompressionCSConversion = EDC_photometricInterpretation,
     E_UIDCreation pCreateSOPInstanceUID = EUC_default,
     E_PlanarConfiguration pPlanarConfiguration = EPC_default,
-    OFBool pVerbose = OFFalse);
+    OFBool pVerbose = OFFalse,
+    Uint32 pThreadCount = 1);
 
   /** deregisters decoders.
    *  Attention: Must not be called while other threads might still use
@@ -42,11 +42,159 @@
 #include "dcmtk/dcmdata/dcvrpobw.h"  /* for class DcmPolymorphOBOW */
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary() */
 #include "dcmtk/dcmdata/dcuid.h"     /* for dcmGenerateUniqueIdentifer()*/
+#include "dcmtk/dcmdata/dcfrmpol.h"  /* for class DcmFrameWorkerPool */
 
 // dcmjpeg includes
 #include "dcmtk/dcmjpeg/djcparam.h"  /* for class DJCodecParameter */
 #include "dcmtk/dcmjpeg/djdecabs.h"  /* for class DJDecoder */
 
+
+/** decompresses frames of a multi-frame image on behalf of a
+ *  DcmFrameWorkerPool. Each frame is decompressed by its own decoder
+ *  instance into its position in the uncompressed pixel data.
+ */
+class DJFrameDecompressor: public DcmFrameProcessor
+{
+public:
+
+  /** constructor.
+   *  @param codec decoder codec that creates the decoder instances
+   *  @param fromRepParam representation parameter passed to decode()
+   *  @param cp codec parameters for this codec
+   *  @param precision bit depth of the JPEG data
+   *  @param isYBR true if the DICOM photometric interpretation is YCbCr
+   *  @param isSigned true if the pixel data is signed
+   *  @param fragments table of the fragments of the pixel sequence
+   *  @param startFragments index of the first fragment of each frame
+   *  @param imageData uncompressed pixel data of all frames
+   *  @param frameSize size of one uncompressed frame in bytes
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param createPlanarConfiguration true if frames must be converted to color-by-plane
+   */
+  DJFrameDecompressor(
+    const DJCodecDecoder& codec,
+    const DcmRepresentationParameter *fromRepParam,
+    const DJCodecParameter *cp,
+    Uint8 precision,
+    OFBool isYBR,
+    OFBool isSigned,
+    const DcmFragmentTable& fragments,
+    const Uint32 *startFragments,
+    Uint8 *imageData,
+    Uint32 frameSize,
+    Uint16 columns,
+    Uint16 rows,
+    OFBool createPlanarConfiguration)
+  : codec_(codec)
+  , fromRepParam_(fromRepParam)
+  , cp_(cp)
+  , precision_(precision)
+  , isYBR_(isYBR)
+  , isSigned_(isSigned)
+  , fragments_(fragments)
+  , startFragments_(startFragments)
+  , imageData_(imageData)
+  , frameSize_(frameSize)
+  , columns_(columns)
+  , rows_(rows)
+  , createPlanarConfiguration_(createPlanarConfiguration)
+  {
+  }
+
+  /// destructor
+  virtual ~DJFrameDecompressor() {}
+
+  /** decompresses one frame.
+   *  @param frameNo number of the frame
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  virtual OFCondition processFrame(Uint32 frameNo)
+  {
+    DJDecoder *jpeg = codec_.createDecoderInstance(fromRepParam_, cp_, precision_, isYBR_);
+    if (jpeg == NULL) return EC_MemoryExhausted;
+
+    Uint8 *imageData8 = imageData_ + frameNo * frameSize_;
+    Uint32 currentItem = startFragments_[frameNo];
+    DcmPixelItem *pixItem = NULL;
+    Uint8 *jpegData = NULL;
+    OFCondition result = jpeg->init();
+    if (result.good())
+    {
+      result = EJ_Suspension;
+      while (EJ_Suspension == result)
+      {
+        result = fragments_.getItem(pixItem, currentItem++);
+        if (result.good())
+        {
+          result = pixItem->getUint8Array(jpegData);
+          if (result.good())
+          {
+            result = jpeg->decode(jpegData, pixItem->getLength(), imageData8, frameSize_, isSigned_);
+          }
+        }
+      }
+    }
+    delete jpeg;
+
+    // convert planar configuration if necessary
+    if (result.good() && createPlanarConfiguration_)
+    {
+      if (precision_ > 8)
+        result = DJCodecDecoder::createPlanarConfigurationWord(OFreinterpret_cast(Uint16 *, imageData8), columns_, rows_);
+        else result = DJCodecDecoder::createPlanarConfigurationByte(imageData8, columns_, rows_);
+    }
+    return result;
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameDecompressor(const DJFrameDecompressor&);
+
+  /// private undefined copy assignment operator
+  DJFrameDecompressor& operator=(const DJFrameDecompressor&);
+
+  /// decoder codec that creates the decoder instances
+  const DJCodecDecoder& codec_;
+
+  /// representation parameter passed to decode()
+  const DcmRepresentationParameter *fromRepParam_;
+
+  /// codec parameters for this codec
+  const DJCodecParameter *cp_;
+
+  /// bit depth of the JPEG data
+  Uint8 precision_;
+
+  /// true if the DICOM photometric interpretation is YCbCr
+  OFBool isYBR_;
+
+  /// true if the pixel data is signed
+  OFBool isSigned_;
+
+  /// table of the fragments of the pixel sequence
+  const DcmFragmentTable& fragments_;
+
+  /// index of the first fragment of each frame
+  const Uint32 *startFragments_;
+
+  /// uncompressed pixel data of all frames
+  Uint8 *imageData_;
+
+  /// size of one uncompressed frame in bytes
+  Uint32 frameSize_;
+
+  /// number of columns
+  Uint16 columns_;
+
+  /// number of rows
+  Uint16 rows_;
+
+  /// true if frames must be converted to color-by-plane
+  OFBool createPlanarConfiguration_;
+};
+
 DJCodecDecoder::DJCodecDecoder()
 : DcmCodec()
 {
@@ -146,12 +294,32 @@ OFCondition DJCodecDecoder::decode(
               Sint32 currentFrame = 0;
               Uint32 currentItem = 1; // ignore offset table
 
+              // frames after the first one can be decompressed concurrently if
+              // the first fragment of each frame is known in advance
+              Sint32 sequentialFrames = imageFrames;
+              Uint32 *startFragments = NULL;
+              DcmFragmentTable fragments;
+              if ((djcp->getThreadCount() > 1) && (imageFrames > 1))
+              {
+                startFragments = new Uint32[imageFrames];
+                if (determineStartFragments(imageFrames, pixSeq, startFragments).good() &&
+                    fragments.create(pixSeq, OFTrue).good())
+                {
+                  sequentialFrames = 1;
+                }
+                else
+                {
+                  delete[] startFragments;
+                  startFragments = NULL;
+                }
+              }
+
               result = uncompressedPixelData.createUint16Array(totalSize/sizeof(Uint16), imageData16);
               if (result.good())
               {
                 Uint8 *imageData8 = (Uint8 *)imageData16;
 
-                while ((currentFrame < imageFrames)&&(result.good()))
+                while ((currentFrame < sequentialFrames)&&(result.good()))
                 {
                   result = jpeg->init();
                   if (result.good())
@@ -213,6 +381,17 @@ OFCondition DJCodecDecoder::decode(
                   }
                 }
 
+                // decompress the remaining frames concurrently. The first frame has
+                // determined the color model and planar configuration.
+                if (result.good() && (sequentialFrames < imageFrames))
+                {
+                  DJFrameDecompressor decompressor(*this, fromRepParam, djcp, precision, isYBR, isSigned,
+                    fragments, startFragments, (Uint8 *)imageData16, frameSize, imageColumns, imageRows,
+                    (imageSamplesPerPixel == 3) && createPlanarConfiguration);
+                  DcmFrameWorkerPool pool(decompressor, djcp->getThreadCount());
+                  result = pool.run(OFstatic_cast(Uint32, sequentialFrames), OFstatic_cast(Uint32, imageFrames - sequentialFrames));
+                }
+
                 if (result.good())
                 {
                   // decompression is complete, finally adjust byte order if necessary
@@ -292,6 +471,7 @@ OFCondition DJCodecDecoder::decode(
 
                 // Pixel Representation could be signed if lossless JPEG. For now, we just believe what we get.
               }
+              delete[] startFragments;
               delete jpeg;
             }
           }
@@ -315,6 +495,163 @@ OFCondition DJCodecDecoder::decode(
 }
 
 
+OFCondition DJCodecDecoder::decodeFrame(
+    const DcmRepresentationParameter * fromParam,
+    DcmPixelSequence * fromPixSeq,
+    const DcmCodecParameter * cp,
+    DcmItem * dataset,
+    Uint32 frameNo,
+    Uint32& startFragment,
+    void * buffer,
+    Uint32 bufSize,
+    OFString& decompressedColorModel) const
+{
+  if ((fromPixSeq == NULL) || (dataset == NULL) || (buffer == NULL)) return EC_IllegalCall;
+  OFCondition result = EC_Normal;
+  // assume we can cast the codec parameter to what we need
+  const DJCodecParameter *djcp = (const DJCodecParameter *)cp;
+
+  Uint16 imageSamplesPerPixel = 0;
+  Uint16 imageRows = 0;
+  Uint16 imageColumns = 0;
+  Sint32 imageFrames = 1;
+  const char *sopClassUID = NULL;
+  OFBool createPlanarConfiguration = OFFalse;
+  OFBool isSigned = OFFalse; Uint16 pixelRep = 0; // needed to decline color conversion of signed pixel data to RGB
+
+  if (result.good()) result = dataset->findAndGetUint16(DCM_SamplesPerPixel, imageSamplesPerPixel);
+  if (result.good()) result = dataset->findAndGetUint16(DCM_Rows, imageRows);
+  if (result.good()) result = dataset->findAndGetUint16(DCM_Columns, imageColumns);
+  if (result.good()) result = dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRep);
+  isSigned = (pixelRep == 0) ? OFFalse : OFTrue;
+  // number of frames is an optional attribute - we don't mind if it isn't present.
+  if (result.good()) (void) dataset->findAndGetSint32(DCM_NumberOfFrames, imageFrames);
+  if (imageFrames < 1) imageFrames = 1; // default in case this attribute contains garbage
+  if (result.good() && (frameNo >= (Uint32)imageFrames)) result = EC_IllegalCall;
+
+  // we consider SOP Class UID as optional since we only need it to determine SOP Class specific
+  // encoding rules for planar configuration.
+  if (result.good()) (void) dataset->findAndGetString(DCM_SOPClassUID, sopClassUID);
+
+  EP_Interpretation dicomPI = DcmJpegHelper::getPhotometricInterpretation(dataset);
+
+  OFBool isYBR = OFFalse;
+  if ((dicomPI == EPI_YBR_Full)||(dicomPI == EPI_YBR_Full_422)||(dicomPI == EPI_YBR_Partial_422)) isYBR = OFTrue;
+
+  // locate the first fragment of the frame unless the caller knows it already
+  if (result.good() && (startFragment == 0))
+  {
+    result = determineStartFragment(frameNo, imageFrames, fromPixSeq, startFragment);
+    if (result == EC_IllegalCall) result = determineStartFragmentFromMarkers(frameNo, fromPixSeq, startFragment);
+  }
+
+  if (result.good())
+  {
+    DcmPixelItem *pixItem = NULL;
+    Uint8 * jpegData = NULL;
+    Uint32 currentItem = startFragment;
+    result = fromPixSeq->getItem(pixItem, currentItem);
+    if (result.good())
+    {
+      Uint32 fragmentLength = pixItem->getLength();
+      result = pixItem->getUint8Array(jpegData);
+      if (result.good())
+      {
+        Uint8 precision = scanJpegDataForBitDepth(jpegData, fragmentLength);
+        if (precision == 0) result = EC_CannotChangeRepresentation; // something has gone wrong, bail out
+        else
+        {
+          Uint32 frameSize = ((precision > 8) ? sizeof(Uint16) : sizeof(Uint8)) * imageRows * imageColumns * imageSamplesPerPixel;
+          if (bufSize < frameSize) result = EC_IllegalCall;
+          else
+          {
+            DJDecoder *jpeg = createDecoderInstance(fromParam, djcp, precision, isYBR);
+            if (jpeg == NULL) result = EC_MemoryExhausted;
+            else
+            {
+              Uint8 *imageData8 = (Uint8 *)buffer;
+              result = jpeg->init();
+              if (result.good())
+              {
+                result = EJ_Suspension;
+                while (EJ_Suspension == result)
+                {
+                  result = fromPixSeq->getItem(pixItem, currentItem++);
+                  if (result.good())
+                  {
+                    fragmentLength = pixItem->getLength();
+                    result = pixItem->getUint8Array(jpegData);
+                    if (result.good())
+                    {
+                      result = jpeg->decode(jpegData, fragmentLength, imageData8, frameSize, isSigned);
+                    }
+                  }
+                }
+              }
+
+              if (result.good())
+              {
+                EP_Interpretation colorModel = jpeg->getDecompressedColorModel();
+                if (colorModel == EPI_Unknown)
+                {
+                  // derive color model from DICOM photometric interpretation
+                  if ((dicomPI == EPI_YBR_Full_422)||(dicomPI == EPI_YBR_Partial_422)) colorModel = EPI_YBR_Full;
+                  else colorModel = dicomPI;
+                }
+
+                switch (djcp->getPlanarConfiguration())
+                {
+                  case EPC_default:
+                    createPlanarConfiguration = requiresPlanarConfiguration(sopClassUID, colorModel);
+                    break;
+                  case EPC_colorByPixel:
+                    createPlanarConfiguration = OFFalse;
+                    break;
+                  case EPC_colorByPlane:
+                    createPlanarConfiguration = OFTrue;
+                    break;
+                }
+
+                // convert planar configuration if necessary
+                if ((imageSamplesPerPixel == 3) && createPlanarConfiguration)
+                {
+                  if (precision > 8)
+                    result = createPlanarConfigurationWord((Uint16 *)imageData8, imageColumns, imageRows);
+                    else result = createPlanarConfigurationByte(imageData8, imageColumns, imageRows);
+                }
+
+                // report the photometric interpretation of the decompressed frame,
+                // the dataset itself remains unchanged
+                switch (colorModel)
+                {
+                  case EPI_Monochrome2:
+                    decompressedColorModel = "MONOCHROME2";
+                    break;
+                  case EPI_YBR_Full:
+                    decompressedColorModel = "YBR_FULL";
+                    break;
+                  case EPI_RGB:
+                    decompressedColorModel = "RGB";
+                    break;
+                  default:
+                    if ((dicomPI == EPI_YBR_Full_422)||(dicomPI == EPI_YBR_Partial_422))
+                      decompressedColorModel = "YBR_FULL";
+                      else (void) dataset->findAndGetOFString(DCM_PhotometricInterpretation, decompressedColorModel);
+                    break;
+                }
+                if (result.good()) startFragment = currentItem;
+              }
+              delete jpeg;
+            }
+          }
+        }
+      }
+    }
+  }
+  return result;
+}
+
+
 OFCondition DJCodecDecoder::encode(
         const Uint16 * /* pixelData */,
         const Uint32 /* length */,
@@ -342,6 +679,69 @@ OFCondition DJCodecDecoder::encode(
 }
 
 
+OFCondition DJCodecDecoder::determineStartFragmentFromMarkers(
+  Uint32 frameNo,
+  DcmPixelSequence *fromPixSeq,
+  Uint32& currentItem)
+{
+  DcmPixelItem *pixItem = NULL;
+  Uint8 *jpegData = NULL;
+  Uint32 numberOfFragments = fromPixSeq->card();
+  Uint32 frame = 0;
+
+  // each JPEG frame starts with a Start of Image marker (FFD8) at the
+  // beginning of a fragment, and the marker cannot occur within entropy coded data
+  for (Uint32 item = 1; item < numberOfFragments; ++item)
+  {
+    OFCondition result = fromPixSeq->getItem(pixItem, item);
+    if (result.bad()) return result;
+    if (pixItem->getLength() < 2) continue;
+    result = pixItem->getUint8Array(jpegData);
+    if (result.bad() || (jpegData == NULL)) return EC_CorruptedData;
+    if ((jpegData[0] == 0xFF) && (jpegData[1] == 0xD8))
+    {
+      if (frame == frameNo)
+      {
+        currentItem = item;
+        return EC_Normal;
+      }
+      ++frame;
+    }
+  }
+  return EC_CorruptedData;
+}
+
+
+OFCondition DJCodecDecoder::determineStartFragments(
+  Sint32 numberOfFrames,
+  DcmPixelSequence *fromPixSeq,
+  Uint32 *startFragments)
+{
+  OFCondition result = EC_Normal;
+  for (Sint32 frame = 0; (frame < numberOfFrames) && result.good(); ++frame)
+  {
+    result = determineStartFragment(OFstatic_cast(Uint32, frame), numberOfFrames, fromPixSeq, startFragments[frame]);
+  }
+  if (result != EC_IllegalCall) return result;
+
+  // no usable offset table, locate all Start of Image markers in a single pass
+  DcmPixelItem *pixItem = NULL;
+  Uint8 *jpegData = NULL;
+  Uint32 numberOfFragments = fromPixSeq->card();
+  Sint32 frame = 0;
+  for (Uint32 item = 1; (item < numberOfFragments) && (frame < numberOfFrames); ++item)
+  {
+    result = fromPixSeq->getItem(pixItem, item);
+    if (result.bad()) return result;
+    if (pixItem->getLength() < 2) continue;
+    result = pixItem->getUint8Array(jpegData);
+    if (result.bad() || (jpegData == NULL)) return EC_CorruptedData;
+    if ((jpegData[0] == 0xFF) && (jpegData[1] == 0xD8)) startFragments[frame++] = item;
+  }
+  return (frame == numberOfFrames) ? EC_Normal : EC_CorruptedData;
+}
+
+
 Uint16 DJCodecDecoder::readUint16(const Uint8 *data)
 {
   return (((Uint16)(*data) << 8) | ((Uint16)(*(data+1))));
@@ -51,6 +51,7 @@
 #include "dcmtk/dcmdata/dcvrst.h"    /* for class DcmShortText */
 #include "dcmtk/dcmdata/dcvrus.h"    /* for class DcmUnsignedShort */
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary */
+#include "dcmtk/dcmdata/dcfrmpol.h"  /* for class DcmFrameWorkerPool */
 
 // dcmjpeg includes
 #include "dcmtk/dcmjpeg/djcparam.h"  /* for class DJCodecParameter */
@@ -63,6 +64,183 @@
 #include "dcmtk/ofstd/ofstdinc.h"
 
 
+/** compresses one batch of uncompressed frames on behalf of a
+ *  DcmFrameWorkerPool. Each frame is compressed by its own encoder
+ *  instance because encoders keep state while compressing.
+ */
+class DJFrameCompressor: public DcmFrameProcessor
+{
+public:
+
+  /** constructor.
+   *  @param codec encoder codec that creates the encoder instances
+   *  @param toRepParam representation parameter passed to encode()
+   *  @param cp codec parameters for this codec
+   *  @param compressedBits bit depth passed to createEncoderInstance()
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param interpr photometric interpretation of the frames
+   *  @param samplesPerPixel samples per pixel of the frames
+   *  @param batchSize maximum number of frames in one batch
+   */
+  DJFrameCompressor(
+    const DJCodecEncoder& codec,
+    const DcmRepresentationParameter *toRepParam,
+    const DJCodecParameter *cp,
+    Uint8 compressedBits,
+    Uint16 columns,
+    Uint16 rows,
+    EP_Interpretation interpr,
+    Uint16 samplesPerPixel,
+    Uint32 batchSize)
+  : codec_(codec)
+  , toRepParam_(toRepParam)
+  , cp_(cp)
+  , compressedBits_(compressedBits)
+  , columns_(columns)
+  , rows_(rows)
+  , interpr_(interpr)
+  , samplesPerPixel_(samplesPerPixel)
+  , batchSize_(batchSize)
+  , firstFrame_(0)
+  , frames_(new const Uint8 *[batchSize])
+  , jpegData_(new Uint8 *[batchSize])
+  , jpegLen_(new Uint32[batchSize])
+  {
+    for (Uint32 i = 0; i < batchSize_; ++i)
+    {
+      frames_[i] = NULL;
+      jpegData_[i] = NULL;
+      jpegLen_[i] = 0;
+    }
+  }
+
+  /// destructor
+  virtual ~DJFrameCompressor()
+  {
+    clear();
+    delete[] frames_;
+    delete[] jpegData_;
+    delete[] jpegLen_;
+  }
+
+  /** starts a new batch. Compressed frames of the previous batch that
+   *  have not been taken over by the caller are deleted.
+   *  @param firstFrame number of the first frame of the batch
+   */
+  void setFirstFrame(Uint32 firstFrame)
+  {
+    clear();
+    firstFrame_ = firstFrame;
+  }
+
+  /** sets the uncompressed data of a frame of the current batch
+   *  @param slot index of the frame within the batch
+   *  @param frame uncompressed frame data
+   */
+  void setFrame(Uint32 slot, const Uint8 *frame)
+  {
+    frames_[slot] = frame;
+  }
+
+  /** takes over the compressed data of a frame of the current batch.
+   *  The caller is responsible for deleting the returned array.
+   *  @param slot index of the frame within the batch
+   *  @param jpegData compressed frame data returned in this parameter
+   *  @param jpegLen length of the compressed frame returned in this parameter
+   */
+  void takeResult(Uint32 slot, Uint8 *&jpegData, Uint32 &jpegLen)
+  {
+    jpegData = jpegData_[slot];
+    jpegLen = jpegLen_[slot];
+    jpegData_[slot] = NULL;
+    jpegLen_[slot] = 0;
+  }
+
+  /** compresses one frame of the current batch.
+   *  @param frameNo number of the frame
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  virtual OFCondition processFrame(Uint32 frameNo)
+  {
+    Uint32 slot = frameNo - firstFrame_;
+    DJEncoder *jpeg = codec_.createEncoderInstance(toRepParam_, cp_, compressedBits_);
+    if (jpeg == NULL) return EC_MemoryExhausted;
+
+    OFCondition result = EC_Normal;
+    if (jpeg->bytesPerSample() == 1)
+    {
+      result = jpeg->encode(columns_, rows_, interpr_, samplesPerPixel_,
+        OFconst_cast(Uint8 *, frames_[slot]), jpegData_[slot], jpegLen_[slot]);
+    } else {
+      result = jpeg->encode(columns_, rows_, interpr_, samplesPerPixel_,
+        OFreinterpret_cast(Uint16 *, OFconst_cast(Uint8 *, frames_[slot])), jpegData_[slot], jpegLen_[slot]);
+    }
+    delete jpeg;
+    if (result.good() && (jpegLen_[slot] == 0)) result = EC_CannotChangeRepresentation;
+    return result;
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameCompressor(const DJFrameCompressor&);
+
+  /// private undefined copy assignment operator
+  DJFrameCompressor& operator=(const DJFrameCompressor&);
+
+  /// deletes the compressed frames of the current batch
+  void clear()
+  {
+    for (Uint32 i = 0; i < batchSize_; ++i)
+    {
+      delete[] jpegData_[i];
+      jpegData_[i] = NULL;
+      jpegLen_[i] = 0;
+    }
+  }
+
+  /// encoder codec that creates the encoder instances
+  const DJCodecEncoder& codec_;
+
+  /// representation parameter passed to encode()
+  const DcmRepresentationParameter *toRepParam_;
+
+  /// codec parameters for this codec
+  const DJCodecParameter *cp_;
+
+  /// bit depth passed to createEncoderInstance()
+  Uint8 compressedBits_;
+
+  /// number of columns
+  Uint16 columns_;
+
+  /// number of rows
+  Uint16 rows_;
+
+  /// photometric interpretation of the frames
+  EP_Interpretation interpr_;
+
+  /// samples per pixel of the frames
+  Uint16 samplesPerPixel_;
+
+  /// maximum number of frames in one batch
+  Uint32 batchSize_;
+
+  /// number of the first frame of the current batch
+  Uint32 firstFrame_;
+
+  /// uncompressed frames of the current batch
+  const Uint8 **frames_;
+
+  /// compressed frames of the current batch
+  Uint8 **jpegData_;
+
+  /// lengths of the compressed frames of the current batch
+  Uint32 *jpegLen_;
+};
+
+
 DJCodecEncoder::DJCodecEncoder()
 : DcmCodec()
 {
@@ -99,6 +277,21 @@ OFCondition DJCodecEncoder::decode(
   return EC_IllegalCall;
 }
 
+OFCondition DJCodecEncoder::decodeFrame(
+    const DcmRepresentationParameter * /* fromParam */,
+    DcmPixelSequence * /* fromPixSeq */,
+    const DcmCodecParameter * /* cp */,
+    DcmItem * /* dataset */,
+    Uint32 /* frameNo */,
+    Uint32& /* startFragment */,
+    void * /* buffer */,
+    Uint32 /* bufSize */,
+    OFString& /* decompressedColorModel */) const
+{
+  // we are an encoder only
+  return EC_IllegalCall;
+}
+
 OFCondition DJCodecEncoder::encode(
     const E_TransferSyntax /* fromRepType */,
     const DcmRepresentationParameter * /* fromRepParam */,
@@ -336,7 +529,12 @@ OFCondition DJCodecEncoder::encodeColorImage(
 
       // compute original image size in bytes, ignoring any padding bits.
       uncompressedSize = columns * rows * dimage->getDepth() * frameCount * samplesPerPixel / 8.0;
-      for (unsigned long i=0; (i<frameCount) && (result.good()); i++)
+      if ((cp->getThreadCount() > 1) && (frameCount > 1))
+      {
+        result = compressFrames(toRepParam, cp, (Uint8) compressedBits, dimage, bitsPerSample, NULL, 0,
+          frameCount, columns, rows, interpr, samplesPerPixel, pixelSequence, offsetList, compressedSize);
+      }
+      else for (unsigned long i=0; (i<frameCount) && (result.good()); i++)
       {
         frame = dimage->getOutputData(bitsPerSample, i, 0);
         if (frame == NULL) result = EC_MemoryExhausted;
@@ -585,8 +783,15 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
     DJEncoder *jpeg = createEncoderInstance(toRepParam, djcp, OFstatic_cast(Uint8, bitsAllocated));
     if (jpeg)
     {
+      if ((djcp->getThreadCount() > 1) && (frameCount > 1))
+      {
+        result = compressFrames(toRepParam, djcp, OFstatic_cast(Uint8, bitsAllocated), NULL, 0, framePointer, frameSize,
+          frameCount, columns, rows, interpr, samplesPerPixel, pixelSequence, offsetList, compressedSize);
+        if (result.bad())
+          CERR << "True lossless encoder: Error encoding frame" << endl;
+      }
       // main loop for compression: compress each frame
-      for (unsigned int i=0; i<frameCount && result.good(); i++)
+      else for (unsigned int i=0; i<frameCount && result.good(); i++)
       {
         if (bitsAllocated == 8)
         {
@@ -1096,7 +1301,12 @@ OFCondition DJCodecEncoder::encodeMonochromeImage(
       Uint16 samplesPerPixel = 0;
       if ((dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel)).bad()) samplesPerPixel = 1;
       uncompressedSize = columns * rows * pixelDepth * frameCount * samplesPerPixel / 8.0;
-      for (unsigned long i=0; (i<frameCount) && (result.good()); i++)
+      if ((cp->getThreadCount() > 1) && (frameCount > 1))
+      {
+        result = compressFrames(toRepParam, cp, (Uint8) compressedBits, &dimage, bitsPerSample, NULL, 0,
+          frameCount, columns, rows, EPI_Monochrome2, 1, pixelSequence, offsetList, compressedSize);
+      }
+      else for (unsigned long i=0; (i<frameCount) && (result.good()); i++)
       {
         frame = dimage.getOutputData(bitsPerSample, i, 0);
         if (frame == NULL) result = EC_MemoryExhausted;
@@ -1437,6 +1647,83 @@ OFCondition DJCodecEncoder::updatePlanarConfiguration(
   return item->putAndInsertUint16(DCM_PlanarConfiguration, newPlanConf);
 }
 
+
+OFCondition DJCodecEncoder::compressFrames(
+    const DcmRepresentationParameter *toRepParam,
+    const DJCodecParameter *cp,
+    Uint8 compressedBits,
+    DicomImage *dimage,
+    int renderBits,
+    const Uint8 *pixelData,
+    unsigned long frameSize,
+    unsigned long frameCount,
+    Uint16 columns,
+    Uint16 rows,
+    EP_Interpretation interpr,
+    Uint16 samplesPerPixel,
+    DcmPixelSequence *pixelSequence,
+    DcmOffsetList& offsetList,
+    unsigned long& compressedSize) const
+{
+  OFCondition result = EC_Normal;
+  Uint32 threadCount = cp->getThreadCount();
+
+  // frames are compressed in batches so that only a limited number of
+  // uncompressed and compressed frames is kept in memory at a time
+  Uint32 batchSize = 4 * threadCount;
+  DJFrameCompressor compressor(*this, toRepParam, cp, compressedBits, columns, rows, interpr, samplesPerPixel, batchSize);
+  DcmFrameWorkerPool pool(compressor, threadCount);
+
+  // buffers for frames rendered from the DicomImage
+  unsigned long renderSize = 0;
+  Uint8 **renderBuffer = NULL;
+  if (dimage)
+  {
+    renderSize = dimage->getOutputDataSize(renderBits);
+    renderBuffer = new Uint8 *[batchSize];
+    for (Uint32 i = 0; i < batchSize; ++i) renderBuffer[i] = NULL;
+  }
+
+  Uint8 *jpegData = NULL;
+  Uint32 jpegLen = 0;
+  for (unsigned long first = 0; (first < frameCount) && result.good(); first += batchSize)
+  {
+    Uint32 count = OFstatic_cast(Uint32, (frameCount - first < batchSize) ? frameCount - first : batchSize);
+    compressor.setFirstFrame(OFstatic_cast(Uint32, first));
+
+    // rendering is not thread-safe, therefore it is done by the calling thread
+    for (Uint32 i = 0; (i < count) && result.good(); ++i)
+    {
+      if (dimage)
+      {
+        if (renderBuffer[i] == NULL) renderBuffer[i] = new Uint8[renderSize];
+        if (!dimage->getOutputData(renderBuffer[i], renderSize, renderBits, first + i, 0))
+          result = EC_MemoryExhausted;
+        compressor.setFrame(i, renderBuffer[i]);
+      }
+      else compressor.setFrame(i, pixelData + (first + i) * frameSize);
+    }
+
+    if (result.good()) result = pool.run(OFstatic_cast(Uint32, first), count);
+
+    // store frames in their original order
+    for (Uint32 i = 0; (i < count) && result.good(); ++i)
+    {
+      compressor.takeResult(i, jpegData, jpegLen);
+      result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, cp->getFragmentSize());
+      delete[] jpegData;
+      compressedSize += jpegLen;
+    }
+  }
+
+  if (renderBuffer)
+  {
+    for (Uint32 i = 0; i < batchSize; ++i) delete[] renderBuffer[i];
+    delete[] renderBuffer;
+  }
+  return result;
+}
+
 /*
  * CVS/RCS Log
  * $Log: djcodece.cc,v $
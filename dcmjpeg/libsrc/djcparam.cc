@@ -60,7 +60,8 @@ DJCodecParameter::DJCodecParameter(
     OFBool pUseModalityRescale,
     OFBool pAcceptWrongPaletteTags,
     OFBool pAcrNemaCompatibility,
-    OFBool pTrueLosslessMode)
+    OFBool pTrueLosslessMode,
+    Uint32 pThreadCount)
 : DcmCodecParameter()
 , compressionCSConversion(pCompressionCSConversion)
 , decompressionCSConversion(pDecompressionCSConversion)
@@ -88,6 +89,7 @@ DJCodecParameter::DJCodecParameter(
 , acrNemaCompatibility(pAcrNemaCompatibility)
 , trueLosslessMode(pTrueLosslessMode)
 , verboseMode(pVerbose)
+, threadCount(pThreadCount > 0 ? pThreadCount : 1)
 {
 }
 
@@ -118,6 +120,7 @@ DJCodecParameter::DJCodecParameter(const DJCodecParameter& arg)
 , useModalityRescale(arg.useModalityRescale)
 , trueLosslessMode(arg.trueLosslessMode)
 , verboseMode(arg.verboseMode)
+, threadCount(arg.threadCount)
 {
 }
 
@@ -57,7 +57,8 @@ void DJDecoderRegistration::registerCodecs(
     E_DecompressionColorSpaceConversion pDecompressionCSConversion,
     E_UIDCreation pCreateSOPInstanceUID,
     E_PlanarConfiguration pPlanarConfiguration,
-    OFBool pVerbose)
+    OFBool pVerbose,
+    Uint32 pThreadCount)
 {
   if (! registered)
   {
@@ -66,7 +67,11 @@ void DJDecoderRegistration::registerCodecs(
       pDecompressionCSConversion, 
       pCreateSOPInstanceUID, 
       pPlanarConfiguration,
-      pVerbose);
+      pVerbose,
+      OFFalse, 0, 0, 0, OFTrue, ESS_444, OFFalse, OFFalse, // compression only
+      0, 0, 0.0, 0.0, 0, 0, 0, 0, OFTrue, OFFalse,          // compression only
+      OFFalse, OFFalse, OFTrue,                              // compression only
+      pThreadCount);
     if (cp)
     {
       // baseline JPEG
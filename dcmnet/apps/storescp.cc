@@ -75,9 +75,11 @@ END_EXTERN_C
 #include "dcmtk/dcmdata/dcuid.h"         /* for dcmtk version name */
 #include "dcmtk/dcmnet/dicom.h"         /* for DICOM_APPLICATION_ACCEPTOR */
 #include "dcmtk/dcmdata/dcdeftag.h"      /* for DCM_StudyInstanceUID */
-#include "dcmtk/dcmdata/dcostrmz.h"      /* for dcmZlibCompressionLevel */
+#include "dcmtk/dcmdata/dcostrmz.h"      /* for dcmZlibCompressionLevel, dcmZlibCompressionThreads */
 #include "dcmtk/dcmnet/dcasccfg.h"      /* for class DcmAssociationConfiguration */
 #include "dcmtk/dcmnet/dcasccff.h"      /* for class DcmAssociationConfigurationFile */
+#include "dcmtk/dcmnet/dcasmux.h"       /* for class DcmAssociationMultiplexer */
+#include "dcmtk/dcmnet/dcmtrans.h"      /* for dcmTCPReadBufferSize */
 
 #ifdef WITH_OPENSSL
 #include "dcmtk/dcmtls/tlstrans.h"
@@ -118,7 +120,9 @@ static char rcsid[] = "$dcmtk: " OFFIS_CONSOLE_APPLICATION " v" OFFIS_DCMTK_VERS
 #define CALLED_AETITLE_PLACEHOLDER "#c"
 
 static OFCondition processCommands(T_ASC_Association *assoc);
-static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg);
+static OFCondition processCommand(T_ASC_Association *assoc, T_DIMSE_BlockingMode blockMode, int timeout);
+static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg, T_ASC_Association **acceptedAssoc = NULL);
+static OFCondition endAssociation(T_ASC_Association *assoc, OFCondition cond);
 static OFCondition echoSCP(T_ASC_Association * assoc, T_DIMSE_Message * msg, T_ASC_PresentationContextID presID);
 static OFCondition storeSCP(T_ASC_Association * assoc, T_DIMSE_Message * msg, T_ASC_PresentationContextID presID);
 static void executeOnReception();
@@ -145,6 +149,9 @@ OFBool             opt_rejectWithoutImplementationUID = OFFalse;
 OFCmdUnsignedInt   opt_sleepAfter = 0;
 OFCmdUnsignedInt   opt_sleepDuring = 0;
 OFCmdUnsignedInt   opt_maxPDU = ASC_DEFAULTMAXPDU;
+OFCmdUnsignedInt   opt_asyncWindow = 1;                 // default: synchronous operation
+OFCmdUnsignedInt   opt_readBuffer = 1024;               // kbytes read from the network at once
+OFCmdSignedInt     opt_socketBuffer = -1;               // default: TCP_BUFFER_LENGTH or 32 kbytes
 OFBool             opt_useMetaheader = OFTrue;
 E_TransferSyntax   opt_networkTransferSyntax = EXS_Unknown;
 E_TransferSyntax   opt_writeTransferSyntax = EXS_Unknown;
@@ -154,6 +161,8 @@ E_PaddingEncoding  opt_paddingType = EPD_withoutPadding;
 OFCmdUnsignedInt   opt_filepad = 0;
 OFCmdUnsignedInt   opt_itempad = 0;
 OFCmdUnsignedInt   opt_compressionLevel = 0;
+OFCmdUnsignedInt   opt_compressionThreads = 1;
+OFCmdUnsignedInt   opt_multiplexThreads = 0;            // default: one association at a time
 OFBool             opt_verbose = OFFalse;
 OFBool             opt_debug = OFFalse;
 OFBool             opt_bitPreserving = OFFalse;
@@ -228,6 +237,57 @@ extern "C" void sigChildHandler(int)
 #endif
 
 
+#ifdef WITH_ASSOCIATION_MULTIPLEXER
+/** serves the associations of storescp concurrently in a single process.
+ *  Only used with --multiplex, which excludes all options that depend on
+ *  the global state of the currently received study.
+ */
+class StoreSCPMultiplexer: public DcmAssociationMultiplexer
+{
+public:
+
+  StoreSCPMultiplexer(T_ASC_Network *net, DcmAssociationConfiguration& asccfg, Uint32 numberOfThreads, int timeout)
+  : DcmAssociationMultiplexer(net, numberOfThreads, timeout)
+  , net_(net)
+  , asccfg_(asccfg)
+  {
+  }
+
+protected:
+
+  virtual OFCondition acceptAssociation(T_ASC_Association *&assoc)
+  {
+    assoc = NULL;
+    return ::acceptAssociation(net_, asccfg_, &assoc);
+  }
+
+  virtual OFCondition processMessage(T_ASC_Association *assoc)
+  {
+    /* data is waiting, so DIMSE_NODATAAVAILABLE means that the peer has
+     * stopped sending within the message. The association is aborted.
+     */
+    OFCondition cond = processCommand(assoc, opt_blockMode, opt_dimse_timeout);
+    if (cond == DIMSE_OUTOFRESOURCES) cond = EC_Normal;
+    return cond;
+  }
+
+  virtual void finishAssociation(T_ASC_Association *assoc, OFCondition cond)
+  {
+    endAssociation(assoc, cond);
+    cond = ASC_dropSCPAssociation(assoc);
+    if (cond.bad()) DimseCondition::dump(cond);
+    cond = ASC_destroyAssociation(&assoc);
+    if (cond.bad()) DimseCondition::dump(cond);
+  }
+
+private:
+
+  T_ASC_Network *net_;
+  DcmAssociationConfiguration& asccfg_;
+};
+#endif
+
+
 #define SHORTCOL 4
 #define LONGCOL 21
 
@@ -273,6 +333,11 @@ int main(int argc, char *argv[])
 #ifdef _WIN32
     cmd.addOption("--forked-child",                          "process is forked child, internal use only");
 #endif
+#endif
+#ifdef WITH_ASSOCIATION_MULTIPLEXER
+  cmd.addGroup("multi-threading options:", LONGCOL, SHORTCOL+2);
+    cmd.addOption("--multiplex",                 "+mx",   1, "[n]umber: integer",
+                                                             "serve associations concurrently in a single\nprocess with n worker threads");
 #endif
 
   cmd.addGroup("network options:");
@@ -326,6 +391,12 @@ int main(int argc, char *argv[])
       opt4 += tempstr;
       opt4 += "]";
       cmd.addOption("--max-pdu",                "-pdu",  1,  opt4.c_str(), opt3.c_str());
+      cmd.addOption("--async-window",           "+aw",   1,  "[n]umber: integer [1..65535]",
+                                                             "accept asynchronous operations window of up\nto n outstanding C-STORE requests (default: 1)");
+      cmd.addOption("--read-buffer",            "+rb",   1,  "[k]bytes: integer [0..65536]",
+                                                             "read up to k kbytes from the network at once\n(default: 1024, 0: unbuffered)");
+      cmd.addOption("--socket-buffer",          "+sb",   1,  "[k]bytes: integer [0..65536]",
+                                                             "set TCP receive buffer to k kbytes (default:\nTCP_BUFFER_LENGTH or 32, 0: system default)");
       cmd.addOption("--disable-host-lookup",    "-dhl",      "disable hostname lookup");
       cmd.addOption("--refuse",                              "refuse association");
       cmd.addOption("--reject",                              "reject association if no implement. class UID");
@@ -369,9 +440,11 @@ int main(int argc, char *argv[])
       cmd.addOption("--padding-create",         "+p",    2,  "[f]ile-pad [i]tem-pad: integer",
                                                              "align file on multiple of f bytes and items\non multiple of i bytes");
 #ifdef WITH_ZLIB
-    cmd.addSubGroup("deflate compression level (not with --write-xfer-little/big/implicit):");
+    cmd.addSubGroup("deflate compression options (not with --write-xfer-little/big/implicit):");
       cmd.addOption("--compression-level",      "+cl",   1,  "compression level: 0-9 (default 6)",
                                                              "0=uncompressed, 1=fastest, 9=best compression");
+      cmd.addOption("--compression-threads",    "+ct",   1,  "[n]umber: integer",
+                                                             "compress blocks of 128 kB with n threads\n(default: 1)");
 #endif
     cmd.addSubGroup("sorting into subdirectories (not with --bit-preserving):");
       cmd.addOption("--sort-conc-studies",      "-ss",   1,  "[p]refix: string",
@@ -559,6 +632,17 @@ int main(int argc, char *argv[])
 
     if (cmd.findOption("--aetitle")) app.checkValue(cmd.getValue(opt_respondingaetitle));
     if (cmd.findOption("--max-pdu")) app.checkValue(cmd.getValueAndCheckMinMax(opt_maxPDU, ASC_MINIMUMPDUSIZE, ASC_MAXIMUMPDUSIZE));
+    if (cmd.findOption("--async-window")) app.checkValue(cmd.getValueAndCheckMinMax(opt_asyncWindow, 1, 65535));
+    if (cmd.findOption("--read-buffer"))
+    {
+      app.checkValue(cmd.getValueAndCheckMinMax(opt_readBuffer, 0, 65536));
+      dcmTCPReadBufferSize.set(OFstatic_cast(Uint32, opt_readBuffer * 1024));
+    }
+    if (cmd.findOption("--socket-buffer"))
+    {
+      app.checkValue(cmd.getValueAndCheckMinMax(opt_socketBuffer, 0, 65536));
+      dcmSocketReceiveBufferSize.set(OFstatic_cast(Sint32, opt_socketBuffer * 1024));
+    }
     if (cmd.findOption("--disable-host-lookup")) dcmDisableGethostbyaddr.set(OFTrue);
     if (cmd.findOption("--refuse")) opt_refuseAssociation = OFTrue;
     if (cmd.findOption("--reject")) opt_rejectWithoutImplementationUID = OFTrue;
@@ -759,6 +843,14 @@ int main(int argc, char *argv[])
         dcmZlibCompressionLevel.set(OFstatic_cast(int, opt_compressionLevel));
     }
     cmd.endOptionBlock();
+
+    if (cmd.findOption("--compression-threads"))
+    {
+        if (opt_writeTransferSyntax != EXS_DeflatedLittleEndianExplicit && opt_writeTransferSyntax != EXS_Unknown)
+          app.printError("--compression-threads only allowed with --write-xfer-deflated or --write-xfer-same");
+        app.checkValue(cmd.getValueAndCheckMin(opt_compressionThreads, OFstatic_cast(OFCmdUnsignedInt, 1)));
+        dcmZlibCompressionThreads.set(OFstatic_cast(Uint32, opt_compressionThreads));
+    }
 #endif
 
     if (cmd.findOption("--sort-conc-studies"))
@@ -806,6 +898,20 @@ int main(int argc, char *argv[])
       app.checkValue(cmd.getValueAndCheckMin(opt_endOfStudyTimeout, 0));
     }
 
+#ifdef WITH_ASSOCIATION_MULTIPLEXER
+    if (cmd.findOption("--multiplex"))
+    {
+      app.checkConflict("--multiplex", "--inetd", opt_inetd_mode);
+#ifdef HAVE_FORK
+      app.checkConflict("--multiplex", "--fork", opt_forkMode);
+#endif
+      app.checkConflict("--multiplex", "--sort-conc-studies", opt_sortConcerningStudies != NULL);
+      app.checkConflict("--multiplex", "--timenames", opt_timeNames);
+      app.checkConflict("--multiplex", "--exec-on-reception", opt_execOnReception != NULL);
+      app.checkValue(cmd.getValueAndCheckMin(opt_multiplexThreads, 1));
+    }
+#endif
+
 #ifdef _WIN32
     if (cmd.findOption("--exec-sync")) opt_execSync = OFTrue;
 #endif
@@ -1082,6 +1188,24 @@ int main(int argc, char *argv[])
   signal(SIGCHLD, sigChildHandler);
 #endif
 
+#ifdef WITH_ASSOCIATION_MULTIPLEXER
+  if (opt_multiplexThreads > 0)
+  {
+    /* a worker must not wait indefinitely for a peer that stops sending */
+    /* within a message, so the DIMSE timeout defaults to the ACSE timeout */
+    if (opt_blockMode == DIMSE_BLOCKING)
+    {
+      opt_blockMode = DIMSE_NONBLOCKING;
+      opt_dimse_timeout = opt_acse_timeout;
+    }
+
+    /* receive associations and process their commands until an error occurs */
+    StoreSCPMultiplexer mux(net, asccfg, OFstatic_cast(Uint32, opt_multiplexThreads), opt_dimse_timeout);
+    cond = mux.run();
+    if (cond.bad()) DimseCondition::dump(cond);
+  }
+  else
+#endif
   while (cond.good())
   {
     /* receive an association and acknowledge or reject it. If the association was */
@@ -1139,7 +1263,7 @@ int main(int argc, char *argv[])
 
 
 
-static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg)
+static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg, T_ASC_Association **acceptedAssoc)
 {
   char buf[BUFSIZ];
   T_ASC_Association *assoc;
@@ -1458,6 +1582,10 @@ static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfigura
 #ifdef PRIVATE_STORESCP_CODE
     PRIVATE_STORESCP_CODE
 #endif
+    /* C-STORE requests are processed one after the other, so any number of them
+     * may be outstanding. We never invoke operations on the peer.
+     */
+    ASC_setAsyncOperationsWindow(assoc->params, OFstatic_cast(unsigned short, opt_asyncWindow), 1);
     cond = ASC_acknowledgeAssociation(assoc);
     if (cond.bad())
     {
@@ -1467,6 +1595,10 @@ static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfigura
     if (opt_verbose)
     {
       printf("Association Acknowledged (Max Send PDV: %lu)\n", assoc->sendPDVLength);
+      unsigned short maxOpsInvoked = 1;
+      ASC_getAsyncOperationsWindow(assoc->params, &maxOpsInvoked, NULL);
+      if (maxOpsInvoked != 1)
+        printf("    (asynchronous operations window: %u)\n", OFstatic_cast(unsigned int, maxOpsInvoked));
       if (ASC_countAcceptedPresentationContexts(assoc->params) == 0)
         printf("    (but no valid presentation contexts)\n");
       if (opt_debug) ASC_dumpParameters(assoc->params, COUT);
@@ -1508,26 +1640,19 @@ static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfigura
     calledaetitle.clear();
   }
 
+  /* in multiplex mode, the commands are processed by StoreSCPMultiplexer */
+  if (acceptedAssoc)
+  {
+    *acceptedAssoc = assoc;
+    return EC_Normal;
+  }
+
   /* now do the real work, i.e. receive DIMSE commmands over the network connection */
   /* which was established and handle these commands correspondingly. In case of */
   /* storscp only C-ECHO-RQ and C-STORE-RQ commands can be processed. */
   cond = processCommands(assoc);
 
-  if (cond == DUL_PEERREQUESTEDRELEASE)
-  {
-    if (opt_verbose) printf("Association Release\n");
-    cond = ASC_acknowledgeRelease(assoc);
-  }
-  else if (cond == DUL_PEERABORTEDASSOCIATION)
-  {
-    if (opt_verbose) printf("Association Aborted\n");
-  }
-  else
-  {
-    fprintf(stderr, "storescp: DIMSE Failure (aborting association)\n");
-    /* some kind of error so abort the association */
-    cond = ASC_abortAssociation(assoc);
-  }
+  cond = endAssociation(assoc, cond);
 
 cleanup:
 
@@ -1550,6 +1675,35 @@ cleanup:
 }
 
 
+static OFCondition endAssociation(T_ASC_Association *assoc, OFCondition cond)
+    /*
+     * This function acknowledges the release of an association or aborts
+     * it, depending on the condition that ended the processing of commands.
+     *
+     * Parameters:
+     *   assoc - [in] The association (network connection to another DICOM application).
+     *   cond  - [in] The condition returned by processCommands().
+     */
+{
+  if (cond == DUL_PEERREQUESTEDRELEASE)
+  {
+    if (opt_verbose) printf("Association Release\n");
+    cond = ASC_acknowledgeRelease(assoc);
+  }
+  else if (cond == DUL_PEERABORTEDASSOCIATION)
+  {
+    if (opt_verbose) printf("Association Aborted\n");
+  }
+  else
+  {
+    fprintf(stderr, "storescp: DIMSE Failure (aborting association)\n");
+    /* some kind of error so abort the association */
+    cond = ASC_abortAssociation(assoc);
+  }
+  return cond;
+}
+
+
 
 static OFCondition
 processCommands(T_ASC_Association * assoc)
@@ -1563,18 +1717,15 @@ processCommands(T_ASC_Association * assoc)
      */
 {
   OFCondition cond = EC_Normal;
-  T_DIMSE_Message msg;
-  T_ASC_PresentationContextID presID = 0;
-  DcmDataset *statusDetail = NULL;
 
   // start a loop to be able to receive more than one DIMSE command
   while( cond == EC_Normal || cond == DIMSE_NODATAAVAILABLE || cond == DIMSE_OUTOFRESOURCES )
   {
-    // receive a DIMSE command over the network
+    // receive and process a DIMSE command
     if( opt_endOfStudyTimeout == -1 )
-      cond = DIMSE_receiveCommand(assoc, DIMSE_BLOCKING, 0, &presID, &msg, &statusDetail);
+      cond = processCommand(assoc, DIMSE_BLOCKING, 0);
     else
-      cond = DIMSE_receiveCommand(assoc, DIMSE_NONBLOCKING, OFstatic_cast(int, opt_endOfStudyTimeout), &presID, &msg, &statusDetail);
+      cond = processCommand(assoc, DIMSE_NONBLOCKING, OFstatic_cast(int, opt_endOfStudyTimeout));
 
     // check what kind of error occurred. If no data was
     // received, check if certain other conditions are met
@@ -1610,37 +1761,61 @@ processCommands(T_ASC_Association * assoc)
         endOfStudyThroughTimeoutEvent = OFFalse;
       }
     }
+  }
+  return cond;
+}
 
-    // if the command which was received has extra status
-    // detail information, dump this information
-    if (statusDetail != NULL)
-    {
-      printf("Extra Status Detail: \n");
-      statusDetail->print(COUT);
-      delete statusDetail;
-    }
 
-    // check if peer did release or abort, or if we have a valid message
-    if (cond == EC_Normal)
+static OFCondition
+processCommand(T_ASC_Association * assoc, T_DIMSE_BlockingMode blockMode, int timeout)
+    /*
+     * This function receives one DIMSE commmand over the network connection
+     * and handles it. Note that in case of storscp only C-ECHO-RQ and C-STORE-RQ
+     * commands can be processed.
+     *
+     * Parameters:
+     *   assoc     - [in] The association (network connection to another DICOM application).
+     *   blockMode - [in] The blocking mode for receiving the command.
+     *   timeout   - [in] Timeout in seconds, only used with DIMSE_NONBLOCKING.
+     */
+{
+  OFCondition cond = EC_Normal;
+  T_DIMSE_Message msg;
+  T_ASC_PresentationContextID presID = 0;
+  DcmDataset *statusDetail = NULL;
+
+  // receive a DIMSE command over the network
+  cond = DIMSE_receiveCommand(assoc, blockMode, timeout, &presID, &msg, &statusDetail);
+
+  // if the command which was received has extra status
+  // detail information, dump this information
+  if (statusDetail != NULL)
+  {
+    printf("Extra Status Detail: \n");
+    statusDetail->print(COUT);
+    delete statusDetail;
+  }
+
+  // check if peer did release or abort, or if we have a valid message
+  if (cond == EC_Normal)
+  {
+    // in case we received a valid message, process this command
+    // note that storescp can only process a C-ECHO-RQ and a C-STORE-RQ
+    switch (msg.CommandField)
     {
-      // in case we received a valid message, process this command
-      // note that storescp can only process a C-ECHO-RQ and a C-STORE-RQ
-      switch (msg.CommandField)
-      {
-        case DIMSE_C_ECHO_RQ:
-          // process C-ECHO-Request
-          cond = echoSCP(assoc, &msg, presID);
-          break;
-        case DIMSE_C_STORE_RQ:
-          // process C-STORE-Request
-          cond = storeSCP(assoc, &msg, presID);
-          break;
-        default:
-          // we cannot handle this kind of message
-          cond = DIMSE_BADCOMMANDTYPE;
-          fprintf(stderr, "storescp: Cannot handle command: 0x%x\n", OFstatic_cast(unsigned, msg.CommandField));
-          break;
-      }
+      case DIMSE_C_ECHO_RQ:
+        // process C-ECHO-Request
+        cond = echoSCP(assoc, &msg, presID);
+        break;
+      case DIMSE_C_STORE_RQ:
+        // process C-STORE-Request
+        cond = storeSCP(assoc, &msg, presID);
+        break;
+      default:
+        // we cannot handle this kind of message
+        cond = DIMSE_BADCOMMANDTYPE;
+        fprintf(stderr, "storescp: Cannot handle command: 0x%x\n", OFstatic_cast(unsigned, msg.CommandField));
+        break;
     }
   }
   return cond;
@@ -1862,9 +2037,10 @@ storeSCPCallback(
         fileName = cbdata->imageFileName;
 
         // update global variables outputFileNameArray
-        // (might be used in executeOnReception() and renameOnEndOfStudy)
+        // (might be used in executeOnReception() and renameOnEndOfStudy,
+        // which are not available in multiplex mode)
         const char *tmpstr6 = strrchr( fileName.c_str(), PATH_SEPARATOR );
-        outputFileNameArray.push_back(++tmpstr6);
+        if (opt_multiplexThreads == 0) outputFileNameArray.push_back(++tmpstr6);
       }
 
       // determine the transfer syntax which shall be used to write the information to the file
@@ -1909,7 +2085,7 @@ storeSCPCallback(
       // we need to set outputFileNameArray and outputFileNameArrayCnt to be
       // able to perform the placeholder substitution in executeOnReception()
       char *tmpstr7 = strrchr( cbdata->imageFileName, PATH_SEPARATOR );
-      outputFileNameArray.push_back(++tmpstr7);
+      if (opt_multiplexThreads == 0) outputFileNameArray.push_back(++tmpstr7);
     }
   }
 
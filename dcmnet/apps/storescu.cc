@@ -52,6 +52,9 @@ END_EXTERN_C
 #endif
 
 #include "dcmtk/ofstd/ofstring.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/oftimer.h"
+#include "dcmtk/ofstd/ofthread.h"
 #include "dcmtk/dcmnet/dimse.h"
 #include "dcmtk/dcmnet/diutil.h"
 #include "dcmtk/dcmdata/dcdatset.h"
@@ -102,14 +105,19 @@ static OFCmdUnsignedInt opt_maxReceivePDULength = ASC_DEFAULTMAXPDU;
 static OFCmdUnsignedInt opt_maxSendPDULength = 0;
 static E_TransferSyntax opt_networkTransferSyntax = EXS_Unknown;
 
+static const char *opt_peer = NULL;
+static OFCmdUnsignedInt opt_port = 104;
+static const char *opt_peerTitle = PEERAPPLICATIONTITLE;
+static const char *opt_ourTitle = APPLICATIONTITLE;
+
 static OFBool opt_haltOnUnsuccessfulStore = OFTrue;
-static OFBool unsuccessfulStoreEncountered = OFFalse;
-static int lastStatusCode = STATUS_Success;
 
 static OFBool opt_proposeOnlyRequiredPresentationContexts = OFFalse;
 static OFBool opt_combineProposedTransferSyntaxes = OFFalse;
 
 static OFCmdUnsignedInt opt_repeatCount = 1;
+static OFCmdUnsignedInt opt_asyncWindow = 1;
+static OFCmdUnsignedInt opt_parallel = 1;
 static OFCmdUnsignedInt opt_inventPatientCount = 25;
 static OFCmdUnsignedInt opt_inventStudyCount = 50;
 static OFCmdUnsignedInt opt_inventSeriesCount = 100;
@@ -126,6 +134,49 @@ T_DIMSE_BlockingMode opt_blockMode = DIMSE_BLOCKING;
 int opt_dimse_timeout = 0;
 int opt_acse_timeout = 30;
 
+/* C-STORE request that has been sent but not yet been responded to */
+struct StoreRequest
+{
+    DIC_US msgId;
+    OFString fname;
+};
+
+/* association over which (a part of) the files is sent, and its results */
+struct StoreAssociation
+{
+    StoreAssociation()
+    : assoc(NULL)
+    , asyncWindow(1)
+    , outstandingRequests()
+    , fileNames()
+    , sopClassUIDs()
+    , unsuccessfulStoreEncountered(OFFalse)
+    , lastStatusCode(STATUS_Success)
+    , cond(EC_Normal)
+    , imagesSent(0)
+    , bytesSent(0)
+    , seconds(0)
+    {
+    }
+
+    T_ASC_Association *assoc;
+    unsigned short asyncWindow;                // number of C-STORE requests that may be outstanding, as negotiated
+    OFList<StoreRequest> outstandingRequests;
+    OFList<OFString> fileNames;                // files to transfer over this association
+    OFList<OFString> sopClassUIDs;             // their SOP classes, if only required contexts are proposed
+    OFBool unsuccessfulStoreEncountered;
+    int lastStatusCode;
+    OFCondition cond;                          // result of sending the files
+    unsigned long imagesSent;
+    double bytesSent;
+    double seconds;                            // time spent sending the files
+};
+
+#ifdef WITH_THREADS
+/* protects the counters of replaceSOPInstanceInformation() */
+static OFMutex inventMutex;
+#endif
+
 #ifdef WITH_ZLIB
 static OFCmdUnsignedInt opt_compressionLevel = 0;
 #endif
@@ -165,7 +216,49 @@ static OFCondition
 addStoragePresentationContexts(T_ASC_Parameters *params, OFList<OFString>& sopClasses);
 
 static OFCondition
-cstore(T_ASC_Association *assoc, const OFString& fname);
+requestAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg, StoreAssociation& sa);
+
+static OFCondition
+storeFiles(StoreAssociation& sa);
+
+static OFCondition
+releaseAssociation(StoreAssociation& sa);
+
+static void
+printStatistics(const StoreAssociation *associations, size_t count, double seconds);
+
+static OFCondition
+cstore(StoreAssociation& sa, const OFString& fname);
+
+static OFCondition
+receiveStoreResponses(StoreAssociation& sa, size_t maxOutstanding);
+
+#ifdef WITH_THREADS
+/* thread which sends the files of one association */
+class StoreThread: public OFThread
+{
+public:
+    StoreThread(StoreAssociation& sa)
+    : OFThread()
+    , sa_(sa)
+    {
+    }
+
+    virtual ~StoreThread() {}
+
+private:
+    /* private undefined copy constructor and assignment operator */
+    StoreThread(const StoreThread&);
+    StoreThread& operator=(const StoreThread&);
+
+    virtual void run()
+    {
+        storeFiles(sa_);
+    }
+
+    StoreAssociation& sa_;
+};
+#endif
 
 #define SHORTCOL 4
 #define LONGCOL 19
@@ -173,20 +266,11 @@ cstore(T_ASC_Association *assoc, const OFString& fname);
 int
 main(int argc, char *argv[])
 {
-    const char *opt_peer = NULL;
-    OFCmdUnsignedInt opt_port = 104;
-    const char *opt_peerTitle = PEERAPPLICATIONTITLE;
-    const char *opt_ourTitle = APPLICATIONTITLE;
-
     OFList<OFString> fileNameList;       // list of files to transfer to SCP
     OFList<OFString> sopClassUIDList;    // the list of sop classes
     OFList<OFString> sopInstanceUIDList; // the list of sop instances
 
     T_ASC_Network *net;
-    T_ASC_Parameters *params;
-    DIC_NODENAME localHost;
-    DIC_NODENAME peerHost;
-    T_ASC_Association *assoc;
     DcmAssociationConfiguration asccfg; // handler for association configuration profiles
 
 #ifdef HAVE_GUSI_H
@@ -275,6 +359,12 @@ main(int argc, char *argv[])
       cmd.addOption("--max-pdu",                "-pdu",   1,  opt4.c_str(), opt3.c_str());
       cmd.addOption("--max-send-pdu",                     1,  opt4.c_str(), "restrict max send pdu to n bytes");
       cmd.addOption("--repeat",                           1,  "[n]umber: integer", "repeat n times");
+      cmd.addOption("--async-window",           "+aw",    1,  "[n]umber: integer [1..65535]",
+                                                              "propose asynchronous operations window, send\nup to n C-STORE requests before waiting for\nthe responses (default: 1)");
+#ifdef WITH_THREADS
+      cmd.addOption("--parallel",               "+pa",    1,  "[n]umber: integer",
+                                                              "send the files over n associations in\nparallel and print transfer statistics");
+#endif
       cmd.addOption("--abort",                                "abort association instead of releasing it");
       cmd.addOption("--no-halt",                              "do not halt if unsuccessful store encountered\n(default: do halt)");
       cmd.addOption("--uid-padding",            "-up",        "silently correct space-padded UIDs");
@@ -490,6 +580,10 @@ main(int argc, char *argv[])
       }
 
       if (cmd.findOption("--repeat"))  app.checkValue(cmd.getValueAndCheckMin(opt_repeatCount, 1));
+      if (cmd.findOption("--async-window")) app.checkValue(cmd.getValueAndCheckMinMax(opt_asyncWindow, 1, 65535));
+#ifdef WITH_THREADS
+      if (cmd.findOption("--parallel")) app.checkValue(cmd.getValueAndCheckMin(opt_parallel, 1));
+#endif
       if (cmd.findOption("--abort"))   opt_abortAssociation = OFTrue;
       if (cmd.findOption("--no-halt")) opt_haltOnUnsuccessfulStore = OFFalse;
       if (cmd.findOption("--uid-padding")) opt_correctUIDPadding = OFTrue;
@@ -534,6 +628,10 @@ main(int argc, char *argv[])
       }
       cmd.endOptionBlock();
 
+      /* the associations would share one SSL context, and no OpenSSL locking callbacks are installed */
+      if (opt_secureConnection && (opt_parallel > 1))
+        app.printError("--parallel not allowed with --enable-tls or --anonymous-tls");
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--std-passwd"))
       {
@@ -779,184 +877,112 @@ main(int argc, char *argv[])
 
 #endif
 
-    /* initialize asscociation parameters, i.e. create an instance of T_ASC_Parameters*. */
-    cond = ASC_createAssociationParameters(&params, opt_maxReceivePDULength);
-    if (cond.bad()) {
-        DimseCondition::dump(cond);
-        return 1;
-    }
-    /* sets this application's title and the called application's title in the params */
-    /* structure. The default values to be set here are "STORESCU" and "ANY-SCP". */
-    ASC_setAPTitles(params, opt_ourTitle, opt_peerTitle, NULL);
-
-    /* Set the transport layer type (type of network connection) in the params */
-    /* strucutre. The default is an insecure connection; where OpenSSL is  */
-    /* available the user is able to request an encrypted,secure connection. */
-    cond = ASC_setTransportLayerType(params, opt_secureConnection);
-    if (cond.bad()) {
-        DimseCondition::dump(cond);
-        return 1;
-    }
-
-    /* Figure out the presentation addresses and copy the */
-    /* corresponding values into the association parameters.*/
-    gethostname(localHost, sizeof(localHost) - 1);
-    sprintf(peerHost, "%s:%d", opt_peer, (int)opt_port);
-    ASC_setPresentationAddresses(params, localHost, peerHost);
-
-    if (opt_profileName)
-    {
-      /* perform name mangling for config file key */
-      OFString sprofile;
-      const char *c = opt_profileName;
-      while (*c)
-      {
-        if (! isspace(*c)) sprofile += (char) (toupper(*c));
-        ++c;
-      }
-
-      /* set presentation contexts as defined in config file */
-      cond = asccfg.setAssociationParameters(sprofile.c_str(), *params);
-    }
-    else
+    /* partition the files among the associations. Each file is assigned to the */
+    /* association with the smallest amount of data so far, so that all of them */
+    /* finish at about the same time. */
+    size_t numAssociations = OFstatic_cast(size_t, opt_parallel);
+    if (numAssociations > fileNameList.size()) numAssociations = fileNameList.size();
+    if (numAssociations == 0) numAssociations = 1;
+    StoreAssociation *associations = new StoreAssociation[numAssociations];
+    double *partitionBytes = new double[numAssociations];
+    size_t i;
+    for (i = 0; i < numAssociations; ++i) partitionBytes[i] = 0;
+    OFListIterator(OFString) iter = fileNameList.begin();
+    OFListIterator(OFString) enditer = fileNameList.end();
+    OFListIterator(OFString) sopClassIter = sopClassUIDList.begin();
+    while (iter != enditer)
     {
-      /* Set the presentation contexts which will be negotiated */
-      /* when the network connection will be established */
-      cond = addStoragePresentationContexts(params, sopClassUIDList);
-    }
-
-    if (cond.bad()) {
-        DimseCondition::dump(cond);
-        return 1;
+        size_t smallest = 0;
+        for (i = 1; i < numAssociations; ++i)
+            if (partitionBytes[i] < partitionBytes[smallest]) smallest = i;
+        partitionBytes[smallest] += DU_fileSize((*iter).c_str());
+        associations[smallest].fileNames.push_back(*iter);
+        /* the SOP classes are only known if only required contexts are proposed */
+        if (opt_proposeOnlyRequiredPresentationContexts)
+            associations[smallest].sopClassUIDs.push_back(*sopClassIter++);
+        ++iter;
     }
+    delete[] partitionBytes;
 
-    /* dump presentation contexts if required */
-    if (opt_showPresentationContexts || opt_debug) {
-        printf("Request Parameters:\n");
-        ASC_dumpParameters(params, COUT);
+    /* create the associations, i.e. try to establish network connections to the SCP */
+    for (i = 0; (i < numAssociations) && cond.good(); ++i)
+    {
+        cond = requestAssociation(net, asccfg, associations[i]);
     }
-
-    /* create association, i.e. try to establish a network connection to another */
-    /* DICOM application. This call creates an instance of T_ASC_Association*. */
-    if (opt_verbose)
-        printf("Requesting Association\n");
-    cond = ASC_requestAssociation(net, params, &assoc);
     if (cond.bad()) {
-        if (cond == DUL_ASSOCIATIONREJECTED) {
-            T_ASC_RejectParameters rej;
-
-            ASC_getRejectParameters(params, &rej);
-            errmsg("Association Rejected:");
-            ASC_printRejectParameters(stderr, &rej);
-            return 1;
-        } else {
-            errmsg("Association Request Failed:");
-            DimseCondition::dump(cond);
-            return 1;
+        /* abort the associations which have already been established */
+        for (i = 0; i < numAssociations; ++i) {
+            if (associations[i].assoc) {
+                ASC_abortAssociation(associations[i].assoc);
+                ASC_destroyAssociation(&associations[i].assoc);
+            }
         }
-    }
-
-    /* dump the connection parameters if in debug mode*/
-    if (opt_debug)
-    {
-        ostream& out = ofConsole.lockCout();     
-        ASC_dumpConnectionParameters(assoc, out);
-        ofConsole.unlockCout();
-    }
-
-    /* dump the presentation contexts which have been accepted/refused */
-    if (opt_showPresentationContexts || opt_debug) {
-        printf("Association Parameters Negotiated:\n");
-        ASC_dumpParameters(params, COUT);
-    }
-
-    /* count the presentation contexts which have been accepted by the SCP */
-    /* If there are none, finish the execution */
-    if (ASC_countAcceptedPresentationContexts(params) == 0) {
-        errmsg("No Acceptable Presentation Contexts");
+        delete[] associations;
         return 1;
     }
 
-    /* dump general information concerning the establishment of the network connection if required */
-    if (opt_verbose) {
-        printf("Association Accepted (Max Send PDV: %lu)\n",
-                assoc->sendPDVLength);
-    }
-
     /* do the real work, i.e. for all files which were specified in the */
     /* command line, transmit the encapsulated DICOM objects to the SCP. */
-    cond = EC_Normal;
-    OFListIterator(OFString) iter = fileNameList.begin();
-    OFListIterator(OFString) enditer = fileNameList.end();
-
-    while ((iter != enditer) && (cond == EC_Normal)) // compare with EC_Normal since DUL_PEERREQUESTEDRELEASE is also good()
+    OFTimer timer;
+#ifdef WITH_THREADS
+    if (numAssociations > 1)
     {
-        cond = cstore(assoc, *iter);
-        ++iter;
-    }
-
-    /* tear down association, i.e. terminate network connection to SCP */
-    if (cond == EC_Normal)
-    {
-        if (opt_abortAssociation) {
-            if (opt_verbose)
-                printf("Aborting Association\n");
-            cond = ASC_abortAssociation(assoc);
-            if (cond.bad()) {
-                errmsg("Association Abort Failed:");
-                DimseCondition::dump(cond);
-                return 1;
-            }
-        } else {
-            /* release association */
-            if (opt_verbose)
-                printf("Releasing Association\n");
-            cond = ASC_releaseAssociation(assoc);
-            if (cond.bad())
+        /* send the files of each association in a thread of its own */
+        StoreThread **threads = new StoreThread *[numAssociations];
+        for (i = 0; i < numAssociations; ++i)
+        {
+            threads[i] = new StoreThread(associations[i]);
+            if (threads[i]->start() != 0)
             {
-                errmsg("Association Release Failed:");
-                DimseCondition::dump(cond);
-                return 1;
+                // resources exhausted, send the files of this association ourselves
+                delete threads[i];
+                threads[i] = NULL;
+                storeFiles(associations[i]);
             }
         }
-    }
-    else if (cond == DUL_PEERREQUESTEDRELEASE)
-    {
-        errmsg("Protocol Error: peer requested release (Aborting)");
-        if (opt_verbose)
-            printf("Aborting Association\n");
-        cond = ASC_abortAssociation(assoc);
-        if (cond.bad()) {
-            errmsg("Association Abort Failed:");
-            DimseCondition::dump(cond);
-            return 1;
+        for (i = 0; i < numAssociations; ++i)
+        {
+            if (threads[i])
+            {
+                threads[i]->join();
+                delete threads[i];
+            }
         }
-    }
-    else if (cond == DUL_PEERABORTEDASSOCIATION)
-    {
-        if (opt_verbose) printf("Peer Aborted Association\n");
+        delete[] threads;
     }
     else
+#endif
+        storeFiles(associations[0]);
+
+    /* print the transfer statistics */
+    if (numAssociations > 1)
+        printStatistics(associations, numAssociations, timer.getDiff());
+
+    /* tear down the associations, i.e. terminate network connections to SCP */
+    OFBool releaseFailed = OFFalse;
+    for (i = 0; i < numAssociations; ++i)
     {
-        errmsg("SCU Failed:");
-        DimseCondition::dump(cond);
-        if (opt_verbose)
-            printf("Aborting Association\n");
-        cond = ASC_abortAssociation(assoc);
-        if (cond.bad()) {
-            errmsg("Association Abort Failed:");
-            DimseCondition::dump(cond);
-            return 1;
-        }
+        if (releaseAssociation(associations[i]).bad()) releaseFailed = OFTrue;
     }
 
-    /* destroy the association, i.e. free memory of T_ASC_Association* structure. This */
-    /* call is the counterpart of ASC_requestAssociation(...) which was called above. */
-    cond = ASC_destroyAssociation(&assoc);
-    if (cond.bad()) {
-        DimseCondition::dump(cond);
-        return 1;
+    /* the exit code reflects the first association on which a store failed */
+    int exitCode = 0;
+    if (opt_haltOnUnsuccessfulStore) {
+        for (i = 0; i < numAssociations; ++i) {
+            if (associations[i].unsuccessfulStoreEncountered) {
+                if (associations[i].lastStatusCode == STATUS_Success) {
+                    // there must have been some kind of general network error
+                    exitCode = 0xff;
+                } else {
+                    exitCode = (associations[i].lastStatusCode >> 8); // only the least significant byte is relevant as exit code
+                }
+                break;
+            }
+        }
     }
+    delete[] associations;
+    if (releaseFailed) return 1;
+
     /* drop the network, i.e. free memory of T_ASC_Network* structure. This call */
     /* is the counterpart of ASC_initializeNetwork(...) which was called above. */
     cond = ASC_dropNetwork(&net);
@@ -985,16 +1011,6 @@ main(int argc, char *argv[])
     delete tLayer;
 #endif
 
-    int exitCode = 0;
-    if (opt_haltOnUnsuccessfulStore && unsuccessfulStoreEncountered) {
-        if (lastStatusCode == STATUS_Success) {
-            // there must have been some kind of general network error
-            exitCode = 0xff;
-        } else {
-            exitCode = (lastStatusCode >> 8); // only the least significant byte is relevant as exit code
-        }
-    }
-
 #ifdef ON_THE_FLY_COMPRESSION
     // deregister JPEG codecs
     DJDecoderRegistration::cleanup();
@@ -1337,7 +1353,360 @@ progressCallback(void * /*callbackData*/,
 }
 
 static OFCondition
-storeSCU(T_ASC_Association * assoc, const char *fname)
+requestAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg, StoreAssociation& sa)
+    /*
+     * This function creates the association parameters, proposes the presentation
+     * contexts for the files of the given association and requests the association.
+     *
+     * Parameters:
+     *   net - [in] The network over which the association is requested.
+     *   asccfg - [in] The association negotiation profiles.
+     *   sa - [inout] The association; the established association is stored in sa.assoc.
+     */
+{
+    /* initialize asscociation parameters, i.e. create an instance of T_ASC_Parameters*. */
+    T_ASC_Parameters *params = NULL;
+    OFCondition cond = ASC_createAssociationParameters(&params, opt_maxReceivePDULength);
+    if (cond.bad()) {
+        DimseCondition::dump(cond);
+        return cond;
+    }
+    /* sets this application's title and the called application's title in the params */
+    /* structure. The default values to be set here are "STORESCU" and "ANY-SCP". */
+    ASC_setAPTitles(params, opt_ourTitle, opt_peerTitle, NULL);
+
+    /* propose to invoke several C-STORE operations without waiting for the responses. */
+    /* We never perform operations invoked by the SCP. */
+    if (opt_asyncWindow > 1)
+        ASC_setAsyncOperationsWindow(params, OFstatic_cast(unsigned short, opt_asyncWindow), 1);
+
+    /* Set the transport layer type (type of network connection) in the params */
+    /* strucutre. The default is an insecure connection; where OpenSSL is  */
+    /* available the user is able to request an encrypted,secure connection. */
+    cond = ASC_setTransportLayerType(params, opt_secureConnection);
+    if (cond.bad()) {
+        DimseCondition::dump(cond);
+        return cond;
+    }
+
+    /* Figure out the presentation addresses and copy the */
+    /* corresponding values into the association parameters.*/
+    DIC_NODENAME localHost;
+    DIC_NODENAME peerHost;
+    gethostname(localHost, sizeof(localHost) - 1);
+    sprintf(peerHost, "%s:%d", opt_peer, (int)opt_port);
+    ASC_setPresentationAddresses(params, localHost, peerHost);
+
+    if (opt_profileName)
+    {
+      /* perform name mangling for config file key */
+      OFString sprofile;
+      const char *c = opt_profileName;
+      while (*c)
+      {
+        if (! isspace(*c)) sprofile += (char) (toupper(*c));
+        ++c;
+      }
+
+      /* set presentation contexts as defined in config file */
+      cond = asccfg.setAssociationParameters(sprofile.c_str(), *params);
+    }
+    else
+    {
+      /* Set the presentation contexts which will be negotiated */
+      /* when the network connection will be established */
+      cond = addStoragePresentationContexts(params, sa.sopClassUIDs);
+    }
+
+    if (cond.bad()) {
+        DimseCondition::dump(cond);
+        return cond;
+    }
+
+    /* dump presentation contexts if required */
+    if (opt_showPresentationContexts || opt_debug) {
+        printf("Request Parameters:\n");
+        ASC_dumpParameters(params, COUT);
+    }
+
+    /* create association, i.e. try to establish a network connection to another */
+    /* DICOM application. This call creates an instance of T_ASC_Association*. */
+    if (opt_verbose)
+        printf("Requesting Association\n");
+    T_ASC_Association *assoc = NULL;
+    cond = ASC_requestAssociation(net, params, &assoc);
+    if (cond.bad()) {
+        if (cond == DUL_ASSOCIATIONREJECTED) {
+            T_ASC_RejectParameters rej;
+
+            ASC_getRejectParameters(params, &rej);
+            errmsg("Association Rejected:");
+            ASC_printRejectParameters(stderr, &rej);
+            return cond;
+        } else {
+            errmsg("Association Request Failed:");
+            DimseCondition::dump(cond);
+            return cond;
+        }
+    }
+
+    sa.assoc = assoc;
+
+    /* dump the connection parameters if in debug mode*/
+    if (opt_debug)
+    {
+        ostream& out = ofConsole.lockCout();     
+        ASC_dumpConnectionParameters(assoc, out);
+        ofConsole.unlockCout();
+    }
+
+    /* dump the presentation contexts which have been accepted/refused */
+    if (opt_showPresentationContexts || opt_debug) {
+        printf("Association Parameters Negotiated:\n");
+        ASC_dumpParameters(params, COUT);
+    }
+
+    /* count the presentation contexts which have been accepted by the SCP */
+    /* If there are none, finish the execution */
+    if (ASC_countAcceptedPresentationContexts(params) == 0) {
+        errmsg("No Acceptable Presentation Contexts");
+        return DIMSE_NOVALIDPRESENTATIONCONTEXTID;
+    }
+
+    /* dump general information concerning the establishment of the network connection if required */
+    if (opt_verbose) {
+        printf("Association Accepted (Max Send PDV: %lu)\n",
+                assoc->sendPDVLength);
+    }
+
+    /* figure out how many C-STORE requests may be outstanding. 0 means unlimited, */
+    /* but we never send more requests than we have proposed. */
+    ASC_getAsyncOperationsWindow(params, &sa.asyncWindow, NULL);
+    if (sa.asyncWindow == 0 || sa.asyncWindow > opt_asyncWindow)
+        sa.asyncWindow = OFstatic_cast(unsigned short, opt_asyncWindow);
+    if (opt_verbose && sa.asyncWindow > 1) {
+        printf("Asynchronous Operations Window: %u\n", OFstatic_cast(unsigned int, sa.asyncWindow));
+    }
+    return EC_Normal;
+}
+
+static OFCondition
+storeFiles(StoreAssociation& sa)
+    /*
+     * This function transmits all files of the given association to the SCP
+     * and records the time needed in sa.seconds and the result in sa.cond.
+     *
+     * Parameters:
+     *   sa - [inout] The association over which the files are sent.
+     */
+{
+    OFTimer timer;
+    OFCondition cond = EC_Normal;
+    OFListIterator(OFString) iter = sa.fileNames.begin();
+    OFListIterator(OFString) enditer = sa.fileNames.end();
+
+    while ((iter != enditer) && (cond == EC_Normal)) // compare with EC_Normal since DUL_PEERREQUESTEDRELEASE is also good()
+    {
+        cond = cstore(sa, *iter);
+        ++iter;
+    }
+
+    /* receive the responses to the C-STORE requests which are still outstanding */
+    if (cond == EC_Normal && sa.asyncWindow > 1) {
+        cond = receiveStoreResponses(sa, 0);
+        if (! opt_haltOnUnsuccessfulStore) cond = EC_Normal;
+    }
+
+    sa.seconds = timer.getDiff();
+    sa.cond = cond;
+    return cond;
+}
+
+static OFCondition
+releaseAssociation(StoreAssociation& sa)
+    /*
+     * This function releases or aborts the given association, depending on the
+     * result of sending its files, and destroys it.
+     *
+     * Parameters:
+     *   sa - [inout] The association.
+     */
+{
+    T_ASC_Association *assoc = sa.assoc;
+    OFCondition cond = sa.cond;
+
+    /* tear down association, i.e. terminate network connection to SCP */
+    if (cond == EC_Normal)
+    {
+        if (opt_abortAssociation) {
+            if (opt_verbose)
+                printf("Aborting Association\n");
+            cond = ASC_abortAssociation(assoc);
+            if (cond.bad()) {
+                errmsg("Association Abort Failed:");
+                DimseCondition::dump(cond);
+                return cond;
+            }
+        } else {
+            /* release association */
+            if (opt_verbose)
+                printf("Releasing Association\n");
+            cond = ASC_releaseAssociation(assoc);
+            if (cond.bad())
+            {
+                errmsg("Association Release Failed:");
+                DimseCondition::dump(cond);
+                return cond;
+            }
+        }
+    }
+    else if (cond == DUL_PEERREQUESTEDRELEASE)
+    {
+        errmsg("Protocol Error: peer requested release (Aborting)");
+        if (opt_verbose)
+            printf("Aborting Association\n");
+        cond = ASC_abortAssociation(assoc);
+        if (cond.bad()) {
+            errmsg("Association Abort Failed:");
+            DimseCondition::dump(cond);
+            return cond;
+        }
+    }
+    else if (cond == DUL_PEERABORTEDASSOCIATION)
+    {
+        if (opt_verbose) printf("Peer Aborted Association\n");
+    }
+    else
+    {
+        errmsg("SCU Failed:");
+        DimseCondition::dump(cond);
+        if (opt_verbose)
+            printf("Aborting Association\n");
+        cond = ASC_abortAssociation(assoc);
+        if (cond.bad()) {
+            errmsg("Association Abort Failed:");
+            DimseCondition::dump(cond);
+            return cond;
+        }
+    }
+
+    /* destroy the association, i.e. free memory of T_ASC_Association* structure. This */
+    /* call is the counterpart of ASC_requestAssociation(...) which was called above. */
+    cond = ASC_destroyAssociation(&sa.assoc);
+    if (cond.bad()) {
+        DimseCondition::dump(cond);
+        return cond;
+    }
+    return EC_Normal;
+}
+
+static double
+perSecond(double amount, double seconds)
+{
+    return (seconds > 0) ? amount / seconds : 0;
+}
+
+static void
+printStatistics(const StoreAssociation *associations, size_t count, double seconds)
+    /*
+     * This function prints the amount of data sent and the transfer rates
+     * of each association and of all associations together.
+     *
+     * Parameters:
+     *   associations - [in] The associations.
+     *   count - [in] The number of associations.
+     *   seconds - [in] The time needed to send the files over all associations.
+     */
+{
+    unsigned long totalImages = 0;
+    double totalBytes = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const StoreAssociation& sa = associations[i];
+        double megaBytes = sa.bytesSent / (1024.0 * 1024.0);
+        printf("Association %lu: %lu images, %.2f MB in %.2f s (%.2f MB/s, %.2f images/s)\n",
+            OFstatic_cast(unsigned long, i + 1), sa.imagesSent, megaBytes, sa.seconds,
+            perSecond(megaBytes, sa.seconds), perSecond(sa.imagesSent, sa.seconds));
+        totalImages += sa.imagesSent;
+        totalBytes += sa.bytesSent;
+    }
+    double megaBytes = totalBytes / (1024.0 * 1024.0);
+    printf("Total: %lu images, %.2f MB in %.2f s over %lu associations (%.2f MB/s, %.2f images/s)\n",
+        totalImages, megaBytes, seconds, OFstatic_cast(unsigned long, count),
+        perSecond(megaBytes, seconds), perSecond(totalImages, seconds));
+}
+
+static OFCondition
+receiveStoreResponses(StoreAssociation& sa, size_t maxOutstanding)
+    /*
+     * This function receives C-STORE-RSP messages until no more than the given
+     * number of C-STORE requests are outstanding. The responses may arrive in
+     * any order and are matched with the requests by their message ID.
+     *
+     * Parameters:
+     *   sa - [inout] The association (network connection to another DICOM application).
+     *   maxOutstanding - [in] Number of requests which may remain outstanding.
+     */
+{
+    OFCondition cond = EC_Normal;
+    while (cond == EC_Normal && sa.outstandingRequests.size() > maxOutstanding)
+    {
+        T_ASC_PresentationContextID presId;
+        T_DIMSE_C_StoreRSP rsp;
+        DcmDataset *statusDetail = NULL;
+
+        bzero((char*)&rsp, sizeof(rsp));
+        cond = DIMSE_receiveStoreResponse(sa.assoc, opt_blockMode, opt_dimse_timeout,
+            &presId, &rsp, &statusDetail);
+        if (cond.bad()) {
+            errmsg("Store Failed, no response received:");
+            DimseCondition::dump(cond);
+            break;
+        }
+
+        /* find the request which is responded to */
+        OFListIterator(StoreRequest) iter = sa.outstandingRequests.begin();
+        OFListIterator(StoreRequest) last = sa.outstandingRequests.end();
+        while (iter != last && (*iter).msgId != rsp.MessageIDBeingRespondedTo) ++iter;
+        if (iter == last) {
+            char buf[256];
+            sprintf(buf, "DIMSE: Unexpected Response MsgId: %d", rsp.MessageIDBeingRespondedTo);
+            cond = makeDcmnetCondition(DIMSEC_UNEXPECTEDRESPONSE, OF_error, buf);
+            errmsg("Store Failed:");
+            DimseCondition::dump(cond);
+            delete statusDetail;
+            break;
+        }
+
+        /*
+         * If the image was not accepted, i.e. the status is neither
+         * success nor some warning, remember it.
+         */
+        if (rsp.DimseStatus != STATUS_Success && !DICOM_WARNING_STATUS(rsp.DimseStatus)) {
+            sa.unsuccessfulStoreEncountered = OFTrue;
+        }
+
+        /* remember the response's status for later transmissions of data */
+        sa.lastStatusCode = rsp.DimseStatus;
+
+        if (opt_verbose) {
+            printf("Response for file: %s\n", (*iter).fname.c_str());
+            DIMSE_printCStoreRSP(stdout, &rsp);
+        }
+
+        /* dump status detail information if there is some */
+        if (statusDetail != NULL) {
+            printf("  Status Detail:\n");
+            statusDetail->print(COUT);
+            delete statusDetail;
+        }
+        sa.outstandingRequests.erase(iter);
+    }
+    return cond;
+}
+
+static OFCondition
+storeSCU(StoreAssociation& sa, const char *fname)
     /*
      * This function will read all the information from the given file,
      * figure out a corresponding presentation context which will be used
@@ -1345,10 +1714,11 @@ storeSCU(T_ASC_Association * assoc, const char *fname)
      * will finally initiate the transmission of all data to the SCP.
      *
      * Parameters:
-     *   assoc - [in] The association (network connection to another DICOM application).
+     *   sa - [inout] The association (network connection to another DICOM application).
      *   fname - [in] Name of the file which shall be processed.
      */
 {
+    T_ASC_Association *assoc = sa.assoc;
     DIC_US msgId = assoc->nextMsgID++;
     T_ASC_PresentationContextID presId;
     T_DIMSE_C_StoreRQ req;
@@ -1357,7 +1727,7 @@ storeSCU(T_ASC_Association * assoc, const char *fname)
     DIC_UI sopInstance;
     DcmDataset *statusDetail = NULL;
 
-    unsuccessfulStoreEncountered = OFTrue; // assumption
+    sa.unsuccessfulStoreEncountered = OFTrue; // assumption
 
     if (opt_verbose) {
         printf("--------------------------\n");
@@ -1379,7 +1749,13 @@ storeSCU(T_ASC_Association * assoc, const char *fname)
 
     /* if required, invent new SOP instance information for the current data set (user option) */
     if (opt_inventSOPInstanceInformation) {
+#ifdef WITH_THREADS
+        inventMutex.lock();
+#endif
         replaceSOPInstanceInformation(dcmff.getDataset());
+#ifdef WITH_THREADS
+        inventMutex.unlock();
+#endif
     }
 
     /* figure out which SOP class and SOP instance is encapsulated in the file */
@@ -1440,26 +1816,53 @@ storeSCU(T_ASC_Association * assoc, const char *fname)
         printf("Store SCU RQ: MsgID %d, (%s)\n", msgId, dcmSOPClassUIDToModality(sopClass));
     }
 
+    /* the size of the file is used for the progress information and the statistics */
+    unsigned long fileSize = DU_fileSize(fname);
+
+    /* if an asynchronous operations window has been negotiated, send the request */
+    /* and only wait for responses when the window is full */
+    if (sa.asyncWindow > 1) {
+        cond = DIMSE_sendStoreRequest(assoc, presId, &req,
+            NULL, dcmff.getDataset(), progressCallback, NULL, fileSize);
+        if (cond.bad()) {
+            errmsg("Store Failed, file: %s:", fname);
+            DimseCondition::dump(cond);
+            return cond;
+        }
+        sa.imagesSent++;
+        sa.bytesSent += fileSize;
+        StoreRequest request;
+        request.msgId = msgId;
+        request.fname = fname;
+        sa.outstandingRequests.push_back(request);
+
+        /* the outcome is not known yet, receiveStoreResponses() records failures */
+        sa.unsuccessfulStoreEncountered = OFFalse;
+        return receiveStoreResponses(sa, sa.asyncWindow - 1);
+    }
+
     /* finally conduct transmission of data */
     cond = DIMSE_storeUser(assoc, presId, &req,
         NULL, dcmff.getDataset(), progressCallback, NULL,
         opt_blockMode, opt_dimse_timeout,
-        &rsp, &statusDetail, NULL, DU_fileSize(fname));
+        &rsp, &statusDetail, NULL, fileSize);
 
     /*
      * If store command completed normally, with a status
      * of success or some warning then the image was accepted.
      */
     if (cond == EC_Normal && (rsp.DimseStatus == STATUS_Success || DICOM_WARNING_STATUS(rsp.DimseStatus))) {
-        unsuccessfulStoreEncountered = OFFalse;
+        sa.unsuccessfulStoreEncountered = OFFalse;
     }
 
     /* remember the response's status for later transmissions of data */
-    lastStatusCode = rsp.DimseStatus;
+    sa.lastStatusCode = rsp.DimseStatus;
 
     /* dump some more general information */
     if (cond == EC_Normal)
     {
+        sa.imagesSent++;
+        sa.bytesSent += fileSize;
         if (opt_verbose) {
             DIMSE_printCStoreRSP(stdout, &rsp);
         }
@@ -1482,13 +1885,13 @@ storeSCU(T_ASC_Association * assoc, const char *fname)
 
 
 static OFCondition
-cstore(T_ASC_Association * assoc, const OFString& fname)
+cstore(StoreAssociation& sa, const OFString& fname)
     /*
      * This function will process the given file as often as is specified by opt_repeatCount.
      * "Process" in this case means "read file, send C-STORE-RQ, receive C-STORE-RSP".
      *
      * Parameters:
-     *   assoc - [in] The association (network connection to another DICOM application).
+     *   sa - [inout] The association (network connection to another DICOM application).
      *   fname - [in] Name of the file which shall be processed.
      */
 {
@@ -1498,10 +1901,10 @@ cstore(T_ASC_Association * assoc, const OFString& fname)
     int n = (int)opt_repeatCount;
 
     /* as long as no error occured and the counter does not equal 0 */
-    while ((cond.good()) && n-- && !(opt_haltOnUnsuccessfulStore && unsuccessfulStoreEncountered))
+    while ((cond.good()) && n-- && !(opt_haltOnUnsuccessfulStore && sa.unsuccessfulStoreEncountered))
     {
         /* process file (read file, send C-STORE-RQ, receive C-STORE-RSP) */
-        cond = storeSCU(assoc, fname.c_str());
+        cond = storeSCU(sa, fname.c_str());
     }
 
     // we don't want to return an error code if --no-halt was specified.
@@ -224,6 +224,13 @@ struct T_ASC_Parameters
     long ourMaxPDUReceiveSize;		/* we say what we can receive */
     long theirMaxPDUReceiveSize;	/* they say what we can send */
 
+    /* asynchronous operations window we propose (requestor) or
+     * support at most (acceptor), 0 means unlimited. The negotiated
+     * window is stored in the DUL parameters.
+     */
+    unsigned short ourMaxOperationsInvoked;
+    unsigned short ourMaxOperationsPerformed;
+
 };
 
 /*
@@ -305,6 +312,39 @@ ASC_getApplicationContextName(
     T_ASC_Parameters * params,
     char* applicationContextName);
 
+/** sets the asynchronous operations window. An association requestor
+ *  proposes these values, an association acceptor accepts at most these
+ *  values when acknowledging an association. The default is 1/1, i.e.
+ *  synchronous operation.
+ *  @param params association parameters
+ *  @param maxOpsInvoked maximum number of outstanding operations invoked
+ *    by the association requestor, 0 means unlimited
+ *  @param maxOpsPerformed maximum number of outstanding operations performed
+ *    by the association requestor, 0 means unlimited
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+OFCondition
+ASC_setAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    unsigned short maxOpsInvoked,
+    unsigned short maxOpsPerformed);
+
+/** returns the asynchronous operations window negotiated for an
+ *  association (or the window proposed by the peer if the association
+ *  has been received but not yet acknowledged).
+ *  @param params association parameters
+ *  @param maxOpsInvoked maximum number of outstanding operations invoked
+ *    by the association requestor returned in this parameter, 0 means unlimited
+ *  @param maxOpsPerformed maximum number of outstanding operations performed
+ *    by the association requestor returned in this parameter, 0 means unlimited
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+OFCondition
+ASC_getAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    unsigned short * maxOpsInvoked,
+    unsigned short * maxOpsPerformed);
+
 OFCondition 
 ASC_setPresentationAddresses(
     T_ASC_Parameters * params,
@@ -0,0 +1,204 @@
+/*
+ *
+ *  Copyright (C) 1994-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  agent
+ *
+ *  Purpose: class DcmAssociationMultiplexer, serves many associations
+ *    concurrently in a single process
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#ifndef DCASMUX_H
+#define DCASMUX_H
+
+#include "dcmtk/config/osconfig.h"
+
+/* the multiplexer requires the Linux epoll interface and thread support */
+#if defined(HAVE_SYS_EPOLL_H) && defined(WITH_THREADS)
+#define WITH_ASSOCIATION_MULTIPLEXER
+#endif
+
+#ifdef WITH_ASSOCIATION_MULTIPLEXER
+
+#include "dcmtk/ofstd/ofcond.h"    /* for class OFCondition */
+#include "dcmtk/ofstd/ofthread.h"  /* for class OFMutex, OFSemaphore */
+#include "dcmtk/ofstd/oflist.h"    /* for class OFList */
+#include "dcmtk/dcmnet/assoc.h"    /* for T_ASC_Network, T_ASC_Association */
+
+class DcmAssociationWorker;
+
+
+/** abstract base class for an association acceptor that serves many
+ *  associations concurrently in a single process.
+ *  The calling thread waits with epoll for incoming association requests
+ *  and for data on all established associations that are idle. Both are
+ *  handed to a pool of worker threads. A worker either negotiates the
+ *  waiting association request or processes the next DIMSE message of an
+ *  association (including its data set), and then hands the association
+ *  back. While an association is processed, its socket is not watched, so
+ *  each association is processed by one thread at a time. Association
+ *  requests are negotiated one at a time; a peer that connects but does
+ *  not send its request delays further association requests, but not the
+ *  established associations. A peer that stops sending within a message
+ *  occupies a worker until the receive timeout expires.
+ *  The handlers implemented by derived classes are called concurrently for
+ *  different associations and must protect any shared state.
+ */
+class DcmAssociationMultiplexer
+{
+public:
+
+  /** constructor.
+   *  @param network network on which association requests are received
+   *  @param numberOfThreads number of worker threads processing DIMSE messages
+   *  @param timeout timeout in seconds for each read operation on an
+   *    association, i.e. the maximum time a worker waits for the rest of a
+   *    message. 0 for no timeout. The DUL layer reads PDUs in blocking mode
+   *    once their header has arrived, so this timeout is set on the socket.
+   */
+  DcmAssociationMultiplexer(T_ASC_Network *network, Uint32 numberOfThreads, int timeout = 0);
+
+  /// destructor
+  virtual ~DcmAssociationMultiplexer();
+
+  /** accepts associations and processes their messages until
+   *  acceptAssociation() returns an error. Associations that are still
+   *  established at that time are passed to finishAssociation().
+   *  @return EC_Normal if terminated by acceptAssociation(), an error code if
+   *    the event loop could not be run or failed
+   */
+  OFCondition run();
+
+protected:
+
+  /** receives and negotiates an association request. Called by a worker
+   *  thread whenever an association request is waiting. Association requests
+   *  are never negotiated concurrently.
+   *  @param assoc the acknowledged association is returned in this parameter.
+   *    NULL if the association was rejected or could not be received.
+   *  @return EC_Normal to continue, an error code to terminate run()
+   */
+  virtual OFCondition acceptAssociation(T_ASC_Association *&assoc) = 0;
+
+  /** processes the next DIMSE message on the given association.
+   *  Called by a worker thread when data is waiting on the association.
+   *  @param assoc association
+   *  @return EC_Normal if the association remains established, otherwise the
+   *    condition that ended it (e.g. DUL_PEERREQUESTEDRELEASE)
+   */
+  virtual OFCondition processMessage(T_ASC_Association *assoc) = 0;
+
+  /** terminates the given association (e.g. acknowledges the release
+   *  or aborts) and destroys it. Called by a worker thread after
+   *  processMessage() has returned an error, and by run() for associations
+   *  that are still established when the event loop ends.
+   *  @param assoc association
+   *  @param cond condition returned by processMessage(), or
+   *    DUL_NETWORKCLOSED if the event loop has ended
+   */
+  virtual void finishAssociation(T_ASC_Association *assoc, OFCondition cond) = 0;
+
+private:
+
+  friend class DcmAssociationWorker;
+
+  /// private undefined copy constructor
+  DcmAssociationMultiplexer(const DcmAssociationMultiplexer&);
+
+  /// private undefined copy assignment operator
+  DcmAssociationMultiplexer& operator=(const DcmAssociationMultiplexer&);
+
+  /** starts watching the socket of the given association
+   *  @param assoc association
+   *  @param add true if the association is new, false if it is handed back
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition watch(T_ASC_Association *assoc, OFBool add);
+
+  /** starts or resumes watching the listen socket for association requests
+   *  @param add true if the socket is not yet watched
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition watchNetwork(OFBool add);
+
+  /// processes associations handed over by run() until NULL is handed over
+  void work();
+
+  /** receives an association request by calling acceptAssociation() and
+   *  starts watching the new association. If acceptAssociation() fails,
+   *  run() is woken up and terminates.
+   */
+  void receive();
+
+  /** stops watching the socket of the given association and removes
+   *  the association from the list of established associations
+   *  @param assoc association
+   */
+  void forget(T_ASC_Association *assoc);
+
+  /// network on which association requests are received
+  T_ASC_Network *network_;
+
+  /// number of worker threads
+  Uint32 numberOfThreads_;
+
+  /// timeout in seconds for read operations on an association, 0 for none
+  int timeout_;
+
+  /// epoll file descriptor, -1 while not running
+  int epollfd_;
+
+  /// pipe used by receive() to wake up run() after acceptAssociation() has failed
+  int wakeup_[2];
+
+  /// true if an association request is waiting for a worker
+  OFBool receivePending_;
+
+  /// condition returned by acceptAssociation() if it has failed
+  OFCondition receiveResult_;
+
+  /// associations waiting for a worker, NULL tells a worker to terminate
+  OFList<T_ASC_Association *> queue_;
+
+  /// counts the entries of queue_
+  OFSemaphore queueCount_;
+
+  /// all associations that are established, i.e. watched, queued or processed
+  OFList<T_ASC_Association *> associations_;
+
+  /// protects queue_, receivePending_, receiveResult_ and associations_
+  OFMutex mutex_;
+};
+
+#endif
+#endif
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
@@ -38,10 +38,18 @@
 #include "dcmtk/ofstd/oftypes.h"     /* for OFBool */
 #include "dcmtk/dcmnet/dcmlayer.h"    /* for DcmTransportLayerStatus */
 #include "dcmtk/ofstd/ofstream.h"    /* for ostream */
+#include "dcmtk/ofstd/ofglobal.h"    /* for OFGlobal */
 
 #define INCLUDE_UNISTD
 #include "dcmtk/ofstd/ofstdinc.h"
 
+/** size in bytes of the buffer into which a DcmTCPConnection reads from its
+ *  socket. Data is read in blocks of up to this size, so that the headers and
+ *  bodies of many PDUs are taken from memory without further system calls.
+ *  Zero disables buffering. The value is evaluated when a connection is created.
+ */
+extern OFGlobal<Uint32> dcmTCPReadBufferSize; /* default 1048576 */
+
 /** this class represents a TCP/IP based transport connection
  *  which can be a transparent TCP/IP socket communication or a
  *  secure transport protocol such as TLS.
@@ -99,6 +107,28 @@ public:
    */
   virtual ssize_t write(void *buf, size_t nbyte) = 0;
 
+  /** attempts to write the given blocks of data to the transport connection,
+   *  one after the other. The default implementation calls write() for each
+   *  block until all data has been written.
+   *  @param blocks array of pointers to the blocks
+   *  @param lengths array of the lengths of the blocks in bytes
+   *  @param count number of blocks
+   *  @return number of bytes written, negative number if unsuccessful.
+   */
+  virtual ssize_t writeBlocks(const void * const *blocks, const size_t *lengths, int count);
+
+  /** attempts to write a header followed by nbyte bytes from the given file
+   *  to the transport connection. The default implementation reads the file
+   *  data into a buffer and calls write() until all data has been written.
+   *  @param head header written before the file data, may be NULL
+   *  @param headLength length of the header in bytes
+   *  @param fd descriptor of a file opened for reading
+   *  @param offset byte offset of the data from the start of the file
+   *  @param nbyte number of bytes to write from the file
+   *  @return number of bytes written including the header, negative number if unsuccessful.
+   */
+  virtual ssize_t writeFromFile(const void *head, size_t headLength, int fd, unsigned long offset, size_t nbyte);
+
   /** Closes the transport connection. If a secure connection
    *  is used, a closure alert is sent before the connection
    *  is closed. Abstract method.
@@ -161,8 +191,6 @@ public:
    */
   static OFBool selectReadableAssociation(DcmTransportConnection *connections[], int connCount, int timeout);
 
-protected:
-
   /** returns the socket file descriptor managed by this object.
    *  @return socket file descriptor
    */
@@ -272,6 +300,28 @@ public:
    */
   virtual ssize_t write(void *buf, size_t nbyte);
 
+  /** attempts to write the given blocks of data to the transport connection,
+   *  one after the other. Where available, writev() is used so that all
+   *  blocks are sent with a single system call.
+   *  @param blocks array of pointers to the blocks
+   *  @param lengths array of the lengths of the blocks in bytes
+   *  @param count number of blocks
+   *  @return number of bytes written, negative number if unsuccessful.
+   */
+  virtual ssize_t writeBlocks(const void * const *blocks, const size_t *lengths, int count);
+
+  /** attempts to write a header followed by nbyte bytes from the given file
+   *  to the transport connection. Where available, sendfile() is used so that
+   *  the file data does not pass through a user space buffer.
+   *  @param head header written before the file data, may be NULL
+   *  @param headLength length of the header in bytes
+   *  @param fd descriptor of a file opened for reading
+   *  @param offset byte offset of the data from the start of the file
+   *  @param nbyte number of bytes to write from the file
+   *  @return number of bytes written including the header, negative number if unsuccessful.
+   */
+  virtual ssize_t writeFromFile(const void *head, size_t headLength, int fd, unsigned long offset, size_t nbyte);
+
   /** Closes the transport connection. If a secure connection
    *  is used, a closure alert is sent before the connection
    *  is closed.
@@ -301,7 +351,9 @@ public:
   virtual OFBool networkDataAvailable(int timeout);
 
   /** returns OFTrue if this connection is a transparent TCP connection,
-   *  OFFalse if the connection is a secure connection.
+   *  OFFalse if the connection is a secure connection. While data that has
+   *  already been read from the socket is waiting in the read buffer, OFFalse
+   *  is returned as well, since select() on the socket would not report it.
    */
   virtual OFBool isTransparentConnection();
 
@@ -325,6 +377,18 @@ private:
   /// private undefined assignment operator
   DcmTCPConnection& operator=(const DcmTCPConnection&);
 
+  /// buffer for data read from the socket, allocated on first use
+  char *readBuffer;
+
+  /// size of the read buffer in bytes, 0 if reads are not buffered
+  size_t readBufferSize;
+
+  /// offset of the first byte in the read buffer not yet passed to the caller
+  size_t readStart;
+
+  /// offset behind the last byte in the read buffer
+  size_t readEnd;
+
 };
 
 #endif
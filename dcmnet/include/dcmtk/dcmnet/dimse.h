@@ -706,6 +706,35 @@ DIMSE_storeUser(
         /* in */
         long imageFileTotalBytes=0);
 
+/*
+ * Pipelined C-STORE: if an asynchronous operations window has been
+ * negotiated, several C-STORE-RQ messages may be sent with
+ * DIMSE_sendStoreRequest() before the responses are received with
+ * DIMSE_receiveStoreResponse().  The peer may respond in any order,
+ * the caller matches the responses with its requests using the
+ * MessageIDBeingRespondedTo field.
+ */
+
+OFCondition
+DIMSE_sendStoreRequest(
+	/* in */ 
+	T_ASC_Association *assoc, T_ASC_PresentationContextID presId,
+	T_DIMSE_C_StoreRQ *request,
+	const char *imageFileName, DcmDataset *imageDataSet,
+	DIMSE_StoreUserCallback callback, void *callbackData,
+        long imageFileTotalBytes=0);
+
+OFCondition
+DIMSE_receiveStoreResponse(
+	/* in */ 
+	T_ASC_Association *assoc,
+	/* blocking info for response */
+	T_DIMSE_BlockingMode blockMode, int timeout,
+	/* out */
+	T_ASC_PresentationContextID *presId,
+	T_DIMSE_C_StoreRSP *response,
+	DcmDataset **statusDetail);
+
 typedef void (*DIMSE_StoreProviderCallback)(
     /* in */
     void *callbackData, 
@@ -717,6 +746,11 @@ typedef void (*DIMSE_StoreProviderCallback)(
     /* out */
     DcmDataset **statusDetail);
 
+typedef void (*DIMSE_StoreDataCallback)(
+    /* in */
+    void *callbackData,
+    const void *data, Uint32 length);	/* data set fragment written to file */
+
 OFCondition
 DIMSE_storeProvider(/* in */
 	T_ASC_Association *assoc, 
@@ -726,7 +760,9 @@ DIMSE_storeProvider(/* in */
     DcmDataset **imageDataSet,
 	DIMSE_StoreProviderCallback callback, void *callbackData,
 	/* blocking info for data set */
-	T_DIMSE_BlockingMode blockMode, int timeout);
+	T_DIMSE_BlockingMode blockMode, int timeout,
+	/* data set fragments, only if received into file */
+	DIMSE_StoreDataCallback dataCallback = NULL, void *dataCallbackData = NULL);
 
 OFCondition
 DIMSE_sendStoreResponse(T_ASC_Association * assoc,
@@ -981,7 +1017,9 @@ DIMSE_receiveDataSetInFile(T_ASC_Association *assoc,
 		     T_DIMSE_BlockingMode blocking, int timeout, 
 		     T_ASC_PresentationContextID *presID,
 		     DcmOutputStream *filestream,
-		     DIMSE_ProgressCallback callback, void *callbackData);
+		     DIMSE_ProgressCallback callback, void *callbackData,
+		     DIMSE_StoreDataCallback dataCallback = NULL,
+		     void *dataCallbackData = NULL);
 
 OFCondition 
 DIMSE_ignoreDataSet( T_ASC_Association * assoc,
@@ -97,6 +97,22 @@ extern OFGlobal<const char *> dcmTCPWrapperDaemonName;   /* default NULL */
  */
 extern OFGlobal<unsigned long> dcmEnableBackwardCompatibility;
 
+/** Global size (bytes) of the TCP send buffer (SO_SNDBUF) of new connections.
+ *  Default value is -1 which selects the value of the environment variable
+ *  TCP_BUFFER_LENGTH or, if that is not set, 32 kbytes. Zero keeps the default
+ *  of the operating system, which may adjust the buffer size automatically.
+ */
+extern OFGlobal<Sint32> dcmSocketSendBufferSize;   /* default -1 */
+
+/** Global size (bytes) of the TCP receive buffer (SO_RCVBUF) of new connections,
+ *  which limits the TCP window offered to the peer. The size is also set on the
+ *  socket on which association requests are accepted. Default value is -1 which
+ *  selects the value of the environment variable TCP_BUFFER_LENGTH or, if that
+ *  is not set, 32 kbytes. Zero keeps the default of the operating system, which
+ *  may adjust the buffer size automatically.
+ */
+extern OFGlobal<Sint32> dcmSocketReceiveBufferSize;   /* default -1 */
+
 #ifndef DUL_KEYS
 #define DUL_KEYS 1
 typedef void DUL_NETWORKKEY;
@@ -389,6 +405,9 @@ DUL_ReadPDVs(DUL_ASSOCIATIONKEY ** association,
 OFCondition
 DUL_WritePDVs(DUL_ASSOCIATIONKEY ** association,
 	      DUL_PDVLIST * pdvList);
+OFCondition
+DUL_WritePDVFromFile(DUL_ASSOCIATIONKEY ** association,
+		     DUL_PDV * pdv, int fd, unsigned long offset);
 OFCondition DUL_NextPDV(DUL_ASSOCIATIONKEY ** association, DUL_PDV * pdv);
 
 
@@ -316,6 +316,12 @@ ASC_createAssociationParameters(T_ASC_Parameters ** params,
     (*params)->theirMaxPDUReceiveSize = 0;      /* not yet negotiated */
     (*params)->modeCallback = NULL;
 
+    /* synchronous operation unless changed by the application */
+    (*params)->ourMaxOperationsInvoked = 1;
+    (*params)->ourMaxOperationsPerformed = 1;
+    (*params)->DULparams.maximumOperationsInvoked = 1;
+    (*params)->DULparams.maximumOperationsPerformed = 1;
+
     /* set something unusable */
     ASC_setPresentationAddresses(*params,
                                  "calling Presentation Address",
@@ -1312,7 +1318,13 @@ ASC_dumpParameters(T_ASC_Parameters * params, ostream& outstream)
         << "Our Max PDU Receive Size: "
         << params->ourMaxPDUReceiveSize << endl
         << "Their Max PDU Receive Size: "
-        << params->theirMaxPDUReceiveSize << endl;
+        << params->theirMaxPDUReceiveSize << endl
+        << "Our Max Operations Invoked/Performed: "
+        << params->ourMaxOperationsInvoked << "/"
+        << params->ourMaxOperationsPerformed << endl
+        << "Negotiated Max Operations Invoked/Performed: "
+        << params->DULparams.maximumOperationsInvoked << "/"
+        << params->DULparams.maximumOperationsPerformed << endl;
 
     outstream << "Presentation Contexts:" << endl;
     for (i=0; i<ASC_countPresentationContexts(params); i++) {
@@ -1660,6 +1672,15 @@ updateRequestedPCListFromAcceptedPCList(
     return cond;
 }
 
+static unsigned short
+negotiateOperations(unsigned short proposed, unsigned short supported)
+{
+    /* zero means unlimited */
+    if (proposed == 0) return supported;
+    if (supported == 0) return proposed;
+    return (proposed < supported) ? proposed : supported;
+}
+
 OFCondition
 ASC_requestAssociation(T_ASC_Network * network,
                        T_ASC_Parameters * params,
@@ -1690,6 +1711,8 @@ ASC_requestAssociation(T_ASC_Network * network,
     (*assoc)->sendPDVBuffer = NULL;
 
     params->DULparams.maxPDU = params->ourMaxPDUReceiveSize;
+    params->DULparams.maximumOperationsInvoked = params->ourMaxOperationsInvoked;
+    params->DULparams.maximumOperationsPerformed = params->ourMaxOperationsPerformed;
     strcpy(params->DULparams.callingImplementationClassUID,
         params->ourImplementationClassUID);
     strcpy(params->DULparams.callingImplementationVersionName,
@@ -1715,6 +1738,12 @@ ASC_requestAssociation(T_ASC_Network * network,
         */
         params->theirMaxPDUReceiveSize = params->DULparams.peerMaxPDU;
 
+        /* the acceptor may only reduce the proposed asynchronous operations window */
+        params->DULparams.maximumOperationsInvoked = negotiateOperations(
+            params->ourMaxOperationsInvoked, params->DULparams.maximumOperationsInvoked);
+        params->DULparams.maximumOperationsPerformed = negotiateOperations(
+            params->ourMaxOperationsPerformed, params->DULparams.maximumOperationsPerformed);
+
         if (!((params->theirMaxPDUReceiveSize & DUL_MAXPDUCOMPAT) ^ DUL_DULCOMPAT))
         {          
           /* activate compatibility with DCMTK releases prior to 3.0 */
@@ -1791,6 +1820,12 @@ ASC_acknowledgeAssociation(
       assoc->params->DULparams.maxPDU = dcmEnableBackwardCompatibility.get() | DUL_DULCOMPAT | DUL_DIMSECOMPAT;
     }
 
+    /* accept the proposed asynchronous operations window up to what we support */
+    assoc->params->DULparams.maximumOperationsInvoked = negotiateOperations(
+        assoc->params->DULparams.maximumOperationsInvoked, assoc->params->ourMaxOperationsInvoked);
+    assoc->params->DULparams.maximumOperationsPerformed = negotiateOperations(
+        assoc->params->DULparams.maximumOperationsPerformed, assoc->params->ourMaxOperationsPerformed);
+
     strcpy(assoc->params->DULparams.calledImplementationClassUID,
         assoc->params->ourImplementationClassUID);
     strcpy(assoc->params->DULparams.calledImplementationVersionName,
@@ -1942,6 +1977,30 @@ ASC_dropAssociation(T_ASC_Association * association)
 
 
 
+OFCondition
+ASC_setAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    unsigned short maxOpsInvoked,
+    unsigned short maxOpsPerformed)
+{
+    if (params == NULL) return ASC_NULLKEY;
+    params->ourMaxOperationsInvoked = maxOpsInvoked;
+    params->ourMaxOperationsPerformed = maxOpsPerformed;
+    return EC_Normal;
+}
+
+OFCondition
+ASC_getAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    unsigned short * maxOpsInvoked,
+    unsigned short * maxOpsPerformed)
+{
+    if (params == NULL) return ASC_NULLKEY;
+    if (maxOpsInvoked) *maxOpsInvoked = params->DULparams.maximumOperationsInvoked;
+    if (maxOpsPerformed) *maxOpsPerformed = params->DULparams.maximumOperationsPerformed;
+    return EC_Normal;
+}
+
 OFCondition
 ASC_setTransportLayerType(
     T_ASC_Parameters * params,
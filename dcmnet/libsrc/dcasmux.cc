@@ -0,0 +1,392 @@
+/*
+ *
+ *  Copyright (C) 1994-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  agent
+ *
+ *  Purpose: class DcmAssociationMultiplexer, serves many associations
+ *    concurrently in a single process
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/dcmnet/dcasmux.h"
+
+#ifdef WITH_ASSOCIATION_MULTIPLEXER
+
+#define INCLUDE_CSTDIO
+#define INCLUDE_CSTRING
+#define INCLUDE_CERRNO
+#include "dcmtk/ofstd/ofstdinc.h"
+
+BEGIN_EXTERN_C
+#include <sys/epoll.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+END_EXTERN_C
+
+#include "dcmtk/dcmnet/dul.h"
+#include "dcmtk/dcmnet/dcmtrans.h"
+#include "dcmtk/dcmnet/cond.h"
+
+/* maximum number of events returned by one call to epoll_wait() */
+#define DCMASSOCIATIONMULTIPLEXER_EVENTS 64
+
+
+/** worker thread of a DcmAssociationMultiplexer
+ */
+class DcmAssociationWorker: public OFThread
+{
+public:
+
+  /** constructor.
+   *  @param mux multiplexer that hands out the associations
+   */
+  DcmAssociationWorker(DcmAssociationMultiplexer& mux)
+  : OFThread()
+  , mux_(mux)
+  {
+  }
+
+  /// destructor
+  virtual ~DcmAssociationWorker() {}
+
+private:
+
+  /// private undefined copy constructor
+  DcmAssociationWorker(const DcmAssociationWorker&);
+
+  /// private undefined copy assignment operator
+  DcmAssociationWorker& operator=(const DcmAssociationWorker&);
+
+  /// thread entry point
+  virtual void run()
+  {
+    mux_.work();
+  }
+
+  /// multiplexer that hands out the associations
+  DcmAssociationMultiplexer& mux_;
+};
+
+/* ======================================================================= */
+
+static OFCondition makeEpollError(const char *function)
+{
+  char buf[256];
+  sprintf(buf, "TCP Initialization Error: %s, %s failed", strerror(errno), function);
+  return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, buf);
+}
+
+DcmAssociationMultiplexer::DcmAssociationMultiplexer(T_ASC_Network *network, Uint32 numberOfThreads, int timeout)
+: network_(network)
+, numberOfThreads_(numberOfThreads > 0 ? numberOfThreads : 1)
+, timeout_(timeout > 0 ? timeout : 0)
+, epollfd_(-1)
+, receivePending_(OFFalse)
+, receiveResult_(EC_Normal)
+, queue_()
+, queueCount_(0)
+, associations_()
+, mutex_()
+{
+  wakeup_[0] = -1;
+  wakeup_[1] = -1;
+}
+
+DcmAssociationMultiplexer::~DcmAssociationMultiplexer()
+{
+}
+
+OFCondition DcmAssociationMultiplexer::watch(T_ASC_Association *assoc, OFBool add)
+{
+  DcmTransportConnection *connection = DUL_getTransportConnection(assoc->DULassociation);
+  if (connection == NULL) return DUL_NULLKEY;
+
+  /* a read that waits longer than the timeout fails, and so does the message */
+  if (add && (timeout_ > 0))
+  {
+    struct timeval tv;
+    tv.tv_sec = timeout_;
+    tv.tv_usec = 0;
+    if (setsockopt(connection->getSocket(), SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(tv)) < 0)
+      return makeEpollError("setsockopt");
+  }
+
+  /* EPOLLONESHOT disables the socket after one event, so that the
+   * association is handed to one worker only until it is handed back
+   */
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.ptr = assoc;
+  if (epoll_ctl(epollfd_, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, connection->getSocket(), &event) < 0)
+    return makeEpollError("epoll_ctl");
+  return EC_Normal;
+}
+
+OFCondition DcmAssociationMultiplexer::watchNetwork(OFBool add)
+{
+  /* the listen socket is identified by a NULL pointer. EPOLLONESHOT ensures
+   * that only one worker at a time receives an association request.
+   */
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.ptr = NULL;
+  if (epoll_ctl(epollfd_, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, DUL_networkSocket(network_->network), &event) < 0)
+    return makeEpollError("epoll_ctl");
+  return EC_Normal;
+}
+
+void DcmAssociationMultiplexer::forget(T_ASC_Association *assoc)
+{
+  DcmTransportConnection *connection = DUL_getTransportConnection(assoc->DULassociation);
+  if (connection)
+  {
+    /* the kernel ignores the event parameter, but versions before 2.6.9
+     * require it to be non-NULL
+     */
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    epoll_ctl(epollfd_, EPOLL_CTL_DEL, connection->getSocket(), &event);
+  }
+  mutex_.lock();
+  associations_.remove(assoc);
+  mutex_.unlock();
+}
+
+void DcmAssociationMultiplexer::work()
+{
+  while (1)
+  {
+    queueCount_.wait();
+    mutex_.lock();
+    T_ASC_Association *assoc = NULL;
+    const OFBool receiving = receivePending_;
+    if (receiving) receivePending_ = OFFalse;
+    else
+    {
+      assoc = queue_.front();
+      queue_.pop_front();
+    }
+    mutex_.unlock();
+    if (receiving)
+    {
+      receive();
+      continue;
+    }
+    if (assoc == NULL) break;
+
+    /* process messages as long as data is waiting. Data may already have been
+     * read from the socket, e.g. by the TLS layer, so epoll would not report it.
+     */
+    OFCondition cond = EC_Normal;
+    do
+    {
+      cond = processMessage(assoc);
+    } while (cond.good() && ASC_dataWaiting(assoc, 0));
+
+    if (cond.good()) cond = watch(assoc, OFFalse);
+    if (cond.bad())
+    {
+      forget(assoc);
+      finishAssociation(assoc, cond);
+    }
+  }
+}
+
+void DcmAssociationMultiplexer::receive()
+{
+  T_ASC_Association *assoc = NULL;
+  OFCondition cond = acceptAssociation(assoc);
+  if (assoc)
+  {
+    mutex_.lock();
+    associations_.push_back(assoc);
+    mutex_.unlock();
+    OFCondition watchCond = watch(assoc, OFTrue);
+    if (watchCond.bad())
+    {
+      forget(assoc);
+      finishAssociation(assoc, watchCond);
+    }
+  }
+
+  /* wait for the next association request, unless run() has to terminate */
+  if (cond.good()) cond = watchNetwork(OFFalse);
+  if (cond.bad())
+  {
+    mutex_.lock();
+    receiveResult_ = cond;
+    mutex_.unlock();
+    char c = 0;
+    while ((write(wakeup_[1], &c, 1) < 0) && (errno == EINTR)) /* nothing */ ;
+  }
+}
+
+OFCondition DcmAssociationMultiplexer::run()
+{
+  if (DUL_networkSocket(network_->network) < 0) return DUL_NULLKEY;
+
+  epollfd_ = epoll_create(DCMASSOCIATIONMULTIPLEXER_EVENTS);
+  if (epollfd_ < 0) return makeEpollError("epoll_create");
+  if (pipe(wakeup_) < 0)
+  {
+    OFCondition cond = makeEpollError("pipe");
+    close(epollfd_);
+    epollfd_ = -1;
+    return cond;
+  }
+  receivePending_ = OFFalse;
+  receiveResult_ = EC_Normal;
+
+  /* the wakeup pipe is identified by a pointer to this object */
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.ptr = this;
+  OFCondition cond = EC_Normal;
+  if (epoll_ctl(epollfd_, EPOLL_CTL_ADD, wakeup_[0], &event) < 0) cond = makeEpollError("epoll_ctl");
+  if (cond.good()) cond = watchNetwork(OFTrue);
+  if (cond.bad())
+  {
+    close(wakeup_[0]);
+    close(wakeup_[1]);
+    close(epollfd_);
+    epollfd_ = -1;
+    return cond;
+  }
+
+  DcmAssociationWorker **workers = new DcmAssociationWorker *[numberOfThreads_];
+  Uint32 started = 0;
+  for (Uint32 i = 0; i < numberOfThreads_; ++i)
+  {
+    workers[started] = new DcmAssociationWorker(*this);
+    if (workers[started]->start() == 0) ++started;
+    else
+    {
+      // resources exhausted, continue with fewer threads
+      delete workers[started];
+      break;
+    }
+  }
+
+  OFCondition result = EC_Normal;
+  if (started == 0) result = makeDcmnetCondition(DULC_TCPINITERROR, OF_error, "TCP Initialization Error: cannot create worker threads");
+
+  struct epoll_event events[DCMASSOCIATIONMULTIPLEXER_EVENTS];
+  while (result.good())
+  {
+    int count = epoll_wait(epollfd_, events, DCMASSOCIATIONMULTIPLEXER_EVENTS, -1);
+    if (count < 0)
+    {
+      if (errno == EINTR) continue; // e.g. SIGCHLD of an executed command
+      result = makeEpollError("epoll_wait");
+      break;
+    }
+    for (int i = 0; (i < count) && result.good(); ++i)
+    {
+      if (events[i].data.ptr == this)
+      {
+        // acceptAssociation() has failed
+        char c;
+        while ((read(wakeup_[0], &c, 1) < 0) && (errno == EINTR)) /* nothing */ ;
+        mutex_.lock();
+        result = receiveResult_;
+        mutex_.unlock();
+        continue;
+      }
+      T_ASC_Association *assoc = OFstatic_cast(T_ASC_Association *, events[i].data.ptr);
+      mutex_.lock();
+      if (assoc == NULL)
+      {
+        // hand the association request to a worker
+        receivePending_ = OFTrue;
+      }
+      else
+      {
+        // hand the association to a worker
+        queue_.push_back(assoc);
+      }
+      mutex_.unlock();
+      queueCount_.post();
+    }
+  }
+
+  // terminate the workers once they have processed all queued associations
+  for (Uint32 i = 0; i < started; ++i)
+  {
+    mutex_.lock();
+    queue_.push_back(NULL);
+    mutex_.unlock();
+    queueCount_.post();
+  }
+  for (Uint32 i = 0; i < started; ++i)
+  {
+    workers[i]->join();
+    delete workers[i];
+  }
+  delete[] workers;
+
+  // terminate the associations that are still established
+  while (! associations_.empty())
+  {
+    T_ASC_Association *assoc = associations_.front();
+    forget(assoc);
+    finishAssociation(assoc, DUL_NETWORKCLOSED);
+  }
+
+  close(wakeup_[0]);
+  close(wakeup_[1]);
+  close(epollfd_);
+  epollfd_ = -1;
+  return result;
+}
+
+#else /* WITH_ASSOCIATION_MULTIPLEXER */
+
+/* make sure that the object file is not completely empty if compiled
+ * without epoll or thread support because some linkers might fail otherwise.
+ */
+void dcasmux_dummy_function()
+{
+  return;
+}
+
+#endif /* WITH_ASSOCIATION_MULTIPLEXER */
+
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */
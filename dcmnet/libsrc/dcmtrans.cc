@@ -41,6 +41,8 @@
 #define INCLUDE_CTIME
 #define INCLUDE_CERRNO
 #define INCLUDE_CSIGNAL
+#define INCLUDE_CLIMITS
+#define INCLUDE_UNISTD
 #include "dcmtk/ofstd/ofstdinc.h"
 
 BEGIN_EXTERN_C
@@ -53,6 +55,12 @@ BEGIN_EXTERN_C
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 END_EXTERN_C
 
 #ifdef HAVE_WINDOWS_H
@@ -63,6 +71,18 @@ END_EXTERN_C
 #include <GUSI.h>	/* Use the Grand Unified Sockets Interface (GUSI) on Macintosh */
 #endif
 
+/* maximum number of blocks passed to one call to writev() */
+#define DCMTRANS_IOVEC_COUNT 64
+#if defined(IOV_MAX) && (IOV_MAX < DCMTRANS_IOVEC_COUNT)
+#undef DCMTRANS_IOVEC_COUNT
+#define DCMTRANS_IOVEC_COUNT IOV_MAX
+#endif
+
+/* size of the buffer used to copy file data if sendfile() is not available */
+#define DCMTRANS_FILEBUFFER_SIZE 65536
+
+OFGlobal<Uint32> dcmTCPReadBufferSize(1048576);
+
 DcmTransportConnection::DcmTransportConnection(int openSocket)
 : theSocket(openSocket)
 {
@@ -72,6 +92,64 @@ DcmTransportConnection::~DcmTransportConnection()
 {
 }
 
+ssize_t DcmTransportConnection::writeBlocks(const void * const *blocks, const size_t *lengths, int count)
+{
+  ssize_t total = 0;
+  for (int i=0; i<count; i++)
+  {
+    const char *buf = OFstatic_cast(const char *, blocks[i]);
+    size_t remaining = lengths[i];
+    while (remaining > 0)
+    {
+      ssize_t nbytes = write(OFconst_cast(char *, buf), remaining);
+      if (nbytes <= 0)
+      {
+        if ((nbytes < 0) && (errno == EINTR)) continue;
+        return -1;
+      }
+      buf += nbytes;
+      remaining -= nbytes;
+      total += nbytes;
+    }
+  }
+  return total;
+}
+
+ssize_t DcmTransportConnection::writeFromFile(const void *head, size_t headLength, int fd, unsigned long offset, size_t nbyte)
+{
+  ssize_t total = 0;
+  if (head && (headLength > 0))
+  {
+    total = writeBlocks(&head, &headLength, 1);
+    if (total < 0) return total;
+  }
+  if (nbyte == 0) return total;
+
+#ifdef HAVE_UNISTD_H
+  if (lseek(fd, OFstatic_cast(off_t, offset), SEEK_SET) == OFstatic_cast(off_t, -1)) return -1;
+  size_t bufLength = (nbyte < DCMTRANS_FILEBUFFER_SIZE) ? nbyte : DCMTRANS_FILEBUFFER_SIZE;
+  char *buf = new char[bufLength];
+  while (nbyte > 0)
+  {
+    size_t chunk = (nbyte < bufLength) ? nbyte : bufLength;
+    ssize_t nread = ::read(fd, buf, chunk);
+    if (nread < 0 && errno == EINTR) continue;
+    if (nread <= 0) break;
+    const void *block = buf;
+    size_t blockLength = OFstatic_cast(size_t, nread);
+    if (writeBlocks(&block, &blockLength, 1) < 0) break;
+    total += nread;
+    nbyte -= nread;
+  }
+  delete[] buf;
+  return (nbyte > 0) ? -1 : total;
+#else
+  (void) fd;
+  (void) offset;
+  return -1;
+#endif
+}
+
 OFBool DcmTransportConnection::safeSelectReadableAssociation(DcmTransportConnection *connections[], int connCount, int timeout)
 {
   int numberOfRounds = timeout+1;
@@ -179,11 +257,16 @@ OFBool DcmTransportConnection::selectReadableAssociation(DcmTransportConnection
 
 DcmTCPConnection::DcmTCPConnection(int openSocket)
 : DcmTransportConnection(openSocket)
+, readBuffer(NULL)
+, readBufferSize(dcmTCPReadBufferSize.get())
+, readStart(0)
+, readEnd(0)
 {
 }
 
 DcmTCPConnection::~DcmTCPConnection()
 {
+  delete[] readBuffer;
 }
 
 DcmTransportLayerStatus DcmTCPConnection::serverSideHandshake()
@@ -201,15 +284,44 @@ DcmTransportLayerStatus DcmTCPConnection::renegotiate(const char * /* newSuite *
   return TCS_ok;
 }
 
-ssize_t DcmTCPConnection::read(void *buf, size_t nbyte)
+static ssize_t receiveFromSocket(int sock, void *buf, size_t nbyte)
 {
 #ifdef HAVE_WINSOCK_H
-  return recv(getSocket(), (char *)buf, nbyte, 0);
+  return recv(sock, (char *)buf, nbyte, 0);
 #else
-  return ::read(getSocket(), (char *)buf, nbyte);
+  return ::read(sock, (char *)buf, nbyte);
 #endif
 }
 
+ssize_t DcmTCPConnection::read(void *buf, size_t nbyte)
+{
+  /* pass on data that has been read from the socket before */
+  if (readStart < readEnd)
+  {
+    size_t count = readEnd - readStart;
+    if (count > nbyte) count = nbyte;
+    memcpy(buf, readBuffer + readStart, count);
+    readStart += count;
+    return OFstatic_cast(ssize_t, count);
+  }
+
+  /* large blocks are read directly into the caller's buffer */
+  if (nbyte >= readBufferSize) return receiveFromSocket(getSocket(), buf, nbyte);
+
+  /* otherwise read as much as is available, which typically contains
+   * the following PDUs as well
+   */
+  if (readBuffer == NULL) readBuffer = new char[readBufferSize];
+  ssize_t nbytes = receiveFromSocket(getSocket(), readBuffer, readBufferSize);
+  if (nbytes <= 0) return nbytes;
+  size_t count = OFstatic_cast(size_t, nbytes);
+  if (count > nbyte) count = nbyte;
+  memcpy(buf, readBuffer, count);
+  readStart = count;
+  readEnd = OFstatic_cast(size_t, nbytes);
+  return OFstatic_cast(ssize_t, count);
+}
+
 ssize_t DcmTCPConnection::write(void *buf, size_t nbyte)
 {
 #ifdef HAVE_WINSOCK_H
@@ -219,6 +331,106 @@ ssize_t DcmTCPConnection::write(void *buf, size_t nbyte)
 #endif
 }
 
+ssize_t DcmTCPConnection::writeBlocks(const void * const *blocks, const size_t *lengths, int count)
+{
+#if defined(HAVE_SYS_UIO_H) && !defined(HAVE_WINSOCK_H)
+  struct iovec iov[DCMTRANS_IOVEC_COUNT];
+  ssize_t total = 0;
+  int next = 0;          /* next block not yet placed into iov */
+  size_t nextOffset = 0; /* bytes of that block already written */
+  while (next < count)
+  {
+    /* collect up to DCMTRANS_IOVEC_COUNT non-empty blocks */
+    int iovcnt = 0;
+    int i = next;
+    size_t off = nextOffset;
+    while ((i < count) && (iovcnt < DCMTRANS_IOVEC_COUNT))
+    {
+      if (lengths[i] > off)
+      {
+        iov[iovcnt].iov_base = OFconst_cast(char *, OFstatic_cast(const char *, blocks[i])) + off;
+        iov[iovcnt].iov_len = lengths[i] - off;
+        iovcnt++;
+      }
+      i++;
+      off = 0;
+    }
+    if (iovcnt == 0) break;
+
+    ssize_t nbytes = ::writev(getSocket(), iov, iovcnt);
+    if (nbytes <= 0)
+    {
+      if ((nbytes < 0) && (errno == EINTR)) continue;
+      return -1;
+    }
+    total += nbytes;
+
+    /* skip the blocks that have been written completely */
+    size_t written = OFstatic_cast(size_t, nbytes);
+    while ((next < count) && (written >= lengths[next] - nextOffset))
+    {
+      written -= lengths[next] - nextOffset;
+      next++;
+      nextOffset = 0;
+    }
+    if (next < count) nextOffset += written;
+  }
+  return total;
+#else
+  return DcmTransportConnection::writeBlocks(blocks, lengths, count);
+#endif
+}
+
+ssize_t DcmTCPConnection::writeFromFile(const void *head, size_t headLength, int fd, unsigned long offset, size_t nbyte)
+{
+#if defined(HAVE_SYS_SENDFILE_H) && !defined(HAVE_WINSOCK_H)
+  ssize_t total = 0;
+  const char *buf = OFstatic_cast(const char *, head);
+  while (buf && (headLength > 0))
+  {
+    /* tell the kernel that the file data follows, so that the header
+     * is not sent in a segment of its own
+     */
+#ifdef MSG_MORE
+    ssize_t nbytes = ::send(getSocket(), buf, headLength, (nbyte > 0) ? MSG_MORE : 0);
+#else
+    ssize_t nbytes = ::send(getSocket(), buf, headLength, 0);
+#endif
+    if (nbytes <= 0)
+    {
+      if ((nbytes < 0) && (errno == EINTR)) continue;
+      return -1;
+    }
+    buf += nbytes;
+    headLength -= nbytes;
+    total += nbytes;
+  }
+
+  off_t pos = OFstatic_cast(off_t, offset);
+  while (nbyte > 0)
+  {
+    ssize_t nbytes = ::sendfile(getSocket(), fd, &pos, nbyte);
+    if (nbytes < 0)
+    {
+      if (errno == EINTR) continue;
+      if ((errno == EINVAL) || (errno == ENOSYS))
+      {
+        /* file type not supported by sendfile(), copy the remaining data */
+        ssize_t result = DcmTransportConnection::writeFromFile(NULL, 0, fd, OFstatic_cast(unsigned long, pos), nbyte);
+        return (result < 0) ? result : total + result;
+      }
+      return -1;
+    }
+    if (nbytes == 0) return -1; /* file shorter than expected */
+    nbyte -= nbytes;
+    total += nbytes;
+  }
+  return total;
+#else
+  return DcmTransportConnection::writeFromFile(head, headLength, fd, offset, nbyte);
+#endif
+}
+
 void DcmTCPConnection::close()
 {
 #ifdef HAVE_WINSOCK_H
@@ -245,6 +457,9 @@ OFBool DcmTCPConnection::networkDataAvailable(int timeout)
   fd_set fdset;
   int nfound;
 
+  /* data may already have been read from the socket */
+  if (readStart < readEnd) return OFTrue;
+
   FD_ZERO(&fdset);
 
 #ifdef __MINGW32__
@@ -272,7 +487,7 @@ OFBool DcmTCPConnection::networkDataAvailable(int timeout)
 
 OFBool DcmTCPConnection::isTransparentConnection()
 {
-  return OFTrue;
+  return (readStart == readEnd);
 }
 
 void DcmTCPConnection::dumpConnectionParameters(ostream &out)
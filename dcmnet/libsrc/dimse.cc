@@ -639,6 +639,229 @@ sendStraightFileData(T_ASC_Association * assoc, const char *dataFileName,
 }
 #endif
 
+/* maximum number of PDVs passed to one call to DUL_WritePDVs() when a
+ * large value is sent directly from the caller's memory
+ */
+#define DIMSE_DIRECTPDVS 32
+
+/* output stream for a data set that is sent over an association.
+ * Large values are not copied into the PDV buffer: values in memory (e.g.
+ * in a memory mapped file) are sent as PDVs that refer to the value itself,
+ * and where sendfile() is available, the values of elements that have not
+ * been loaded into memory are sent directly from their file. The final
+ * fragment of each such value is written to the buffer as usual, so that
+ * the last PDV of the data set is always sent from the buffer.
+ */
+class DimseOutputStream: public DcmOutputBufferStream
+{
+public:
+    DimseOutputStream(T_ASC_Association * assoc, void *buf, Uint32 bufLen,
+                      T_ASC_PresentationContextID presID, OFBool sendDirectly,
+                      Uint32& bytesTransmitted, DIMSE_ProgressCallback callback,
+                      void *callbackContext)
+    : DcmOutputBufferStream(buf, bufLen)
+    , assoc_(assoc)
+    , bufLen_(bufLen)
+    , presID_(presID)
+    , sendDirectly_(sendDirectly)
+    , bytesTransmitted_(bytesTransmitted)
+    , callback_(callback)
+    , callbackContext_(callbackContext)
+    , direct_(0)
+    , status_(EC_Normal)
+    {
+    }
+
+    virtual OFBool good() const
+    {
+        return status_.good() && DcmOutputBufferStream::good();
+    }
+
+    virtual OFCondition status() const
+    {
+        if (status_.bad()) return status_;
+        return DcmOutputBufferStream::status();
+    }
+
+    virtual Uint32 tell() const
+    {
+        return DcmOutputBufferStream::tell() + direct_;
+    }
+
+    virtual Uint32 write(const void *buf, Uint32 buflen);
+
+    virtual Uint32 copyFromFile(const char *filename, Uint32 offset, Uint32 length);
+
+private:
+    DimseOutputStream(const DimseOutputStream&);
+    DimseOutputStream& operator=(const DimseOutputStream&);
+
+    /* returns the number of bytes of a value of the given length that
+     * should bypass the PDV buffer, 0 if the value should be buffered
+     */
+    Uint32 directLength(Uint32 length);
+
+    /* sends the contents of the PDV buffer as a PDV that is not the last one */
+    OFCondition sendBuffer();
+
+    /* counts bytes that have been sent and executes the callback function */
+    void transmitted(Uint32 length);
+
+    T_ASC_Association *assoc_;
+    Uint32 bufLen_;
+    T_ASC_PresentationContextID presID_;
+    OFBool sendDirectly_;
+    Uint32& bytesTransmitted_;
+    DIMSE_ProgressCallback callback_;
+    void *callbackContext_;
+    Uint32 direct_;       /* number of bytes that bypassed the PDV buffer */
+    OFCondition status_;  /* first error that occurred while sending directly */
+};
+
+Uint32
+DimseOutputStream::directLength(Uint32 length)
+{
+    /* small values are not worth the effort */
+    if (!sendDirectly_ || status_.bad() || (length <= bufLen_)) return 0;
+
+    /* the data in the buffer is sent as a PDV of its own, which must have even length */
+    if ((bufLen_ - avail()) & 1) return 0;
+
+    /* leave the last fragment of the value to the buffer */
+    return ((length - 1) / bufLen_) * bufLen_;
+}
+
+OFCondition
+DimseOutputStream::sendBuffer()
+{
+    void *fullBuf = NULL;
+    Uint32 rtnLength = 0;
+    flushBuffer(fullBuf, rtnLength);
+    if (rtnLength == 0) return EC_Normal;
+
+    DUL_PDVLIST pdvList;
+    DUL_PDV pdv;
+    pdv.fragmentLength = rtnLength;
+    pdv.presentationContextID = presID_;
+    pdv.pdvType = DUL_DATASETPDV;
+    pdv.lastPDV = OFFalse;
+    pdv.data = fullBuf;
+    pdvList.count = 1;
+    pdvList.pdv = &pdv;
+
+    if (debug) {
+        COUT << "DIMSE sendDcmDataset: sending " << pdv.fragmentLength
+        << " bytes" << endl;
+    }
+
+    OFCondition dulCond = DUL_WritePDVs(&assoc_->DULassociation, &pdvList);
+    if (dulCond.good()) transmitted(rtnLength);
+    return dulCond;
+}
+
+void
+DimseOutputStream::transmitted(Uint32 length)
+{
+    bytesTransmitted_ += length;
+    if (callback_) callback_(callbackContext_, bytesTransmitted_);
+}
+
+Uint32
+DimseOutputStream::write(const void *buf, Uint32 buflen)
+{
+    Uint32 count = directLength(buflen);
+    if (count == 0) return DcmOutputBufferStream::write(buf, buflen);
+
+    OFCondition dulCond = sendBuffer();
+
+    if (debug && dulCond.good()) {
+        COUT << "DIMSE sendDcmDataset: sending " << count
+        << " bytes without copying" << endl;
+    }
+
+    DUL_PDVLIST pdvList;
+    DUL_PDV pdvs[DIMSE_DIRECTPDVS];
+    const char *data = OFstatic_cast(const char *, buf);
+    Uint32 sent = 0;
+    while (dulCond.good() && (sent < count))
+    {
+        Uint32 n = 0;
+        while ((n < DIMSE_DIRECTPDVS) && (sent + n * bufLen_ < count))
+        {
+            pdvs[n].fragmentLength = bufLen_;
+            pdvs[n].presentationContextID = presID_;
+            pdvs[n].pdvType = DUL_DATASETPDV;
+            pdvs[n].lastPDV = OFFalse;
+            pdvs[n].data = OFconst_cast(char *, data + sent + n * bufLen_);
+            n++;
+        }
+        pdvList.count = n;
+        pdvList.pdv = pdvs;
+        dulCond = DUL_WritePDVs(&assoc_->DULassociation, &pdvList);
+        if (dulCond.good())
+        {
+            sent += n * bufLen_;
+            direct_ += n * bufLen_;
+            transmitted(n * bufLen_);
+        }
+    }
+
+    if (dulCond.bad())
+    {
+        /* the data already sent cannot be taken back, so the stream fails */
+        status_ = dulCond;
+        return 0;
+    }
+    return sent;
+}
+
+Uint32
+DimseOutputStream::copyFromFile(const char *filename, Uint32 offset, Uint32 length)
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    Uint32 count = directLength(length);
+    if (count == 0) return 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+
+    OFCondition dulCond = sendBuffer();
+
+    if (debug && dulCond.good()) {
+        COUT << "DIMSE sendDcmDataset: sending " << count
+        << " bytes from file" << endl;
+    }
+
+    DUL_PDV pdv;
+    pdv.fragmentLength = bufLen_;
+    pdv.presentationContextID = presID_;
+    pdv.pdvType = DUL_DATASETPDV;
+    pdv.lastPDV = OFFalse;
+    pdv.data = NULL;
+    Uint32 sent = 0;
+    while (dulCond.good() && (sent < count))
+    {
+        dulCond = DUL_WritePDVFromFile(&assoc_->DULassociation, &pdv, fd, offset + sent);
+        if (dulCond.good())
+        {
+            sent += bufLen_;
+            direct_ += bufLen_;
+            transmitted(bufLen_);
+        }
+    }
+    close(fd);
+
+    if (dulCond.bad())
+    {
+        status_ = dulCond;
+        return 0;
+    }
+    return sent;
+#else
+    return 0;
+#endif
+}
+
 static OFCondition
 sendDcmDataset(T_ASC_Association * assoc, DcmDataset * obj,
                 T_ASC_PresentationContextID presID,
@@ -687,8 +910,12 @@ sendDcmDataset(T_ASC_Association * assoc, DcmDataset * obj,
       bufLen = maxpdulen - 12;
     }
 
-    /* on the basis of the association's buffer, create a buffer variable that we can write to */
-    DcmOutputBufferStream outBuf(buf, bufLen);
+    /* on the basis of the association's buffer, create a buffer variable that we can write to. */
+    /* Large values of a data set may be sent without copying them into this buffer, */
+    /* unless the data set is compressed. */
+    DimseOutputStream outBuf(assoc, buf, bufLen, presID,
+        (pdvType == DUL_DATASETPDV) && (xferSyntax != EXS_DeflatedLittleEndianExplicit),
+        bytesTransmitted, callback, callbackContext);
 
     /* prepare all elements in the DcmDataset variable for transfer */
     obj->transferInit();
@@ -717,6 +944,8 @@ sendDcmDataset(T_ASC_Association * assoc, DcmDataset * obj,
         /* DcmDataset stores information about what of its content has already been sent to the buffer.) */
         if (! written)
         {
+          /* the buffer has been emptied, let a compression filter write the data it held back */
+          outBuf.writePending();
           econd = obj->write(outBuf, xferSyntax, sequenceType_encoding, 
                              groupLength_encoding, EPD_withoutPadding);
           if (econd == EC_Normal)                   /* all contents have been written to the buffer */
@@ -730,6 +959,10 @@ sendDcmDataset(T_ASC_Association * assoc, DcmDataset * obj,
           else                                      /* some error has occurred */
           {
               DIMSE_warning(assoc, "writeBlock Failed (%s)", econd.text());
+              /* report network errors that occurred while sending from a file */
+              OFCondition streamCond = outBuf.status();
+              if (streamCond.bad())
+                  return makeDcmnetSubCondition(DIMSEC_SENDFAILED, OF_error, "DIMSE Failed to send message", streamCond);
               return DIMSE_SENDFAILED;
           }
         }
@@ -1435,7 +1668,8 @@ DIMSE_receiveDataSetInFile(T_ASC_Association *assoc,
         T_DIMSE_BlockingMode blocking, int timeout, 
         T_ASC_PresentationContextID *presID,
         DcmOutputStream *filestream,
-        DIMSE_ProgressCallback callback, void *callbackData)
+        DIMSE_ProgressCallback callback, void *callbackData,
+        DIMSE_StoreDataCallback dataCallback, void *dataCallbackData)
 {
     OFCondition cond = EC_Normal;
     DUL_PDV pdv;
@@ -1506,6 +1740,10 @@ DIMSE_receiveDataSetInFile(T_ASC_Association *assoc,
               }
               last = OFTrue; // terminate loop
           }
+          else if (dataCallback)
+          { /* pass fragment on, e.g. for extracting attributes while receiving */
+            dataCallback(dataCallbackData, pdv.data, (Uint32)(pdv.fragmentLength));
+          }
         }
 
         if (!last)
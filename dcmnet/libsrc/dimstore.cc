@@ -126,20 +126,15 @@ privateUserCallback(void *callbackData, unsigned long bytes)
 }
 
 OFCondition
-DIMSE_storeUser(
+DIMSE_sendStoreRequest(
 	T_ASC_Association *assoc, T_ASC_PresentationContextID presId,
 	T_DIMSE_C_StoreRQ *request,
 	const char *imageFileName, DcmDataset *imageDataSet,
 	DIMSE_StoreUserCallback callback, void *callbackData,
-	T_DIMSE_BlockingMode blockMode, int timeout,
-	T_DIMSE_C_StoreRSP *response,
-	DcmDataset **statusDetail,
-        T_DIMSE_DetectedCancelParameters *checkForCancelParams,
         long imageFileTotalBytes)
     /*
-     * This function transmits data from a file or a dataset to an SCP. The transmission is
-     * conducted via network and using DIMSE C-STORE messages. Additionally, this function
-     * evaluates C-STORE-Response messages which were received from the SCP.
+     * This function transmits data from a file or a dataset to an SCP using a DIMSE
+     * C-STORE-RQ message, but does not wait for the corresponding C-STORE-RSP message.
      * 
      * Parameters:
      *   assoc                - [in] The association (network connection to SCP).
@@ -150,24 +145,11 @@ DIMSE_storeUser(
      *   imageDataSet         - [in] The data set which is currently processed.
      *   callback             - [in] Pointer to a function which shall be called to indicate progress.
      *   callbackData         - [in] Pointer to data which shall be passed to the progress indicating function
-     *   blockMode            - [in] The blocking mode for receiving data (either DIMSE_BLOCKING or DIMSE_NONBLOCKING)
-     *   timeout              - [in] Timeout interval for receiving data. If the blocking mode is DIMSE_NONBLOCKING
-     *   response             - [out] Represents a DIMSE C-Store Response Message. Contains corresponding
-     *                                information, e.g. message ID being responded to, affected SOP class UID, etc.
-     *                                This variable contains in the end the C-STORE-RSP command which was received
-     *                                as a response to the C-STORE-RQ which was sent.
-     *   statusDetail         - [out] If a non-NULL value is passed this variable will in the end contain detailed
-     *                                information with regard to the status information which is captured in the status
-     *                                element (0000,0900) of the response message. Note that the value for element (0000,0900)
-     *                                is not contained in this return value but in response.
-     *   checkForCancelParams - [out] Indicates, if a C-Cancel (Request) Message was encountered. Contains corresponding
-     *                                information, e.g. a boolean value if a corresponding message was encountered and the
-     *                                C-Cancel (Request) Message itself (in case it actually was encountered).
      *   imageFileTotalBytes  - [in] The size of the file which is currently processed in bytes.
      */
 {
     OFCondition cond = EC_Normal;
-    T_DIMSE_Message req, rsp;
+    T_DIMSE_Message req;
     DIMSE_PrivateUserContext callbackCtx;
     DIMSE_ProgressCallback privCallback = NULL;
     T_DIMSE_StoreProgress progress;
@@ -175,9 +157,8 @@ DIMSE_storeUser(
     /* if there is no image file or no data set, no data can be sent */
     if (imageFileName == NULL && imageDataSet == NULL) return DIMSE_NULLKEY;
     
-    /* initialize the variables which represent DIMSE C-STORE request and DIMSE C-STORE response messages */
+    /* initialize the variable which represents the DIMSE C-STORE request message */
     bzero((char*)&req, sizeof(req));
-    bzero((char*)&rsp, sizeof(rsp));
 
     /* set corresponding values in the request message variable */
     req.CommandField = DIMSE_C_STORE_RQ;
@@ -232,6 +213,110 @@ DIMSE_storeUser(
 	callback(callbackData, &progress, request);
     }
 
+    return EC_Normal;
+}
+
+
+OFCondition
+DIMSE_receiveStoreResponse(
+	T_ASC_Association *assoc,
+	T_DIMSE_BlockingMode blockMode, int timeout,
+	T_ASC_PresentationContextID *presId,
+	T_DIMSE_C_StoreRSP *response,
+	DcmDataset **statusDetail)
+    /*
+     * This function receives the next C-STORE-RSP message on an association on which
+     * one or more C-STORE-RQ messages have been sent with DIMSE_sendStoreRequest().
+     * 
+     * Parameters:
+     *   assoc                - [in] The association (network connection to SCP).
+     *   blockMode            - [in] The blocking mode for receiving data (either DIMSE_BLOCKING or DIMSE_NONBLOCKING)
+     *   timeout              - [in] Timeout interval for receiving data. If the blocking mode is DIMSE_NONBLOCKING
+     *   presId               - [out] The ID of the presentation context on which the response was received.
+     *   response             - [out] The C-STORE-RSP message which was received. The field
+     *                                MessageIDBeingRespondedTo identifies the request it belongs to.
+     *   statusDetail         - [out] If a non-NULL value is passed this variable will in the end contain detailed
+     *                                information with regard to the status information which is captured in the status
+     *                                element (0000,0900) of the response message.
+     */
+{
+    T_DIMSE_Message rsp;
+    T_ASC_PresentationContextID thisPresId = 0;
+
+    bzero((char*)&rsp, sizeof(rsp));
+
+    /* try to receive a C-STORE-RSP over the network. */
+    OFCondition cond = DIMSE_receiveCommand(assoc, blockMode, timeout, 
+        &thisPresId, &rsp, statusDetail);
+    if (cond != EC_Normal) return cond;
+
+    if (rsp.CommandField != DIMSE_C_STORE_RSP)
+    {
+      char buf[256];
+      sprintf(buf, "DIMSE: Unexpected Response Command Field: 0x%x", (unsigned)rsp.CommandField);
+      return makeDcmnetCondition(DIMSEC_UNEXPECTEDRESPONSE, OF_error, buf);
+    }
+
+    *response = rsp.msg.CStoreRSP;
+    if (presId) *presId = thisPresId;
+    return EC_Normal;
+}
+
+
+
+OFCondition
+DIMSE_storeUser(
+	T_ASC_Association *assoc, T_ASC_PresentationContextID presId,
+	T_DIMSE_C_StoreRQ *request,
+	const char *imageFileName, DcmDataset *imageDataSet,
+	DIMSE_StoreUserCallback callback, void *callbackData,
+	T_DIMSE_BlockingMode blockMode, int timeout,
+	T_DIMSE_C_StoreRSP *response,
+	DcmDataset **statusDetail,
+        T_DIMSE_DetectedCancelParameters *checkForCancelParams,
+        long imageFileTotalBytes)
+    /*
+     * This function transmits data from a file or a dataset to an SCP. The transmission is
+     * conducted via network and using DIMSE C-STORE messages. Additionally, this function
+     * evaluates C-STORE-Response messages which were received from the SCP.
+     * 
+     * Parameters:
+     *   assoc                - [in] The association (network connection to SCP).
+     *   presId               - [in] The ID of the presentation context which shall be used
+     *   request              - [in] Represents a DIMSE C-Store Request Message. Contains corresponding
+     *                               information, e.g. message ID, affected SOP class UID, etc.
+     *   imageFileName        - [in] The name of the file which is currently processed.
+     *   imageDataSet         - [in] The data set which is currently processed.
+     *   callback             - [in] Pointer to a function which shall be called to indicate progress.
+     *   callbackData         - [in] Pointer to data which shall be passed to the progress indicating function
+     *   blockMode            - [in] The blocking mode for receiving data (either DIMSE_BLOCKING or DIMSE_NONBLOCKING)
+     *   timeout              - [in] Timeout interval for receiving data. If the blocking mode is DIMSE_NONBLOCKING
+     *   response             - [out] Represents a DIMSE C-Store Response Message. Contains corresponding
+     *                                information, e.g. message ID being responded to, affected SOP class UID, etc.
+     *                                This variable contains in the end the C-STORE-RSP command which was received
+     *                                as a response to the C-STORE-RQ which was sent.
+     *   statusDetail         - [out] If a non-NULL value is passed this variable will in the end contain detailed
+     *                                information with regard to the status information which is captured in the status
+     *                                element (0000,0900) of the response message. Note that the value for element (0000,0900)
+     *                                is not contained in this return value but in response.
+     *   checkForCancelParams - [out] Indicates, if a C-Cancel (Request) Message was encountered. Contains corresponding
+     *                                information, e.g. a boolean value if a corresponding message was encountered and the
+     *                                C-Cancel (Request) Message itself (in case it actually was encountered).
+     *   imageFileTotalBytes  - [in] The size of the file which is currently processed in bytes.
+     */
+{
+    T_DIMSE_Message rsp;
+
+    /* send C-STORE-RQ message and instance data */
+    OFCondition cond = DIMSE_sendStoreRequest(assoc, presId, request,
+        imageFileName, imageDataSet, callback, callbackData, imageFileTotalBytes);
+    if (cond != EC_Normal) {
+	return cond;
+    }
+
+    /* initialize the variable which represents the DIMSE C-STORE response message */
+    bzero((char*)&rsp, sizeof(rsp));
+
     /* check if a C-CANCEL-RQ message was encountered earlier */
     if (checkForCancelParams != NULL) {
         checkForCancelParams->cancelEncountered = OFTrue;
@@ -285,6 +370,7 @@ DIMSE_storeUser(
 
 
 
+
 OFCondition
 DIMSE_sendStoreResponse(T_ASC_Association * assoc, 
 	T_ASC_PresentationContextID presID,
@@ -363,7 +449,8 @@ DIMSE_storeProvider( T_ASC_Association *assoc,
 	const char* imageFileName, int writeMetaheader,
 	DcmDataset **imageDataSet,
 	DIMSE_StoreProviderCallback callback, void *callbackData,
-	T_DIMSE_BlockingMode blockMode, int timeout)
+	T_DIMSE_BlockingMode blockMode, int timeout,
+	DIMSE_StoreDataCallback dataCallback, void *dataCallbackData)
     /*
      * This function receives a data set over the network and either stores this data in a file (exactly as it was
      * received) or it stores this data in memory. Before, during and after the process of receiving data, the callback
@@ -387,6 +474,10 @@ DIMSE_storeProvider( T_ASC_Association *assoc,
      *   callbackData    - [in] Pointer to data which shall be passed to the progress indicating function
      *   blockMode       - [in] The blocking mode for receiving data (either DIMSE_BLOCKING or DIMSE_NONBLOCKING)
      *   timeout         - [in] Timeout interval for receiving data (if the blocking mode is DIMSE_NONBLOCKING).
+     *   dataCallback    - [in] If this variable does not equal NULL and the data is written to a file, this function
+     *                          is called with each data set fragment after it has been written, e.g. in order to
+     *                          extract attributes from the data set without reading the file again.
+     *   dataCallbackData - [in] Pointer to data which shall be passed to the data set fragment function.
      */
 {	
     OFCondition cond = EC_Normal;
@@ -458,7 +549,8 @@ DIMSE_storeProvider( T_ASC_Association *assoc,
           }
         } else {
           /* if no error occured, receive data and write it to the file */
-          cond = DIMSE_receiveDataSetInFile(assoc, blockMode, timeout, &presIdData, filestream, privCallback, &callbackCtx);
+          cond = DIMSE_receiveDataSetInFile(assoc, blockMode, timeout, &presIdData, filestream, privCallback, &callbackCtx,
+            dataCallback, dataCallbackData);
           delete filestream;
           if (cond != EC_Normal)
           {
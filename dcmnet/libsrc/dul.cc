@@ -145,6 +145,8 @@ OFGlobal<Sint32> dcmConnectionTimeout(-1);
 OFGlobal<int>    dcmExternalSocketHandle(-1);
 OFGlobal<const char *> dcmTCPWrapperDaemonName((const char *)NULL);
 OFGlobal<unsigned long> dcmEnableBackwardCompatibility(0);
+OFGlobal<Sint32> dcmSocketSendBufferSize(-1);
+OFGlobal<Sint32> dcmSocketReceiveBufferSize(-1);
 
 static int networkInitialized = 0;
 
@@ -1053,6 +1055,55 @@ DUL_WritePDVs(DUL_ASSOCIATIONKEY ** callerAssociation,
 }
 
 
+/* DUL_WritePDVFromFile
+**
+** Purpose:
+**      Write a PDV whose data are read from a file on an active Association.
+**
+** Parameter Dictionary:
+**      callerAssociation       Caller's handle to the Association
+**      pdv                     Pointer to a structure which describes the
+**                              PDV. Its data field is ignored.
+**      fd                      Descriptor of the file which contains the data
+**      offset                  Byte offset of the data from the start of the file
+**
+** Return Values:
+**
+**
+** Algorithm:
+**      The PDV may be sent in the same states as a list of PDVs passed to
+**      DUL_WritePDVs. Where supported by the transport connection, the data
+**      are sent without passing through a user space buffer.
+*/
+
+OFCondition
+DUL_WritePDVFromFile(DUL_ASSOCIATIONKEY ** callerAssociation,
+                     DUL_PDV * pdv, int fd, unsigned long offset)
+{
+    PRIVATE_ASSOCIATIONKEY
+        ** association;
+
+    /* assign association to local variable */
+    association = (PRIVATE_ASSOCIATIONKEY **) callerAssociation;
+
+    /* check if association is valid, if not return an error */
+    OFCondition cond = checkAssociation(association);
+    if (cond.bad()) return cond;
+
+    /* the state machine only accepts a P-DATA request primitive in */
+    /* state 6 (data transfer) and state 8 (awaiting local release) */
+    int state = (*association)->protocolState;
+    if (state != STATE6 && state != STATE8)
+    {
+      char buf1[256];
+      sprintf(buf1, "DUL Finite State Machine Error: No action defined, state %d event %d", state, P_DATA_REQ);
+      return makeDcmnetCondition(DULC_FSMERROR, OF_error, buf1);
+    }
+
+    return PRV_SendPDVFromFile(association, pdv, fd, offset);
+}
+
+
 /* DUL_ReadPDVs
 **
 ** Purpose:
@@ -1409,8 +1460,8 @@ DUL_DefaultServiceParameters(DUL_ASSOCIATESERVICEPARAMETERS * params)
         "localhost:104",        /* Called presentation addr */
         NULL,                   /* Requested presentation ctx list */
         NULL,                   /* Accepted presentation ctx list */
-        0,                      /* Maximum operations invoked */
-        0,                      /* Maximum operations performed */
+        1,                      /* Maximum operations invoked */
+        1,                      /* Maximum operations performed */
         DICOM_NET_IMPLEMENTATIONCLASSUID, /* Calling implementation class UID */
         DICOM_NET_IMPLEMENTATIONVERSIONNAME, /* Calling implementation vers name */
         "",                     /* Called implementation class UID */
@@ -2011,6 +2062,9 @@ initializeNetworkTCP(PRIVATE_NETWORKKEY ** key, void *parameter)
           return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, buf2);
         }
 #endif
+        /* accepted sockets inherit the buffer sizes, which must be set */
+        /* before listen() so that a large TCP window can be negotiated */
+        setTCPBufferLength((*key)->networkSpecific.TCP.listenSocket);
 /* Name socket using wildcards */
         server.sin_family = AF_INET;
         server.sin_addr.s_addr = INADDR_ANY;
@@ -2237,8 +2291,15 @@ setTCPBufferLength(int sock)
         }
     }
 #if defined(SO_SNDBUF) && defined(SO_RCVBUF)
-    (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &bufLen, sizeof(bufLen));
-    (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &bufLen, sizeof(bufLen));
+    /* explicitly configured sizes take precedence, 0 keeps the system default */
+    int sendLen = dcmSocketSendBufferSize.get();
+    int receiveLen = dcmSocketReceiveBufferSize.get();
+    if (sendLen < 0) sendLen = bufLen;
+    if (receiveLen < 0) receiveLen = bufLen;
+    if (sendLen > 0)
+        (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &sendLen, sizeof(sendLen));
+    if (receiveLen > 0)
+        (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &receiveLen, sizeof(receiveLen));
 #else
     CERR << "DULFSM: setTCPBufferLength: "
             "cannot set TCP buffer length socket option: "
@@ -2273,6 +2334,8 @@ DUL_DumpParams(DUL_ASSOCIATESERVICEPARAMETERS * params)
         << "AP TITLE:     " << params->respondingAPTitle << endl
         << "MAX PDU:      " << (int)params->maxPDU << endl
         << "Peer MAX PDU: " << (int)params->peerMaxPDU << endl
+        << "MAX OPS:      " << (int)params->maximumOperationsInvoked << "/"
+        << (int)params->maximumOperationsPerformed << endl
         << "PRES ADDR:    " << params->callingPresentationAddress << endl
         << "PRES ADDR:    " << params->calledPresentationAddress << endl
         << "REQ IMP UID:  " << params->callingImplementationClassUID << endl;
@@ -2527,8 +2590,8 @@ clearRequestorsParams(DUL_ASSOCIATESERVICEPARAMETERS * params)
     params->calledPresentationAddress[0] = '\0';
     params->requestedPresentationContext = NULL;
     params->acceptedPresentationContext = NULL;
-    params->maximumOperationsInvoked = 0;
-    params->maximumOperationsPerformed = 0;
+    params->maximumOperationsInvoked = 1;
+    params->maximumOperationsPerformed = 1;
     params->callingImplementationClassUID[0] = '\0';
     params->callingImplementationVersionName[0] = '\0';
     params->requestedExtNegList = NULL;
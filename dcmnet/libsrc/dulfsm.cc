@@ -224,8 +224,11 @@ static OFCondition
 sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
              DUL_PDVLIST * pdvList);
 static OFCondition
-writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
-             DUL_DATAPDU * pdu);
+maxDataPDVLength(PRIVATE_ASSOCIATIONKEY ** association,
+                 unsigned long *maxLength);
+static OFCondition
+writeDataPDUs(PRIVATE_ASSOCIATIONKEY ** association,
+              const void * const *blocks, const size_t *lengths, int count);
 static void clearPDUCache(PRIVATE_ASSOCIATIONKEY ** association);
 static void closeTransport(PRIVATE_ASSOCIATIONKEY ** association);
 static void closeTransportTCP(PRIVATE_ASSOCIATIONKEY ** association);
@@ -1007,6 +1010,16 @@ AE_3_AssociateConfirmationAccept(PRIVATE_NETWORKKEY ** /*network*/,
         (*association)->maxPDV = assoc.userInfo.maxLength.maxLength;
         (*association)->maxPDVAcceptor =
             assoc.userInfo.maxLength.maxLength;
+        if (assoc.userInfo.asyncOperations.length != 0) {
+            service->maximumOperationsInvoked =
+                assoc.userInfo.asyncOperations.maximumOperationsInvoked;
+            service->maximumOperationsPerformed =
+                assoc.userInfo.asyncOperations.maximumOperationsProvided;
+        } else {
+            /* no asynchronous operations window: synchronous operation */
+            service->maximumOperationsInvoked = 1;
+            service->maximumOperationsPerformed = 1;
+        }
         strcpy(service->calledImplementationClassUID,
                assoc.userInfo.implementationClassUID.data);
         strcpy(service->calledImplementationVersionName,
@@ -1209,6 +1222,16 @@ AE_6_ExamineAssociateRequest(PRIVATE_NETWORKKEY ** /*network*/,
         (*association)->maxPDV = assoc.userInfo.maxLength.maxLength;
         (*association)->maxPDVRequestor =
             assoc.userInfo.maxLength.maxLength;
+        if (assoc.userInfo.asyncOperations.length != 0) {
+            service->maximumOperationsInvoked =
+                assoc.userInfo.asyncOperations.maximumOperationsInvoked;
+            service->maximumOperationsPerformed =
+                assoc.userInfo.asyncOperations.maximumOperationsProvided;
+        } else {
+            /* no asynchronous operations window: synchronous operation */
+            service->maximumOperationsInvoked = 1;
+            service->maximumOperationsPerformed = 1;
+        }
         strcpy(service->callingImplementationClassUID,
                assoc.userInfo.implementationClassUID.data);
         strcpy(service->callingImplementationVersionName,
@@ -2876,6 +2899,47 @@ sendReleaseRPTCP(PRIVATE_ASSOCIATIONKEY ** association)
 }
 
 
+/* maxDataPDVLength
+**
+** Purpose:
+**      Determine the maximum length of the data of a PDV in a data PDU
+**      that can be sent to the peer.
+**
+** Parameter Dictionary:
+**
+**      association     Handle to the Association
+**      maxLength       The maximum length is returned in this parameter
+**
+** Return Values:
+**
+**
+** Notes:
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+
+static OFCondition
+maxDataPDVLength(PRIVATE_ASSOCIATIONKEY ** association,
+                 unsigned long *maxLength)
+{
+    /* determine the maximum size (length) of a PDU which can be sent over the network. */
+    /* Note that the name "maxPDV" here is misleading. This field contains the maxPDU */
+    /* size which is max PDV size +6 or max PDV data field + 12. */
+    *maxLength = (*association)->maxPDV;
+
+    /* adjust maxLength (maximum length of a PDU) */
+    if (*maxLength == 0) *maxLength = ASC_MAXIMUMPDUSIZE - 12;
+    else if (*maxLength < 14)
+    {
+       char buf[256];
+       sprintf(buf, "DUL Cannot send P-DATA PDU because receiver's max PDU size of %lu is illegal (must be > 12)", *maxLength);
+       return makeDcmnetCondition(DULC_ILLEGALPDULENGTH, OF_error, buf);
+    }
+    else *maxLength -= 12;
+    return EC_Normal;
+}
+
 /* SendPDataTCP
 **
 ** Purpose:
@@ -2892,7 +2956,9 @@ sendReleaseRPTCP(PRIVATE_ASSOCIATIONKEY ** association)
 ** Notes:
 **
 ** Algorithm:
-**      Description of the algorithm (optional) and any other notes.
+**      The headers of the PDUs are streamed into a separate array and
+**      sent together with the PDV data by a single scatter-gather write
+**      for up to PRV_MAXGATHEREDPDUS PDUs, so the PDV data is not copied.
 */
 
 static OFCondition
@@ -2904,34 +2970,26 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
         count,
         length,
         pdvLength,
-        maxLength;
+        maxLength,
+        headLength;
 
     OFBool localLast;
     unsigned char *p;
     DUL_DATAPDU dataPDU;
     OFBool firstTrip;
 
+    /* PDU heads and blocks (head and data of each PDU) to be written at once */
+    unsigned char heads[PRV_MAXGATHEREDPDUS][24];
+    const void *blocks[2 * PRV_MAXGATHEREDPDUS];
+    size_t lengths[2 * PRV_MAXGATHEREDPDUS];
+    int pduCount = 0;
+
     /* assign the amount of PDVs in the array and the PDV array itself to local variables */
     count = pdvList->count;
     pdv = pdvList->pdv;
 
-    /* determine the maximum size (length) of a PDU which can be sent over the network. */
-    /* Note that the name "maxPDV" here is misleading. This field contains the maxPDU */
-    /* size which is max PDV size +6 or max PDV data field + 12. */
-    maxLength = (*association)->maxPDV;
-
-    /* send the error indicator variable to ok */
-    OFCondition cond = EC_Normal;
-
-    /* adjust maxLength (maximum length of a PDU) */
-    if (maxLength == 0) maxLength = ASC_MAXIMUMPDUSIZE - 12;
-    else if (maxLength < 14)
-    {
-       char buf[256];
-       sprintf(buf, "DUL Cannot send P-DATA PDU because receiver's max PDU size of %lu is illegal (must be > 12)", maxLength);
-       cond = makeDcmnetCondition(DULC_ILLEGALPDULENGTH, OF_error, buf);
-    }
-    else maxLength -= 12;
+    /* determine the maximum length of the data of a PDV */
+    OFCondition cond = maxDataPDVLength(association, &maxLength);
 
     /* start a loop iterate over all PDVs in the given */
     /* list and send every PDVs data over the network */
@@ -2956,8 +3014,22 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
             /* construct a data PDU */
             cond = constructDataPDU(p, pdvLength, pdv->pdvType,
                            pdv->presentationContextID, localLast, &dataPDU);
-            /* send the constructed PDU over the network */
-            cond = writeDataPDU(association, &dataPDU);
+            /* stream the PDU head and remember it together with the data */
+            if (cond.good())
+                cond = streamDataPDUHead(&dataPDU, heads[pduCount], sizeof(heads[pduCount]), &headLength);
+            if (cond.good())
+            {
+                blocks[2 * pduCount] = heads[pduCount];
+                lengths[2 * pduCount] = headLength;
+                blocks[2 * pduCount + 1] = p;
+                lengths[2 * pduCount + 1] = pdvLength;
+                /* send the collected PDUs over the network if the arrays are full */
+                if (++pduCount == PRV_MAXGATHEREDPDUS)
+                {
+                    cond = writeDataPDUs(association, blocks, lengths, 2 * pduCount);
+                    pduCount = 0;
+                }
+            }
 
             /* adjust the pointer to the data, so that he points to data which still has to be sent */
             p += pdvLength;
@@ -2968,74 +3040,124 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
         pdv++;
 
     }
+    /* send the remaining PDUs */
+    if (cond.good() && pduCount > 0)
+        cond = writeDataPDUs(association, blocks, lengths, 2 * pduCount);
+
     /* return corresponding result value */
     return cond;
 }
 
-/* writeDataPDU
+/* PRV_SendPDVFromFile
 **
 ** Purpose:
-**      Send the data through the socket interface (for TCP).
+**      Send a PDV whose data are read from a file in one or more data PDUs
+**      over a TCP connection.
 **
 ** Parameter Dictionary:
 **
 **      association     Handle to the Association
-**      pdu             The data unit that is to be sent thru the socket
+**      pdv             Pointer to the PDV, its data field is ignored
+**      fd              Descriptor of the file which contains the data
+**      offset          Byte offset of the data from the start of the file
 **
 ** Return Values:
 **
 **
 ** Notes:
+**      The caller is responsible for checking the state of the Association.
 **
 ** Algorithm:
-**      Description of the algorithm (optional) and any other notes.
+**      Each PDU head is written together with the PDV data taken from the
+**      file. Where supported by the transport connection (e.g. sendfile()
+**      on a transparent TCP connection), the data do not pass through a
+**      user space buffer.
 */
 
-static OFCondition
-writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
-             DUL_DATAPDU * pdu)
+OFCondition
+PRV_SendPDVFromFile(PRIVATE_ASSOCIATIONKEY ** association,
+                    DUL_PDV * pdv, int fd, unsigned long offset)
 {
-    unsigned char
-        head[24];
     unsigned long
-        length;
-    int
-        nbytes;
-
-    /* construct a stream variable that will contain PDU head information */
-    /* (in detail, this variable will contain PDU type, PDU reserved field, */
-    /* PDU length, PDV length, presentation context ID, message control header) */
-    /* (note that our representation of a PDU can only contain one PDV.) */
-    OFCondition cond = streamDataPDUHead(pdu, head, sizeof(head), &length);
-    if (cond.bad()) return cond;
+        length,
+        pdvLength,
+        maxLength,
+        headLength;
+    unsigned char head[24];
+    DUL_DATAPDU dataPDU;
+    OFBool firstTrip = OFTrue;
 
-    /* send the PDU head information (see above) */
-    do
-    {
-      nbytes = (*association)->connection ? (*association)->connection->write((char*)head, size_t(length)) : 0;
-    } while (nbytes == -1 && errno == EINTR);
+    /* determine the maximum length of the data of a PDV */
+    OFCondition cond = maxDataPDVLength(association, &maxLength);
 
-    /* if not all head information was sent, return an error */
-    if ((unsigned long) nbytes != length)
+    length = pdv->fragmentLength;
+    while ((firstTrip || (length > 0)) && (cond.good()))
     {
-        char buf1[256];
-        sprintf(buf1, "TCP I/O Error (%s) occurred in routine: %s", strerror(errno), "writeDataPDU");
-        return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, buf1);
+        firstTrip = OFFalse;
+        pdvLength = (length <= maxLength) ? length : maxLength;
+        cond = constructDataPDU(NULL, pdvLength, pdv->pdvType, pdv->presentationContextID,
+                                (pdvLength == length) && pdv->lastPDV, &dataPDU);
+        if (cond.good())
+            cond = streamDataPDUHead(&dataPDU, head, sizeof(head), &headLength);
+        if (cond.good())
+        {
+            ssize_t nbytes = (*association)->connection ?
+                (*association)->connection->writeFromFile(head, size_t(headLength), fd, offset, size_t(pdvLength)) : 0;
+            if (nbytes < 0 || (unsigned long) nbytes != headLength + pdvLength)
+            {
+                char buf[256];
+                sprintf(buf, "TCP I/O Error (%s) occurred in routine: %s", strerror(errno), "PRV_SendPDVFromFile");
+                cond = makeDcmnetCondition(DULC_TCPIOERROR, OF_error, buf);
+            }
+        }
+        offset += pdvLength;
+        length -= pdvLength;
     }
+    return cond;
+}
 
-    /* send the PDU's PDV data (note that our representation of a PDU can only contain one PDV.) */
-    do
-    {
-      nbytes = (*association)->connection ? (*association)->connection->write((char*)pdu->presentationDataValue.data,
-        size_t(pdu->presentationDataValue.length - 2)) : 0;
-    } while (nbytes == -1 && errno == EINTR);
+/* writeDataPDUs
+**
+** Purpose:
+**      Send the heads and data of one or more data PDUs through the
+**      socket interface (for TCP).
+**
+** Parameter Dictionary:
+**
+**      association     Handle to the Association
+**      blocks          Array of pointers to the PDU heads and PDV data
+**      lengths         Array of the lengths of the blocks
+**      count           Number of blocks
+**
+** Return Values:
+**
+**
+** Notes:
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+
+static OFCondition
+writeDataPDUs(PRIVATE_ASSOCIATIONKEY ** association,
+              const void * const *blocks, const size_t *lengths, int count)
+{
+    unsigned long length = 0;
+    ssize_t nbytes;
+
+    /* determine the number of bytes to send */
+    for (int i = 0; i < count; i++) length += lengths[i];
 
-        /* if not all head information was sent, return an error */
-    if ((unsigned long) nbytes != pdu->presentationDataValue.length - 2)
+    /* send the PDU heads and the PDV data (note that our representation */
+    /* of a PDU can only contain one PDV.) */
+    nbytes = (*association)->connection ? (*association)->connection->writeBlocks(blocks, lengths, count) : 0;
+
+    /* if not all information was sent, return an error */
+    if (nbytes < 0 || (unsigned long) nbytes != length)
     {
-        char buf2[256];
-        sprintf(buf2, "TCP I/O Error (%s) occurred in routine: %s", strerror(errno), "writeDataPDU");
-        return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, buf2);
+        char buf1[256];
+        sprintf(buf1, "TCP I/O Error (%s) occurred in routine: %s", strerror(errno), "writeDataPDUs");
+        return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, buf1);
     }
 
     /* return ok */
@@ -3684,10 +3806,11 @@ dump_pdu(const char *type, void *buffer, unsigned long length)
 /* setTCPBufferLength
 **
 ** Purpose:
-**      This routine checks for the existence of an environment
-**      variable (TCP_BUFFER_LENGTH).  If that variable is defined (and
-**      is a legal integer), this routine sets the socket SNDBUF and RCVBUF
-**      variables to the value defined in TCP_BUFFER_LENGTH.
+**      This routine sets the socket SNDBUF and RCVBUF variables to the
+**      sizes configured in dcmSocketSendBufferSize and
+**      dcmSocketReceiveBufferSize. Unless configured, the value of the
+**      environment variable TCP_BUFFER_LENGTH (if defined and a legal
+**      integer) or 32K is used.
 **
 ** Parameter Dictionary:
 **      sock            Socket descriptor (identifier)
@@ -3724,8 +3847,15 @@ setTCPBufferLength(int sock)
         }
     }
 #if defined(SO_SNDBUF) && defined(SO_RCVBUF)
-    (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &bufLen, sizeof(bufLen));
-    (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &bufLen, sizeof(bufLen));
+    /* explicitly configured sizes take precedence, 0 keeps the system default */
+    int sendLen = dcmSocketSendBufferSize.get();
+    int receiveLen = dcmSocketReceiveBufferSize.get();
+    if (sendLen < 0) sendLen = bufLen;
+    if (receiveLen < 0) receiveLen = bufLen;
+    if (sendLen > 0)
+        (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &sendLen, sizeof(sendLen));
+    if (receiveLen > 0)
+        (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &receiveLen, sizeof(receiveLen));
 #else
      ofConsole.lockCerr() << "DULFSM: setTCPBufferLength: "
             "cannot set TCP buffer length socket option: "
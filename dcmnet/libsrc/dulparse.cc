@@ -84,6 +84,9 @@ parseMaxPDU(DUL_MAXLENGTH * max, unsigned char *buf,
 static OFCondition
     parseDummy(unsigned char *buf, unsigned long *itemLength);
 static OFCondition
+parseAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *buf,
+                     unsigned long *itemLength);
+static OFCondition
 parseSCUSCPRole(PRV_SCUSCPROLE * role, unsigned char *buf,
                 unsigned long *length);
 static void trim_trailing_spaces(char *s);
@@ -504,7 +507,9 @@ parseUserInfo(DUL_USERINFO * userInfo,
             break;
 
         case DUL_TYPEASYNCOPERATIONS:
-            cond = parseDummy(buf, &length);
+            cond = parseAsyncOperations(&userInfo->asyncOperations, buf, &length);
+            if (cond.bad())
+                return cond;
             buf += length;
             userLength -= (unsigned short) length;
             break;
@@ -592,6 +597,51 @@ parseMaxPDU(DUL_MAXLENGTH * max, unsigned char *buf,
     return EC_Normal;
 }
 
+/* parseAsyncOperations
+**
+** Purpose:
+**      Parse the buffer and extract the Asynchronous Operations Window
+**      structure.
+**
+** Parameter Dictionary:
+**      async           The structure to hold the window
+**      buf             The buffer that is to be parsed
+**      itemLength      Length of structure extracted.
+**
+** Return Values:
+**
+**      DUL_ILLEGALPDU
+**
+** Notes:
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+static OFCondition
+parseAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *buf,
+                     unsigned long *itemLength)
+{
+    async->type = *buf++;
+    async->rsv1 = *buf++;
+    EXTRACT_SHORT_BIG(buf, async->length);
+    buf += 2;
+    if (async->length != 4) return DUL_ILLEGALPDU;
+    EXTRACT_SHORT_BIG(buf, async->maximumOperationsInvoked);
+    buf += 2;
+    EXTRACT_SHORT_BIG(buf, async->maximumOperationsProvided);
+    *itemLength = 2 + 2 + async->length;
+
+#ifdef DEBUG
+    if (debug) {
+            DEBUG_DEVICE << "Asynchronous Operations Window: "
+                << (unsigned long)async->maximumOperationsInvoked << "/"
+                << (unsigned long)async->maximumOperationsProvided << endl;
+    }
+#endif
+
+    return EC_Normal;
+}
+
 /* parseDummy
 **
 ** Purpose:
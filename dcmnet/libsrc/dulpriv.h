@@ -65,6 +65,7 @@
 
 #define	PRV_DEFAULTTIMEOUT	-1
 #define	PRV_LISTENBACKLOG	50
+#define	PRV_MAXGATHEREDPDUS	32	/* data PDUs sent with one write */
 
 #define DEBUG_DEVICE	COUT
 
@@ -104,6 +105,9 @@ parseAssociate(unsigned char *buf, unsigned long len,
 OFCondition
 PRV_NextPDUType(PRIVATE_ASSOCIATIONKEY ** association,
 		DUL_BLOCKOPTIONS block, int timeout, unsigned char *type);
+OFCondition
+PRV_SendPDVFromFile(PRIVATE_ASSOCIATIONKEY ** association,
+		    DUL_PDV * pdv, int fd, unsigned long offset);
 
 void fsmDebug(OFBool flag);
 void constructDebug(OFBool flag);
@@ -1768,8 +1768,10 @@ private:
                                                    const char *instanceUID = NULL);
 
     /** returns index of specified study within study description record
+     *  which consists of the given number of entries
      */
     int findStudyIdx(StudyDescRecord *study,
+                     int count,
                      const char *uid);
 
     /** conditionally deletes given image file (only if file resides in index.dat directory)
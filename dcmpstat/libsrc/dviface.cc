@@ -2012,12 +2012,13 @@ OFCondition DVInterface::instanceReviewed(const char *studyUID,
 
 
 int DVInterface::findStudyIdx(StudyDescRecord *study,
+                              int count,
                               const char *uid)
 {
     if ((study != NULL) && (uid != NULL))
     {
         register int i = 0;
-        for (i = 0; i < PSTAT_MAXSTUDYCOUNT; i++)
+        for (i = 0; i < count; i++)
         {
             if ((study[i].StudyInstanceUID != NULL) &&
                 (strcmp(uid, study[i].StudyInstanceUID) == 0))
@@ -2060,12 +2061,13 @@ OFCondition DVInterface::deleteStudy(const char *studyUID)
             wasNew = newInstancesReceived();
             if (study->List.gotoFirst())
             {
-                StudyDescRecord *study_desc = OFstatic_cast(StudyDescRecord *, malloc(SIZEOF_STUDYDESC));
+                int count = pHandle->DB_StudyDescCount();
+                StudyDescRecord *study_desc = OFstatic_cast(StudyDescRecord *, malloc(count * sizeof(StudyDescRecord)));
                 if (study_desc != NULL)
                 {
                     if (pHandle->DB_GetStudyDesc(study_desc).good())
                     {
-                        int idx = findStudyIdx(study_desc, studyUID);
+                        int idx = findStudyIdx(study_desc, count, studyUID);
                         if (idx >= 0)
                         {
                             do /* for all series */
@@ -2114,12 +2116,13 @@ OFCondition DVInterface::deleteSeries(const char *studyUID,
             wasNew = newInstancesReceived();
             if (series->List.gotoFirst())
             {
-                StudyDescRecord *study_desc = OFstatic_cast(StudyDescRecord *, malloc(SIZEOF_STUDYDESC));
+                int count = pHandle->DB_StudyDescCount();
+                StudyDescRecord *study_desc = OFstatic_cast(StudyDescRecord *, malloc(count * sizeof(StudyDescRecord)));
                 if (study_desc != NULL)
                 {
                     if (pHandle->DB_GetStudyDesc(study_desc).good())
                     {
-                        int idx = findStudyIdx(study_desc, studyUID);
+                        int idx = findStudyIdx(study_desc, count, studyUID);
                         if (idx >= 0)
                         {
                             do /* for all images */
@@ -2162,13 +2165,14 @@ OFCondition DVInterface::deleteInstance(const char *studyUID,
         {
             wasNew = newInstancesReceived();
             pHandle->DB_IdxRemove(series->List.getPos());
-            StudyDescRecord *study_desc = OFstatic_cast(StudyDescRecord *, malloc(SIZEOF_STUDYDESC));
+            int count = pHandle->DB_StudyDescCount();
+            StudyDescRecord *study_desc = OFstatic_cast(StudyDescRecord *, malloc(count * sizeof(StudyDescRecord)));
             if (study_desc != NULL)
             {
                 if (pHandle->DB_GetStudyDesc(study_desc).good())
                 {
                     register int i = 0;
-                    for (i = 0; i < PSTAT_MAXSTUDYCOUNT; i++)
+                    for (i = 0; i < count; i++)
                     {
                         if ((study_desc[i].StudyInstanceUID != NULL) &&
                             (strcmp(studyUID, study_desc[i].StudyInstanceUID) != 0))
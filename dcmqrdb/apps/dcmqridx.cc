@@ -87,6 +87,11 @@ int main (int argc, char *argv[])
     OFBool opt_verbose = OFFalse;
     OFBool opt_print = OFFalse;
     OFBool opt_isNewFlag = OFTrue;
+    OFBool opt_migrate = OFFalse;
+#ifdef WITH_LUCENE
+    OFCmdUnsignedInt opt_batchSize = 1000;
+    OFCmdUnsignedInt opt_commitInterval = 0;
+#endif
 
     SetDebugLevel(( 0 ));
 
@@ -112,6 +117,18 @@ int main (int argc, char *argv[])
      cmd.addOption("--debug",   "-d", "debug mode, print debug information");
      cmd.addOption("--print",   "-p", "list contents of database index file");
      cmd.addOption("--not-new", "-n", "set instance reviewed status to 'not new'");
+#ifndef WITH_LUCENE
+#ifndef WITH_SQL_DATABASE
+     cmd.addOption("--migrate", "-m", "convert index file of an older version");
+#endif
+#endif
+#ifdef WITH_LUCENE
+    cmd.addGroup("batch ingest options:");
+     cmd.addOption("--batch-size",      "+B", 1, "[n]umber: integer (default: 1000)",
+                                              "commit index after n documents (0 = at end only)");
+     cmd.addOption("--commit-interval", "+I", 1, "[m]illiseconds: integer (default: 0)",
+                                              "commit index after m ms (0 = no time limit)");
+#endif
 
 #ifdef HAVE_GUSI_H
     /* needed for Macintosh */
@@ -154,6 +171,18 @@ int main (int argc, char *argv[])
 
         if (cmd.findOption("--not-new"))
             opt_isNewFlag = OFFalse;
+#ifndef WITH_LUCENE
+#ifndef WITH_SQL_DATABASE
+        if (cmd.findOption("--migrate"))
+            opt_migrate = OFTrue;
+#endif
+#endif
+#ifdef WITH_LUCENE
+        if (cmd.findOption("--batch-size"))
+            app.checkValue(cmd.getValue(opt_batchSize));
+        if (cmd.findOption("--commit-interval"))
+            app.checkValue(cmd.getValue(opt_commitInterval));
+#endif
     }
 
     /* make sure data dictionary is loaded */
@@ -177,16 +206,30 @@ int main (int argc, char *argv[])
     hdlp = new DcmQueryRetrieveSQLDatabaseHandle();
 #else
     // use linear index database (index.dat)
-    hdlp = new DcmQueryRetrieveIndexDatabaseHandle(opt_storageArea, DB_UpperMaxStudies, DB_UpperMaxBytesPerStudy, cond);
+    if (opt_migrate)
+    {
+        int converted = 0;
+        cond = DcmQueryRetrieveIndexDatabaseHandle::migrateIndexFile(opt_storageArea, converted);
+        if (cond.bad())
+        {
+            fprintf(stderr, "%s: cannot convert index file in %s\n", OFFIS_CONSOLE_APPLICATION, opt_storageArea);
+            return 1;
+        }
+        if (opt_verbose)
+            printf("converted %d index records\n", converted);
+    }
+    hdlp = new DcmQueryRetrieveIndexDatabaseHandle(opt_storageArea, DB_UnlimitedStudies, DB_UpperMaxBytesPerStudy, cond);
 #endif    
     
-//    DcmQueryRetrieveIndexDatabaseHandle hdl(opt_storageArea, DB_UpperMaxStudies, DB_UpperMaxBytesPerStudy, cond);
+//    DcmQueryRetrieveIndexDatabaseHandle hdl(opt_storageArea, DB_UnlimitedStudies, DB_UpperMaxBytesPerStudy, cond);
     if (cond.good())
     {
         hdlp->setDebugLevel(opt_debug ? 3 : 0);
 #ifdef WITH_LUCENE
         if (opt_verbose)
 	  dynamic_cast<DcmQueryRetrieveLuceneIndexHandle*>(hdlp)->setVerbose( true );
+        if (!opt_print)
+	  dynamic_cast<DcmQueryRetrieveLuceneIndexHandle*>(hdlp)->setGroupCommit( (unsigned int)opt_batchSize, (int)opt_commitInterval );
 #endif
 #ifndef WITH_LUCENE
 #ifndef WITH_SQL_DATABASE
@@ -80,6 +80,7 @@ END_EXTERN_C
 #include "dcmtk/dcmnet/dimse.h"
 #include "dcmtk/dcmqrdb/dcmqrcnf.h"
 #include "dcmtk/dcmqrdb/dcmqrsrv.h"
+#include "dcmtk/dcmqrdb/dcmqrfcc.h"
 #include "dcmtk/dcmdata/dcdict.h"
 #include "dcmtk/dcmdata/dcdebug.h"
 #include "dcmtk/dcmdata/cmdlnarg.h"
@@ -173,6 +174,9 @@ main(int argc, char *argv[])
 #ifdef HAVE_FORK
    cmd.addOption("--single-process",            "-s",        "single process mode");
 #endif
+#ifdef WITH_THREADS
+   cmd.addOption("--multi-threaded",            "-mt",       "multi-threaded mode, serve associations in\na pool of worker threads");
+#endif
 
   cmd.addGroup("database options:");
     cmd.addSubGroup("association negotiation:");
@@ -196,6 +200,9 @@ main(int argc, char *argv[])
 #ifndef NO_PATIENTSTUDYONLY_SUPPORT
       cmd.addOption("--no-patient-study",       "-QO",       "do not support Patient/Study Only Q/R models");
 #endif
+    cmd.addSubGroup("query result cache:");
+      cmd.addOption("--find-cache",             "+fc",    1, "[n]umber: integer (default: 32)", "keep the results of up to n C-FIND requests");
+      cmd.addOption("--no-find-cache",          "-fc",       "do not cache C-FIND results");
 
   cmd.addGroup("network options:");
     cmd.addSubGroup("preferred network transfer syntaxes (incoming associations):");
@@ -259,6 +266,12 @@ main(int argc, char *argv[])
       cmd.addOption("--reject",                              "reject association if no implement. class UID");
       cmd.addOption("--ignore",                              "ignore store data, receive but do not store");
       cmd.addOption("--uid-padding",            "-up",       "silently correct space-padded UIDs");
+#ifdef WITH_THREADS
+
+    cmd.addSubGroup("C-MOVE sub-operations:");
+      cmd.addOption("--prefetch",               "+pf",    1, "[n]umber: integer (default: 0)", "load up to n files ahead of the C-STORE\nsub-operation on the wire");
+      cmd.addOption("--move-associations",      "+ma",    1, "[n]umber: integer (default: 1)", "spread C-STORE sub-operations across n\nassociations to the move destination");
+#endif
 
   cmd.addGroup("encoding options:");
     cmd.addSubGroup("post-1993 value representations:");
@@ -321,9 +334,18 @@ main(int argc, char *argv[])
         SetDebugLevel(3);
       }
       if (cmd.findOption("--config")) app.checkValue(cmd.getValue(opt_configFileName));
+      cmd.beginOptionBlock();
 #ifdef HAVE_FORK
       if (cmd.findOption("--single-process")) options.singleProcess_ = OFTrue;
 #endif
+#ifdef WITH_THREADS
+      if (cmd.findOption("--multi-threaded"))
+      {
+        options.singleProcess_ = OFFalse;
+        options.multiThreaded_ = OFTrue;
+      }
+#endif
+      cmd.endOptionBlock();
 
       if (cmd.findOption("--require-find")) options.requireFindForMove_ = OFTrue;
       if (cmd.findOption("--no-parallel-store")) options.refuseMultipleStorageAssociations_ = OFTrue;
@@ -358,6 +380,15 @@ main(int argc, char *argv[])
       {
         app.printError("cannot disable all Q/R models");
       }
+      cmd.beginOptionBlock();
+      if (cmd.findOption("--find-cache"))
+      {
+        OFCmdUnsignedInt opt_findCache = DEFAULT_FINDCACHE_ENTRIES;
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_findCache, 1, 65535));
+        options.findCacheEntries_ = OFstatic_cast(int, opt_findCache);
+      }
+      if (cmd.findOption("--no-find-cache")) options.findCacheEntries_ = 0;
+      cmd.endOptionBlock();
 
       cmd.beginOptionBlock();
       if (cmd.findOption("--prefer-uncompr"))  options.networkTransferSyntax_     = EXS_Unknown;
@@ -430,6 +461,20 @@ main(int argc, char *argv[])
       if (cmd.findOption("--reject")) options.rejectWhenNoImplementationClassUID_ = OFTrue;
       if (cmd.findOption("--ignore")) options.ignoreStoreData_ = OFTrue;
       if (cmd.findOption("--uid-padding")) options.correctUIDPadding_ = OFTrue;
+#ifdef WITH_THREADS
+      if (cmd.findOption("--prefetch"))
+      {
+        OFCmdUnsignedInt opt_prefetch = 0;
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_prefetch, 0, 1024));
+        options.movePrefetch_ = OFstatic_cast(int, opt_prefetch);
+      }
+      if (cmd.findOption("--move-associations"))
+      {
+        OFCmdUnsignedInt opt_moveAssociations = 1;
+        app.checkValue(cmd.getValueAndCheckMinMax(opt_moveAssociations, 1, 64));
+        options.moveAssociations_ = OFstatic_cast(int, opt_moveAssociations);
+      }
+#endif
 
       cmd.beginOptionBlock();
       if (cmd.findOption("--enable-new-vr"))
@@ -648,6 +693,8 @@ main(int argc, char *argv[])
     DcmQueryRetrieveIndexDatabaseHandleFactory factory(&config);
 #endif
 
+    DcmQueryRetrieveFindCache::instance().setLimits(options.findCacheEntries_, DEFAULT_FINDCACHE_RESPONSES);
+
     DcmQueryRetrieveSCP scp(config, options, factory);
     scp.setDatabaseFlags(opt_checkFindIdentifier, opt_checkMoveIdentifier, options.debug_);
 
@@ -36,11 +36,16 @@
 
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 #include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmqrdb/dcmqrdba.h"    /* for MAXPATHLEN */
 
 class DcmQueryRetrieveDatabaseHandle;
 class DcmQueryRetrieveOptions;
 class DcmQueryRetrieveConfig;
 class DcmQueryRetrieveDatabaseStatus;
+class DcmQueryRetrieveMoveWorker;
+class DcmFileFormat;
 
 /** this class maintains the context information that is passed to the 
  *  callback function called by DIMSE_moveProvider.
@@ -83,6 +88,20 @@ public:
     , nCompleted(0)
     , nFailed(0)
     , nWarning(0)
+#ifdef WITH_THREADS
+    , subOpTotal(0)
+    , pipelineActive(OFFalse)
+    , pipelineCancelled(OFFalse)
+    , pipelineStatus(STATUS_Success)
+    , moreSubAssocs()
+    , workers()
+    , pendingSubOps()
+    , readySubOps()
+    , pipelineMutex()
+    , prefetchSemaphore(0)
+    , readySemaphore(0)
+    , doneSemaphore(0)
+#endif
     {
       origAETitle[0] = '\0';
       origHostName[0] = '\0';
@@ -90,6 +109,9 @@ public:
       ourAETitle.clear();
     }
 
+    /// destructor, terminates the worker threads if the move was aborted
+    ~DcmQueryRetrieveMoveContext();
+
     /** callback handler called by the DIMSE_storeProvider callback function.
      *  @param cancelled (in) flag indicating whether a C-CANCEL was received
      *  @param request original move request (in) 
@@ -120,9 +142,75 @@ public:
 
 private:
 
+    friend class DcmQueryRetrieveMoveWorker;
+
+#ifdef WITH_THREADS
+    /// a C-STORE sub-operation handed over to the worker threads
+    struct MoveSubOp
+    {
+      /// SOP class UID of the instance
+      DIC_UI sopClass;
+
+      /// SOP instance UID of the instance
+      DIC_UI sopInstance;
+
+      /// name of the image file
+      char fname[MAXPATHLEN + 1];
+
+      /// image file loaded ahead of sending, NULL if the file is sent by name
+      DcmFileFormat *fileformat;
+    };
+
+    /** check whether C-STORE sub-operations are pipelined, i.e. whether
+     *  files are loaded ahead or several sub-associations are used.
+     */
+    OFBool isPipelined() const;
+
+    /** fetch all sub-operations from the database and start the worker
+     *  threads, which open the additional sub-associations.
+     *  @param dbStatus database status, pending if there are sub-operations to perform
+     */
+    void startPipeline(DcmQueryRetrieveDatabaseStatus * dbStatus);
+
+    /** wait until the next sub-operation has completed and update the
+     *  move status accordingly.
+     *  @param cancelled true if a C-CANCEL was received
+     *  @param dbStatus move status, pending until all sub-operations are done
+     */
+    void waitPipeline(OFBool cancelled, DcmQueryRetrieveDatabaseStatus * dbStatus);
+
+    /// terminate the worker threads and release the additional sub-associations
+    void stopPipeline();
+
+    /** start a worker thread
+     *  @param assoc sub-association for a sending thread, NULL for a loading thread.
+     *    A sending thread opens the sub-association itself if *assoc is NULL
+     *    and releases it when it terminates.
+     *  @return true if successful
+     */
+    OFBool startWorker(T_ASC_Association **assoc);
+
+    /** perform a pipelined sub-operation and delete it
+     *  @param assoc sub-association to use
+     *  @param subOp sub-operation, deleted by this method
+     */
+    void sendSubOp(T_ASC_Association *assoc, MoveSubOp *subOp);
+
+    /// main loop of a worker thread loading files ahead
+    void runLoader();
+
+    /** main loop of a worker thread performing sub-operations
+     *  @param assoc sub-association used by this thread, opened if NULL
+     */
+    void runSender(T_ASC_Association **assoc);
+#endif
+
     void addFailedUIDInstance(const char *sopInstance);
-    OFCondition performMoveSubOp(DIC_UI sopClass, DIC_UI sopInstance, char *fname);
+    void countSubOp(DIC_US& counter, const char *failedSOPInstance);
+    OFCondition performMoveSubOp(T_ASC_Association *assoc, DIC_UI sopClass, DIC_UI sopInstance, char *fname, DcmDataset *dataset);
     OFCondition buildSubAssociation(T_DIMSE_C_MoveRQ *request);
+    OFCondition openSubAssociation(T_ASC_Association **assoc);
+    OFCondition releaseSubAssociation(T_ASC_Association **assoc);
     OFCondition closeSubAssociation();
     void moveNextImage(DcmQueryRetrieveDatabaseStatus * dbStatus);
     void failAllSubOperations(DcmQueryRetrieveDatabaseStatus * dbStatus);
@@ -185,7 +273,44 @@ private:
     
     /// number of completed sub-operations that causes warnings
     DIC_US nWarning;
-    
+
+#ifdef WITH_THREADS
+    /// number of sub-operations fetched from the database in pipelined mode
+    DIC_US subOpTotal;
+
+    /// true if the sub-operations of this move are pipelined
+    OFBool pipelineActive;
+
+    /// true if the pipelined move was cancelled
+    OFBool pipelineCancelled;
+
+    /// final database status of the pipelined move
+    DIC_US pipelineStatus;
+
+    /// additional sub-associations to the move destination
+    OFList<T_ASC_Association *> moreSubAssocs;
+
+    /// worker threads loading files and performing sub-operations
+    OFList<DcmQueryRetrieveMoveWorker *> workers;
+
+    /// sub-operations not yet loaded
+    OFList<MoveSubOp *> pendingSubOps;
+
+    /// sub-operations ready to be sent
+    OFList<MoveSubOp *> readySubOps;
+
+    /// mutex protecting the sub-operation lists, counters and failed UID list
+    OFMutex pipelineMutex;
+
+    /// semaphore limiting the number of files loaded ahead
+    OFSemaphore prefetchSemaphore;
+
+    /// semaphore counting the entries in readySubOps
+    OFSemaphore readySemaphore;
+
+    /// semaphore counting finished sub-operations
+    OFSemaphore doneSemaphore;
+#endif
 };
 
 #endif
@@ -40,6 +40,7 @@
 class DcmQueryRetrieveDatabaseHandle;
 class DcmQueryRetrieveOptions;
 class DcmFileFormat;
+class DcmQueryRetrieveStoreScanner;
 
 /** this class maintains the context information that is passed to the 
  *  callback function called by DIMSE_storeProvider.
@@ -66,6 +67,7 @@ public:
     , fileName(NULL)
     , dcmff(ff)
     , correctUIDPadding(correctuidpadding)
+    , scanner(NULL)
     {
     }
 
@@ -82,6 +84,13 @@ public:
      */
     void setFileName(const char *fn) { fileName = fn; }
 
+    /** set the scanner that extracts the attributes to be registered in the
+     *  database while the image is received into a file. If the scanner has
+     *  parsed the complete dataset, the file is not read again.
+     *  @param s scanner, may be NULL. Object is not copied.
+     */
+    void setScanner(DcmQueryRetrieveStoreScanner *s) { scanner = s; }
+
     /** callback handler called by the DIMSE_storeProvider callback function.
      *  @param progress progress state (in)
      *  @param req original store request (in)
@@ -105,6 +114,7 @@ private:
     void saveImageToDB(
         T_DIMSE_C_StoreRQ *req,             /* original store request */
         const char *imageFileName,
+        DcmDataset *dataSet,                /* attributes to be registered */
         /* out */
         T_DIMSE_C_StoreRSP *rsp,            /* final store response */
         DcmDataset **stDetail);
@@ -138,6 +148,9 @@ private:
 
     /// flag indicating whether space padded UIDs should be silently corrected
     OFBool correctUIDPadding;
+
+    /// scanner extracting attributes while the image is received into a file, may be NULL
+    DcmQueryRetrieveStoreScanner *scanner;
     
 };
 
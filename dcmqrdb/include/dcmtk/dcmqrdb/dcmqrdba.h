@@ -41,6 +41,8 @@
 #define INCLUDE_UNISTD
 #include "dcmtk/ofstd/ofstdinc.h"
 #include "dcmtk/ofstd/ofcond.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/dcmdata/dctagkey.h"
 
 class DcmDataset;
 class DcmQueryRetrieveDatabaseStatus;
@@ -98,6 +100,46 @@ public:
       DcmQueryRetrieveDatabaseStatus  *status,
       OFBool     isNew = OFTrue ) = 0;
 
+  /** register the given DICOM object, which has been received through a C-STORE
+   *  operation and stored in a file, in the database. The attributes to be
+   *  registered are taken from the given dataset, the file is not read again.
+   *  @param SOPClassUID SOP class UID of DICOM instance
+   *  @param SOPInstanceUID SOP instance UID of DICOM instance
+   *  @param imageFileName file name (full path) of DICOM instance
+   *  @param dataset dataset of the DICOM instance. It must contain at least
+   *    all attributes returned by getStoreAttributes() that are present in
+   *    the DICOM instance.
+   *    The default implementation ignores the dataset and calls the file
+   *    based storeRequest(), i.e. the file is read again.
+   *  @param status pointer to DB status object in which a DIMSE status code
+        suitable for use with the C-STORE-RSP message is set.
+   *  @param isNew if true, the instance is marked as "new" in the database,
+   *    if such a flag is maintained in the database.
+   *  @return EC_Normal upon normal completion, or some other OFCondition code upon failure.
+   */
+  virtual OFCondition storeRequest(
+      const char *SOPClassUID,
+      const char *SOPInstanceUID,
+      const char *imageFileName,
+      DcmDataset * /* dataset */,
+      DcmQueryRetrieveDatabaseStatus  *status,
+      OFBool     isNew = OFTrue )
+  {
+    return storeRequest(SOPClassUID, SOPInstanceUID, imageFileName, status, isNew);
+  }
+
+  /** get the list of attributes that are evaluated when a DICOM object is
+   *  registered in the database. A dataset containing these attributes can
+   *  be passed to storeRequest() in place of the complete object.
+   *  An empty list (the default) means that the database handle needs the
+   *  file and no attributes are extracted while the object is received.
+   *  @param tags list of attributes returned in this parameter
+   */
+  virtual void getStoreAttributes(OFList<DcmTagKey>& tags)
+  {
+    tags.clear();
+  }
+
   /** initiate FIND operation using the given SOP class UID (which identifies
    *  the query model) and DICOM dataset containing find request identifiers.
    *  @param SOPClassUID SOP class UID of query service, identifies Q/R model
@@ -48,7 +48,12 @@ struct IdxRecord;
 struct DB_ElementList;
 class DcmQueryRetrieveConfig;
 
-#define DBINDEXFILE "index.dat"
+#define DBINDEXFILE "index2.dat"
+#define DBOLDINDEXFILE "index.dat"
+#define DBOLDINDEXBACKUPFILE "index.dat.v1"
+#define DBKEYINDEXFILE "index.key"
+#define DBLOCKFILE "index.lck"
+#define DBSTUDYFILE "index.std"
 
 #ifndef _WIN32
 /* we lock image files on all platforms except Win32 where it does not work
@@ -88,8 +93,8 @@ enum DVIFhierarchyStatus
   DVIF_objectContainsNewSubobjects
 };
 
-/// upper limit for the number of studies per storage area
-#define DB_UpperMaxStudies              500
+/// number of studies per storage area that is used if no limit is configured
+#define DB_UnlimitedStudies             0x7fffffffL
 
 /// upper limit for the number bytes per study
 #define DB_UpperMaxBytesPerStudy        0x40000000L
@@ -107,7 +112,8 @@ public:
    *  database storage area (storageArea).
    *  @param storageArea name of storage area, must not be NULL
    *  @param maxStudiesPerStorageArea maximum number of studies for this storage area,
-   *    needed to correctly parse the index file.
+   *    for quota mechanism. Zero or a negative value means that the number of studies
+   *    is not limited.
    *  @param maxBytesPerStudy maximum number of bytes per study, for quota mechanism
    *  @param result upon successful initialization of the database handle,
    *    EC_Normal is returned in this parameter, otherwise an error code is returned.
@@ -167,6 +173,34 @@ public:
       const char *imageFileName,
       DcmQueryRetrieveDatabaseStatus  *status,
       OFBool     isNew = OFTrue );
+
+  /** register the given DICOM object, which has been received through a C-STORE 
+   *  operation and stored in a file, in the database. The attributes to be
+   *  registered are taken from the given dataset, the file is not read again.
+   *  @param SOPClassUID SOP class UID of DICOM instance
+   *  @param SOPInstanceUID SOP instance UID of DICOM instance
+   *  @param imageFileName file name (full path) of DICOM instance
+   *  @param dataset dataset containing at least the attributes returned by getStoreAttributes()
+   *  @param status pointer to DB status object in which a DIMSE status code 
+        suitable for use with the C-STORE-RSP message is set.
+   *  @param isNew if true, the instance is marked as "new" in the database,
+   *    if such a flag is maintained in the database.   
+   *  @return EC_Normal upon normal completion, or some other OFCondition code upon failure.
+   */
+  OFCondition storeRequest(
+      const char *SOPClassUID,
+      const char *SOPInstanceUID,
+      const char *imageFileName,
+      DcmDataset *dataset,
+      DcmQueryRetrieveDatabaseStatus  *status,
+      OFBool     isNew = OFTrue );
+
+  /** get the list of attributes that are evaluated when a DICOM object is
+   *  registered in the database, i.e. the attributes of the index record
+   *  and those the instance description is derived from.
+   *  @param tags list of attributes returned in this parameter
+   */
+  void getStoreAttributes(OFList<DcmTagKey>& tags);
   
   /** initiate FIND operation using the given SOP class UID (which identifies
    *  the query model) and DICOM dataset containing find request identifiers. 
@@ -281,6 +315,20 @@ public:
    *  @param storeArea name of storage area, must not be NULL
    */
   static void printIndexFile (char *storeArea);
+
+  /** convert a version 1 index file (DBOLDINDEXFILE, fixed size records
+   *  preceded by a fixed number of study descriptors) into the current
+   *  variable length format (DBINDEXFILE). The conversion is done in
+   *  temporary files that are renamed only upon success. The version 1 file
+   *  is then renamed to DBOLDINDEXBACKUPFILE, so that older applications
+   *  cannot keep working on it. No other process may access the storage
+   *  area while the conversion is running.
+   *  @param storeArea name of storage area, must not be NULL
+   *  @param converted returns the number of index records converted
+   *  @return EC_Normal upon success or if there is no version 1 index file,
+   *    an error code otherwise
+   */
+  static OFCondition migrateIndexFile (const char *storeArea, int& converted);
     
   /** deletes the given file only if the quota mechanism is enabled.
    *  The image is not de-registered from the database by this routine.
@@ -319,19 +367,27 @@ public:
    */
   OFCondition DB_IdxRead(int idx, IdxRecord *idxRec);
 
-  /** get study descriptor record from start of index file
-   *  @param pStudyDesc pointer to study record descriptor structure
+  /** determine the number of study descriptors that DB_GetStudyDesc() and
+   *  DB_StudyDescChange() work on, i.e. one for each descriptor in the study
+   *  file plus a free one, but not more than the maximum number of studies.
+   *  Must be called with the database locked, before DB_GetStudyDesc().
+   *  @return number of entries the study descriptor array must provide
+   */
+  int DB_StudyDescCount();
+
+  /** get study descriptor records from the study file
+   *  @param pStudyDesc pointer to an array of DB_StudyDescCount() study descriptors
    *  @return EC_Normal upon success, an error code otherwise
    */
   OFCondition DB_GetStudyDesc(StudyDescRecord *pStudyDesc);
 
-  /** write study descriptor record to start of index file
-   *  @param pStudyDesc pointer to study record descriptor structure
+  /** write study descriptor records to the study file
+   *  @param pStudyDesc pointer to an array of DB_StudyDescCount() study descriptors
    *  @return EC_Normal upon success, an error code otherwise
    */
   OFCondition DB_StudyDescChange(StudyDescRecord *pStudyDesc);
 
-  /** deactivate index record at given index by setting an empty filename
+  /** deactivate index record at given index by marking it free
    *  @param idx index
    *  @return EC_Normal upon success, an error code otherwise
    */
@@ -387,6 +443,56 @@ private:
       DB_LEVEL        infLevel,
       DB_LEVEL        lowestLevel);
 
+  /** check whether a query key is matched against every candidate record
+   *  by hierarchicalCompare() and can therefore be used for a key index lookup.
+   *  @param tag query key
+   *  @param infLevel highest level of the current information model
+   *  @return OFTrue if the key restricts the result set, OFFalse otherwise
+   */
+  OFBool DB_KeyIndexApplicable(DcmTagKey tag, DB_LEVEL infLevel);
+
+  /** look up the index records that may match the current request list
+   *  in the secondary key index file. Upon success, DB_IdxGetNextCandidate()
+   *  only visits these records, otherwise it falls back to a full scan.
+   *  @param infLevel highest level of the current information model
+   *  @return EC_Normal if a candidate list has been created, an error code otherwise
+   */
+  OFCondition DB_KeyIndexLookup(DB_LEVEL infLevel);
+
+  /// discard the candidate list created by DB_KeyIndexLookup()
+  void DB_KeyIndexFreeCandidates();
+
+  /** get next candidate index record, either from the candidate list created
+   *  by DB_KeyIndexLookup() or, if there is none, by scanning the index file.
+   *  @param idx pointer to index number, updated upon successful return
+   *  @param idxRec pointer to index record structure
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition DB_IdxGetNextCandidate(int *idx, IdxRecord *idxRec);
+
+  /** mark the key index file as being updated. Must be called with
+   *  an exclusive lock held before the index file is modified.
+   *  @return OFTrue if the key index file was consistent with the index file
+   */
+  OFBool DB_KeyIndexBeginUpdate();
+
+  /** add the keys of a new index record to the key index file and mark it
+   *  valid again. The key index file is rebuilt from the index file if it
+   *  was not consistent before the update or if the journal is full.
+   *  @param idx index number of the new record
+   *  @param idxRec new index record
+   *  @param wasConsistent return value of DB_KeyIndexBeginUpdate()
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition DB_KeyIndexCommit(int idx, IdxRecord *idxRec, OFBool wasConsistent);
+
+  /** merge the journal of the key index file into its sorted block.
+   *  @param rebuild if true, ignore the current content and recreate all keys
+   *    from the index file
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition DB_KeyIndexMerge(OFBool rebuild);
+
   /// database handle
   DB_Private_Handle *handle;
 
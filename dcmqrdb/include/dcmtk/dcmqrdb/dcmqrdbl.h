@@ -43,8 +43,21 @@ public:
   ~DcmQueryRetrieveLuceneIndexHandle();
   void printIndexFile(void);
   virtual OFCondition storeRequest(const char* SOPClassUID, const char* SOPInstanceUID, const char* imageFileName, DcmQueryRetrieveDatabaseStatus* status, OFBool isNew = OFTrue);
+  virtual OFCondition storeRequest(const char* SOPClassUID, const char* SOPInstanceUID, const char* imageFileName, DcmDataset* dataset, DcmQueryRetrieveDatabaseStatus* status, OFBool isNew = OFTrue);
+  /** returns the attributes of DcmQRLuceneTagList, which are evaluated by storeRequest()
+   */
+  virtual void getStoreAttributes(OFList<DcmTagKey>& tags);
   static bool indexExists( const OFString &s );
   void setVerbose(bool v);
+
+  /** enables group commit of stored documents. Documents added by storeRequest()
+   *  are kept pending in memory and flushed to the index when either limit is
+   *  reached, instead of reopening the index searcher for every lookup.
+   *  @param maxDocuments flush after this many pending documents, 0 disables the limit
+   *  @param maxMillis flush when the oldest pending document is older than this
+   *    number of milliseconds, 0 disables the limit
+   */
+  void setGroupCommit(unsigned int maxDocuments, int maxMillis);
 private:
   virtual void setIdentifierChecking(OFBool checkFind, OFBool checkMove);
   virtual void setDebugLevel(int debugLevel);
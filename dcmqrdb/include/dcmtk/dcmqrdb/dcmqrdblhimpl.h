@@ -30,6 +30,7 @@
 #define DCMQRDBLHIMPL_H
 
 #include <CLucene.h>
+#include <sys/types.h>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
@@ -41,10 +42,13 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 
 #include "dcmtk/dcmqrdb/lucenestring.h"
 #include "dcmtk/dcmqrdb/luceneenums.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmqrdb/dcmqrfcc.h"
 
 
 
@@ -65,6 +69,9 @@ typedef std::map< DcmTagKey, LuceneString > TagValueMapType;
 typedef std::map< LuceneString, LuceneString > StringValueMapType;
 typedef std::map< DcmTagKey, std::string > TagStdValueMapType;
 typedef std::multimap< DcmTagKey, std::string > TagMultiStdValueMapType;
+typedef std::vector< std::string > FindResponseValuesType;
+typedef std::list< FindResponseValuesType > FindResponseBatchType;
+typedef std::map< LuceneString, size_t > FieldIndexMapType;
 
 struct DicomUID {
   Lucene_LEVEL level;
@@ -75,17 +82,46 @@ struct DicomUID {
 };
 
 typedef set< DicomUID > UIDSetType;
+typedef std::map< LuceneString, std::string > UIDFileNameMapType;
+
+/** process-wide manager for read-only index searchers. It keeps one warmed
+ *  IndexReader per index path which is borrowed by all reader handles and is
+ *  only reopened (incrementally, sharing unchanged segments) when the segment
+ *  generation on disk has changed. A forked child process opens its own reader
+ *  once, since it must not share the file offsets of the parent's index files.
+ */
+class DcmQRLuceneSearcherManager {
+  public:
+  /// returns the current searcher for the given index, reopening it if outdated
+  static shared_ptr<IndexSearcher> acquire( const string &indexPath );
+  /// opens the searcher for the given index and loads its term dictionary and norms
+  static void warm( const string &indexPath );
+  private:
+  struct Entry {
+    shared_ptr<IndexReader> reader;
+    shared_ptr<IndexSearcher> searcher;
+    pid_t pid;
+  };
+  typedef map< string, Entry > EntryMapType;
+  static EntryMapType &entries();
+  static OFMutex &mutex();
+};
 
-class DcmQRDBLHImpl { // TODO: implement Singleton based IndexWriter and IndexSearcher
+class DcmQRDBLHImpl {
   protected:
-  static const std::string storageAreaToIndexPath(const string &storageArea);
   shared_ptr<Analyzer> analyzer;
   shared_ptr<IndexWriter> indexwriter;
   shared_ptr<IndexSearcher> indexsearcher;
   shared_ptr<boost::posix_time::ptime> first_modified;
   UIDSetType newUIDSet; // set of UIDs modified since last searcher flush
+  UIDSetType pendingUIDSet; // UIDs of the documents added since last searcher flush, per level
+  UIDFileNameMapType pendingImageFiles; // file names of the image level documents in pendingUIDSet
+  unsigned int pendingDocuments; // number of documents added since last searcher flush
+  unsigned int groupCommitDocuments; // flush after this many pending documents, 0 = disabled
+  int groupCommitMillis; // flush when oldest pending document is older than this, 0 = disabled
   string getIndexPath(void);
   void flushIndex(bool force=false);
+  bool isPending( const DicomUID &uid ) const;
   public:
   enum Result {
     good,
@@ -93,17 +129,30 @@ class DcmQRDBLHImpl { // TODO: implement Singleton based IndexWriter and IndexSe
   };
   const string storageArea;
   
+  static const std::string storageAreaToIndexPath(const string &storageArea);
   IndexReader& getIndexReader();
   void addDocument( Lucene_LEVEL level, const TagValueMapType &tagDataset, const StringValueMapType &stringDataset=StringValueMapType() );
   bool sopInstanceExists( const LuceneString &sopInstanceUID, string &existingFileName );
   void findQuery(Query* query, int upToDateMillis, const DicomUID &uid);
   void moveQuery(Query* query, int upToDateMillis, const DicomUID &uid);
+  void prepareFindResponses();
+  bool nextFindResponseValues(FindResponseValuesType &values);
+  void clearFindResponses();
+  size_t findResponseCount() const;
 
   scoped_ptr<Document> imageDoc;
+  shared_ptr<IndexSearcher> findResponseSearcher; // searcher findResponseHits belong to
   scoped_ptr<Hits> findResponseHits;
   scoped_ptr<BooleanQuery> findRequest;
   unsigned int findResponseHitCounter;
   TagListType findRequestList;
+  FieldIndexMapType findFieldIndex; // field name -> position in findRequestList
+  scoped_ptr<MapFieldSelector> findFieldSelector; // loads only the fields in findRequestList
+  FindResponseBatchType findResponseBatch; // values of the prefetched responses
+  OFString findCacheKey; // key of the current find in the query result cache, empty if not cached
+  OFList<OFString> findCacheRestrictions; // UIDs the current find is restricted to
+  unsigned long findGeneration; // version of the reader the current find is answered from
+  scoped_ptr<DcmQueryRetrieveFindCacheResult> findCacheResult; // responses collected for the query result cache
   std::string queryLevelString;
   scoped_ptr<Hits> moveResponseHits;
   scoped_ptr<BooleanQuery> moveRequest;
@@ -111,6 +160,8 @@ class DcmQRDBLHImpl { // TODO: implement Singleton based IndexWriter and IndexSe
   const DcmQRLuceneIndexType indexType;
 
   bool checkAndStoreDataForLevel( Lucene_LEVEL level, TagValueMapType &dataset);
+  void setGroupCommit( unsigned int maxDocuments, int maxMillis );
+  void commitIfDue();
   DcmQRDBLHImpl(const string &s, DcmQRLuceneIndexType i, Result &r);
   ~DcmQRDBLHImpl();
   static bool indexExists( const string &s );
@@ -0,0 +1,217 @@
+/*
+ *
+ *  Copyright (C) 1993-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  agent
+ *
+ *  Purpose: class DcmQueryRetrieveFindCache
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#ifndef DCMQRFCC_H
+#define DCMQRFCC_H
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/ofstd/ofstring.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmdata/dctagkey.h"
+
+class DcmDataset;
+class DcmQueryRetrieveFindCacheEntry;
+class DcmQueryRetrieveFindCacheArea;
+
+/// default number of C-FIND results kept in the cache
+#define DEFAULT_FINDCACHE_ENTRIES 32
+
+/// default maximum number of responses of a C-FIND result that is cached
+#define DEFAULT_FINDCACHE_RESPONSES 4096
+
+/** the responses of a C-FIND as kept in the result cache. All responses
+ *  consist of the same attributes; the values of each response are stored
+ *  in the order of the tags list.
+ */
+struct DcmQueryRetrieveFindCacheResult
+{
+  /// attributes of each response
+  OFList<DcmTagKey> tags;
+
+  /// values of the responses, one list per response
+  OFList<OFList<OFString> > responses;
+};
+
+/** process-wide cache of C-FIND results. A result is stored under a key
+ *  derived from the storage area, the SOP class and the normalized query
+ *  identifier. Each storage area carries a generation number that changes
+ *  with every modification of the database. Results are only valid for the
+ *  generation they were computed in, unless the modification has been
+ *  reported with invalidate(), which only drops the results that are
+ *  restricted to instances other than the ones written or removed.
+ *  All methods are thread-safe.
+ */
+class DcmQueryRetrieveFindCache
+{
+public:
+
+  /// destructor
+  ~DcmQueryRetrieveFindCache();
+
+  /// returns the cache used by all database handles of this process
+  static DcmQueryRetrieveFindCache& instance();
+
+  /** set the size of the cache.
+   *  @param maxEntries maximum number of results kept, 0 disables the cache
+   *  @param maxResponses results with more responses are not cached
+   */
+  void setLimits(size_t maxEntries, size_t maxResponses);
+
+  /// returns true if results are cached
+  OFBool enabled();
+
+  /// returns the maximum number of responses of a result that is cached
+  size_t maxResponses();
+
+  /** create the cache key for a C-FIND request. The key consists of the
+   *  SOP class and all attributes of the identifier with leading and trailing
+   *  spaces removed, the Query/Retrieve Level converted to upper case.
+   *  @param SOPClassUID SOP class of the C-FIND request
+   *  @param identifiers query identifier
+   *  @param key cache key returned in this parameter
+   */
+  static void makeKey(const char *SOPClassUID, DcmDataset *identifiers, OFString& key);
+
+  /** determine the instances a C-FIND request is restricted to by single
+   *  valued unique keys at or above the query level. A result with such
+   *  restrictions can only change if one of the matching instances changes.
+   *  @param identifiers query identifier
+   *  @param restrictions list of "(gggg,eeee)=value" strings returned
+   *    in this parameter, empty if the query is not restricted
+   */
+  static void getRestrictions(DcmDataset *identifiers, OFList<OFString>& restrictions);
+
+  /** create the string for a unique key value that is used in restriction
+   *  and invalidation lists.
+   *  @param tag unique key
+   *  @param value value of the unique key
+   *  @return "(gggg,eeee)=value"
+   */
+  static OFString makeRestriction(const DcmTagKey& tag, const char *value);
+
+  /** look up a C-FIND result. If the database generation differs from the
+   *  one the cache knows for the storage area, all results of the storage
+   *  area are discarded first.
+   *  @param storageArea storage area the query is performed on
+   *  @param generation current database generation of the storage area
+   *  @param key cache key created by makeKey()
+   *  @param result copy of the cached result returned in this parameter
+   *  @return OFTrue if the result was found, OFFalse otherwise
+   */
+  OFBool lookup(const OFString& storageArea, unsigned long generation,
+    const OFString& key, DcmQueryRetrieveFindCacheResult& result);
+
+  /** add a C-FIND result. The result is dropped if the database has been
+   *  modified since the preceding lookup() with the same generation.
+   *  @param storageArea storage area the query was performed on
+   *  @param generation database generation the result was computed in
+   *  @param key cache key created by makeKey()
+   *  @param restrictions restrictions determined by getRestrictions()
+   *  @param result result to be cached
+   */
+  void insert(const OFString& storageArea, unsigned long generation,
+    const OFString& key, const OFList<OFString>& restrictions,
+    const DcmQueryRetrieveFindCacheResult& result);
+
+  /** report a modification of the database. Results that may be affected,
+   *  i.e. that are not restricted or whose restrictions all appear in the
+   *  list of written unique keys, are discarded. If the cache did not know
+   *  the old generation, all results of the storage area are discarded.
+   *  @param storageArea storage area that has been modified
+   *  @param oldGeneration database generation before the modification
+   *  @param newGeneration database generation after the modification
+   *  @param written unique keys of the instances added or removed,
+   *    as created by makeRestriction()
+   */
+  void invalidate(const OFString& storageArea, unsigned long oldGeneration,
+    unsigned long newGeneration, const OFList<OFString>& written);
+
+  /** get the cache statistics since the start of the process
+   *  @param hits number of C-FIND requests answered from the cache
+   *  @param misses number of lookups that did not find a result
+   *  @param invalidated number of results discarded due to modifications
+   */
+  void getStatistics(unsigned long& hits, unsigned long& misses, unsigned long& invalidated);
+
+private:
+
+  /// private constructor, use instance()
+  DcmQueryRetrieveFindCache();
+
+  /// private undefined copy constructor
+  DcmQueryRetrieveFindCache(const DcmQueryRetrieveFindCache& other);
+
+  /// private undefined assignment operator
+  DcmQueryRetrieveFindCache& operator=(const DcmQueryRetrieveFindCache& other);
+
+  /** find the storage area with the given name. Mutex must be locked.
+   *  @return pointer to the storage area, NULL if unknown
+   */
+  DcmQueryRetrieveFindCacheArea *findArea(const OFString& storageArea);
+
+  /** bring the generation known for the storage area up to date, discarding
+   *  all results of the storage area if it has changed. Mutex must be locked.
+   *  @return OFTrue if the generation was already up to date
+   */
+  OFBool synchronize(const OFString& storageArea, unsigned long generation);
+
+  /// cached results, most recently used first
+  OFList<DcmQueryRetrieveFindCacheEntry *> entries_;
+
+  /// storage areas known to the cache along with their generation
+  OFList<DcmQueryRetrieveFindCacheArea *> areas_;
+
+  /// maximum number of entries
+  size_t maxEntries_;
+
+  /// maximum number of responses per entry
+  size_t maxResponses_;
+
+  /// statistics
+  unsigned long hits_;
+  unsigned long misses_;
+  unsigned long invalidated_;
+
+  /// protects all members
+  OFMutex mutex_;
+};
+
+#endif
+
+/*
+ * CVS Log
+ * $Log$
+ *
+ */
@@ -130,10 +130,15 @@ enum DB_KEY_CLASS
 
 #define DBC_MAXSTRING           256
 
-#define MAX_MAX_STUDIES         DB_UpperMaxStudies
 #define MAX_NUMBER_OF_IMAGES    10000
 #define SIZEOF_IDXRECORD        (sizeof (IdxRecord))
-#define SIZEOF_STUDYDESC        (sizeof (StudyDescRecord) * MAX_MAX_STUDIES)
+
+/* number of study descriptors at the start of a version 1 index file */
+#define LEGACY_MAX_STUDIES      500
+#define SIZEOF_LEGACY_STUDYDESC (sizeof (StudyDescRecord) * LEGACY_MAX_STUDIES)
+
+/* current version of the index file format */
+#define DB_INDEXFILE_VERSION    2
 
 /** this class provides a primitive interface for handling a flat DICOM element,
  *  similar to DcmElement, but only for use within the database module
@@ -193,9 +198,18 @@ struct DB_UidList
 struct DB_CounterList
 {
     int idxCounter ;
+    char SOPClassUID [UI_MAX_LENGTH+1] ;
+    char SOPInstanceUID [UI_MAX_LENGTH+1] ;
+    char filename [DBC_MAXSTRING+1] ;
     struct DB_CounterList *next ;
 };
 
+struct DB_ResponseList
+{
+    DB_ElementList *elements ;
+    struct DB_ResponseList *next ;
+};
+
 struct DB_FindAttr
 {
     DcmTagKey tag ;
@@ -213,6 +227,7 @@ struct DB_Private_Handle
     int pidx ;
     DB_ElementList *findRequestList ;
     DB_ElementList *findResponseList ;
+    DB_ResponseList *pendingResponseList ;
     DB_LEVEL queryLevel ;
     char indexFilename[DBC_MAXSTRING+1] ;
     char storageArea[DBC_MAXSTRING+1] ;
@@ -223,6 +238,16 @@ struct DB_Private_Handle
     int NumberRemainOperations ;
     DB_QUERY_CLASS rootLevel ;
     DB_UidList *uidList ;
+    int pkey ;
+    int plck ;
+    int pstd ;
+    int studyDescCount ;
+    char *scanBuffer ;
+    long scanStart ;
+    long scanLength ;
+    int *candidateList ;
+    int candidateCount ;
+    int candidatePos ;
 };
 
 struct StudyDescRecord 
@@ -295,6 +320,24 @@ struct ImagesofStudyArray
 
 #define NBPARAMETERS                             41
 
+/* the following constants define the key types stored
+ * in the secondary key index file (DBKEYINDEXFILE).
+ * Each index record contributes exactly one key of each type.
+ */
+
+#define KEYINDEX_PatientID                        0
+#define KEYINDEX_StudyDate                        1
+#define KEYINDEX_StudyInstanceUID                 2
+#define KEYINDEX_SeriesInstanceUID                3
+#define KEYINDEX_SOPInstanceUID                   4
+
+#define NBKEYINDEXKEYS                            5
+
+/* maximum number of unsorted key records appended to the
+ * key index file before they are merged into the sorted block
+ */
+#define KEYINDEX_MAX_JOURNAL                   1024
+
 
 /** this class manages an instance entry of the index file.
  *  Each instance/image record within the index.dat file is
@@ -370,6 +413,63 @@ private:
 };
 
 
+/** header of the index file. In the current format (DB_INDEXFILE_VERSION),
+ *  the header is followed by a heap of variable length index records, each of
+ *  which starts with a DB_IdxRecordHeader. The number of an index record is
+ *  its byte offset in the index file, which never changes once the record
+ *  has been allocated. Files without this header are in the version 1 format,
+ *  i.e. a block of SIZEOF_LEGACY_STUDYDESC bytes followed by IdxRecord copies.
+ *  generation is incremented whenever an index record is added or removed,
+ *  so that cached query results of other processes can be detected as stale.
+ */
+struct DB_IndexFileHeader
+{
+    char    magic [8] ;
+    Uint32  version ;
+    Uint32  generation ;
+};
+
+/** header of a variable length index record. capacity is the total size of
+ *  the record including this header. length is the size of the encoded record
+ *  following the header, zero if the record is free.
+ */
+struct DB_IdxRecordHeader
+{
+    Uint32  capacity ;
+    Uint32  length ;
+};
+
+#define SIZEOF_INDEXFILEHEADER  (sizeof (DB_IndexFileHeader))
+#define SIZEOF_IDXRECORDHEADER  (sizeof (DB_IdxRecordHeader))
+
+/** header of the secondary key index file. The file consists of this header,
+ *  a block of sortedCount key records sorted by key type, key and record index,
+ *  followed by journalCount unsorted key records that have been appended since
+ *  the last merge. The header is only marked valid while the key records are
+ *  consistent with an index file of size indexFileSize.
+ */
+struct DB_KeyIndexHeader
+{
+    char    magic [8] ;
+    int     valid ;
+    int     sortedCount ;
+    int     journalCount ;
+    long    indexFileSize ;
+};
+
+/** a single entry of the secondary key index file which maps a normalized
+ *  key value to the number of an index record in the index file.
+ */
+struct DB_KeyIndexRecord
+{
+    int     keyType ;
+    int     idx ;
+    char    key [LO_MAX_LENGTH+1] ;
+};
+
+#define SIZEOF_KEYINDEXHEADER   (sizeof (DB_KeyIndexHeader))
+#define SIZEOF_KEYINDEXRECORD   (sizeof (DB_KeyIndexRecord))
+
 #endif
 
 /*
@@ -82,6 +82,9 @@ public:
   /// block size for file padding, pad DICOM files to multiple of this value
   OFCmdUnsignedInt  	filepad_;
 
+  /// number of C-FIND results kept in the query result cache, 0 = disabled
+  int         		findCacheEntries_;
+
   /// group length encoding when writing DICOM files
   E_GrpLenEncoding  	groupLength_;
 
@@ -97,6 +100,17 @@ public:
   /// maximum PDU size
   OFCmdUnsignedInt   	maxPDU_;
 
+  /** number of associations to the move destination across which the
+   *  C-STORE sub-operations of a C-MOVE are spread (requires thread support)
+   */
+  int         		moveAssociations_;
+
+  /** number of files loaded ahead of the C-STORE sub-operations of a
+   *  C-MOVE by background threads, 0 = load each file when it is sent
+   *  (requires thread support)
+   */
+  int         		movePrefetch_;
+
   /// pointer to network structure used for requesting C-STORE sub-associations
   T_ASC_Network *	net_;
 
@@ -140,6 +154,12 @@ public:
   /// single process mode
   OFBool      		singleProcess_;
 
+  /** multi-threaded mode: serve associations in a pool of worker threads
+   *  sharing one database handle factory instead of forking, bounded by
+   *  maxAssociations_.
+   */
+  OFBool      		multiThreaded_;
+
   /// support for patient root q/r model
   OFBool      		supportPatientRoot_;
 
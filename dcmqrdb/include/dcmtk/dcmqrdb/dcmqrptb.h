@@ -93,13 +93,15 @@ public:
    */
   OFBool haveProcessWithWriteAccess(const char *calledAETitle) const;
 
-private:
-
-  /** remove the process with the given process ID from the table
+  /** remove the process with the given process ID from the table.
+   *  In multi-threaded mode, pseudo process IDs identify the associations
+   *  served by the worker threads.
    *  @param pid process ID
    */
   void removeProcessFromTable(int pid);
 
+private:
+
   /// the list of process entries maintained by this object.
   OFList<DcmQueryRetrieveProcessSlot *> table_;
 };
@@ -0,0 +1,199 @@
+/*
+ *
+ *  Copyright (C) 1993-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  agent
+ *
+ *  Purpose: class DcmQueryRetrieveStoreScanner
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#ifndef DCMQRSCN_H
+#define DCMQRSCN_H
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/ofstd/ofstring.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/dcmdata/dctagkey.h"
+#include "dcmtk/dcmdata/dcxfer.h"
+
+class DcmDataset;
+struct DcmQueryRetrieveStoreScannerContainer;
+
+/// maximum length of an attribute value extracted by DcmQueryRetrieveStoreScanner
+#define STORESCANNER_MAX_VALUE_LENGTH 65536
+
+/// maximum nesting level of sequences supported by DcmQueryRetrieveStoreScanner
+#define STORESCANNER_MAX_DEPTH 64
+
+/** extracts selected attributes from a data set while it is received
+ *  through a C-STORE operation and written to a file. The data set is passed
+ *  to the scanner fragment by fragment in the order received from the network.
+ *  Only the element headers are parsed, the values of all attributes except
+ *  the selected ones are skipped without being copied. The extracted attributes
+ *  are sufficient for registering the object in the database, so the file does
+ *  not need to be read again after the object has been received.
+ *  Only top-level attributes with a string VR are extracted. In addition, the
+ *  scanner notes whether a non-empty Digital Signatures Sequence is present
+ *  on any nesting level, since this is part of the instance description.
+ */
+class DcmQueryRetrieveStoreScanner
+{
+public:
+
+  /** constructor
+   *  @param xfer transfer syntax of the data set to be received
+   *  @param tags attributes to be extracted
+   */
+  DcmQueryRetrieveStoreScanner(E_TransferSyntax xfer, const OFList<DcmTagKey>& tags);
+
+  /// destructor
+  ~DcmQueryRetrieveStoreScanner();
+
+  /** parse the next fragment of the data set
+   *  @param data pointer to fragment
+   *  @param length length of fragment in bytes
+   */
+  void addFragment(const void *data, Uint32 length);
+
+  /** check whether the data set received so far could be parsed. The
+   *  scanner does not support deflated transfer syntaxes and data sets
+   *  that do not conform to the DICOM encoding rules. In this case, the
+   *  caller must read the attributes from the file.
+   *  @return OFTrue if the scanner is in a consistent state
+   */
+  OFBool good() const;
+
+  /** check whether the complete data set has been parsed, i.e. all
+   *  fragments have been passed to the scanner and all elements,
+   *  sequences and items are complete.
+   *  @return OFTrue if the data set is complete and has been parsed successfully
+   */
+  OFBool complete() const;
+
+  /** create a data set containing the extracted attributes. The data set
+   *  can be passed to DcmQueryRetrieveDatabaseHandle::storeRequest() in place
+   *  of the file that has been received.
+   *  @return new data set, NULL if the scanner is not complete().
+   *    The caller is responsible for deleting the data set.
+   */
+  DcmDataset *createDataset() const;
+
+  /** callback function suitable for DIMSE_storeProvider().
+   *  @param callbackData pointer to DcmQueryRetrieveStoreScanner
+   *  @param data pointer to fragment
+   *  @param length length of fragment in bytes
+   */
+  static void storeDataCallback(void *callbackData, const void *data, Uint32 length);
+
+private:
+
+  /// private undefined copy constructor
+  DcmQueryRetrieveStoreScanner(const DcmQueryRetrieveStoreScanner& other);
+
+  /// private undefined assignment operator
+  DcmQueryRetrieveStoreScanner& operator=(const DcmQueryRetrieveStoreScanner& other);
+
+  /** parse the element, item or delimitation header that is in the header
+   *  buffer, if complete, and set up the handling of the value.
+   *  @return OFTrue if a complete header has been parsed
+   */
+  OFBool parseHeader();
+
+  /** enter a sequence, item or encapsulated pixel data.
+   *  @param type type of the container
+   *  @param length value length of the container, may be undefined
+   *  @param signatures OFTrue if the container is the Digital Signatures Sequence
+   */
+  void push(int type, Uint32 length, OFBool signatures);
+
+  /// leave all containers of defined length that end at the current position
+  void popComplete();
+
+  /// read a 16 bit number from the header buffer in the byte order of the data set
+  Uint16 getUint16(size_t offset) const;
+
+  /// read a 32 bit number from the header buffer in the byte order of the data set
+  Uint32 getUint32(size_t offset) const;
+
+  /// returns true if the given attribute is to be extracted
+  OFBool isSelected(const DcmTagKey& tag) const;
+
+  /// attributes to be extracted
+  OFList<DcmTagKey> tags_;
+
+  /// values of the attributes extracted so far
+  OFList<DcmTagKey> foundTags_;
+  OFList<OFString> foundValues_;
+
+  /// true if the data set is encoded with explicit VR
+  OFBool explicitVR_;
+
+  /// true if the data set is encoded in big endian byte order
+  OFBool bigEndian_;
+
+  /// false if the data set cannot be parsed
+  OFBool good_;
+
+  /// header of the current element, item or delimitation item
+  Uint8 header_[12];
+
+  /// number of bytes in header_
+  size_t headerLength_;
+
+  /// number of value bytes of the current element that are still to be skipped or copied
+  Uint32 valueRemaining_;
+
+  /// true if the value of the current element is copied to value_
+  OFBool copyValue_;
+
+  /// value of the current element if selected
+  OFString value_;
+
+  /// tag of the current element if selected
+  DcmTagKey valueTag_;
+
+  /// sequences, items and encapsulated pixel data the current element is nested in
+  DcmQueryRetrieveStoreScannerContainer *containers_;
+
+  /// number of entries in containers_
+  size_t depth_;
+
+  /// number of bytes of the data set parsed so far
+  unsigned long position_;
+
+  /// true if a non-empty Digital Signatures Sequence has been found
+  OFBool signed_;
+};
+
+#endif
+
+/*
+ * CVS Log
+ * $Log$
+ *
+ */
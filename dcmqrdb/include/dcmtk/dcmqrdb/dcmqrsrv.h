@@ -39,11 +39,14 @@
 #include "dcmtk/dcmnet/assoc.h"
 #include "dcmtk/dcmnet/dimse.h"
 #include "dcmtk/dcmqrdb/dcmqrptb.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofthread.h"
 
 class DcmQueryRetrieveConfig;
 class DcmQueryRetrieveOptions;
 class DcmQueryRetrieveDatabaseHandle;
 class DcmQueryRetrieveDatabaseHandleFactory;
+class DcmQueryRetrieveSCPWorker;
 
 /// enumeration describing reasons for refusing an association request
 enum CTN_RefuseReason
@@ -78,12 +81,13 @@ public:
     const DcmQueryRetrieveOptions& options,
     const DcmQueryRetrieveDatabaseHandleFactory& factory);
 
-  /// destructor
-  virtual ~DcmQueryRetrieveSCP() { }
+  /// destructor, terminates the worker threads in multi-threaded mode
+  virtual ~DcmQueryRetrieveSCP();
 
   /** wait for incoming A-ASSOCIATE requests, perform association negotiation
    *  and serve the requests. May fork child processes depending on availability
-   *  of the fork() system function and configuration options.
+   *  of the fork() system function and configuration options, or hand the
+   *  association over to a pool of worker threads in multi-threaded mode.
    *  @param theNet network structure for listen socket
    *  @return EC_Normal if successful, an error code otherwise
    */
@@ -99,13 +103,43 @@ public:
     OFBool dbCheckMoveIdentifier,
     OFBool dbDebug);
 
-  /** clean up terminated child processes.
+  /** clean up terminated child processes, or associations completed by
+   *  the worker threads in multi-threaded mode.
    *  @param verbose verbose mode flag
    */
   void cleanChildren(OFBool verbose = OFFalse);
 
 private:
 
+  friend class DcmQueryRetrieveSCPWorker;
+
+#ifdef WITH_THREADS
+  /// an association handed over to the worker threads
+  struct WorkerJob
+  {
+    /// association to be handled, NULL terminates the worker
+    T_ASC_Association *assoc;
+
+    /// pseudo process ID of the association in the process table
+    int id;
+  };
+
+  /** start the pool of worker threads if not yet running.
+   *  The pool size is given by the maximum number of associations.
+   */
+  void startWorkers();
+
+  /** queue an acknowledged association for the worker threads
+   *  @param assoc association, ownership is transferred
+   */
+  void queueAssociation(T_ASC_Association *assoc);
+
+  /** main loop of a worker thread, serves queued associations
+   *  until a terminating NULL association is received.
+   */
+  void runWorker();
+#endif
+
   /** perform association negotiation for an incoming A-ASSOCIATE request based
    *  on the SCP configuration and option flags. No A-ASSOCIATE response is generated,
    *  this is left to the caller.
@@ -176,6 +210,26 @@ private:
 
   /// SCP configuration options
   const DcmQueryRetrieveOptions& options_;
+
+#ifdef WITH_THREADS
+  /// worker threads, only used in multi-threaded mode
+  OFList<DcmQueryRetrieveSCPWorker *> workers_;
+
+  /// associations waiting for a worker thread
+  OFList<WorkerJob> pendingJobs_;
+
+  /// IDs of associations completed by the worker threads, not yet removed from the process table
+  OFList<int> finishedJobs_;
+
+  /// next pseudo process ID for the process table
+  int nextJobId_;
+
+  /// mutex protecting pendingJobs_ and finishedJobs_
+  OFMutex jobMutex_;
+
+  /// semaphore counting the entries in pendingJobs_
+  OFSemaphore jobSemaphore_;
+#endif
 };
 
 #endif
@@ -41,6 +41,7 @@
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmqrdb/dcmqrdbs.h"
 #include "dcmtk/dcmqrdb/dcmqrdba.h"
+#include "dcmtk/dcmqrdb/dcmqrfcc.h"
 
 
 void DcmQueryRetrieveFindContext::callbackHandler(
@@ -67,6 +68,12 @@ void DcmQueryRetrieveFindContext::callbackHandler(
 	    DcmQueryRetrieveOptions::errmsg("findSCP: Database: startFindRequest Failed (%s):",
 		DU_cfindStatusString(dbStatus.status()));
         }
+	if (options_.verbose_ && DcmQueryRetrieveFindCache::instance().enabled()) {
+	    unsigned long hits, misses, invalidated;
+	    DcmQueryRetrieveFindCache::instance().getStatistics(hits, misses, invalidated);
+	    printf("Find SCP query result cache: %lu hits, %lu misses, %lu invalidated\n",
+		hits, misses, invalidated);
+	}
     }
     
     /* only cancel if we have pending responses */
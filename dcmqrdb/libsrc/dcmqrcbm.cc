@@ -49,6 +49,42 @@ BEGIN_EXTERN_C
 END_EXTERN_C
 
 
+/** worker thread loading files or performing C-STORE sub-operations for
+ *  a pipelined DcmQueryRetrieveMoveContext. Internal use only.
+ */
+class DcmQueryRetrieveMoveWorker: public OFThread
+{
+public:
+  /** constructor
+   *  @param context move context whose sub-operations are processed
+   *  @param assoc sub-association for a sending thread, NULL for a loading thread.
+   *    A sending thread opens the sub-association itself if *assoc is NULL.
+   */
+  DcmQueryRetrieveMoveWorker(DcmQueryRetrieveMoveContext& context, T_ASC_Association **assoc)
+  : OFThread()
+  , context_(context)
+  , assoc_(assoc)
+  {
+  }
+
+protected:
+  /// thread main function
+  virtual void run()
+  {
+#ifdef WITH_THREADS
+    if (assoc_) context_.runSender(assoc_); else context_.runLoader();
+#endif
+  }
+
+private:
+  /// move context whose sub-operations are processed
+  DcmQueryRetrieveMoveContext& context_;
+
+  /// sub-association used by a sending thread
+  T_ASC_Association **assoc_;
+};
+
+
 static void moveSubOpProgressCallback(void *callbackData, 
     T_DIMSE_StoreProgress *progress,
     T_DIMSE_C_StoreRQ * /*req*/)
@@ -72,6 +108,18 @@ static void moveSubOpProgressCallback(void *callbackData,
   }
 }
 
+DcmQueryRetrieveMoveContext::~DcmQueryRetrieveMoveContext()
+{
+#ifdef WITH_THREADS
+    /* the move provider gives up without a final response if the association is lost */
+    pipelineMutex.lock();
+    pipelineCancelled = OFTrue;
+    pipelineMutex.unlock();
+    stopPipeline();
+    closeSubAssociation();
+#endif
+}
+
 OFBool DcmQueryRetrieveMoveContext::isVerbose() const 
 { 
   return options_.verbose_ ? OFTrue : OFFalse; 
@@ -113,19 +161,42 @@ void DcmQueryRetrieveMoveContext::callbackHandler(
 	        /* failed to build association, must fail move */
 		failAllSubOperations(&dbStatus);
 	    }
+#ifdef WITH_THREADS
+	    else if (isPipelined()) {
+	        /* hand all sub-operations over to the worker threads */
+		startPipeline(&dbStatus);
+	    }
+#endif
         }
     }
     
-    /* only cancel if we have pending status */
-    if (cancelled && dbStatus.status() == STATUS_Pending) {
-	dbHandle.cancelMoveRequest(&dbStatus);
-    }
+#ifdef WITH_THREADS
+    if (pipelineActive) {
+        /* cancellation is handled by the worker threads */
+	if (dbStatus.status() == STATUS_Pending) {
+	    waitPipeline(cancelled, &dbStatus);
+	}
+    } else
+#endif
+    {
+	/* only cancel if we have pending status */
+	if (cancelled && dbStatus.status() == STATUS_Pending) {
+	    dbHandle.cancelMoveRequest(&dbStatus);
+	}
 
-    if (dbStatus.status() == STATUS_Pending) {
-        moveNextImage(&dbStatus);
+	if (dbStatus.status() == STATUS_Pending) {
+	    moveNextImage(&dbStatus);
+	}
     }
 
     if (dbStatus.status() != STATUS_Pending) {
+#ifdef WITH_THREADS
+	/*
+	 * Terminate the worker threads (if any).
+	 */
+	stopPipeline();
+#endif
+
 	/*
 	 * Tear down sub-association (if it exists).
 	 */
@@ -158,11 +229,21 @@ void DcmQueryRetrieveMoveContext::callbackHandler(
     }
 
     /* set response status */
+#ifdef WITH_THREADS
+    /* the worker threads keep counting while this response is sent */
+    pipelineMutex.lock();
+    if (pipelineActive) {
+	nRemaining = subOpTotal - nCompleted - nFailed - nWarning;
+    }
+#endif
     response->DimseStatus = dbStatus.status();
     response->NumberOfRemainingSubOperations = nRemaining;
     response->NumberOfCompletedSubOperations = nCompleted;
     response->NumberOfFailedSubOperations = nFailed;
     response->NumberOfWarningSubOperations = nWarning;
+#ifdef WITH_THREADS
+    pipelineMutex.unlock();
+#endif
     *stDetail = dbStatus.extractStatusDetail();
 
     if (options_.verbose_) {
@@ -205,7 +286,23 @@ void DcmQueryRetrieveMoveContext::addFailedUIDInstance(const char *sopInstance)
     }
 }
 
-OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_UI sopInstance, char *fname)
+void DcmQueryRetrieveMoveContext::countSubOp(DIC_US& counter, const char *failedSOPInstance)
+{
+#ifdef WITH_THREADS
+    /* sub-operations may be performed by several worker threads */
+    pipelineMutex.lock();
+#endif
+    counter++;
+    if (failedSOPInstance != NULL) {
+	addFailedUIDInstance(failedSOPInstance);
+    }
+#ifdef WITH_THREADS
+    pipelineMutex.unlock();
+#endif
+}
+
+OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(T_ASC_Association *assoc,
+    DIC_UI sopClass, DIC_UI sopInstance, char *fname, DcmDataset *dataset)
 {
     OFCondition cond = EC_Normal;
     T_DIMSE_C_StoreRQ req;
@@ -215,32 +312,32 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
     DcmDataset *stDetail = NULL;
 
 #ifdef LOCK_IMAGE_FILES
-    /* shared lock image file */
-    int lockfd;
+    /* shared lock image file, a data set loaded ahead is already in memory */
+    int lockfd = -1;
+    if (dataset == NULL) {
 #ifdef O_BINARY
-    lockfd = open(fname, O_RDONLY | O_BINARY, 0666);
+	lockfd = open(fname, O_RDONLY | O_BINARY, 0666);
 #else
-    lockfd = open(fname, O_RDONLY , 0666);
+	lockfd = open(fname, O_RDONLY , 0666);
 #endif
-    if (lockfd < 0) {
-        /* due to quota system the file could have been deleted */
-	DcmQueryRetrieveOptions::errmsg("Move SCP: storeSCU: [file: %s]: %s", 
-	    fname, strerror(errno));
-	nFailed++;
-	addFailedUIDInstance(sopInstance);
-	return EC_Normal;
-    }
-    dcmtk_flock(lockfd, LOCK_SH);
+	if (lockfd < 0) {
+	    /* due to quota system the file could have been deleted */
+	    DcmQueryRetrieveOptions::errmsg("Move SCP: storeSCU: [file: %s]: %s", 
+		fname, strerror(errno));
+	    countSubOp(nFailed, sopInstance);
+	    return EC_Normal;
+	}
+	dcmtk_flock(lockfd, LOCK_SH);
+    }
 #endif
 
-    msgId = subAssoc->nextMsgID++;
+    msgId = assoc->nextMsgID++;
  
     /* which presentation context should be used */
-    presId = ASC_findAcceptedPresentationContextID(subAssoc,
+    presId = ASC_findAcceptedPresentationContextID(assoc,
         sopClass);
     if (presId == 0) {
-	nFailed++;
-	addFailedUIDInstance(sopInstance);
+	countSubOp(nFailed, sopInstance);
 	DcmQueryRetrieveOptions::errmsg("Move SCP: storeSCU: [file: %s] No presentation context for: (%s) %s", 
 	    fname, dcmSOPClassUIDToModality(sopClass), sopClass);
 	return DIMSE_NOVALIDPRESENTATIONCONTEXTID;
@@ -260,15 +357,17 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
 	    msgId, dcmSOPClassUIDToModality(sopClass));
     }
 
-    cond = DIMSE_storeUser(subAssoc, presId, &req,
-        fname, NULL, moveSubOpProgressCallback, this, 
+    cond = DIMSE_storeUser(assoc, presId, &req,
+        (dataset == NULL) ? fname : NULL, dataset, moveSubOpProgressCallback, this, 
 	options_.blockMode_, options_.dimse_timeout_, 
 	&rsp, &stDetail);
 	
 #ifdef LOCK_IMAGE_FILES
     /* unlock image file */
-    dcmtk_flock(lockfd, LOCK_UN);
-    close(lockfd);
+    if (lockfd >= 0) {
+	dcmtk_flock(lockfd, LOCK_UN);
+	close(lockfd);
+    }
 #endif
 	
     if (cond.good()) {
@@ -278,22 +377,20 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
         }
 	if (rsp.DimseStatus == STATUS_Success) {
 	    /* everything ok */
-	    nCompleted++;
+	    countSubOp(nCompleted, NULL);
 	} else if ((rsp.DimseStatus & 0xf000) == 0xb000) {
 	    /* a warning status message */
-	    nWarning++;
+	    countSubOp(nWarning, NULL);
 	    DcmQueryRetrieveOptions::errmsg("Move SCP: Store Waring: Response Status: %s", 
 		DU_cstoreStatusString(rsp.DimseStatus));
 	} else {
-	    nFailed++;
-	    addFailedUIDInstance(sopInstance);
+	    countSubOp(nFailed, sopInstance);
 	    /* print a status message */
 	    DcmQueryRetrieveOptions::errmsg("Move SCP: Store Failed: Response Status: %s", 
 		DU_cstoreStatusString(rsp.DimseStatus));
 	}
     } else {
-	nFailed++;
-	addFailedUIDInstance(sopInstance);
+	countSubOp(nFailed, sopInstance);
 	DcmQueryRetrieveOptions::errmsg("Move SCP: storeSCU: Store Request Failed:");
 	DimseCondition::dump(cond);
     }
@@ -309,13 +406,6 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
 
 OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *request)
 {
-    OFCondition cond = EC_Normal;
-    DIC_NODENAME dstHostName;
-    DIC_NODENAME dstHostNamePlusPort;
-    int dstPortNumber;
-    DIC_NODENAME localHostName;
-    T_ASC_Parameters *params;
-
     strcpy(dstAETitle, request->MoveDestination);
 
     /*
@@ -331,8 +421,24 @@ OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *r
 
     ASC_getPresentationAddresses(origAssoc->params, origHostName, NULL);
 
+    OFCondition cond = openSubAssociation(&subAssoc);
+    if (cond.good()) {
+	assocStarted = OFTrue;
+    }    
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveMoveContext::openSubAssociation(T_ASC_Association **assoc)
+{
+    OFCondition cond = EC_Normal;
+    DIC_NODENAME dstHostName;
+    DIC_NODENAME dstHostNamePlusPort;
+    int dstPortNumber;
+    DIC_NODENAME localHostName;
+    T_ASC_Parameters *params;
+
     if (!mapMoveDestination(origHostName, origAETitle,
-	request->MoveDestination, dstHostName, &dstPortNumber)) {
+	dstAETitle, dstHostName, &dstPortNumber)) {
 	return APP_INVALIDPEER;
     }
     if (cond.good()) {
@@ -363,7 +469,7 @@ OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *r
 	if (options_.verbose_)
 	    printf("Requesting Sub-Association\n");
 	cond = ASC_requestAssociation(options_.net_, params,
-				      &subAssoc);
+				      assoc);
 	if (cond.bad()) {
 	    if (cond == DUL_ASSOCIATIONREJECTED) {
 		T_ASC_RejectParameters rej;
@@ -380,37 +486,44 @@ OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *r
 	}
     }
 
-    if (cond.good()) {
-	assocStarted = OFTrue;
-    }    
+    if (cond.bad() && (*assoc != NULL)) {
+	ASC_dropAssociation(*assoc);
+	ASC_destroyAssociation(assoc);
+    }
     return cond;
 }
 
-OFCondition DcmQueryRetrieveMoveContext::closeSubAssociation()
+OFCondition DcmQueryRetrieveMoveContext::releaseSubAssociation(T_ASC_Association **assoc)
 {
     OFCondition cond = EC_Normal;
 
-    if (subAssoc != NULL) {
+    if (*assoc != NULL) {
 	/* release association */
 	if (options_.verbose_)
 	    printf("Releasing Sub-Association\n");
-	cond = ASC_releaseAssociation(subAssoc);
+	cond = ASC_releaseAssociation(*assoc);
 	if (cond.bad()) {
 	    DcmQueryRetrieveOptions::errmsg("moveSCP: Sub-Association Release Failed:");
 	    DimseCondition::dump(cond);
 	}
-	cond = ASC_dropAssociation(subAssoc);
+	cond = ASC_dropAssociation(*assoc);
 	if (cond.bad()) {
 	    DcmQueryRetrieveOptions::errmsg("moveSCP: Sub-Association Drop Failed:");
 	    DimseCondition::dump(cond);
 	}
-	cond = ASC_destroyAssociation(&subAssoc);
+	cond = ASC_destroyAssociation(assoc);
 	if (cond.bad()) {
 	    DcmQueryRetrieveOptions::errmsg("moveSCP: Sub-Association Destroy Failed:");
 	    DimseCondition::dump(cond);
 	}
 
     }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveMoveContext::closeSubAssociation()
+{
+    OFCondition cond = releaseSubAssociation(&subAssoc);
 
     if (assocStarted) {
 	assocStarted = OFFalse;
@@ -443,8 +556,8 @@ void DcmQueryRetrieveMoveContext::moveNextImage(DcmQueryRetrieveDatabaseStatus *
 
     if (dbStatus->status() == STATUS_Pending) {
 	/* perform sub-op */
-	cond = performMoveSubOp(subImgSOPClass,
-	    subImgSOPInstance, subImgFileName);
+	cond = performMoveSubOp(subAssoc, subImgSOPClass,
+	    subImgSOPInstance, subImgFileName, NULL);
 	if (cond != EC_Normal) {
 	    DcmQueryRetrieveOptions::errmsg("moveSCP: Move Sub-Op Failed:");
 	    DimseCondition::dump(cond);
@@ -453,6 +566,257 @@ void DcmQueryRetrieveMoveContext::moveNextImage(DcmQueryRetrieveDatabaseStatus *
     }
 }
 
+#ifdef WITH_THREADS
+
+OFBool DcmQueryRetrieveMoveContext::isPipelined() const
+{
+    return (options_.movePrefetch_ > 0 || options_.moveAssociations_ > 1) ? OFTrue : OFFalse;
+}
+
+OFBool DcmQueryRetrieveMoveContext::startWorker(T_ASC_Association **assoc)
+{
+    DcmQueryRetrieveMoveWorker *worker = new DcmQueryRetrieveMoveWorker(*this, assoc);
+    int result = worker->start();
+    if (result != 0) {
+	OFString err;
+	OFThread::errorstr(err, result);
+	DcmQueryRetrieveOptions::errmsg("moveSCP: Cannot create worker thread: %s", err.c_str());
+	delete worker;
+	return OFFalse;
+    }
+    workers.push_back(worker);
+    return OFTrue;
+}
+
+void DcmQueryRetrieveMoveContext::startPipeline(DcmQueryRetrieveDatabaseStatus * dbStatus)
+{
+    OFCondition dbcond = EC_Normal;
+    MoveSubOp *subOp = NULL;
+    DIC_US remaining = 0;
+
+    /* the database handle is not shared with the worker threads, fetch all sub-operations now */
+    while (dbStatus->status() == STATUS_Pending) {
+	subOp = new MoveSubOp;
+	bzero(subOp->sopClass, sizeof(subOp->sopClass));
+	bzero(subOp->sopInstance, sizeof(subOp->sopInstance));
+	bzero(subOp->fname, sizeof(subOp->fname));
+	subOp->fileformat = NULL;
+	dbcond = dbHandle.nextMoveResponse(
+	    subOp->sopClass, subOp->sopInstance, subOp->fname,
+	    &remaining, dbStatus);
+	if (dbcond.bad()) {
+	    DcmQueryRetrieveOptions::errmsg("moveSCP: Database: nextMoveResponse Failed (%s):",
+		DU_cmoveStatusString(dbStatus->status()));
+	}
+	if (dbStatus->status() == STATUS_Pending) {
+	    pendingSubOps.push_back(subOp);
+	} else {
+	    delete subOp;
+	}
+    }
+    subOpTotal = OFstatic_cast(DIC_US, pendingSubOps.size());
+    nRemaining = subOpTotal;
+    pipelineStatus = dbStatus->status();
+    pipelineActive = OFTrue;
+    if (subOpTotal == 0) return;
+    dbStatus->setStatus(STATUS_Pending);
+
+    /* one sending thread per sub-association, the additional sub-associations
+     * are opened by their threads so that a move destination serving one
+     * association at a time cannot block the move
+     */
+    if (!startWorker(&subAssoc)) {
+	/* no threads, the sub-operations are performed by waitPipeline() */
+	return;
+    }
+    int i;
+    for (i = 1; (i < options_.moveAssociations_) && (i < subOpTotal); i++) {
+	moreSubAssocs.push_back(NULL);
+	if (!startWorker(&moreSubAssocs.back())) {
+	    moreSubAssocs.pop_back();
+	    break;
+	}
+    }
+
+    /* loading threads, each one loads one file at a time */
+    size_t loaders = 0;
+    for (i = 0; (i < options_.movePrefetch_) && (i < subOpTotal); i++) {
+	prefetchSemaphore.post();
+	if (startWorker(NULL)) loaders++;
+    }
+    if (loaders == 0) {
+	/* files are loaded when they are sent */
+	pipelineMutex.lock();
+	while (pendingSubOps.size() > 0) {
+	    readySubOps.push_back(pendingSubOps.front());
+	    pendingSubOps.pop_front();
+	    readySemaphore.post();
+	}
+	pipelineMutex.unlock();
+    }
+}
+
+void DcmQueryRetrieveMoveContext::waitPipeline(OFBool cancelled, DcmQueryRetrieveDatabaseStatus * dbStatus)
+{
+    if (cancelled) {
+	/* sub-operations on the wire are completed, all others are dropped */
+	pipelineMutex.lock();
+	pipelineCancelled = OFTrue;
+	pipelineMutex.unlock();
+	stopPipeline();
+	dbStatus->setStatus(STATUS_MOVE_Cancel_SubOperationsTerminatedDueToCancelIndication);
+	return;
+    }
+
+    if (workers.size() == 0) {
+	/* no worker threads could be started, perform the next sub-operation here */
+	MoveSubOp *subOp = pendingSubOps.front();
+	pendingSubOps.pop_front();
+	sendSubOp(subAssoc, subOp);
+    } else {
+	doneSemaphore.wait();
+    }
+
+    pipelineMutex.lock();
+    OFBool finished = (nCompleted + nFailed + nWarning >= subOpTotal) ? OFTrue : OFFalse;
+    pipelineMutex.unlock();
+    if (finished) {
+	dbStatus->setStatus(pipelineStatus);
+    }
+}
+
+void DcmQueryRetrieveMoveContext::stopPipeline()
+{
+    OFListIterator(DcmQueryRetrieveMoveWorker *) first = workers.begin();
+    OFListIterator(DcmQueryRetrieveMoveWorker *) last = workers.end();
+
+    /* wake up every worker, it terminates once there is nothing left to do */
+    while (first != last) {
+	prefetchSemaphore.post();
+	readySemaphore.post();
+	++first;
+    }
+    first = workers.begin();
+    while (first != last) {
+	(*first)->join();
+	delete (*first);
+	first = workers.erase(first);
+    }
+
+    /* sub-operations left over after a cancel */
+    OFListIterator(MoveSubOp *) op = pendingSubOps.begin();
+    while (op != pendingSubOps.end()) {
+	delete (*op);
+	op = pendingSubOps.erase(op);
+    }
+    op = readySubOps.begin();
+    while (op != readySubOps.end()) {
+	delete (*op)->fileformat;
+	delete (*op);
+	op = readySubOps.erase(op);
+    }
+
+    /* the sending threads have released their sub-associations */
+    moreSubAssocs.clear();
+}
+
+void DcmQueryRetrieveMoveContext::sendSubOp(T_ASC_Association *assoc, MoveSubOp *subOp)
+{
+    OFCondition cond = performMoveSubOp(assoc, subOp->sopClass, subOp->sopInstance, subOp->fname,
+	(subOp->fileformat != NULL) ? subOp->fileformat->getDataset() : NULL);
+    if (cond != EC_Normal) {
+	DcmQueryRetrieveOptions::errmsg("moveSCP: Move Sub-Op Failed:");
+	DimseCondition::dump(cond);
+    }
+    delete subOp->fileformat;
+    delete subOp;
+}
+
+void DcmQueryRetrieveMoveContext::runLoader()
+{
+    OFCondition cond = EC_Normal;
+    MoveSubOp *subOp = NULL;
+
+    for (;;) {
+	prefetchSemaphore.wait();
+	pipelineMutex.lock();
+	if (pipelineCancelled || pendingSubOps.size() == 0) {
+	    pipelineMutex.unlock();
+	    break;
+	}
+	subOp = pendingSubOps.front();
+	pendingSubOps.pop_front();
+	pipelineMutex.unlock();
+
+#ifdef LOCK_IMAGE_FILES
+	/* shared lock image file while it is loaded */
+	int lockfd;
+#ifdef O_BINARY
+	lockfd = open(subOp->fname, O_RDONLY | O_BINARY, 0666);
+#else
+	lockfd = open(subOp->fname, O_RDONLY , 0666);
+#endif
+	if (lockfd >= 0) dcmtk_flock(lockfd, LOCK_SH);
+#endif
+	subOp->fileformat = new DcmFileFormat();
+	cond = subOp->fileformat->loadFile(subOp->fname);
+	if (cond.good()) cond = subOp->fileformat->loadAllDataIntoMemory();
+#ifdef LOCK_IMAGE_FILES
+	if (lockfd >= 0) {
+	    dcmtk_flock(lockfd, LOCK_UN);
+	    close(lockfd);
+	}
+#endif
+
+	if (cond.bad()) {
+	    /* due to quota system the file could have been deleted */
+	    DcmQueryRetrieveOptions::errmsg("Move SCP: storeSCU: [file: %s]: %s", 
+		subOp->fname, cond.text());
+	    countSubOp(nFailed, subOp->sopInstance);
+	    delete subOp->fileformat;
+	    delete subOp;
+	    prefetchSemaphore.post();
+	    doneSemaphore.post();
+	    continue;
+	}
+
+	pipelineMutex.lock();
+	readySubOps.push_back(subOp);
+	pipelineMutex.unlock();
+	readySemaphore.post();
+    }
+}
+
+void DcmQueryRetrieveMoveContext::runSender(T_ASC_Association **assoc)
+{
+    MoveSubOp *subOp = NULL;
+
+    /* an additional sub-association, the move continues with fewer if it is refused */
+    if ((*assoc == NULL) && openSubAssociation(assoc).bad()) return;
+
+    for (;;) {
+	readySemaphore.wait();
+	pipelineMutex.lock();
+	if (pipelineCancelled || readySubOps.size() == 0) {
+	    pipelineMutex.unlock();
+	    break;
+	}
+	subOp = readySubOps.front();
+	readySubOps.pop_front();
+	pipelineMutex.unlock();
+
+	/* let the loading threads fetch the next file while this one is on the wire */
+	if (subOp->fileformat != NULL) prefetchSemaphore.post();
+	sendSubOp(*assoc, subOp);
+	doneSemaphore.post();
+    }
+
+    /* release as early as possible, the move destination may be waiting for it */
+    releaseSubAssociation(assoc);
+}
+
+#endif
+
 void DcmQueryRetrieveMoveContext::failAllSubOperations(DcmQueryRetrieveDatabaseStatus * dbStatus)
 {
     OFCondition dbcond = EC_Normal;
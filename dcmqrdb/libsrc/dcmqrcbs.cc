@@ -41,6 +41,7 @@
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmqrdb/dcmqrdbs.h"
 #include "dcmtk/dcmqrdb/dcmqrdba.h"
+#include "dcmtk/dcmqrdb/dcmqrscn.h"
 
 
 void DcmQueryRetrieveStoreContext::updateDisplay(T_DIMSE_StoreProgress * progress)
@@ -67,6 +68,7 @@ void DcmQueryRetrieveStoreContext::updateDisplay(T_DIMSE_StoreProgress * progres
 void DcmQueryRetrieveStoreContext::saveImageToDB(
     T_DIMSE_C_StoreRQ *req,             /* original store request */
     const char *imageFileName,
+    DcmDataset *dataSet,                /* attributes to be registered */
     /* out */
     T_DIMSE_C_StoreRSP *rsp,            /* final store response */
     DcmDataset **stDetail)
@@ -85,7 +87,7 @@ void DcmQueryRetrieveStoreContext::saveImageToDB(
     {    
         dbcond = dbHandle.storeRequest(
             req->AffectedSOPClassUID, req->AffectedSOPInstanceUID,
-            imageFileName, &dbStatus);
+            imageFileName, dataSet, &dbStatus);
         if (dbcond.bad())
         {
             DcmQueryRetrieveOptions::errmsg("storeSCP: Database: storeRequest Failed (%s)",
@@ -129,7 +131,8 @@ void DcmQueryRetrieveStoreContext::checkRequestAgainstDataset(
 
     if (dataSet == NULL)
     {
-      ff.loadFile(fname);
+      /* the pixel data is not needed for the check */
+      ff.loadFile(fname, EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_autoDetect, OFFalse, DCM_PixelData);
       dataSet = ff.getDataset();
     }
 
@@ -162,22 +165,42 @@ void DcmQueryRetrieveStoreContext::callbackHandler(
 
     if (progress->state == DIMSE_StoreEnd) {
 
+        /* attributes extracted while receiving into file, or complete file contents */
+        DcmDataset *indexDataSet = NULL;
+        DcmFileFormat ff;
+
         if (!options_.ignoreStoreData_ && rsp->DimseStatus == STATUS_Success) {
             if ((imageDataSet)&&(*imageDataSet)) {
                 checkRequestAgainstDataset(req, NULL, *imageDataSet, rsp, correctUIDPadding);
             } else {
-                checkRequestAgainstDataset(req, imageFileName, NULL, rsp, correctUIDPadding);
+                if (scanner) indexDataSet = scanner->createDataset();
+                OFCondition cond = EC_Normal;
+                if (indexDataSet == NULL) {
+                    /* read the file once for both check and database, */
+                    /* neither of which needs the pixel data */
+                    cond = ff.loadFile(imageFileName, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+                                       ERM_autoDetect, OFFalse, DCM_PixelData);
+                }
+                if (cond.bad()) {
+                    DcmQueryRetrieveOptions::errmsg("Bad image file: %s", imageFileName);
+                    rsp->DimseStatus = STATUS_STORE_Error_CannotUnderstand;
+                } else {
+                    checkRequestAgainstDataset(req, imageFileName, (indexDataSet) ? indexDataSet : ff.getDataset(), rsp, correctUIDPadding);
+                }
             }
         }
 
         if (!options_.ignoreStoreData_ && rsp->DimseStatus == STATUS_Success) {
             if ((imageDataSet)&&(*imageDataSet)) {
                 writeToFile(dcmff, fileName, rsp);
-            }
-            if (rsp->DimseStatus == STATUS_Success) {
-                saveImageToDB(req, fileName, rsp, stDetail);
+                if (rsp->DimseStatus == STATUS_Success) {
+                    saveImageToDB(req, fileName, *imageDataSet, rsp, stDetail);
+                }
+            } else {
+                saveImageToDB(req, fileName, (indexDataSet) ? indexDataSet : ff.getDataset(), rsp, stDetail);
             }
         }
+        delete indexDataSet;
 
         if (options_.verbose_) {
             printf("Sending:\n");
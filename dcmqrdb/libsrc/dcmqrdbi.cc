@@ -54,6 +54,7 @@ END_EXTERN_C
 #include "dcmtk/dcmqrdb/dcmqrcnf.h"
 
 #include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrfcc.h"
 #include "dcmtk/dcmnet/diutil.h"
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/ofstd/ofstd.h"
@@ -428,16 +429,6 @@ static long DB_lseek(int fildes, long offset, int whence)
         return pos;
     }
 
-    /*
-    ** print an alert if we are seeking to far
-    ** what is the limit? We don't expect the index file to be
-    ** larger than 32Mb
-    */
-    const long maxFileSize = 33554432;
-    if (pos > maxFileSize) {
-        CERR << "*** DB ALERT: attempt to seek beyond " << maxFileSize << " bytes" << endl;
-    }
-
     /* print an alert if we are seeking beyond the end of file.
      * ignore when file is empty
      */
@@ -449,31 +440,363 @@ static long DB_lseek(int fildes, long offset, int whence)
     return pos;
 }
 
+static long DB_FileSize(int fd)
+{
+    struct stat buf ;
+    if (fstat(fd, &buf) < 0)
+        return -1 ;
+    return (long) buf. st_size ;
+}
+
+/*
+** Index file format (DB_INDEXFILE_VERSION 2):
+** The index file starts with a DB_IndexFileHeader, followed by index records
+** of variable length. Each index record consists of a DB_IdxRecordHeader,
+** the fixed size values (RecordedDate, ImageSize, hstat) and the non-empty
+** text fields of the IdxRecord, each of them encoded as a field number
+** (one byte), the value length (two bytes) and the value without trailing
+** zero byte. Unknown field numbers are skipped when reading, so that fields
+** can be added without changing the format version. The number of an index
+** record is its offset in the index file. Free records are reused for new
+** records that fit into them, so that records never move once allocated.
+** The study descriptors are kept in a separate file (DBSTUDYFILE) that
+** grows with the number of studies. Version 1 index files have a different
+** name (DBOLDINDEXFILE), so that older applications never read or overwrite
+** an index file in the current format.
+*/
+
+static const char DB_IndexFileMagic[8] = { 'D', 'C', 'M', 'Q', 'R', 'I', 'D', 'X' };
+
+#define DB_FIELD_filename               0
+#define DB_FIELD_SOPClassUID            1
+#define DB_FIELD_InstanceDescription    2
+#define DB_FIELD_param                  3
+
+/* size of the fixed size values at the start of an encoded index record */
+#define DB_IDXRECORD_FIXEDSIZE          (sizeof (double) + 2 * sizeof (Sint32))
+
+/* upper limit for the size of an index record including its header */
+#define DB_IDXRECORD_MAXSIZE            (SIZEOF_IDXRECORDHEADER + DB_IDXRECORD_FIXEDSIZE + \
+                                         SIZEOF_IDXRECORD + 3 * (DB_FIELD_param + NBPARAMETERS))
+
+/* index records are allocated in multiples of this size */
+#define DB_IDXRECORD_ALIGNMENT          8
+
+/* size of the read-ahead buffer used when scanning the index file */
+#define DB_SCANBUFSIZE                  65536
+
+static Uint32 DB_IdxRecordCapacity (int length)
+{
+    return (Uint32) (((SIZEOF_IDXRECORDHEADER + length + DB_IDXRECORD_ALIGNMENT - 1)
+        / DB_IDXRECORD_ALIGNMENT) * DB_IDXRECORD_ALIGNMENT) ;
+}
+
+/* length of a text field which is not necessarily zero terminated */
+static size_t DB_IdxFieldLength (const char *value, size_t maxLength)
+{
+    const char *end = (const char *) memchr (value, 0, maxLength) ;
+    return (end == NULL) ? maxLength : (size_t) (end - value) ;
+}
+
+static void DB_IdxEncodeField (char *buf, int *length, int field, const char *value, size_t len)
+{
+    Uint16 l = (Uint16) len ;
+
+    if (len == 0)
+        return ;
+    buf [(*length)++] = (char) field ;
+    memcpy (buf + *length, &l, sizeof (l)) ;
+    *length += sizeof (l) ;
+    memcpy (buf + *length, value, len) ;
+    *length += (int) len ;
+}
+
+/************
+ *      Encodes an IdxRecord, returns the length of the encoded record
+ */
+
+static int DB_IdxEncode (IdxRecord *idxRec, char *buf)
+{
+    IdxRecord   limits ;
+    Sint32      val ;
+    int         length = 0 ;
+    int         i ;
+
+    DB_IdxInitRecord (&limits, 0) ;
+
+    memcpy (buf + length, &(idxRec -> RecordedDate), sizeof (double)) ;
+    length += sizeof (double) ;
+    val = (Sint32) idxRec -> ImageSize ;
+    memcpy (buf + length, &val, sizeof (val)) ;
+    length += sizeof (val) ;
+    val = (Sint32) idxRec -> hstat ;
+    memcpy (buf + length, &val, sizeof (val)) ;
+    length += sizeof (val) ;
+
+    DB_IdxEncodeField (buf, &length, DB_FIELD_filename, idxRec -> filename,
+        DB_IdxFieldLength (idxRec -> filename, DBC_MAXSTRING)) ;
+    DB_IdxEncodeField (buf, &length, DB_FIELD_SOPClassUID, idxRec -> SOPClassUID,
+        DB_IdxFieldLength (idxRec -> SOPClassUID, UI_MAX_LENGTH)) ;
+    DB_IdxEncodeField (buf, &length, DB_FIELD_InstanceDescription, idxRec -> InstanceDescription,
+        DB_IdxFieldLength (idxRec -> InstanceDescription, DESCRIPTION_MAX_LENGTH)) ;
+    for (i = 0 ; i < NBPARAMETERS ; i++)
+        DB_IdxEncodeField (buf, &length, DB_FIELD_param + i, idxRec -> param [i]. PValueField,
+            DB_IdxFieldLength (idxRec -> param [i]. PValueField, (size_t) limits. param [i]. ValueLength)) ;
+
+    return length ;
+}
+
+/************
+ *      Decodes an encoded index record into an IdxRecord.
+ *      An empty encoded record yields an IdxRecord with empty filename.
+ */
+
+static OFCondition DB_IdxDecode (const char *buf, int length, IdxRecord *idxRec)
+{
+    Uint32      maxLength [NBPARAMETERS] ;
+    Sint32      val ;
+    Uint16      l ;
+    char        *value ;
+    size_t      max ;
+    int         field ;
+    int         pos ;
+    int         i ;
+
+    DB_IdxInitRecord (idxRec, 0) ;
+    for (i = 0 ; i < NBPARAMETERS ; i++) {
+        maxLength [i] = idxRec -> param [i]. ValueLength ;
+        idxRec -> param [i]. ValueLength = 0 ;
+        idxRec -> param [i]. PValueField [0] = '\0' ;
+    }
+    idxRec -> filename [0] = '\0' ;
+    idxRec -> SOPClassUID [0] = '\0' ;
+    idxRec -> InstanceDescription [0] = '\0' ;
+    idxRec -> RecordedDate = 0.0 ;
+    idxRec -> ImageSize = 0 ;
+    idxRec -> hstat = DVIF_objectIsNotNew ;
+
+    if (length == 0)
+        return EC_Normal ;
+    if (length < (int) DB_IDXRECORD_FIXEDSIZE)
+        return DcmQRIndexDatabaseError ;
+
+    pos = 0 ;
+    memcpy (&(idxRec -> RecordedDate), buf + pos, sizeof (double)) ;
+    pos += sizeof (double) ;
+    memcpy (&val, buf + pos, sizeof (val)) ;
+    idxRec -> ImageSize = (int) val ;
+    pos += sizeof (val) ;
+    memcpy (&val, buf + pos, sizeof (val)) ;
+    idxRec -> hstat = (DVIFhierarchyStatus) val ;
+    pos += sizeof (val) ;
+
+    while (pos + 1 + (int) sizeof (l) <= length) {
+        field = (unsigned char) buf [pos++] ;
+        memcpy (&l, buf + pos, sizeof (l)) ;
+        pos += sizeof (l) ;
+        if (pos + (int) l > length)
+            return DcmQRIndexDatabaseError ;
+
+        value = NULL ;
+        max = 0 ;
+        if (field == DB_FIELD_filename) {
+            value = idxRec -> filename ;
+            max = DBC_MAXSTRING ;
+        }
+        else if (field == DB_FIELD_SOPClassUID) {
+            value = idxRec -> SOPClassUID ;
+            max = UI_MAX_LENGTH ;
+        }
+        else if (field == DB_FIELD_InstanceDescription) {
+            value = idxRec -> InstanceDescription ;
+            max = DESCRIPTION_MAX_LENGTH ;
+        }
+        else if (field - DB_FIELD_param < NBPARAMETERS) {
+            i = field - DB_FIELD_param ;
+            value = idxRec -> param [i]. PValueField ;
+            max = (size_t) maxLength [i] ;
+            idxRec -> param [i]. ValueLength = (l < max) ? l : (Uint32) max ;
+        }
+
+        /* fields written by a newer version are ignored */
+        if (value != NULL) {
+            if ((size_t) l < max)
+                max = (size_t) l ;
+            memcpy (value, buf + pos, max) ;
+            value [max] = '\0' ;
+        }
+        pos += l ;
+    }
+    return EC_Normal ;
+}
+
+/************
+ *      Reads the header of the index record at the given position
+ */
+
+static OFCondition DB_IdxReadHeader (int fd, long pos, DB_IdxRecordHeader *hdr)
+{
+    if (DB_lseek (fd, pos, SEEK_SET) != pos)
+        return DcmQRIndexDatabaseError ;
+    if (read (fd, (char *) hdr, SIZEOF_IDXRECORDHEADER) != SIZEOF_IDXRECORDHEADER)
+        return DcmQRIndexDatabaseError ;
+    if ((hdr -> capacity < SIZEOF_IDXRECORDHEADER) || (hdr -> capacity > DB_SCANBUFSIZE)
+        || (hdr -> length > hdr -> capacity - SIZEOF_IDXRECORDHEADER)) {
+        CERR << "*** DB ALERT: invalid index record at offset " << pos << endl;
+        return DcmQRIndexDatabaseError ;
+    }
+    return EC_Normal ;
+}
+
+/************
+ *      Writes an encoded index record (buf starts with room for the
+ *      DB_IdxRecordHeader) to the given position. If the record is
+ *      appended, the whole capacity is written so that the next record
+ *      starts at the end of file.
+ */
+
+static OFCondition DB_IdxWriteRecord (DB_Private_Handle *phandle, long pos, Uint32 capacity, char *buf, int length)
+{
+    DB_IdxRecordHeader hdr ;
+    int size = (int) (SIZEOF_IDXRECORDHEADER + length) ;
+
+    if ((Uint32) size > capacity)
+        return DcmQRIndexDatabaseError ;
+    if (capacity <= DB_IDXRECORD_MAXSIZE + DB_IDXRECORD_ALIGNMENT) {
+        bzero (buf + size, (size_t) (capacity - size)) ;
+        size = (int) capacity ;
+    }
+    hdr. capacity = capacity ;
+    hdr. length = (Uint32) length ;
+    memcpy (buf, &hdr, SIZEOF_IDXRECORDHEADER) ;
+
+    /* invalidate the read-ahead buffer */
+    phandle -> scanLength = 0 ;
+
+    if (DB_lseek (phandle -> pidx, pos, SEEK_SET) != pos)
+        return DcmQRIndexDatabaseError ;
+    if (write (phandle -> pidx, buf, size) != size)
+        return DcmQRIndexDatabaseError ;
+    return EC_Normal ;
+}
+
+/************
+ *      Returns a pointer to the index record at the given position within
+ *      the read-ahead buffer, reading the file as necessary. If withData is
+ *      false, only the record header is guaranteed to be available.
+ *      Returns NULL at end of file or if the record is invalid.
+ */
+
+static const char *DB_IdxScanRecord (DB_Private_Handle *phandle, long pos, OFBool withData)
+{
+    DB_IdxRecordHeader hdr ;
+    long size = SIZEOF_IDXRECORDHEADER ;
+    int pass ;
+
+    if (phandle -> scanBuffer == NULL) {
+        phandle -> scanBuffer = (char *) malloc (DB_SCANBUFSIZE) ;
+        phandle -> scanLength = 0 ;
+        if (phandle -> scanBuffer == NULL) {
+            CERR << "DB_IdxScanRecord: out of memory" << endl;
+            return NULL ;
+        }
+    }
+
+    for (pass = 0 ; pass < 2 ; pass++) {
+        if ((pos < phandle -> scanStart) || (pos + size > phandle -> scanStart + phandle -> scanLength)) {
+            phandle -> scanStart = pos ;
+            phandle -> scanLength = 0 ;
+            if (lseek (phandle -> pidx, pos, SEEK_SET) != pos)
+                return NULL ;
+            int n = read (phandle -> pidx, phandle -> scanBuffer, DB_SCANBUFSIZE) ;
+            if (n > 0)
+                phandle -> scanLength = n ;
+            if (pos + size > phandle -> scanStart + phandle -> scanLength)
+                return NULL ;
+        }
+        if (pass == 0) {
+            memcpy (&hdr, phandle -> scanBuffer + (pos - phandle -> scanStart), SIZEOF_IDXRECORDHEADER) ;
+            if ((hdr. capacity < SIZEOF_IDXRECORDHEADER) || (hdr. capacity > DB_SCANBUFSIZE)
+                || (hdr. length > hdr. capacity - SIZEOF_IDXRECORDHEADER)) {
+                CERR << "*** DB ALERT: invalid index record at offset " << pos << endl;
+                return NULL ;
+            }
+            if (!withData)
+                break ;
+            size += hdr. length ;
+        }
+    }
+    return phandle -> scanBuffer + (pos - phandle -> scanStart) ;
+}
+
 /******************************
  *      Read an Index record
  */
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRead (int idx, IdxRecord *idxRec)
 {
+    DB_IdxRecordHeader  hdr ;
+    char                buf [DB_IDXRECORD_MAXSIZE] ;
 
-    /*** Goto the right index in file
-    **/
-
-    DB_lseek (handle -> pidx, (long) (SIZEOF_STUDYDESC + idx * SIZEOF_IDXRECORD), SEEK_SET) ;
+    if (idx < (int) SIZEOF_INDEXFILEHEADER)
+        return (DcmQRIndexDatabaseError) ;
 
-    /*** Read the record
+    /*** Read the record header, then the encoded record
     **/
 
-    if (read (handle -> pidx, (char *) idxRec, SIZEOF_IDXRECORD) != SIZEOF_IDXRECORD)
+    if (DB_IdxReadHeader (handle -> pidx, (long) idx, &hdr) != EC_Normal)
+        return (DcmQRIndexDatabaseError) ;
+    if (hdr. length > sizeof (buf))
+        return (DcmQRIndexDatabaseError) ;
+    if ((hdr. length > 0) && (read (handle -> pidx, buf, (size_t) hdr. length) != (int) hdr. length))
         return (DcmQRIndexDatabaseError) ;
 
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
+    return DB_IdxDecode (buf, (int) hdr. length, idxRec) ;
+}
 
-    /*** Initialize record links
-    **/
 
-    DB_IdxInitRecord (idxRec, 1) ;
-    return EC_Normal ;
+/************
+ *      Reads the generation counter from the index file header
+ */
+
+static Uint32 DB_IdxGetGeneration (int fd)
+{
+    DB_IndexFileHeader  hdr ;
+
+    if (DB_lseek (fd, 0L, SEEK_SET) != 0)
+        return 0 ;
+    if (read (fd, (char *) &hdr, SIZEOF_INDEXFILEHEADER) != SIZEOF_INDEXFILEHEADER)
+        return 0 ;
+    return hdr. generation ;
+}
+
+/************
+ *      Increments the generation counter of the index file after an index
+ *      record has been added or removed, and drops the cached query results
+ *      that may include the record. Must be called with an exclusive lock held.
+ */
+
+static void DB_IdxRecordChanged (DB_Private_Handle *phandle, IdxRecord *idxRec)
+{
+    DB_IndexFileHeader  hdr ;
+    OFList<OFString>    written ;
+    Uint32              oldGeneration ;
+
+    if (DB_lseek (phandle -> pidx, 0L, SEEK_SET) != 0)
+        return ;
+    if (read (phandle -> pidx, (char *) &hdr, SIZEOF_INDEXFILEHEADER) != SIZEOF_INDEXFILEHEADER)
+        return ;
+    oldGeneration = hdr. generation ;
+    hdr. generation++ ;
+    DB_lseek (phandle -> pidx, 0L, SEEK_SET) ;
+    if (write (phandle -> pidx, (char *) &hdr, SIZEOF_INDEXFILEHEADER) != SIZEOF_INDEXFILEHEADER)
+        return ;
+
+    written. push_back (DcmQueryRetrieveFindCache::makeRestriction (DCM_StudyInstanceUID, idxRec -> StudyInstanceUID)) ;
+    written. push_back (DcmQueryRetrieveFindCache::makeRestriction (DCM_SeriesInstanceUID, idxRec -> SeriesInstanceUID)) ;
+    written. push_back (DcmQueryRetrieveFindCache::makeRestriction (DCM_SOPInstanceUID, idxRec -> SOPInstanceUID)) ;
+    DcmQueryRetrieveFindCache::instance (). invalidate (phandle -> storageArea,
+        (unsigned long) oldGeneration, (unsigned long) hdr. generation, written) ;
 }
 
 
@@ -484,49 +807,89 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRead (int idx, IdxRecord
 
 static OFCondition DB_IdxAdd (DB_Private_Handle *phandle, int *idx, IdxRecord *idxRec)
 {
-    IdxRecord   rec ;
-    OFCondition cond = EC_Normal;
-
-    /*** Find free place for the record
-    *** A place is free if filename is empty
+    DB_IdxRecordHeader  hdr ;
+    char                buf [DB_IDXRECORD_MAXSIZE + DB_IDXRECORD_ALIGNMENT] ;
+    const char          *rec ;
+    long                pos ;
+    int                 length ;
+    Uint32              capacity ;
+
+    length = DB_IdxEncode (idxRec, buf + SIZEOF_IDXRECORDHEADER) ;
+    capacity = DB_IdxRecordCapacity (length) ;
+
+    /*** Find the first free record that is large enough,
+    *** otherwise append the record to the end of file
     **/
 
-    *idx = 0 ;
-
-    DB_lseek (phandle -> pidx, (long) SIZEOF_STUDYDESC, SEEK_SET) ;
-    while (read (phandle -> pidx, (char *) &rec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD) {
-        if (rec. filename [0] == '\0')
+    pos = SIZEOF_INDEXFILEHEADER ;
+    while ((rec = DB_IdxScanRecord (phandle, pos, OFFalse)) != NULL) {
+        memcpy (&hdr, rec, SIZEOF_IDXRECORDHEADER) ;
+        if ((hdr. length == 0) && (hdr. capacity >= capacity)) {
+            capacity = hdr. capacity ;
             break ;
-        (*idx)++ ;
+        }
+        pos += hdr. capacity ;
     }
+    if (rec == NULL)
+        pos = DB_FileSize (phandle -> pidx) ;
 
-    /*** We have either found a free place or we are at the end of file. **/
+    if ((pos < (long) SIZEOF_INDEXFILEHEADER) || (pos + (long) capacity > 0x7fffffffL)) {
+        CERR << "DB_IdxAdd: index file too large" << endl;
+        return DcmQRIndexDatabaseError ;
+    }
 
+    *idx = (int) pos ;
+    if (DB_IdxWriteRecord (phandle, pos, capacity, buf, length) != EC_Normal)
+        return DcmQRIndexDatabaseError ;
+    DB_IdxRecordChanged (phandle, idxRec) ;
+    return EC_Normal ;
+}
 
-    DB_lseek (phandle -> pidx, (long) (SIZEOF_STUDYDESC + (*idx) * SIZEOF_IDXRECORD), SEEK_SET) ;
 
-    if (write (phandle -> pidx, (char *) idxRec, SIZEOF_IDXRECORD) != SIZEOF_IDXRECORD)
-        cond = DcmQRIndexDatabaseError ;
-    else
-        cond = EC_Normal ;
+/******************************
+ *      Determine the number of study descriptors in use
+ */
 
-    DB_lseek (phandle -> pidx, 0L, SEEK_SET) ;
+int DcmQueryRetrieveIndexDatabaseHandle::DB_StudyDescCount()
+{
+    long stored = DB_FileSize (handle -> pstd) / (long) sizeof (StudyDescRecord) ;
 
-    return cond ;
+    if (stored < 0)
+        stored = 0 ;
+    if (stored >= handle -> maxStudiesAllowed)
+        handle -> studyDescCount = (int) handle -> maxStudiesAllowed ;
+    else
+        handle -> studyDescCount = (int) stored + 1 ;
+    return handle -> studyDescCount ;
 }
 
 
 /******************************
  *      Change the StudyDescRecord
+ *      Trailing free descriptors are cut off the study file
+ *      unless other descriptors follow beyond studyDescCount.
  */
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_StudyDescChange(StudyDescRecord *pStudyDesc)
 {
-    OFCondition cond = EC_Normal;
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
-    if (write (handle -> pidx, (char *) pStudyDesc, SIZEOF_STUDYDESC) != SIZEOF_STUDYDESC) cond = DcmQRIndexDatabaseError;
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
-    return cond ;
+    int count = handle -> studyDescCount ;
+    long stored = DB_FileSize (handle -> pstd) / (long) sizeof (StudyDescRecord) ;
+    int size ;
+
+    if (count <= 0)
+        return DcmQRIndexDatabaseError ;
+    if (stored <= count) {
+        while ((count > 0) && (pStudyDesc [count - 1]. NumberofRegistratedImages == 0))
+            count-- ;
+    }
+    size = (int) (count * sizeof (StudyDescRecord)) ;
+
+    lseek (handle -> pstd, 0L, SEEK_SET) ;
+    if ((size > 0) && (write (handle -> pstd, (char *) pStudyDesc, size) != size))
+        return DcmQRIndexDatabaseError ;
+    if ((stored <= handle -> studyDescCount) && (stored > count))
+        ftruncate (handle -> pstd, (off_t) size) ;
+    return EC_Normal ;
 }
 
 /******************************
@@ -535,7 +898,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_StudyDescChange(StudyDescRec
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxInitLoop(int *idx)
 {
-    DB_lseek (handle -> pidx, SIZEOF_STUDYDESC, SEEK_SET) ;
+    handle -> scanLength = 0 ;
     *idx = -1 ;
     return EC_Normal ;
 }
@@ -547,67 +910,121 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxInitLoop(int *idx)
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxGetNext(int *idx, IdxRecord *idxRec)
 {
+    DB_IdxRecordHeader  hdr ;
+    const char          *rec ;
+    long                pos ;
 
-    (*idx)++ ;
-    DB_lseek (handle -> pidx, SIZEOF_STUDYDESC + (long)(*idx) * SIZEOF_IDXRECORD, SEEK_SET) ;
-    while (read (handle -> pidx, (char *) idxRec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD) {
-        if (idxRec -> filename [0] != '\0') {
-            DB_IdxInitRecord (idxRec, 1) ;
+    if (*idx < 0)
+        pos = SIZEOF_INDEXFILEHEADER ;
+    else {
+        if ((rec = DB_IdxScanRecord (handle, (long) *idx, OFFalse)) == NULL)
+            return DcmQRIndexDatabaseError ;
+        memcpy (&hdr, rec, SIZEOF_IDXRECORDHEADER) ;
+        pos = (long) *idx + hdr. capacity ;
+    }
 
-            return EC_Normal ;
+    while ((rec = DB_IdxScanRecord (handle, pos, OFTrue)) != NULL) {
+        memcpy (&hdr, rec, SIZEOF_IDXRECORDHEADER) ;
+        if (hdr. length > 0) {
+            *idx = (int) pos ;
+            return DB_IdxDecode (rec + SIZEOF_IDXRECORDHEADER, (int) hdr. length, idxRec) ;
         }
-        (*idx)++ ;
+        pos += hdr. capacity ;
     }
 
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
-
     return DcmQRIndexDatabaseError ;
 }
 
 
 /******************************
- *      Get next Index record
- *      On return, idx is initialized with the index of the record read
+ *      Get the study descriptors
+ *      pStudyDesc must provide DB_StudyDescCount() entries
  */
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_GetStudyDesc (StudyDescRecord *pStudyDesc)
 {
+    int count = handle -> studyDescCount ;
+    long stored = DB_FileSize (handle -> pstd) / (long) sizeof (StudyDescRecord) ;
+    int size ;
+
+    if (count <= 0)
+        count = DB_StudyDescCount () ;
+    bzero ((char *) pStudyDesc, count * sizeof (StudyDescRecord)) ;
+    if (stored > count)
+        stored = count ;
+    size = (int) (stored * sizeof (StudyDescRecord)) ;
+
+    lseek (handle -> pstd, 0L, SEEK_SET) ;
+    if ((size > 0) && (read (handle -> pstd, (char *) pStudyDesc, size) != size))
+        return DcmQRIndexDatabaseError ;
 
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
-    if ( read (handle -> pidx, (char *) pStudyDesc, SIZEOF_STUDYDESC) == SIZEOF_STUDYDESC )
-        return EC_Normal ;
-
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
-
-    return DcmQRIndexDatabaseError ;
+    return EC_Normal ;
 }
 
 
 /******************************
  *      Remove an Index record
- *      Just put a record with filename == ""
+ *      Just mark the record as free
  */
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRemove(int idx)
 {
-    IdxRecord   rec ;
-    OFCondition cond = EC_Normal;
+    DB_IdxRecordHeader  hdr ;
+    IdxRecord           idxRec ;
 
-    DB_lseek (handle -> pidx, SIZEOF_STUDYDESC + (long)idx * SIZEOF_IDXRECORD, SEEK_SET) ;
-    DB_IdxInitRecord (&rec, 0) ;
+    if (DB_IdxRead (idx, &idxRec) != EC_Normal)
+        return DcmQRIndexDatabaseError ;
+    if (DB_IdxReadHeader (handle -> pidx, (long) idx, &hdr) != EC_Normal)
+        return DcmQRIndexDatabaseError ;
 
-    rec. filename [0] = '\0' ;
-    if (write (handle -> pidx, (char *) &rec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD)
-        cond = EC_Normal ;
+    handle -> scanLength = 0 ;
+    hdr. length = 0 ;
+    DB_lseek (handle -> pidx, (long) idx, SEEK_SET) ;
+    if (write (handle -> pidx, (char *) &hdr, SIZEOF_IDXRECORDHEADER) != SIZEOF_IDXRECORDHEADER)
+        return DcmQRIndexDatabaseError ;
 
-    else
-        cond = DcmQRIndexDatabaseError ;
+    DB_IdxRecordChanged (handle, &idxRec) ;
+    return EC_Normal ;
+}
 
-    DB_lseek (handle -> pidx, 0L, SEEK_SET) ;
+/******************************
+ *      Check the header of an index file, which is
+ *      initialized if the file is empty. legacy is set
+ *      if the file is in the version 1 format.
+ */
 
-    return cond ;
+static OFCondition DB_IdxCheckFile (int fd, OFBool *legacy)
+{
+    DB_IndexFileHeader  hdr ;
+
+    *legacy = OFFalse ;
+    lseek (fd, 0L, SEEK_SET) ;
+    if (DB_FileSize (fd) == 0) {
+        bzero ((char *) &hdr, SIZEOF_INDEXFILEHEADER) ;
+        memcpy (hdr. magic, DB_IndexFileMagic, sizeof (hdr. magic)) ;
+        hdr. version = DB_INDEXFILE_VERSION ;
+        if (write (fd, (char *) &hdr, SIZEOF_INDEXFILEHEADER) != SIZEOF_INDEXFILEHEADER)
+            return DcmQRIndexDatabaseError ;
+        return EC_Normal ;
+    }
+    if ((read (fd, (char *) &hdr, SIZEOF_INDEXFILEHEADER) != SIZEOF_INDEXFILEHEADER)
+        || (memcmp (hdr. magic, DB_IndexFileMagic, sizeof (hdr. magic)) != 0)) {
+        *legacy = OFTrue ;
+        return DcmQRIndexDatabaseError ;
+    }
+    if (hdr. version != DB_INDEXFILE_VERSION)
+        return DcmQRIndexDatabaseError ;
+    return EC_Normal ;
 }
 
+/*
+** The lock file (DBLOCKFILE) serves as a turnstile in front of the index file
+** lock. A writer keeps it locked exclusively until it has finished, readers
+** only pass it on their way to the shared index file lock. Once a writer is
+** waiting, no new reader gets the index file lock, so that a steady stream
+** of queries cannot starve incoming stores.
+*/
+
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_lock(OFBool exclusive)
 {
     int lockmode;
@@ -617,10 +1034,20 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_lock(OFBool exclusive)
     } else {
         lockmode = LOCK_SH;     /* shared lock */
     }
+    if ((handle->plck >= 0) && (dcmtk_flock(handle->plck, lockmode) < 0)) {
+        dcmtk_plockerr("DB_lock");
+        return DcmQRIndexDatabaseError;
+    }
     if (dcmtk_flock(handle->pidx, lockmode) < 0) {
         dcmtk_plockerr("DB_lock");
+        if (handle->plck >= 0) dcmtk_flock(handle->plck, LOCK_UN);
         return DcmQRIndexDatabaseError;
     }
+    if (!exclusive && (handle->plck >= 0) && (dcmtk_flock(handle->plck, LOCK_UN) < 0)) {
+        dcmtk_plockerr("DB_lock");
+    }
+    /* other processes may have changed the index file in the meantime */
+    handle->scanLength = 0;
     return EC_Normal;
 }
 
@@ -630,6 +1057,10 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_unlock()
         dcmtk_plockerr("DB_unlock");
         return DcmQRIndexDatabaseError;
     }
+    if ((handle->plck >= 0) && (dcmtk_flock(handle->plck, LOCK_UN) < 0)) {
+        dcmtk_plockerr("DB_unlock");
+        return DcmQRIndexDatabaseError;
+    }
     return EC_Normal;
 }
 
@@ -672,6 +1103,23 @@ static OFCondition DB_FreeElementList (DB_ElementList *lst)
 }
 
 
+/*******************
+ *    Free a list of pending find responses
+ */
+
+static void DB_FreeResponseList (DB_ResponseList *lst)
+{
+    DB_ResponseList *next ;
+
+    while (lst) {
+        next = lst -> next ;
+        DB_FreeElementList (lst -> elements) ;
+        free (lst) ;
+        lst = next ;
+    }
+}
+
+
 /*******************
  *    Matches two strings
  */
@@ -954,6 +1402,90 @@ static void DB_DuplicateElement (DB_SmallDcmElmt *src, DB_SmallDcmElmt *dst)
 }
 
 
+/***********************
+ *    Copy a list of find responses into a result for the query result cache.
+ *    Returns OFFalse if there are more than maxResponses responses or if
+ *    the responses do not consist of the same attributes.
+ */
+
+static OFBool DB_ResponseListToCache (DB_ResponseList *presp, size_t maxResponses, DcmQueryRetrieveFindCacheResult *result)
+{
+    DB_ElementList *plist ;
+
+    if (presp != NULL) {
+        for (plist = presp -> elements ; plist != NULL ; plist = plist -> next)
+            result -> tags. push_back (plist -> elem. XTag) ;
+    }
+    for ( ; presp != NULL ; presp = presp -> next) {
+        OFList<OFString> values ;
+        OFListIterator(DcmTagKey) tag = result -> tags. begin () ;
+        for (plist = presp -> elements ; plist != NULL ; plist = plist -> next, ++tag) {
+            if ((tag == result -> tags. end ()) || (*tag != plist -> elem. XTag))
+                return OFFalse ;
+            values. push_back (plist -> elem. PValueField ? plist -> elem. PValueField : "") ;
+        }
+        if ((tag != result -> tags. end ()) || (result -> responses. size () >= maxResponses))
+            return OFFalse ;
+        result -> responses. push_back (values) ;
+    }
+    return OFTrue ;
+}
+
+/***********************
+ *    Create a list of find responses from a cached result
+ */
+
+static OFCondition DB_ResponseListFromCache (DcmQueryRetrieveFindCacheResult *result, DB_ResponseList **list)
+{
+    DB_ResponseList *presp ;
+    DB_ResponseList *lastResponse = NULL ;
+    DB_ElementList  *plist ;
+    DB_ElementList  *last ;
+
+    *list = NULL ;
+    OFListIterator(OFList<OFString>) values = result -> responses. begin () ;
+    for ( ; values != result -> responses. end () ; ++values) {
+        presp = (DB_ResponseList *) malloc (sizeof (DB_ResponseList)) ;
+        if (presp == NULL)
+            return DcmQRIndexDatabaseError ;
+        presp -> elements = NULL ;
+        presp -> next = NULL ;
+        if (lastResponse == NULL)
+            *list = lastResponse = presp ;
+        else {
+            lastResponse -> next = presp ;
+            lastResponse = presp ;
+        }
+
+        last = NULL ;
+        OFListIterator(DcmTagKey) tag = result -> tags. begin () ;
+        OFListIterator(OFString) value = (*values). begin () ;
+        for ( ; tag != result -> tags. end () ; ++tag, ++value) {
+            plist = (DB_ElementList *) malloc (sizeof (DB_ElementList)) ;
+            if (plist == NULL)
+                return DcmQRIndexDatabaseError ;
+            bzero ((char *) &(plist -> elem), sizeof (DB_SmallDcmElmt)) ;
+            plist -> next = NULL ;
+            plist -> elem. XTag = *tag ;
+            if (last == NULL)
+                presp -> elements = last = plist ;
+            else {
+                last -> next = plist ;
+                last = plist ;
+            }
+            if ((*value). length () > 0) {
+                plist -> elem. PValueField = (char *) malloc ((*value). length () + 1) ;
+                if (plist -> elem. PValueField == NULL)
+                    return DcmQRIndexDatabaseError ;
+                strcpy (plist -> elem. PValueField, (*value). c_str ()) ;
+                plist -> elem. ValueLength = (*value). length () ;
+            }
+        }
+    }
+    return EC_Normal ;
+}
+
+
 /***********************
  *    Compare two ImagesofStudyArray elements
  */
@@ -973,6 +1505,592 @@ static int DB_Compare(const void *ve1, const void *ve2)
 }
 
 
+/* ========================= KEY INDEX ========================= */
+
+/*
+** The key index file (DBKEYINDEXFILE) is an optional companion of the
+** index file. It stores, for every index record, its PatientID, StudyDate
+** and level UIDs as fixed size key records. The bulk of the key records is
+** kept sorted so that a lookup is a binary search followed by a short
+** sequential read; new keys are appended to a small unsorted journal that
+** is merged into the sorted block once it is full.
+**
+** The key index is only a hint: every candidate record is still matched
+** by hierarchicalCompare(). Records removed from the index file therefore
+** leave harmless stale keys behind. Records added to the index file must
+** be added to the key index within the same exclusive lock, otherwise the
+** key index is marked invalid and queries fall back to a full scan.
+*/
+
+static const char DB_KeyIndexMagic[8] = { 'D', 'C', 'M', 'Q', 'R', 'K', 'Y', '2' };
+
+static OFCondition DB_KeyIndexReadHeader(int fd, DB_KeyIndexHeader *hdr)
+{
+    OFCondition cond = EC_Normal;
+    lseek (fd, 0L, SEEK_SET) ;
+    if (read (fd, (char *) hdr, SIZEOF_KEYINDEXHEADER) != SIZEOF_KEYINDEXHEADER)
+        cond = DcmQRIndexDatabaseError ;
+    else if (memcmp (hdr -> magic, DB_KeyIndexMagic, sizeof (DB_KeyIndexMagic)) != 0)
+        cond = DcmQRIndexDatabaseError ;
+    lseek (fd, 0L, SEEK_SET) ;
+    return cond ;
+}
+
+static OFCondition DB_KeyIndexWriteHeader(int fd, DB_KeyIndexHeader *hdr)
+{
+    OFCondition cond = EC_Normal;
+    memcpy (hdr -> magic, DB_KeyIndexMagic, sizeof (DB_KeyIndexMagic)) ;
+    lseek (fd, 0L, SEEK_SET) ;
+    if (write (fd, (char *) hdr, SIZEOF_KEYINDEXHEADER) != SIZEOF_KEYINDEXHEADER)
+        cond = DcmQRIndexDatabaseError ;
+    lseek (fd, 0L, SEEK_SET) ;
+    return cond ;
+}
+
+/*******************
+ *    Copy a key value into a key record, applying the same normalization
+ *    as the corresponding matching function
+ */
+
+static void DB_KeyIndexSetKey (DB_KeyIndexRecord *rec, int keyType, int idx, const char *value)
+{
+    char tmp [DBC_MAXSTRING+1] ;
+
+    bzero ((char *) rec, SIZEOF_KEYINDEXRECORD) ;
+    rec -> keyType = keyType ;
+    rec -> idx = idx ;
+
+    strncpy (tmp, value, DBC_MAXSTRING) ;
+    tmp [DBC_MAXSTRING] = '\0' ;
+
+    if (keyType == KEYINDEX_StudyDate) {
+        /* dates are compared by their numeric value in range matching */
+        DB_RemoveSpaces (tmp) ;
+        sprintf (rec -> key, "%08ld", DB_DateToLong (tmp)) ;
+    }
+    else {
+#ifndef STRICT_COMPARE
+        DB_RemoveEnclosingSpaces (tmp) ;
+#endif
+        strncpy (rec -> key, tmp, LO_MAX_LENGTH) ;
+    }
+}
+
+static void DB_KeyIndexMakeKeys (IdxRecord *idxRec, int idx, DB_KeyIndexRecord *keys)
+{
+    DB_KeyIndexSetKey (&keys [KEYINDEX_PatientID], KEYINDEX_PatientID, idx, idxRec -> PatientID) ;
+    DB_KeyIndexSetKey (&keys [KEYINDEX_StudyDate], KEYINDEX_StudyDate, idx, idxRec -> StudyDate) ;
+    DB_KeyIndexSetKey (&keys [KEYINDEX_StudyInstanceUID], KEYINDEX_StudyInstanceUID, idx, idxRec -> StudyInstanceUID) ;
+    DB_KeyIndexSetKey (&keys [KEYINDEX_SeriesInstanceUID], KEYINDEX_SeriesInstanceUID, idx, idxRec -> SeriesInstanceUID) ;
+    DB_KeyIndexSetKey (&keys [KEYINDEX_SOPInstanceUID], KEYINDEX_SOPInstanceUID, idx, idxRec -> SOPInstanceUID) ;
+}
+
+static int DB_KeyIndexCompare (const void *ve1, const void *ve2)
+{
+    const DB_KeyIndexRecord *e1 = (const DB_KeyIndexRecord *) ve1 ;
+    const DB_KeyIndexRecord *e2 = (const DB_KeyIndexRecord *) ve2 ;
+    int result ;
+
+    if (e1 -> keyType != e2 -> keyType)
+        return (e1 -> keyType < e2 -> keyType) ? -1 : 1 ;
+    result = strcmp (e1 -> key, e2 -> key) ;
+    if (result != 0)
+        return result ;
+    if (e1 -> idx != e2 -> idx)
+        return (e1 -> idx < e2 -> idx) ? -1 : 1 ;
+    return 0 ;
+}
+
+static int DB_IntCompare (const void *ve1, const void *ve2)
+{
+    int i1 = *(const int *) ve1 ;
+    int i2 = *(const int *) ve2 ;
+    return (i1 < i2) ? -1 : ((i1 > i2) ? 1 : 0) ;
+}
+
+/*******************
+ *    Locate a key record relative to a key range.
+ *    If upper is NULL, the range comprises all keys starting with lower.
+ *    Returns -1 if the record sorts before the range, 0 if it is part of
+ *    the range and 1 if it sorts behind the range.
+ */
+
+static int DB_KeyIndexLocate (const DB_KeyIndexRecord *rec, int keyType, const char *lower, const char *upper)
+{
+    if (rec -> keyType != keyType)
+        return (rec -> keyType < keyType) ? -1 : 1 ;
+    if (strcmp (rec -> key, lower) < 0)
+        return -1 ;
+    if (upper == NULL)
+        return (strncmp (rec -> key, lower, strlen (lower)) == 0) ? 0 : 1 ;
+    return (strcmp (rec -> key, upper) > 0) ? 1 : 0 ;
+}
+
+static OFCondition DB_KeyIndexReadRecord (int fd, int pos, DB_KeyIndexRecord *rec)
+{
+    lseek (fd, (long) (SIZEOF_KEYINDEXHEADER + pos * SIZEOF_KEYINDEXRECORD), SEEK_SET) ;
+    if (read (fd, (char *) rec, SIZEOF_KEYINDEXRECORD) != SIZEOF_KEYINDEXRECORD)
+        return DcmQRIndexDatabaseError ;
+    return EC_Normal ;
+}
+
+static OFCondition DB_KeyIndexAddCandidate (DB_Private_Handle *phandle, int *allocated, int idx)
+{
+    if (phandle -> candidateCount == *allocated) {
+        int newSize = (*allocated == 0) ? 64 : 2 * (*allocated) ;
+        int *newList = (int *) realloc (phandle -> candidateList, newSize * sizeof (int)) ;
+        if (newList == NULL)
+            return DcmQRIndexDatabaseError ;
+        phandle -> candidateList = newList ;
+        *allocated = newSize ;
+    }
+    phandle -> candidateList [phandle -> candidateCount++] = idx ;
+    return EC_Normal ;
+}
+
+/*******************
+ *    Append the record numbers of all keys within a key range
+ *    to the candidate list of the handle
+ */
+
+static OFCondition DB_KeyIndexCollect (
+                DB_Private_Handle       *phandle,
+                DB_KeyIndexHeader       *hdr,
+                int                     *allocated,
+                int                     keyType,
+                const char              *lower,
+                const char              *upper)
+{
+    DB_KeyIndexRecord rec ;
+    OFCondition cond = EC_Normal;
+    int low = 0 ;
+    int high = hdr -> sortedCount ;
+    int pos ;
+
+    /*** Binary search for the first key of the range in the sorted block
+    **/
+
+    while (low < high) {
+        int mid = low + (high - low) / 2 ;
+        cond = DB_KeyIndexReadRecord (phandle -> pkey, mid, &rec) ;
+        if (cond.bad())
+            return cond ;
+        if (DB_KeyIndexLocate (&rec, keyType, lower, upper) < 0)
+            low = mid + 1 ;
+        else
+            high = mid ;
+    }
+
+    /*** Read the range sequentially
+    **/
+
+    lseek (phandle -> pkey, (long) (SIZEOF_KEYINDEXHEADER + low * SIZEOF_KEYINDEXRECORD), SEEK_SET) ;
+    for (pos = low ; pos < hdr -> sortedCount ; pos++) {
+        if (read (phandle -> pkey, (char *) &rec, SIZEOF_KEYINDEXRECORD) != SIZEOF_KEYINDEXRECORD)
+            return DcmQRIndexDatabaseError ;
+        if (DB_KeyIndexLocate (&rec, keyType, lower, upper) != 0)
+            break ;
+        cond = DB_KeyIndexAddCandidate (phandle, allocated, rec. idx) ;
+        if (cond.bad())
+            return cond ;
+    }
+
+    /*** The journal is small and unsorted, read it completely
+    **/
+
+    lseek (phandle -> pkey, (long) (SIZEOF_KEYINDEXHEADER + hdr -> sortedCount * SIZEOF_KEYINDEXRECORD), SEEK_SET) ;
+    for (pos = 0 ; pos < hdr -> journalCount ; pos++) {
+        if (read (phandle -> pkey, (char *) &rec, SIZEOF_KEYINDEXRECORD) != SIZEOF_KEYINDEXRECORD)
+            return DcmQRIndexDatabaseError ;
+        if (DB_KeyIndexLocate (&rec, keyType, lower, upper) != 0)
+            continue ;
+        cond = DB_KeyIndexAddCandidate (phandle, allocated, rec. idx) ;
+        if (cond.bad())
+            return cond ;
+    }
+
+    lseek (phandle -> pkey, 0L, SEEK_SET) ;
+    return EC_Normal ;
+}
+
+OFBool DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexApplicable(DcmTagKey tag, DB_LEVEL infLevel)
+{
+    DB_LEVEL tagLevel ;
+    DcmTagKey uidTag ;
+
+    if (DB_GetTagLevel (tag, &tagLevel) != EC_Normal)
+        return OFFalse ;
+
+    /** Keys above the information model are only matched for
+    ** patient keys in the Study Root Information Model at the study level
+    */
+
+    if (tagLevel < infLevel)
+        return (tagLevel == PATIENT_LEVEL)
+            && (handle -> queryLevel == STUDY_LEVEL)
+            && (infLevel == STUDY_LEVEL) ;
+
+    /** Keys below the query level are never matched
+    */
+
+    if (tagLevel > handle -> queryLevel)
+        return OFFalse ;
+
+    /** All keys at the query level are matched,
+    ** above the query level only the unique keys
+    */
+
+    if (tagLevel == handle -> queryLevel)
+        return OFTrue ;
+    if (DB_GetUIDTag (tagLevel, &uidTag) != EC_Normal)
+        return OFFalse ;
+    return (tag == uidTag) ;
+}
+
+void DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexFreeCandidates()
+{
+    if (handle -> candidateList)
+        free (handle -> candidateList) ;
+    handle -> candidateList = NULL ;
+    handle -> candidateCount = -1 ;
+    handle -> candidatePos = 0 ;
+}
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexLookup(DB_LEVEL infLevel)
+{
+    /* key types in the order of their expected selectivity */
+    static const int keyTypes [NBKEYINDEXKEYS] = {
+        KEYINDEX_SOPInstanceUID, KEYINDEX_SeriesInstanceUID, KEYINDEX_StudyInstanceUID,
+        KEYINDEX_PatientID, KEYINDEX_StudyDate
+    } ;
+    static const DcmTagKey keyTags [NBKEYINDEXKEYS] = {
+        DCM_SOPInstanceUID, DCM_SeriesInstanceUID, DCM_StudyInstanceUID,
+        DCM_PatientID, DCM_StudyDate
+    } ;
+
+    DB_KeyIndexHeader   hdr ;
+    DB_ElementList      *plist = NULL ;
+    char                modl [DBC_MAXSTRING+1] ;
+    char                lower [LO_MAX_LENGTH+1] ;
+    char                upper [LO_MAX_LENGTH+1] ;
+    char                *pc ;
+    int                 allocated = 0 ;
+    int                 k ;
+    int                 i ;
+    OFCondition         cond = EC_Normal ;
+
+    DB_KeyIndexFreeCandidates () ;
+
+    /**** The key index can only be used if it is consistent
+    **** with the current index file
+    ***/
+
+    if (handle -> pkey < 0)
+        return DcmQRIndexDatabaseError ;
+    if (DB_KeyIndexReadHeader (handle -> pkey, &hdr) != EC_Normal)
+        return DcmQRIndexDatabaseError ;
+    if (!hdr. valid || (hdr. indexFileSize != DB_FileSize (handle -> pidx)))
+        return DcmQRIndexDatabaseError ;
+
+    /**** Find the most selective key that restricts the result set
+    ***/
+
+    for (k = 0 ; k < NBKEYINDEXKEYS ; k++) {
+        for (plist = handle -> findRequestList ; plist ; plist = plist -> next)
+            if ((plist -> elem. XTag == keyTags [k]) && (plist -> elem. ValueLength > 0)
+                && (plist -> elem. PValueField != NULL))
+                break ;
+        if ((plist == NULL) || !DB_KeyIndexApplicable (keyTags [k], infLevel))
+            continue ;
+
+        /** A pattern starting with a wild card does not restrict the keys
+        */
+
+        if (keyTypes [k] == KEYINDEX_PatientID) {
+            strncpy (modl, plist -> elem. PValueField, DBC_MAXSTRING) ;
+            modl [DBC_MAXSTRING] = '\0' ;
+#ifndef STRICT_COMPARE
+            DB_RemoveEnclosingSpaces (modl) ;
+#endif
+            if (strcspn (modl, "*?") == 0)
+                continue ;
+        }
+        break ;
+    }
+    if (k == NBKEYINDEXKEYS)
+        return DcmQRIndexDatabaseError ;
+
+    strncpy (modl, plist -> elem. PValueField, DBC_MAXSTRING) ;
+    modl [DBC_MAXSTRING] = '\0' ;
+    handle -> candidateCount = 0 ;
+
+    switch (keyTypes [k]) {
+
+    case KEYINDEX_StudyDate :
+
+        /*** Date range matching, see matchDate()
+        **/
+
+        DB_RemoveSpaces (modl) ;
+        if ((pc = strchr (modl, '-')) == NULL) {
+            sprintf (lower, "%08ld", DB_DateToLong (modl)) ;
+            strcpy (upper, lower) ;
+        }
+        else if (modl [0] == '-') {
+            strcpy (lower, "00000000") ;
+            sprintf (upper, "%08ld", DB_DateToLong (modl + 1)) ;
+        }
+        else if (modl [strlen (modl) - 1] == '-') {
+            modl [strlen (modl) - 1] = '\0' ;
+            sprintf (lower, "%08ld", DB_DateToLong (modl)) ;
+            strcpy (upper, "99999999") ;
+        }
+        else {
+            *pc = '\0' ;
+            sprintf (lower, "%08ld", DB_DateToLong (modl)) ;
+            sprintf (upper, "%08ld", DB_DateToLong (pc + 1)) ;
+        }
+        cond = DB_KeyIndexCollect (handle, &hdr, &allocated, keyTypes [k], lower, upper) ;
+        break ;
+
+    case KEYINDEX_PatientID :
+
+        /*** String matching, see matchStrings(). With wild cards,
+        *** all matching values start with the characters in front of them.
+        **/
+
+#ifndef STRICT_COMPARE
+        DB_RemoveEnclosingSpaces (modl) ;
+#endif
+        i = (int) strcspn (modl, "*?") ;
+        if (i > LO_MAX_LENGTH)
+            i = LO_MAX_LENGTH ;
+        strncpy (lower, modl, (size_t) i) ;
+        lower [i] = '\0' ;
+        cond = DB_KeyIndexCollect (handle, &hdr, &allocated, keyTypes [k], lower,
+            (strpbrk (modl, "*?") == NULL) ? lower : NULL) ;
+        break ;
+
+    default :
+
+        /*** UID matching, see matchUID(). A UID list is looked up
+        *** one UID after the other.
+        **/
+
+#ifndef STRICT_COMPARE
+        DB_RemoveEnclosingSpaces (modl) ;
+#endif
+        for (pc = modl ; cond.good() ; ) {
+            i = (int) strcspn (pc, "\\") ;
+            strncpy (lower, pc, (size_t) ((i < LO_MAX_LENGTH) ? i : LO_MAX_LENGTH)) ;
+            lower [(i < LO_MAX_LENGTH) ? i : LO_MAX_LENGTH] = '\0' ;
+            cond = DB_KeyIndexCollect (handle, &hdr, &allocated, keyTypes [k], lower, lower) ;
+            if (pc [i] == '\0')
+                break ;
+            pc += i + 1 ;
+        }
+        break ;
+    }
+
+    if (cond.bad()) {
+        DB_KeyIndexFreeCandidates () ;
+        return cond ;
+    }
+
+    /**** Visit the candidates in index file order, each one only once
+    ***/
+
+    if (handle -> candidateCount > 1) {
+        qsort ((char *) handle -> candidateList, handle -> candidateCount, sizeof (int), DB_IntCompare) ;
+        for (i = 1, k = 1 ; i < handle -> candidateCount ; i++)
+            if (handle -> candidateList [i] != handle -> candidateList [k - 1])
+                handle -> candidateList [k++] = handle -> candidateList [i] ;
+        handle -> candidateCount = k ;
+    }
+
+#ifdef DEBUG
+    dbdebug(1, "DB_KeyIndexLookup () : %d candidate records\n", handle -> candidateCount) ;
+#endif
+    return EC_Normal ;
+}
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxGetNextCandidate(int *idx, IdxRecord *idxRec)
+{
+    if (handle -> candidateCount < 0)
+        return DB_IdxGetNext (idx, idxRec) ;
+
+    while (handle -> candidatePos < handle -> candidateCount) {
+        *idx = handle -> candidateList [handle -> candidatePos++] ;
+        if ((DB_IdxRead (*idx, idxRec) == EC_Normal) && (idxRec -> filename [0] != '\0'))
+            return EC_Normal ;
+    }
+    return DcmQRIndexDatabaseError ;
+}
+
+OFBool DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexBeginUpdate()
+{
+    DB_KeyIndexHeader hdr ;
+    OFBool consistent ;
+
+    if (handle -> pkey < 0)
+        return OFFalse ;
+
+    bzero ((char *) &hdr, SIZEOF_KEYINDEXHEADER) ;
+    consistent = (DB_KeyIndexReadHeader (handle -> pkey, &hdr) == EC_Normal)
+        && hdr. valid
+        && (hdr. indexFileSize == DB_FileSize (handle -> pidx)) ;
+
+    /* invalidate until DB_KeyIndexCommit() has been called */
+    hdr. valid = 0 ;
+    DB_KeyIndexWriteHeader (handle -> pkey, &hdr) ;
+    return consistent ;
+}
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexCommit(int idx, IdxRecord *idxRec, OFBool wasConsistent)
+{
+    DB_KeyIndexHeader hdr ;
+    DB_KeyIndexRecord keys [NBKEYINDEXKEYS] ;
+
+    if (handle -> pkey < 0)
+        return DcmQRIndexDatabaseError ;
+
+    if (!wasConsistent || (DB_KeyIndexReadHeader (handle -> pkey, &hdr) != EC_Normal))
+        return DB_KeyIndexMerge (OFTrue) ;
+
+    /**** Append the keys of the new record to the journal
+    ***/
+
+    DB_KeyIndexMakeKeys (idxRec, idx, keys) ;
+    lseek (handle -> pkey, (long) (SIZEOF_KEYINDEXHEADER + (hdr. sortedCount + hdr. journalCount) * SIZEOF_KEYINDEXRECORD), SEEK_SET) ;
+    if (write (handle -> pkey, (char *) keys, sizeof (keys)) != sizeof (keys)) {
+        lseek (handle -> pkey, 0L, SEEK_SET) ;
+        return DcmQRIndexDatabaseError ;
+    }
+    hdr. journalCount += NBKEYINDEXKEYS ;
+
+    if (hdr. journalCount >= KEYINDEX_MAX_JOURNAL) {
+        if (DB_KeyIndexWriteHeader (handle -> pkey, &hdr) != EC_Normal)
+            return DcmQRIndexDatabaseError ;
+        return DB_KeyIndexMerge (OFFalse) ;
+    }
+
+    hdr. valid = 1 ;
+    hdr. indexFileSize = DB_FileSize (handle -> pidx) ;
+    return DB_KeyIndexWriteHeader (handle -> pkey, &hdr) ;
+}
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexMerge(OFBool rebuild)
+{
+    DB_KeyIndexHeader   hdr ;
+    DB_KeyIndexRecord   *keys = NULL ;
+    DB_IdxRecordHeader  recHdr ;
+    IdxRecord           idxRec ;
+    const char          *rec ;
+    long                records ;
+    long                pos ;
+    int                 count = 0 ;
+    int                 allocated ;
+    int                 idx ;
+    int                 i ;
+    int                 n ;
+
+    if (handle -> pkey < 0)
+        return DcmQRIndexDatabaseError ;
+
+    /**** Stale keys of removed records are dropped by rebuilding
+    **** once they outnumber the keys of the records in the index file
+    ***/
+
+    bzero ((char *) &hdr, SIZEOF_KEYINDEXHEADER) ;
+    if (!rebuild && (DB_KeyIndexReadHeader (handle -> pkey, &hdr) != EC_Normal))
+        rebuild = OFTrue ;
+    if (!rebuild) {
+        records = 0 ;
+        pos = SIZEOF_INDEXFILEHEADER ;
+        while ((rec = DB_IdxScanRecord (handle, pos, OFFalse)) != NULL) {
+            memcpy (&recHdr, rec, SIZEOF_IDXRECORDHEADER) ;
+            pos += recHdr. capacity ;
+            records++ ;
+        }
+        if (hdr. sortedCount + hdr. journalCount > 2 * NBKEYINDEXKEYS * records)
+            rebuild = OFTrue ;
+    }
+
+    if (rebuild) {
+#ifdef DEBUG
+        dbdebug(1, "DB_KeyIndexMerge () : rebuilding key index\n") ;
+#endif
+        allocated = 1024 * NBKEYINDEXKEYS ;
+        keys = (DB_KeyIndexRecord *) malloc (allocated * SIZEOF_KEYINDEXRECORD) ;
+        if (keys == NULL) {
+            CERR << "DB_KeyIndexMerge: out of memory" << endl;
+            return DcmQRIndexDatabaseError ;
+        }
+        DB_IdxInitLoop (&idx) ;
+        while (DB_IdxGetNext (&idx, &idxRec) == EC_Normal) {
+            if (count + NBKEYINDEXKEYS > allocated) {
+                DB_KeyIndexRecord *grown = (DB_KeyIndexRecord *) realloc (keys, 2 * allocated * SIZEOF_KEYINDEXRECORD) ;
+                if (grown == NULL) {
+                    free (keys) ;
+                    CERR << "DB_KeyIndexMerge: out of memory" << endl;
+                    return DcmQRIndexDatabaseError ;
+                }
+                keys = grown ;
+                allocated *= 2 ;
+            }
+            DB_KeyIndexMakeKeys (&idxRec, idx, keys + count) ;
+            count += NBKEYINDEXKEYS ;
+        }
+    }
+    else {
+        count = hdr. sortedCount + hdr. journalCount ;
+        keys = (DB_KeyIndexRecord *) malloc ((count + 1) * SIZEOF_KEYINDEXRECORD) ;
+        if (keys == NULL) {
+            CERR << "DB_KeyIndexMerge: out of memory" << endl;
+            return DcmQRIndexDatabaseError ;
+        }
+        lseek (handle -> pkey, (long) SIZEOF_KEYINDEXHEADER, SEEK_SET) ;
+        if (read (handle -> pkey, (char *) keys, count * SIZEOF_KEYINDEXRECORD) != (int) (count * SIZEOF_KEYINDEXRECORD)) {
+            free (keys) ;
+            lseek (handle -> pkey, 0L, SEEK_SET) ;
+            return DB_KeyIndexMerge (OFTrue) ;
+        }
+    }
+
+    /**** Sort and remove duplicate keys
+    ***/
+
+    if (count > 1) {
+        qsort ((char *) keys, count, SIZEOF_KEYINDEXRECORD, DB_KeyIndexCompare) ;
+        for (i = 1, n = 1 ; i < count ; i++)
+            if (DB_KeyIndexCompare (&keys [i], &keys [n - 1]) != 0)
+                memcpy (&keys [n++], &keys [i], SIZEOF_KEYINDEXRECORD) ;
+        count = n ;
+    }
+
+    hdr. valid = 0 ;
+    hdr. sortedCount = count ;
+    hdr. journalCount = 0 ;
+    hdr. indexFileSize = DB_FileSize (handle -> pidx) ;
+    if (DB_KeyIndexWriteHeader (handle -> pkey, &hdr) != EC_Normal) {
+        free (keys) ;
+        return DcmQRIndexDatabaseError ;
+    }
+
+    lseek (handle -> pkey, (long) SIZEOF_KEYINDEXHEADER, SEEK_SET) ;
+    if ((count > 0) && (write (handle -> pkey, (char *) keys, count * SIZEOF_KEYINDEXRECORD) != (int) (count * SIZEOF_KEYINDEXRECORD))) {
+        free (keys) ;
+        lseek (handle -> pkey, 0L, SEEK_SET) ;
+        return DcmQRIndexDatabaseError ;
+    }
+    free (keys) ;
+    ftruncate (handle -> pkey, (off_t) (SIZEOF_KEYINDEXHEADER + count * SIZEOF_KEYINDEXRECORD)) ;
+
+    hdr. valid = 1 ;
+    return DB_KeyIndexWriteHeader (handle -> pkey, &hdr) ;
+}
+
+
 /* ==================================================================== */
 
 DcmQueryRetrieveDatabaseHandle::~DcmQueryRetrieveDatabaseHandle()
@@ -1789,61 +2907,131 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
     }
 
     /**** Goto the beginning of Index File
-    **** Then find the first matching image
+    **** Then find all matching images.
+    **** The responses are collected while the index file is locked, so that
+    **** the lock is not held while they are sent to the peer.
     ***/
 
     DB_lock(OFFalse);
 
     DB_IdxInitLoop (&(handle->idxCounter)) ;
-    MatchFound = OFFalse ;
+    DB_FreeResponseList (handle->pendingResponseList) ;
+    handle->pendingResponseList = NULL ;
+    DB_ResponseList *lastResponse = NULL ;
+    Uint16 failedStatus = STATUS_FIND_Failed_UnableToProcess ;
     cond = EC_Normal ;
 
-    while (1) {
+    /**** Repeated queries are answered from the query result cache
+    **** as long as no index record has been added or removed
+    ***/
+
+    DcmQueryRetrieveFindCache& findCache = DcmQueryRetrieveFindCache::instance() ;
+    DcmQueryRetrieveFindCacheResult cachedResult ;
+    OFString cacheKey ;
+    unsigned long generation = 0 ;
+    OFBool cacheHit = OFFalse ;
+
+    if (findCache. enabled ()) {
+        DcmQueryRetrieveFindCache::makeKey (SOPClassUID, findRequestIdentifiers, cacheKey) ;
+        generation = DB_IdxGetGeneration (handle->pidx) ;
+        cacheHit = findCache. lookup (handle->storageArea, generation, cacheKey, cachedResult) ;
+    }
+    if (cacheHit) {
+        cond = DB_ResponseListFromCache (&cachedResult, &(handle->pendingResponseList)) ;
+        if (cond != EC_Normal)
+            failedStatus = STATUS_FIND_Refused_OutOfResources ;
+    }
+    else
+        DB_KeyIndexLookup (qLevel) ;
+
+    while (! cacheHit) {
 
         /*** Exit loop if read error (or end of file)
         **/
 
-        if (DB_IdxGetNext (&(handle->idxCounter), &idxRec) != EC_Normal)
+        if (DB_IdxGetNextCandidate (&(handle->idxCounter), &idxRec) != EC_Normal)
+            break ;
+
+        /*** If Response already found
+        **/
+
+        if (DB_UIDAlreadyFound (handle, &idxRec))
+            continue ;
+
+        /*** Exit loop if error
+        **/
+
+        MatchFound = OFFalse ;
+        cond = hierarchicalCompare (handle, &idxRec, qLevel, qLevel, &MatchFound) ;
+        if (cond != EC_Normal)
             break ;
+        if (! MatchFound)
+            continue ;
 
-        /*** Exit loop if error or matching OK
+        /*** Append the response to the pending responses
         **/
 
-        cond = hierarchicalCompare (handle, &idxRec, qLevel, qLevel, &MatchFound) ;
-        if (cond != EC_Normal)
-            break ;
-        if (MatchFound)
-            break ;
+        DB_ResponseList *presp = (DB_ResponseList *) malloc (sizeof (DB_ResponseList)) ;
+        if (presp == NULL) {
+            failedStatus = STATUS_FIND_Refused_OutOfResources ;
+            cond = DcmQRIndexDatabaseError ;
+            break ;
+        }
+        DB_UIDAddFound (handle, &idxRec) ;
+        makeResponseList (handle, &idxRec) ;
+        presp->elements = handle->findResponseList ;
+        presp->next = NULL ;
+        handle->findResponseList = NULL ;
+        if (lastResponse == NULL)
+            handle->pendingResponseList = lastResponse = presp ;
+        else {
+            lastResponse->next = presp ;
+            lastResponse = presp ;
+        }
+    }
+
+    if (! cacheHit && (cond == EC_Normal) && findCache. enabled ()) {
+        DcmQueryRetrieveFindCacheResult result ;
+        OFList<OFString> restrictions ;
+        if (DB_ResponseListToCache (handle->pendingResponseList, findCache. maxResponses (), &result)) {
+            DcmQueryRetrieveFindCache::getRestrictions (findRequestIdentifiers, restrictions) ;
+            findCache. insert (handle->storageArea, generation, cacheKey, restrictions, result) ;
+        }
     }
 
+    DB_unlock();
+
+    handle->idxCounter = -1 ;
+    DB_FreeElementList (handle->findRequestList) ;
+    handle->findRequestList = NULL ;
+    DB_FreeUidList (handle->uidList) ;
+    handle->uidList = NULL ;
+    DB_KeyIndexFreeCandidates () ;
+
     /**** If an error occured in Matching function
     ****    return a failed status
     ***/
 
     if (cond != EC_Normal) {
-        handle->idxCounter = -1 ;
-        DB_FreeElementList (handle->findRequestList) ;
-        handle->findRequestList = NULL ;
+        DB_FreeResponseList (handle->pendingResponseList) ;
+        handle->pendingResponseList = NULL ;
 #ifdef DEBUG
         dbdebug(1, "DB_startFindRequest () : STATUS_FIND_Failed_UnableToProcess\n") ;
 #endif
-        status->setStatus(STATUS_FIND_Failed_UnableToProcess);
-
-        DB_unlock();
-
+        status->setStatus(failedStatus);
         return (cond) ;
     }
 
-
     /**** If a matching image has been found,
-    ****         add index record to UID found list
-    ****    prepare Response List in handle
+    ****    prepare the first response in handle
     ****    return status is pending
     ***/
 
-    if (MatchFound) {
-        DB_UIDAddFound (handle, &idxRec) ;
-        makeResponseList (handle, &idxRec) ;
+    if (handle->pendingResponseList) {
+        DB_ResponseList *presp = handle->pendingResponseList ;
+        handle->findResponseList = presp->elements ;
+        handle->pendingResponseList = presp->next ;
+        free (presp) ;
 #ifdef DEBUG
         dbdebug(1, "DB_startFindRequest () : STATUS_Pending\n") ;
 #endif
@@ -1852,21 +3040,14 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
     }
 
     /**** else no matching image has been found,
-    ****    free query identifiers list
     ****    status is success
     ***/
 
     else {
-        handle->idxCounter = -1 ;
-        DB_FreeElementList (handle->findRequestList) ;
-        handle->findRequestList = NULL ;
 #ifdef DEBUG
         dbdebug(1, "DB_startFindRequest () : STATUS_Success\n") ;
 #endif
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
@@ -1882,11 +3063,8 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
 {
 
     DB_ElementList      *plist = NULL;
-    int                 MatchFound = OFFalse;
-    IdxRecord           idxRec ;
-    DB_LEVEL            qLevel = PATIENT_LEVEL;
+    DB_ResponseList     *presp = NULL;
     const char          *queryLevelString = NULL;
-    OFCondition         cond = EC_Normal;
 
     if (handle->findResponseList == NULL) {
 #ifdef DEBUG
@@ -1894,9 +3072,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
 #endif
         *findResponseIdentifiers = NULL ;
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
@@ -1961,103 +3136,24 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
 #endif
     }
     else {
-
-        DB_unlock();
-
         return (DcmQRIndexDatabaseError) ;
     }
 
-    switch (handle->rootLevel) {
-    case PATIENT_ROOT : qLevel = PATIENT_LEVEL ;        break ;
-    case STUDY_ROOT :   qLevel = STUDY_LEVEL ;          break ;
-    case PATIENT_STUDY: qLevel = PATIENT_LEVEL ;        break ;
-    }
-
-    /***** Free the last response...
+    /***** Free the last response and prepare the next one
+    ***** from the responses collected by startFindRequest().
+    ***** If there is none, the next call will return STATUS_Success
     ****/
 
     DB_FreeElementList (handle->findResponseList) ;
     handle->findResponseList = NULL ;
 
-    /***** ... and find the next one
-    ****/
-
-    MatchFound = OFFalse ;
-    cond = EC_Normal ;
-
-    while (1) {
-
-        /*** Exit loop if read error (or end of file)
-        **/
-
-        if (DB_IdxGetNext (&(handle->idxCounter), &idxRec) != EC_Normal)
-            break ;
-
-        /*** If Response already found
-        **/
-
-        if (DB_UIDAlreadyFound (handle, &idxRec))
-            continue ;
-
-        /*** Exit loop if error or matching OK
-        **/
-
-        cond = hierarchicalCompare (handle, &idxRec, qLevel, qLevel, &MatchFound) ;
-        if (cond != EC_Normal)
-            break ;
-        if (MatchFound)
-            break ;
-
-    }
-
-    /**** If an error occured in Matching function
-    ****    return status is pending
-    ***/
-
-    if (cond != EC_Normal) {
-        handle->idxCounter = -1 ;
-        DB_FreeElementList (handle->findRequestList) ;
-        handle->findRequestList = NULL ;
-#ifdef DEBUG
-        dbdebug(1, "DB_nextFindResponse () : STATUS_FIND_Failed_UnableToProcess\n") ;
-#endif
-        status->setStatus(STATUS_FIND_Failed_UnableToProcess);
-
-        DB_unlock();
-
-        return (cond) ;
-    }
-
-
-    /**** If a matching image has been found
-    ****    add index records UIDs in found UID list
-    ****    prepare Response List in handle
-    ***/
-
-    if (MatchFound) {
-        DB_UIDAddFound (handle, &idxRec) ;
-        makeResponseList (handle, &idxRec) ;
-#ifdef DEBUG
-        dbdebug(1, "DB_nextFindResponse () : STATUS_Pending\n") ;
-#endif
-        status->setStatus(STATUS_Pending);
-        return (EC_Normal) ;
-    }
-
-    /**** else no matching image has been found,
-    ****    free query identifiers list
-    **** Response list is null, so next call will return STATUS_Success
-    ***/
-
-    else {
-        handle->idxCounter = -1 ;
-        DB_FreeElementList (handle->findRequestList) ;
-        handle->findRequestList = NULL ;
-        DB_FreeUidList (handle->uidList) ;
-        handle->uidList = NULL ;
+    presp = handle->pendingResponseList ;
+    if (presp) {
+        handle->findResponseList = presp->elements ;
+        handle->pendingResponseList = presp->next ;
+        free (presp) ;
     }
 
-
 #ifdef DEBUG
     dbdebug(1, "DB_nextFindResponse () : STATUS_Pending\n") ;
 #endif
@@ -2077,13 +3173,13 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::cancelFindRequest (DcmQueryRetr
     handle->findRequestList = NULL ;
     DB_FreeElementList (handle->findResponseList) ;
     handle->findResponseList = NULL ;
+    DB_FreeResponseList (handle->pendingResponseList) ;
+    handle->pendingResponseList = NULL ;
+    DB_KeyIndexFreeCandidates () ;
     DB_FreeUidList (handle->uidList) ;
     handle->uidList = NULL ;
 
     status->setStatus(STATUS_FIND_Cancel_MatchingTerminatedDueToCancelRequest);
-
-    DB_unlock();
-
     return (EC_Normal) ;
 }
 
@@ -2396,18 +3492,21 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
     handle->moveCounterList = NULL ;
     handle->NumberRemainOperations = 0 ;
 
-    /**** Find matching images
+    /**** Find matching images.
+    **** The file names and UIDs of the matching images are copied,
+    **** so that the lock is not held during the sub-operations.
     ***/
 
     DB_lock(OFFalse);
 
     DB_IdxInitLoop (&(handle->idxCounter)) ;
+    DB_KeyIndexLookup (qLevel) ;
     while (1) {
 
         /*** Exit loop if read error (or end of file)
         **/
 
-        if (DB_IdxGetNext (&(handle->idxCounter), &idxRec) != EC_Normal)
+        if (DB_IdxGetNextCandidate (&(handle->idxCounter), &idxRec) != EC_Normal)
             break ;
 
         /*** If matching found
@@ -2418,11 +3517,15 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
             pidxlist = (DB_CounterList *) malloc (sizeof( DB_CounterList ) ) ;
             if (pidxlist == NULL) {
                 status->setStatus(STATUS_FIND_Refused_OutOfResources);
+                DB_unlock();
                 return (DcmQRIndexDatabaseError) ;
             }
 
             pidxlist->next = NULL ;
             pidxlist->idxCounter = handle->idxCounter ;
+            strcpy (pidxlist->SOPClassUID, idxRec. SOPClassUID) ;
+            strcpy (pidxlist->SOPInstanceUID, idxRec. SOPInstanceUID) ;
+            strcpy (pidxlist->filename, idxRec. filename) ;
             handle->NumberRemainOperations++ ;
             if ( handle->moveCounterList == NULL )
                 handle->moveCounterList = lastidxlist = pidxlist ;
@@ -2434,8 +3537,11 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
         }
     }
 
+    DB_unlock();
+
     DB_FreeElementList (handle->findRequestList) ;
     handle->findRequestList = NULL ;
+    DB_KeyIndexFreeCandidates () ;
 
     /**** If a matching image has been found,
     ****    status is pending
@@ -2460,9 +3566,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
         dbdebug(1,"DB_startMoveRequest : STATUS_Success\n") ;
 #endif
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
@@ -2476,38 +3579,24 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextMoveResponse(
                 unsigned short  *numberOfRemainingSubOperations,
                 DcmQueryRetrieveDatabaseStatus  *status)
 {
-    IdxRecord           idxRec ;
     DB_CounterList              *nextlist ;
 
     /**** If all matching images have been retrieved,
     ****    status is success
     ***/
 
-    if ( handle->NumberRemainOperations <= 0 ) {
+    if ( handle->NumberRemainOperations <= 0 || handle->moveCounterList == NULL ) {
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
-    /**** Goto the next matching image number of Index File
+    /**** Take the next matching image from the list
+    **** collected by startMoveRequest()
     ***/
 
-    if (DB_IdxRead (handle->moveCounterList->idxCounter, &idxRec) != EC_Normal) {
-#ifdef DEBUG
-        dbdebug(1,"DB_nextMoveResponse : STATUS_MOVE_Failed_UnableToProcess\n") ;
-#endif
-        status->setStatus(STATUS_MOVE_Failed_UnableToProcess);
-
-        DB_unlock();
-
-        return (DcmQRIndexDatabaseError) ;
-    }
-
-    strcpy (SOPClassUID, (char *) idxRec. SOPClassUID) ;
-    strcpy (SOPInstanceUID, (char *) idxRec. SOPInstanceUID) ;
-    strcpy (imageFileName, (char *) idxRec. filename) ;
+    strcpy (SOPClassUID, handle->moveCounterList->SOPClassUID) ;
+    strcpy (SOPInstanceUID, handle->moveCounterList->SOPInstanceUID) ;
+    strcpy (imageFileName, handle->moveCounterList->filename) ;
 
     *numberOfRemainingSubOperations = --handle->NumberRemainOperations ;
 
@@ -2533,11 +3622,9 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::cancelMoveRequest (DcmQueryRetr
         handle->moveCounterList = handle->moveCounterList->next ;
         free (plist) ;
     }
+    handle->NumberRemainOperations = 0 ;
 
     status->setStatus(STATUS_MOVE_Cancel_SubOperationsTerminatedDueToCancelIndication);
-
-    DB_unlock();
-
     return (EC_Normal) ;
 }
 
@@ -2611,7 +3698,7 @@ int DcmQueryRetrieveIndexDatabaseHandle::deleteOldestStudy(StudyDescRecord *pStu
     double OldestDate ;
     int s ;
     int n ;
-    int idx = 0 ;
+    int idx ;
     IdxRecord idxRec ;
 
     oldestStudy = 0 ;
@@ -2621,7 +3708,7 @@ int DcmQueryRetrieveIndexDatabaseHandle::deleteOldestStudy(StudyDescRecord *pStu
     dbdebug(1, "deleteOldestStudy\n") ;
 #endif
 
-    for ( s = 0 ; s < handle -> maxStudiesAllowed ; s++ ) {
+    for ( s = 0 ; s < handle -> studyDescCount ; s++ ) {
     if ( ( pStudyDesc[s]. NumberofRegistratedImages != 0 ) &&
         ( ( OldestDate == 0.0 ) || ( pStudyDesc[s]. LastRecordedDate < OldestDate ) ) ) {
         OldestDate = pStudyDesc[s]. LastRecordedDate ;
@@ -2634,13 +3721,13 @@ int DcmQueryRetrieveIndexDatabaseHandle::deleteOldestStudy(StudyDescRecord *pStu
 #endif
 
     n = strlen(pStudyDesc[oldestStudy].StudyInstanceUID) ;
-    while ( DB_IdxRead (idx, &idxRec) == EC_Normal ) {
+    DB_IdxInitLoop (&idx) ;
+    while ( DB_IdxGetNext (&idx, &idxRec) == EC_Normal ) {
 
     if ( ! ( strncmp(idxRec. StudyInstanceUID, pStudyDesc[oldestStudy].StudyInstanceUID, n) ) ) {
         DB_IdxRemove (idx) ;
         deleteImageFile(idxRec.filename);
     }
-    idx++ ;
     }
 
     pStudyDesc[oldestStudy].NumberofRegistratedImages = 0 ;
@@ -2736,6 +3823,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::deleteOldestImages(StudyDescRec
  *   If the study UID exists, its index in the study descriptor is returned.
  *   If the study UID does not exist, the index of the first unused descriptor entry is returned.
  *   If no entries are free, maxStudiesAllowed is returned.
+ *   maxStudiesAllowed is the number of entries in pStudyDesc.
  */
 
 int DcmQueryRetrieveIndexDatabaseHandle::matchStudyUIDInStudyDesc (StudyDescRecord *pStudyDesc, char *StudyUID, int maxStudiesAllowed)
@@ -2769,12 +3857,12 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::checkupinStudyDesc(StudyDescRec
     long        RequiredSize ;
 
     s = matchStudyUIDInStudyDesc (pStudyDesc, StudyUID,
-                     (int)(handle -> maxStudiesAllowed)) ;
+                     handle -> studyDescCount) ;
 
     /** If Study already exists
      */
 
-    if ( pStudyDesc[s]. NumberofRegistratedImages != 0 ) {
+    if ( ( s < handle -> studyDescCount ) && ( pStudyDesc[s]. NumberofRegistratedImages != 0 ) ) {
 
 #ifdef DEBUG
     dbdebug(1, "checkupinStudyDesc: study already exists : %d\n",s) ;
@@ -2809,7 +3897,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::checkupinStudyDesc(StudyDescRec
 #endif
         return ( DcmQRIndexDatabaseError ) ;
     }
-    if ( s > ( handle -> maxStudiesAllowed - 1 ) )
+    if ( s > ( handle -> studyDescCount - 1 ) )
         s = deleteOldestStudy(pStudyDesc) ;
 
     }
@@ -2843,19 +3931,20 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::removeDuplicateImage(
     StudyDescRecord *pStudyDesc, const char *newImageFileName)
 {
 
-    int idx = 0;
+    int idx ;
     IdxRecord       idxRec ;
     int studyIdx = 0;
 
     studyIdx = matchStudyUIDInStudyDesc (pStudyDesc, (char*)StudyInstanceUID,
-                        (int)(handle -> maxStudiesAllowed)) ;
+                        handle -> studyDescCount) ;
 
-    if ( pStudyDesc[studyIdx].NumberofRegistratedImages == 0 ) {
+    if ( ( studyIdx == handle -> studyDescCount ) || ( pStudyDesc[studyIdx].NumberofRegistratedImages == 0 ) ) {
     /* no study images, cannot be any old images */
     return EC_Normal;
     }
 
-    while (DB_IdxRead(idx, &idxRec) == EC_Normal) {
+    DB_IdxInitLoop (&idx) ;
+    while (DB_IdxGetNext(&idx, &idxRec) == EC_Normal) {
 
     if (strcmp(idxRec.SOPInstanceUID, SOPInstanceUID) == 0) {
 
@@ -2875,7 +3964,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::removeDuplicateImage(
         pStudyDesc[studyIdx].NumberofRegistratedImages--;
         pStudyDesc[studyIdx].StudySize -= idxRec.ImageSize;
     }
-    idx++;
     }
     /* the study record should be written to file later */
     return EC_Normal;
@@ -2886,10 +3974,61 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::removeDuplicateImage(
 **  Add data from imageFileName to database
  */
 
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
+    const char  *SOPClassUID,
+    const char  *SOPInstanceUID,
+    const char  *imageFileName,
+    DcmQueryRetrieveDatabaseStatus   *status,
+    OFBool      isNew)
+{
+    /**** Get IdxRec values from ImageFile
+    ***/
+
+    /* only the attributes before the pixel data are needed for the index */
+    DcmFileFormat dcmff;
+    if (dcmff.loadFile(imageFileName, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+                       ERM_autoDetect, OFFalse, DCM_PixelData).bad())
+    {
+      CERR << "DB: Cannot open file: " << imageFileName << ": "
+           << strerror(errno) << endl;
+      status->setStatus(STATUS_STORE_Error_CannotUnderstand);
+      return (DcmQRIndexDatabaseError) ;
+    }
+
+    return storeRequest(SOPClassUID, SOPInstanceUID, imageFileName, dcmff.getDataset(), status, isNew);
+}
+
+/*************************
+**  Attributes evaluated by storeRequest
+ */
+
+void DcmQueryRetrieveIndexDatabaseHandle::getStoreAttributes(OFList<DcmTagKey>& tags)
+{
+    IdxRecord idxRec ;
+
+    bzero((char*)&idxRec, sizeof(idxRec));
+    DB_IdxInitRecord (&idxRec, 0) ;
+    for (int i = 0 ; i < NBPARAMETERS ; i++ )
+        tags.push_back(idxRec.param[i].XTag);
+
+    /* InstanceDescription */
+    tags.push_back(DCM_ImageComments);
+    tags.push_back(DCM_ContentDescription);
+    tags.push_back(DCM_VerificationFlag);
+    tags.push_back(DCM_CompletionFlag);
+    tags.push_back(DCM_CompletionFlagDescription);
+    tags.push_back(DCM_DigitalSignaturesSequence);
+}
+
+/*************************
+**  Add data from dataset to database
+ */
+
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
     const char  *SOPClassUID,
     const char  * /*SOPInstanceUID*/,
     const char  *imageFileName,
+    DcmDataset  *dset,
     DcmQueryRetrieveDatabaseStatus   *status,
     OFBool      isNew)
 {
@@ -2912,20 +4051,9 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
 #endif
     strncpy (idxRec.SOPClassUID, SOPClassUID, UI_MAX_LENGTH);
 
-    /**** Get IdxRec values from ImageFile
+    /**** Get IdxRec values from dataset
     ***/
 
-    DcmFileFormat dcmff;
-    if (dcmff.loadFile(imageFileName).bad())
-    {
-      CERR << "DB: Cannot open file: " << imageFileName << ": "
-           << strerror(errno) << endl;
-      status->setStatus(STATUS_STORE_Error_CannotUnderstand);
-      return (DcmQRIndexDatabaseError) ;
-    }
-
-    DcmDataset *dset = dcmff.getDataset();
-
     for (i = 0 ; i < NBPARAMETERS ; i++ ) {
         OFCondition ec = EC_Normal;
         DB_SmallDcmElmt *se = idxRec.param + i;
@@ -3037,7 +4165,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
 
     DB_lock(OFTrue);
 
-    pStudyDesc = (StudyDescRecord *)malloc (SIZEOF_STUDYDESC) ;
+    pStudyDesc = (StudyDescRecord *)malloc (DB_StudyDescCount() * sizeof (StudyDescRecord)) ;
     if (pStudyDesc == NULL) {
       CERR << "DB_storeRequest: out of memory" << endl;
       status->setStatus(STATUS_STORE_Refused_OutOfResources);
@@ -3045,7 +4173,9 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
       return (DcmQRIndexDatabaseError) ;
     }
 
-    bzero((char *)pStudyDesc, SIZEOF_STUDYDESC);
+    /* the key index stays invalid if we fail before the record is added */
+    OFBool keyIndexConsistent = DB_KeyIndexBeginUpdate();
+
     DB_GetStudyDesc(pStudyDesc) ;
 
     stat(imageFileName, &buf) ;
@@ -3077,6 +4207,8 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
 
     if (DB_IdxAdd (handle, &i, &idxRec) == EC_Normal)
     {
+    if (DB_KeyIndexCommit (i, &idxRec, keyIndexConsistent) != EC_Normal)
+        CERR << "DB_storeRequest: cannot update key index, queries will scan the index file" << endl;
     status->setStatus(STATUS_Success);
     DB_unlock();
     return (EC_Normal) ;
@@ -3095,25 +4227,23 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::pruneInvalidRecords()
 {
-    int idx = 0;
+    int idx ;
     IdxRecord idxRec ;
     StudyDescRecord *pStudyDesc;
 
     DB_lock(OFTrue);
 
-    pStudyDesc = (StudyDescRecord *)malloc (SIZEOF_STUDYDESC) ;
+    pStudyDesc = (StudyDescRecord *)malloc (DB_StudyDescCount() * sizeof (StudyDescRecord)) ;
     if (pStudyDesc == NULL) {
       CERR << "DB_pruneInvalidRecords: out of memory" << endl;
       DB_unlock();
       return (DcmQRIndexDatabaseError) ;
     }
 
-    for (int i = 0 ; i < handle -> maxStudiesAllowed ; i++ )
-      pStudyDesc[i]. NumberofRegistratedImages = 0 ;
-
     DB_GetStudyDesc(pStudyDesc) ;
 
-    while (DB_IdxRead(idx, &idxRec) == EC_Normal)
+    DB_IdxInitLoop (&idx) ;
+    while (DB_IdxGetNext(&idx, &idxRec) == EC_Normal)
     {
       if (access(idxRec.filename, R_OK) < 0)
       {
@@ -3121,8 +4251,8 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::pruneInvalidRecords()
         dbdebug(1,"*** Pruning Invalid DB Image Record: %s\n", idxRec.filename);
 #endif
         /* update the study info */
-        int studyIdx = matchStudyUIDInStudyDesc(pStudyDesc, idxRec.StudyInstanceUID, (int)(handle->maxStudiesAllowed)) ;
-        if (studyIdx < handle->maxStudiesAllowed)
+        int studyIdx = matchStudyUIDInStudyDesc(pStudyDesc, idxRec.StudyInstanceUID, handle->studyDescCount) ;
+        if (studyIdx < handle->studyDescCount)
         {
           if (pStudyDesc[studyIdx].NumberofRegistratedImages > 0)
           {
@@ -3141,7 +4271,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::pruneInvalidRecords()
         /* remove the idx record  */
         DB_IdxRemove (idx);
       }
-      idx++;
     }
 
     DB_StudyDescChange (pStudyDesc);
@@ -3162,6 +4291,7 @@ void DcmQueryRetrieveIndexDatabaseHandle::printIndexFile (char *storeArea)
 {
     int i ;
     int j ;
+    int records = 0 ;
     IdxRecord           idxRec ;
     StudyDescRecord     *pStudyDesc;
 
@@ -3169,17 +4299,18 @@ void DcmQueryRetrieveIndexDatabaseHandle::printIndexFile (char *storeArea)
     DcmQueryRetrieveIndexDatabaseHandle handle(storeArea, -1, -1, result);
     if (result.bad()) return;
 
-    pStudyDesc = (StudyDescRecord *)malloc (SIZEOF_STUDYDESC) ;
+    handle.DB_lock(OFFalse);
+
+    pStudyDesc = (StudyDescRecord *)malloc (handle.DB_StudyDescCount() * sizeof (StudyDescRecord)) ;
     if (pStudyDesc == NULL) {
         CERR << "printIndexFile: out of memory" << endl;
+        handle.DB_unlock();
         return;
     }
 
-    handle.DB_lock(OFFalse);
-
     handle.DB_GetStudyDesc(pStudyDesc);
 
-    for (i=0; i<handle.handle->maxStudiesAllowed; i++) {
+    for (i=0; i<handle.handle->studyDescCount; i++) {
         if (pStudyDesc[i].NumberofRegistratedImages != 0 ) {
             COUT << "******************************************************" << endl
                 << "STUDY DESCRIPTOR: " << i << endl
@@ -3189,11 +4320,13 @@ void DcmQueryRetrieveIndexDatabaseHandle::printIndexFile (char *storeArea)
                 << "  NumOfImages: " << pStudyDesc[i].NumberofRegistratedImages << endl;
         }
     }
+    free (pStudyDesc) ;
 
     handle.DB_IdxInitLoop (&j) ;
     while (1) {
         if (handle.DB_IdxGetNext(&j, &idxRec) != EC_Normal)
             break ;
+        records++ ;
 
         COUT << "*******************************************************" << endl;
         COUT << "RECORD NUMBER: " << j << endl << "  Status: ";
@@ -3214,12 +4347,181 @@ void DcmQueryRetrieveIndexDatabaseHandle::printIndexFile (char *storeArea)
             COUT << "  InstanceDescription: \"" << idxRec.InstanceDescription << "\"" << endl;
     }
     COUT << "*******************************************************" << endl
-         << "RECORDS IN THIS INDEXFILE: " << j << endl;
+         << "RECORDS IN THIS INDEXFILE: " << records << endl;
 
     handle.DB_unlock();
 
 }
 
+/************************
+ *      Convert a version 1 index file
+ */
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::migrateIndexFile (const char *storeArea, int& converted)
+{
+    char                oldIndexFilename [DBC_MAXSTRING+1] ;
+    char                backupFilename [DBC_MAXSTRING+1] ;
+    char                indexFilename [DBC_MAXSTRING+1] ;
+    char                studyFilename [DBC_MAXSTRING+1] ;
+    char                keyIndexFilename [DBC_MAXSTRING+1] ;
+    char                tmpIndexFilename [DBC_MAXSTRING+5] ;
+    char                tmpStudyFilename [DBC_MAXSTRING+5] ;
+    char                buf [DB_IDXRECORD_MAXSIZE + DB_IDXRECORD_ALIGNMENT] ;
+    DB_IdxRecordHeader  hdr ;
+    IdxRecord           idxRec ;
+    StudyDescRecord     *pStudyDesc ;
+    OFBool              legacy = OFFalse ;
+    OFCondition         cond = EC_Normal ;
+    int                 count ;
+    int                 length ;
+    int                 fd ;
+    int                 ftmp ;
+    int                 fstd ;
+
+    converted = 0 ;
+    sprintf (oldIndexFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBOLDINDEXFILE) ;
+    sprintf (backupFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBOLDINDEXBACKUPFILE) ;
+    sprintf (indexFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBINDEXFILE) ;
+    sprintf (studyFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBSTUDYFILE) ;
+    sprintf (keyIndexFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBKEYINDEXFILE) ;
+    sprintf (tmpIndexFilename, "%s.tmp", indexFilename) ;
+    sprintf (tmpStudyFilename, "%s.tmp", studyFilename) ;
+
+    /**** Nothing to do if there is no version 1 index file
+    ***/
+
+#ifdef O_BINARY
+    fd = open (oldIndexFilename, O_RDWR | O_BINARY) ;
+#else
+    fd = open (oldIndexFilename, O_RDWR) ;
+#endif
+    if (fd < 0) {
+        if (errno == ENOENT)
+            return EC_Normal ;
+        CERR << oldIndexFilename << ": " << strerror(errno) << endl;
+        return DcmQRIndexDatabaseError ;
+    }
+    if (dcmtk_flock (fd, LOCK_EX) < 0) {
+        dcmtk_plockerr ("migrateIndexFile") ;
+        close (fd) ;
+        return DcmQRIndexDatabaseError ;
+    }
+
+    /**** Never overwrite an index file in the current format. If both files
+    **** exist, an older application has created the version 1 file again.
+    ***/
+
+    if (access (indexFilename, F_OK) == 0) {
+        CERR << indexFilename << ": index file already exists, remove "
+             << oldIndexFilename << " if it is no longer used" << endl;
+        dcmtk_flock (fd, LOCK_UN) ;
+        close (fd) ;
+        return DcmQRIndexDatabaseError ;
+    }
+
+    /**** Copy the study descriptors in use to the study file. An empty
+    **** version 1 index file has no study descriptors yet.
+    ***/
+
+    count = 0 ;
+    if (DB_FileSize (fd) != 0) {
+        lseek (fd, 0L, SEEK_SET) ;
+        if ((DB_IdxCheckFile (fd, &legacy) == EC_Normal) || !legacy) {
+            CERR << oldIndexFilename << ": unsupported index file format" << endl;
+            dcmtk_flock (fd, LOCK_UN) ;
+            close (fd) ;
+            return DcmQRIndexDatabaseError ;
+        }
+        count = LEGACY_MAX_STUDIES ;
+    }
+    pStudyDesc = (StudyDescRecord *) malloc (SIZEOF_LEGACY_STUDYDESC) ;
+    if (pStudyDesc == NULL) {
+        CERR << "migrateIndexFile: out of memory" << endl;
+        dcmtk_flock (fd, LOCK_UN) ;
+        close (fd) ;
+        return DcmQRIndexDatabaseError ;
+    }
+    lseek (fd, 0L, SEEK_SET) ;
+    if ((count > 0) && (read (fd, (char *) pStudyDesc, SIZEOF_LEGACY_STUDYDESC) != (int) SIZEOF_LEGACY_STUDYDESC)) {
+        CERR << oldIndexFilename << ": truncated index file" << endl;
+        free (pStudyDesc) ;
+        dcmtk_flock (fd, LOCK_UN) ;
+        close (fd) ;
+        return DcmQRIndexDatabaseError ;
+    }
+    while ((count > 0) && (pStudyDesc [count - 1]. NumberofRegistratedImages == 0))
+        count-- ;
+
+#ifdef O_BINARY
+    fstd = open (tmpStudyFilename, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666) ;
+    ftmp = open (tmpIndexFilename, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666) ;
+#else
+    fstd = open (tmpStudyFilename, O_RDWR | O_CREAT | O_TRUNC, 0666) ;
+    ftmp = open (tmpIndexFilename, O_RDWR | O_CREAT | O_TRUNC, 0666) ;
+#endif
+    if ((fstd < 0) || (ftmp < 0)) {
+        CERR << "migrateIndexFile: cannot create temporary files: " << strerror(errno) << endl;
+        cond = DcmQRIndexDatabaseError ;
+    }
+    else if ((count > 0) && (write (fstd, (char *) pStudyDesc, count * sizeof (StudyDescRecord)) != (int) (count * sizeof (StudyDescRecord))))
+        cond = DcmQRIndexDatabaseError ;
+    free (pStudyDesc) ;
+
+    /**** Convert the records in use, free records are dropped
+    ***/
+
+    if (cond. good ()) {
+        DB_IdxCheckFile (ftmp, &legacy) ;
+        lseek (ftmp, 0L, SEEK_END) ;
+        lseek (fd, (long) SIZEOF_LEGACY_STUDYDESC, SEEK_SET) ;
+        while (read (fd, (char *) &idxRec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD) {
+            if (idxRec. filename [0] == '\0')
+                continue ;
+            DB_IdxInitRecord (&idxRec, 1) ;
+            length = DB_IdxEncode (&idxRec, buf + SIZEOF_IDXRECORDHEADER) ;
+            hdr. capacity = DB_IdxRecordCapacity (length) ;
+            hdr. length = (Uint32) length ;
+            memcpy (buf, &hdr, SIZEOF_IDXRECORDHEADER) ;
+            bzero (buf + SIZEOF_IDXRECORDHEADER + length, hdr. capacity - SIZEOF_IDXRECORDHEADER - length) ;
+            if (write (ftmp, buf, hdr. capacity) != (int) hdr. capacity) {
+                cond = DcmQRIndexDatabaseError ;
+                break ;
+            }
+            converted++ ;
+        }
+    }
+    if (cond. bad ())
+        CERR << "migrateIndexFile: cannot write converted index file" << endl;
+
+    /**** Install the new files and move the version 1 file out of the way
+    **** of older applications, the key index is rebuilt on demand
+    ***/
+
+    if (fstd >= 0) close (fstd) ;
+    if (ftmp >= 0) close (ftmp) ;
+    if (cond. good ()) {
+        if ((rename (tmpStudyFilename, studyFilename) != 0) || (rename (tmpIndexFilename, indexFilename) != 0)) {
+            CERR << "migrateIndexFile: cannot create index file: " << strerror(errno) << endl;
+            cond = DcmQRIndexDatabaseError ;
+        }
+        else if (rename (oldIndexFilename, backupFilename) != 0) {
+            CERR << "migrateIndexFile: cannot rename " << oldIndexFilename << ": " << strerror(errno) << endl;
+            unlink (indexFilename) ;
+            cond = DcmQRIndexDatabaseError ;
+        }
+        else
+            unlink (keyIndexFilename) ;
+    }
+    if (cond. bad ()) {
+        unlink (tmpStudyFilename) ;
+        unlink (tmpIndexFilename) ;
+    }
+
+    dcmtk_flock (fd, LOCK_UN) ;
+    close (fd) ;
+    return cond ;
+}
+
 
 /* ========================= UTILS ========================= */
 
@@ -3291,22 +4593,41 @@ DcmQueryRetrieveIndexDatabaseHandle::DcmQueryRetrieveIndexDatabaseHandle(
             maxStudiesPerStorageArea, maxBytesPerStudy);
 #endif
 
-    if (maxStudiesPerStorageArea > DB_UpperMaxStudies) {
-        CERR << "WARING: maxStudiesPerStorageArea too large" << endl
-             << "        setting to " << DB_UpperMaxStudies << endl;
-        maxStudiesPerStorageArea = DB_UpperMaxStudies;
-    }
-    if (maxStudiesPerStorageArea < 0) {
-        maxStudiesPerStorageArea = DB_UpperMaxStudies;
+    if (maxStudiesPerStorageArea <= 0 || maxStudiesPerStorageArea > DB_UnlimitedStudies) {
+        maxStudiesPerStorageArea = DB_UnlimitedStudies;
     }
     if (maxBytesPerStudy < 0 || maxBytesPerStudy > DB_UpperMaxBytesPerStudy) {
         maxBytesPerStudy = DB_UpperMaxBytesPerStudy;
     }
 
     if (handle) {
+        handle -> pkey = -1;
+        handle -> plck = -1;
+        handle -> pstd = -1;
+        handle -> studyDescCount = 0;
+        handle -> scanBuffer = NULL;
+        handle -> scanStart = 0;
+        handle -> scanLength = 0;
+        handle -> candidateList = NULL;
+        handle -> candidateCount = -1;
+        handle -> candidatePos = 0;
         sprintf (handle -> storageArea,"%s", storageArea);
         sprintf (handle -> indexFilename,"%s%c%s", storageArea, PATH_SEPARATOR, DBINDEXFILE);
 
+        /* refuse storage areas that still have a version 1 index file */
+        if (access(handle->indexFilename, F_OK) != 0)
+        {
+            char oldIndexFilename[DBC_MAXSTRING+1];
+            sprintf (oldIndexFilename,"%s%c%s", storageArea, PATH_SEPARATOR, DBOLDINDEXFILE);
+            if (access(oldIndexFilename, F_OK) == 0)
+            {
+                CERR << oldIndexFilename << ": index file has an old format," << endl
+                     << "        stop all applications using it and convert it with 'dcmqridx --migrate " << storageArea << "'" << endl;
+                result = DcmQRIndexDatabaseError;
+                return;
+            }
+        }
+
         /* create index file if it does not already exist */
         FILE* f = fopen(handle->indexFilename, "ab");
         if (f == NULL) {
@@ -3331,9 +4652,56 @@ DcmQueryRetrieveIndexDatabaseHandle::DcmQueryRetrieveIndexDatabaseHandle(
             handle -> idxCounter = -1;
             handle -> findRequestList = NULL;
             handle -> findResponseList = NULL;
+            handle -> pendingResponseList = NULL;
+            handle -> moveCounterList = NULL;
             handle -> maxBytesPerStudy = maxBytesPerStudy;
             handle -> maxStudiesAllowed = maxStudiesPerStorageArea;
             handle -> uidList = NULL;
+
+            /* refuse index files in an unknown format, initialize new ones */
+            dcmtk_flock(handle -> pidx, LOCK_EX);
+            OFBool legacy = OFFalse;
+            OFCondition cond = DB_IdxCheckFile(handle -> pidx, &legacy);
+            dcmtk_flock(handle -> pidx, LOCK_UN);
+            if (cond.bad())
+            {
+                CERR << handle -> indexFilename << ": unsupported index file format" << endl;
+                result = DcmQRIndexDatabaseError;
+                return;
+            }
+
+            /* open fd of study descriptor file */
+            char studyFilename[DBC_MAXSTRING+1];
+            sprintf (studyFilename,"%s%c%s", storageArea, PATH_SEPARATOR, DBSTUDYFILE);
+#ifdef O_BINARY
+            handle -> pstd = open(studyFilename, O_RDWR | O_CREAT | O_BINARY, 0666);
+#else
+            handle -> pstd = open(studyFilename, O_RDWR | O_CREAT, 0666);
+#endif
+            if ( handle -> pstd == (-1) )
+            {
+                CERR << studyFilename << ": " << strerror(errno) << endl;
+                result = DcmQRIndexDatabaseError;
+                return;
+            }
+
+            /* open fd of key index file, which is optional */
+            char keyIndexFilename[DBC_MAXSTRING+1];
+            sprintf (keyIndexFilename,"%s%c%s", storageArea, PATH_SEPARATOR, DBKEYINDEXFILE);
+#ifdef O_BINARY
+            handle -> pkey = open(keyIndexFilename, O_RDWR | O_CREAT | O_BINARY, 0666);
+#else
+            handle -> pkey = open(keyIndexFilename, O_RDWR | O_CREAT, 0666);
+#endif
+
+            /* open fd of lock file, without it readers may starve writers */
+            char lockFilename[DBC_MAXSTRING+1];
+            sprintf (lockFilename,"%s%c%s", storageArea, PATH_SEPARATOR, DBLOCKFILE);
+#ifdef O_BINARY
+            handle -> plck = open(lockFilename, O_RDWR | O_CREAT | O_BINARY, 0666);
+#else
+            handle -> plck = open(lockFilename, O_RDWR | O_CREAT, 0666);
+#endif
             result = EC_Normal;
             return;
         }
@@ -3364,11 +4732,17 @@ DcmQueryRetrieveIndexDatabaseHandle::~DcmQueryRetrieveIndexDatabaseHandle()
       DB_unlock();
 #endif
       closeresult = close( handle -> pidx);
+      if (handle -> pkey >= 0) close( handle -> pkey);
+      if (handle -> plck >= 0) close( handle -> plck);
+      if (handle -> pstd >= 0) close( handle -> pstd);
+      free (handle -> scanBuffer);
 
       /* Free lists */
       DB_FreeElementList (handle -> findRequestList);
       DB_FreeElementList (handle -> findResponseList);
+      DB_FreeResponseList (handle -> pendingResponseList);
       DB_FreeUidList (handle -> uidList);
+      DB_KeyIndexFreeCandidates ();
 
       free ( (char *)(handle) );
     }
@@ -3415,10 +4789,18 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::instanceReviewed(int idx)
       result = DB_lock(OFTrue);
       if (result.bad()) return result;
 
-      record.hstat = DVIF_objectIsNotNew;
-      DB_lseek(handle->pidx, OFstatic_cast(long, SIZEOF_STUDYDESC + idx * SIZEOF_IDXRECORD), SEEK_SET);
-      write(handle->pidx, OFreinterpret_cast(char *, &record), SIZEOF_IDXRECORD);
-      DB_lseek(handle->pidx, 0L, SEEK_SET);
+      // hstat has a fixed position within the encoded record, just overwrite it
+      DB_IdxRecordHeader hdr;
+      Sint32 hstat = OFstatic_cast(Sint32, DVIF_objectIsNotNew);
+      long pos = OFstatic_cast(long, idx) + SIZEOF_IDXRECORDHEADER + sizeof(double) + sizeof(Sint32);
+      result = DB_IdxReadHeader(handle->pidx, OFstatic_cast(long, idx), &hdr);
+      if (result.good() && (hdr.length > 0))
+      {
+        handle->scanLength = 0;
+        DB_lseek(handle->pidx, pos, SEEK_SET);
+        if (write(handle->pidx, OFreinterpret_cast(char *, &hstat), sizeof(hstat)) != sizeof(hstat))
+          result = DcmQRIndexDatabaseError;
+      }
       DB_unlock();
     }
 
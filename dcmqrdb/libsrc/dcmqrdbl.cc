@@ -92,6 +92,8 @@ const OFCondition DcmQRLuceneIndex_STORE_Error_CannotUnderstand(DcmQRLuceneIndex
 
 
 const int IndexRequestUpToDateMillis = 5000;
+const unsigned int IndexGroupCommitDocuments = 100;
+const int IndexGroupCommitMillis = IndexRequestUpToDateMillis;
 
 bool DcmQueryRetrieveLuceneIndexHandle::indexExists( const OFString &s ) {
   return DcmQRDBLHImpl::indexExists( s.c_str() );
@@ -114,6 +116,10 @@ void DcmQueryRetrieveLuceneIndexHandle::setVerbose(bool v) {
   verbose = v;
 }
 
+void DcmQueryRetrieveLuceneIndexHandle::setGroupCommit(unsigned int maxDocuments, int maxMillis) {
+  impl->setGroupCommit(maxDocuments, maxMillis);
+}
+
 
 
 void DcmQueryRetrieveLuceneIndexHandle::printIndexFile(void) {
@@ -394,6 +400,7 @@ OFCondition DcmQueryRetrieveLuceneIndexHandle::cancelFindRequest(DcmQueryRetriev
 {
 dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
   impl->findRequestList.clear();
+  impl->clearFindResponses();
   impl->findResponseHitCounter = 0;
   impl->findResponseHits.reset(NULL);
   impl->findRequest.reset(NULL);
@@ -404,7 +411,7 @@ dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
 OFCondition DcmQueryRetrieveLuceneIndexHandle::nextFindResponse(DcmDataset** findResponseIdentifiers, DcmQueryRetrieveDatabaseStatus* status)
 {
 dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
-    dbdebug(1, "%s : about to deliver hit #%i/%i\n", __FUNCTION__, impl->findResponseHitCounter, impl->findResponseHits->length()) ;
+    dbdebug(1, "%s : about to deliver hit #%i/%i\n", __FUNCTION__, impl->findResponseHitCounter, (int) impl->findResponseCount()) ;
     *findResponseIdentifiers = new DcmDataset ;
     if ( *findResponseIdentifiers == NULL ) {
 	dbdebug(1, "%s : could allocate ResponseIdentifiers DataSet - STATUS_FIND_Refused_OutOfResources\n", __FUNCTION__) ;
@@ -414,32 +421,18 @@ dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
 
     /*** Put responses
     **/
-    if (impl->findResponseHitCounter < impl->findResponseHits->length()) {
-      Document &responseDoc = impl->findResponseHits->doc( impl->findResponseHitCounter++ );
-      const Document::FieldsType *responseFields = responseDoc.getFields();
-
+    FindResponseValuesType responseValues;
+    if (impl->nextFindResponseValues( responseValues )) {
       dbdebug(3, "%s response:", __FUNCTION__);
-      for(Document::FieldsType::const_iterator fi = responseFields->begin(); fi!= responseFields->end(); fi++) {
-	const TCHAR* fname = (*fi)->name();
-	dbdebug(3, "%s %s: %s", __FUNCTION__, LuceneString( fname ).toStdString().c_str(), LuceneString( responseDoc.get( fname ) ).toStdString().c_str() );
-      }
-      
-      
-      for( TagListType::const_iterator i=impl->findRequestList.begin(); i!=impl->findRequestList.end(); i++) {
-	LuceneString fieldName = LuceneString(*i);
-	std::string responseValue;
-	for(Document::FieldsType::const_iterator fi = responseFields->begin(); fi!= responseFields->end(); fi++) {
-	  const TCHAR* fname = (*fi)->name();
-	  if (fieldName.compare( fname )==0) {
-	    responseValue = LuceneString(responseDoc.get( fname )).toStdString();
-	  }
-	}
+      FindResponseValuesType::const_iterator vi = responseValues.begin();
+      for( TagListType::const_iterator i=impl->findRequestList.begin(); i!=impl->findRequestList.end(); i++, vi++) {
+	dbdebug(3, "%s %s: %s", __FUNCTION__, i->toString().c_str(), vi->c_str() );
 	DcmElement *dce = newDicomElement( *i );
 	if (dce == NULL) {
 	    status->setStatus(STATUS_FIND_Refused_OutOfResources);
 	    return DcmQRLuceneIndex_FIND_Refused_OutOfResources;
 	}
-	OFCondition ec = dce->putString(responseValue.c_str());
+	OFCondition ec = dce->putString(vi->c_str());
 	if (ec != EC_Normal) {
 	    CERR << __FUNCTION__ << ": cannot putString()" << endl;
 	    status->setStatus(STATUS_FIND_Failed_UnableToProcess);
@@ -578,10 +571,16 @@ dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
   }
 
   dbdebug(2, "%s: searching index: %s", __FUNCTION__, LuceneString((const TCHAR*)boolQuery.toString(NULL)).toStdString().c_str());
+  impl->findCacheKey.clear();
+  if (DcmQueryRetrieveFindCache::instance().enabled()) {
+    DcmQueryRetrieveFindCache::makeKey(SOPClassUID, findRequestIdentifiers, impl->findCacheKey);
+    DcmQueryRetrieveFindCache::getRestrictions(findRequestIdentifiers, impl->findCacheRestrictions);
+  }
+  impl->prepareFindResponses();
   impl->findQuery(&boolQuery, IndexRequestUpToDateMillis, mostRestrictiveUID);
-  dbdebug(1, "%s found %i items", __FUNCTION__, impl->findResponseHits->length());
+  dbdebug(1, "%s found %i items", __FUNCTION__, (int) impl->findResponseCount());
 
-  if (impl->findResponseHits->length() == 0) {
+  if (impl->findResponseCount() == 0) {
     cancelFindRequest(status);
     dbdebug(1, "%s : STATUS_Success", __FUNCTION__) ;
     status->setStatus(STATUS_Success);
@@ -605,14 +604,28 @@ dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
     /**** Get IdxRec values from ImageFile
     ***/
 
+    /* only the attributes before the pixel data are needed for the index */
     DcmFileFormat dcmff;
-    if (dcmff.loadFile(imageFileName).bad())
+    if (dcmff.loadFile(imageFileName, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+                       ERM_autoDetect, OFFalse, DCM_PixelData).bad())
     {
       CERR << "Cannot open file: " << imageFileName << ": "
            << strerror(errno) << endl;
       status->setStatus(STATUS_STORE_Error_CannotUnderstand);
       return (DcmQRLuceneIndex_STORE_Error_CannotUnderstand);
     }
+    return storeRequest(SOPClassUID, SOPInstanceUID, imageFileName, dcmff.getDataset(), status, isNew);
+}
+
+void DcmQueryRetrieveLuceneIndexHandle::getStoreAttributes(OFList<DcmTagKey>& tags)
+{
+    for(DcmQRLuceneTagListIterator i = DcmQRLuceneTagList.begin(); i!=DcmQRLuceneTagList.end(); i++) {
+      tags.push_back(i->tag);
+    }
+}
+
+OFCondition DcmQueryRetrieveLuceneIndexHandle::storeRequest(const char* SOPClassUID, const char* SOPInstanceUID, const char* imageFileName, DcmDataset* dset, DcmQueryRetrieveDatabaseStatus* status, OFBool isNew)
+{
     {
       if (SOPInstanceUID == NULL) {
 	  CERR << __FUNCTION__ << ":\"" << imageFileName << "\" - no DCM_SOPInstanceUID, rejecting" << endl;
@@ -625,8 +638,6 @@ dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
       }
     }
 
-    DcmDataset *dset = dcmff.getDataset();
-    
     typedef std::map< DcmTagKey, LuceneString > DataMapType;
     TagValueMapType dataMap;
 
@@ -655,6 +666,7 @@ dbdebug(1, "%s: start (line %i)", __FUNCTION__, __LINE__) ;
     stringDataMap[ FieldNameDCM_SOPClassUID ] = SOPClassUID;
 
     impl->addDocument( IMAGE_LEVEL, dataMap, stringDataMap );
+    impl->commitIfDue();
     
     return EC_Normal;
 }
@@ -681,6 +693,15 @@ DcmQueryRetrieveLuceneIndexReaderHandleFactory::DcmQueryRetrieveLuceneIndexReade
 : DcmQueryRetrieveDatabaseHandleFactory()
 , config_(config)
 {
+  // open and warm the shared searchers once, so that handles created
+  // for the individual associations only borrow them
+  DcmQueryRetrieveConfigAEEntry *aeList = NULL;
+  int numAEs = 0;
+  if (config_) config_->getAEList( &aeList, &numAEs );
+  for (int i = 0; i < numAEs; i++) {
+    if (aeList[i].StorageArea)
+      DcmQRLuceneSearcherManager::warm( DcmQRDBLHImpl::storageAreaToIndexPath( aeList[i].StorageArea ) );
+  }
 }
 
 DcmQueryRetrieveLuceneIndexReaderHandleFactory::~DcmQueryRetrieveLuceneIndexReaderHandleFactory()
@@ -703,10 +724,12 @@ DcmQueryRetrieveDatabaseHandle *DcmQueryRetrieveLuceneIndexWriterHandleFactory::
     const char *calledAETitle,
     OFCondition& result) const
 {
-  return new DcmQueryRetrieveLuceneIndexHandle(
+  DcmQueryRetrieveLuceneIndexHandle *handle = new DcmQueryRetrieveLuceneIndexHandle(
     config_->getStorageArea(calledAETitle),
     DcmQRLuceneWriter,
     result);
+  handle->setGroupCommit(IndexGroupCommitDocuments, IndexGroupCommitMillis);
+  return handle;
 }
 
 
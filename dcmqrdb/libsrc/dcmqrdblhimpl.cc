@@ -32,12 +32,16 @@
 
 
 #include <iostream>
+#include <unistd.h>
 
 using namespace std;
 
 
 namespace pt = boost::posix_time;
 
+/// number of C-FIND responses loaded from the index at once
+static const unsigned int FindResponseBatchSize = 64;
+
 
 bool DicomUID::operator<(const DicomUID &other) const {
   if (this->level < other.level) return true;
@@ -47,13 +51,86 @@ bool DicomUID::operator<(const DicomUID &other) const {
 }
 
 
+/** closes a searcher before deleting it, used as deleter for shared searchers.
+ *  Optionally keeps the shared reader the searcher was created on alive.
+ */
+struct IndexSearcherCloser {
+  shared_ptr<IndexReader> reader;
+  IndexSearcherCloser() {}
+  IndexSearcherCloser(const shared_ptr<IndexReader> &r): reader(r) {}
+  void operator()(IndexSearcher *searcher) {
+    searcher->close();
+    delete searcher;
+    reader.reset();
+  }
+};
+
+/** closes a reader before deleting it, used as deleter for shared readers
+ */
+struct IndexReaderCloser {
+  void operator()(IndexReader *reader) const {
+    reader->close();
+    delete reader;
+  }
+};
+
+
+DcmQRLuceneSearcherManager::EntryMapType &DcmQRLuceneSearcherManager::entries() {
+  static EntryMapType entryMap;
+  return entryMap;
+}
+
+OFMutex &DcmQRLuceneSearcherManager::mutex() {
+  static OFMutex entryMutex;
+  return entryMutex;
+}
+
+shared_ptr<IndexSearcher> DcmQRLuceneSearcherManager::acquire( const string &indexPath ) {
+  shared_ptr<IndexSearcher> result;
+  mutex().lock();
+  try {
+    Entry &entry = entries()[ indexPath ];
+    if (!entry.reader || entry.pid != getpid()) {
+      entry.reader.reset( IndexReader::open( indexPath.c_str() ), IndexReaderCloser() );
+      entry.searcher.reset( new IndexSearcher( entry.reader.get() ), IndexSearcherCloser( entry.reader ) );
+      entry.pid = getpid();
+    } else if (!entry.reader->isCurrent()) {
+      // readers and searchers still borrowed by open handles stay alive until released
+      IndexReader *newReader = entry.reader->reopen();
+      if (newReader != entry.reader.get()) {
+        entry.reader.reset( newReader, IndexReaderCloser() );
+        entry.searcher.reset( new IndexSearcher( entry.reader.get() ), IndexSearcherCloser( entry.reader ) );
+      }
+    }
+    result = entry.searcher;
+  } catch(CLuceneError &e) {
+    cerr << "Exception while creation of IndexSearcher caught:" << e.what() << endl;
+  }
+  mutex().unlock();
+  return result;
+}
+
+void DcmQRLuceneSearcherManager::warm( const string &indexPath ) {
+  if (!IndexReader::indexExists( indexPath.c_str() )) return;
+  shared_ptr<IndexSearcher> searcher = acquire( indexPath );
+  if (!searcher) return;
+  try {
+    TermQuery warmQuery( new Term( FieldNameDocumentDicomLevel.c_str(), QRLevelStringMap.find( PATIENT_LEVEL )->second.c_str() ) );
+    scoped_ptr<Hits> hits( searcher->search( &warmQuery ) );
+  } catch(CLuceneError &e) {
+    cerr << "Exception while warming IndexSearcher caught:" << e.what() << endl;
+  }
+}
+
+
 bool DcmQRDBLHImpl::indexExists( const string &s ) {
   return IndexReader::indexExists( storageAreaToIndexPath( s ).c_str() );
 }
 
 DcmQRDBLHImpl::DcmQRDBLHImpl(const string &storageArea,
   DcmQRLuceneIndexType indexType, Result& result)
-  :analyzer( new LowerCaseWhiteSpaceAnalyzer()), first_modified(new pt::ptime(pt::pos_infin)), storageArea(storageArea), imageDoc( new Document),
+  :analyzer( new LowerCaseWhiteSpaceAnalyzer()), first_modified(new pt::ptime(pt::pos_infin)),
+  pendingDocuments(0), groupCommitDocuments(0), groupCommitMillis(0), storageArea(storageArea), imageDoc( new Document),
   indexType( indexType )
   {
   if (indexType == DcmQRLuceneWriter) {
@@ -78,33 +155,59 @@ DcmQRDBLHImpl::DcmQRDBLHImpl(const string &storageArea,
 
 void DcmQRDBLHImpl::flushIndex(bool force) {
   if (force || newUIDSet.size() > 0)
-    if (indexType == DcmQRLuceneWriter)
+    if (indexType == DcmQRLuceneWriter) {
+      unsigned long oldVersion = (unsigned long) IndexReader::getCurrentVersion( getIndexPath().c_str() );
       indexwriter->flush();
+      unsigned long newVersion = (unsigned long) IndexReader::getCurrentVersion( getIndexPath().c_str() );
+      // drop the cached find results the flushed documents may belong to
+      OFList<OFString> written;
+      for( UIDSetType::const_iterator i = newUIDSet.begin(); i != newUIDSet.end(); i++)
+        written.push_back( DcmQueryRetrieveFindCache::makeRestriction( LevelToUIDTag.find( i->level )->second.tag, i->uid.toStdString().c_str() ) );
+      DcmQueryRetrieveFindCache::instance().invalidate( storageArea.c_str(), oldVersion, newVersion, written );
+    }
 
   if (!indexsearcher || force || newUIDSet.size() > 0) {
     if (indexType == DcmQRLuceneWriter) {
       try {
-	indexsearcher.reset( new IndexSearcher( indexwriter->getDirectory() ) );
+	indexsearcher.reset( new IndexSearcher( indexwriter->getDirectory() ), IndexSearcherCloser() );
       } catch(CLuceneError &e) {
 	cerr << "Exception while creation of IndexSearcher caught:" << e.what() << endl;
       }
     } else if (indexType == DcmQRLuceneReader) {
-      try {
-	indexsearcher.reset( new IndexSearcher( getIndexPath().c_str()) );
-      } catch(CLuceneError &e) {
-	cerr << "Exception while creation of IndexSearcher caught:" << e.what() << endl;
-      }
+      indexsearcher = DcmQRLuceneSearcherManager::acquire( getIndexPath() );
     }
   }
   newUIDSet.clear();
+  pendingUIDSet.clear();
+  pendingImageFiles.clear();
+  pendingDocuments = 0;
   *first_modified = pt::pos_infin;
 }
 
+bool DcmQRDBLHImpl::isPending( const DicomUID &uid ) const {
+  return pendingUIDSet.find( uid ) != pendingUIDSet.end();
+}
+
+void DcmQRDBLHImpl::setGroupCommit( unsigned int maxDocuments, int maxMillis ) {
+  groupCommitDocuments = maxDocuments;
+  groupCommitMillis = maxMillis;
+}
+
+void DcmQRDBLHImpl::commitIfDue() {
+  if (pendingDocuments == 0) return;
+  if (groupCommitDocuments > 0 && pendingDocuments >= groupCommitDocuments) {
+    flushIndex();
+  } else if (groupCommitMillis > 0
+    && *first_modified + pt::millisec( groupCommitMillis ) < pt::microsec_clock::local_time()) {
+    flushIndex();
+  }
+}
+
 DcmQRDBLHImpl::~DcmQRDBLHImpl() {
   if (indexType == DcmQRLuceneWriter) {
     imageDoc->clear();
   }
-  indexsearcher->close();
+  indexsearcher.reset();
   if (indexType == DcmQRLuceneWriter) {
     indexwriter->optimize();
     indexwriter->close();
@@ -133,13 +236,14 @@ bool DcmQRDBLHImpl::checkAndStoreDataForLevel( Lucene_LEVEL level, TagValueMapTy
   TagValueMapType::const_iterator uidDataIter = dataset.find( UIDTagEntry.tag );
   if (uidDataIter == dataset.end() ) throw new std::runtime_error(std::string(__FUNCTION__) + ": tag " + UIDTagEntry.tagStr.toStdString() + " not found!");
 
+  // documents not yet flushed are answered from memory, all others are
+  // visible to the current searcher since flushIndex() reopens it
+  if ( isPending( DicomUID( level, uidDataIter->second ) ) ) return true;
+
   BooleanQuery lookupQuery;
   lookupQuery.add( new TermQuery( new Term( FieldNameDocumentDicomLevel.c_str(), QRLevelStringMap.find( level )->second.c_str() ) ), BooleanClause::MUST );
   lookupQuery.add( new TermQuery( new Term( UIDTagEntry.tagStr.c_str(), uidDataIter->second.c_str() ) ), BooleanClause::MUST );
 
-// TODO: remove this dumb thing ---- snip -----  
-flushIndex();
-// TODO: remove this dumb thing ---- snap -----
   scoped_ptr<Hits> hits( indexsearcher->search(&lookupQuery) );
   if (hits->length()>0) {
     return true;
@@ -159,6 +263,13 @@ void DcmQRDBLHImpl::addDocument( Lucene_LEVEL level, const TagValueMapType &tagD
     TagValueMapType::const_iterator UIDIterator = tagDataset.find( LevelToUIDTag.find( (Lucene_LEVEL)l )->second.tag );
     if ( UIDIterator == tagDataset.end() ) throw runtime_error("No UID defined for Document");
     newUIDSet.insert( DicomUID( (Lucene_LEVEL)l, UIDIterator->second ) );
+    if (l == level) {
+      pendingUIDSet.insert( DicomUID( level, UIDIterator->second ) );
+      if (level == IMAGE_LEVEL) {
+        StringValueMapType::const_iterator fileNameIterator = stringDataset.find( FieldNameDicomFileName );
+        pendingImageFiles[ UIDIterator->second ] = (fileNameIterator != stringDataset.end()) ? fileNameIterator->second.toStdString() : string();
+      }
+    }
   }
 
   for(StringValueMapType::const_iterator i=stringDataset.begin(); i != stringDataset.end(); i++)
@@ -174,11 +285,16 @@ void DcmQRDBLHImpl::addDocument( Lucene_LEVEL level, const TagValueMapType &tagD
     }
   }
   indexwriter->addDocument(imageDoc.get());
+  pendingDocuments++;
   if (*first_modified == pt::pos_infin) *first_modified = pt::microsec_clock::local_time();
 }
 
 bool DcmQRDBLHImpl::sopInstanceExists( const LuceneString &sopInstanceUID, string &existingFileName ) {
-  if ( newUIDSet.find( DicomUID( IMAGE_LEVEL, sopInstanceUID ) ) != newUIDSet.end() ) flushIndex();
+  UIDFileNameMapType::const_iterator pendingIterator = pendingImageFiles.find( sopInstanceUID );
+  if ( pendingIterator != pendingImageFiles.end() ) {
+    existingFileName = pendingIterator->second;
+    return true;
+  }
 
   TermQuery tq( new Term( FieldNameDCM_SOPInstanceUID.c_str(), sopInstanceUID.c_str() ) );
   scoped_ptr<Hits> hits( indexsearcher->search(&tq) );
@@ -201,7 +317,31 @@ void DcmQRDBLHImpl::findQuery(Query* query, int upToDateMillis, const DicomUID &
       flushIndex();
   }
   findResponseHitCounter = 0;
-  findResponseHits.reset( indexsearcher->search(query) );
+  findResponseHits.reset( NULL );
+  findCacheResult.reset();
+  findResponseSearcher = indexsearcher;
+  findGeneration = (unsigned long) findResponseSearcher->getReader()->getVersion();
+
+  // repeated queries are answered from the query result cache
+  DcmQueryRetrieveFindCache &findCache = DcmQueryRetrieveFindCache::instance();
+  if (findCacheKey.length() > 0) {
+    DcmQueryRetrieveFindCacheResult cached;
+    if (findCache.lookup( storageArea.c_str(), findGeneration, findCacheKey, cached )) {
+      for( OFListIterator(OFList<OFString>) r = cached.responses.begin(); r != cached.responses.end(); r++) {
+        findResponseBatch.push_back( FindResponseValuesType() );
+        for( OFListIterator(OFString) v = (*r).begin(); v != (*r).end(); v++)
+          findResponseBatch.back().push_back( (*v).c_str() );
+      }
+      return;
+    }
+  }
+
+  findResponseHits.reset( findResponseSearcher->search(query) );
+  if (findCacheKey.length() > 0 && findResponseHits->length() <= findCache.maxResponses()) {
+    findCacheResult.reset( new DcmQueryRetrieveFindCacheResult );
+    for( TagListType::const_iterator i=findRequestList.begin(); i!=findRequestList.end(); i++)
+      findCacheResult->tags.push_back( *i );
+  }
 }
 
 void DcmQRDBLHImpl::moveQuery(Query* query, int upToDateMillis, const DicomUID &uid) {
@@ -219,6 +359,68 @@ void DcmQRDBLHImpl::moveQuery(Query* query, int upToDateMillis, const DicomUID &
 
 
 
+void DcmQRDBLHImpl::prepareFindResponses() {
+  findFieldIndex.clear();
+  findResponseBatch.clear();
+  findFieldSelector.reset( new MapFieldSelector() );
+  size_t n = 0;
+  for( TagListType::const_iterator i=findRequestList.begin(); i!=findRequestList.end(); i++, n++) {
+    LuceneString fieldName( *i );
+    findFieldIndex[ fieldName ] = n;
+    findFieldSelector->add( fieldName.c_str() );
+  }
+}
+
+bool DcmQRDBLHImpl::nextFindResponseValues(FindResponseValuesType &values) {
+  if (findResponseBatch.empty()) {
+    if (!findResponseHits || !findFieldSelector) return false;
+    // load the stored fields of the next batch of hits, restricted to the requested tags
+    IndexReader *reader = findResponseSearcher->getReader();
+    Document responseDoc;
+    for( unsigned int b = 0; b < FindResponseBatchSize && findResponseHitCounter < findResponseHits->length(); b++) {
+      responseDoc.clear();
+      reader->document( findResponseHits->id( findResponseHitCounter++ ), responseDoc, findFieldSelector.get() );
+      findResponseBatch.push_back( FindResponseValuesType( findRequestList.size() ) );
+      FindResponseValuesType &batchValues = findResponseBatch.back();
+      const Document::FieldsType *responseFields = responseDoc.getFields();
+      for(Document::FieldsType::const_iterator fi = responseFields->begin(); fi!= responseFields->end(); fi++) {
+	FieldIndexMapType::const_iterator index = findFieldIndex.find( (*fi)->name() );
+	if (index != findFieldIndex.end())
+	  batchValues[ index->second ] = LuceneString( (*fi)->stringValue() ).toStdString();
+      }
+    }
+    if (findResponseBatch.empty()) {
+      // all responses delivered, the result can be cached now
+      if (findCacheResult) {
+        DcmQueryRetrieveFindCache::instance().insert( storageArea.c_str(), findGeneration, findCacheKey, findCacheRestrictions, *findCacheResult );
+        findCacheResult.reset();
+      }
+      return false;
+    }
+  }
+  values.swap( findResponseBatch.front() );
+  findResponseBatch.pop_front();
+  if (findCacheResult) {
+    OFList<OFString> cachedValues;
+    for( FindResponseValuesType::const_iterator v = values.begin(); v != values.end(); v++)
+      cachedValues.push_back( v->c_str() );
+    findCacheResult->responses.push_back( cachedValues );
+  }
+  return true;
+}
+
+void DcmQRDBLHImpl::clearFindResponses() {
+  findFieldIndex.clear();
+  findFieldSelector.reset();
+  findResponseBatch.clear();
+  findCacheResult.reset();
+}
+
+size_t DcmQRDBLHImpl::findResponseCount() const {
+  if (findResponseHits) return findResponseHits->length();
+  return findResponseBatch.size();
+}
+
 IndexReader& DcmQRDBLHImpl::getIndexReader() {
   flushIndex();
   return *indexsearcher->getReader();
@@ -0,0 +1,362 @@
+/*
+ *
+ *  Copyright (C) 1993-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  agent
+ *
+ *  Purpose: class DcmQueryRetrieveFindCache
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/dcmqrdb/dcmqrfcc.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+
+/** helper class that describes a cached C-FIND result. Internal use only.
+ */
+class DcmQueryRetrieveFindCacheEntry
+{
+public:
+  /// constructor
+  DcmQueryRetrieveFindCacheEntry(const OFString& area, const OFString& k, const OFList<OFString>& r)
+  : storageArea(area), key(k), restrictions(r), result()
+  {
+  }
+
+  /// storage area the query was performed on
+  OFString storageArea;
+
+  /// cache key
+  OFString key;
+
+  /// unique keys the query is restricted to
+  OFList<OFString> restrictions;
+
+  /// the responses
+  DcmQueryRetrieveFindCacheResult result;
+};
+
+/** helper class that describes the generation of a storage area. Internal use only.
+ */
+class DcmQueryRetrieveFindCacheArea
+{
+public:
+  /// constructor
+  DcmQueryRetrieveFindCacheArea(const OFString& area, unsigned long gen)
+  : storageArea(area), generation(gen)
+  {
+  }
+
+  /// name of the storage area
+  OFString storageArea;
+
+  /// database generation the cached results of the storage area belong to
+  unsigned long generation;
+};
+
+/* remove leading and trailing spaces */
+static void trimSpaces(OFString& value)
+{
+  size_t start = 0;
+  size_t end = value.length();
+  while ((start < end) && (value[start] == ' ')) start++;
+  while ((end > start) && (value[end - 1] == ' ')) end--;
+  value = value.substr(start, end - start);
+}
+
+/* copy a C-FIND result (OFList has no assignment operator) */
+static void copyResult(const DcmQueryRetrieveFindCacheResult& src, DcmQueryRetrieveFindCacheResult& dst)
+{
+  dst.tags.clear();
+  dst.responses.clear();
+  OFListConstIterator(DcmTagKey) tag = src.tags.begin();
+  while (tag != src.tags.end()) dst.tags.push_back(*tag++);
+  OFListConstIterator(OFList<OFString>) response = src.responses.begin();
+  while (response != src.responses.end()) dst.responses.push_back(*response++);
+}
+
+/* check whether a unique key value restricts the query to a single entity */
+static OFBool isSingleValue(const OFString& value)
+{
+  if (value.length() == 0) return OFFalse;
+  for (size_t i = 0; i < value.length(); i++)
+  {
+    if ((value[i] == '*') || (value[i] == '?') || (value[i] == '\\')) return OFFalse;
+  }
+  return OFTrue;
+}
+
+
+DcmQueryRetrieveFindCache::DcmQueryRetrieveFindCache()
+: entries_()
+, areas_()
+, maxEntries_(DEFAULT_FINDCACHE_ENTRIES)
+, maxResponses_(DEFAULT_FINDCACHE_RESPONSES)
+, hits_(0)
+, misses_(0)
+, invalidated_(0)
+, mutex_()
+{
+}
+
+DcmQueryRetrieveFindCache::~DcmQueryRetrieveFindCache()
+{
+  OFListIterator(DcmQueryRetrieveFindCacheEntry *) entry = entries_.begin();
+  while (entry != entries_.end()) delete *entry++;
+  OFListIterator(DcmQueryRetrieveFindCacheArea *) area = areas_.begin();
+  while (area != areas_.end()) delete *area++;
+}
+
+DcmQueryRetrieveFindCache& DcmQueryRetrieveFindCache::instance()
+{
+  static DcmQueryRetrieveFindCache cache;
+  return cache;
+}
+
+void DcmQueryRetrieveFindCache::setLimits(size_t maxEntries, size_t maxResponses)
+{
+  mutex_.lock();
+  maxEntries_ = maxEntries;
+  maxResponses_ = maxResponses;
+  while (entries_.size() > maxEntries_)
+  {
+    delete entries_.back();
+    entries_.pop_back();
+  }
+  mutex_.unlock();
+}
+
+OFBool DcmQueryRetrieveFindCache::enabled()
+{
+  mutex_.lock();
+  OFBool result = (maxEntries_ > 0);
+  mutex_.unlock();
+  return result;
+}
+
+size_t DcmQueryRetrieveFindCache::maxResponses()
+{
+  mutex_.lock();
+  size_t result = maxResponses_;
+  mutex_.unlock();
+  return result;
+}
+
+void DcmQueryRetrieveFindCache::makeKey(const char *SOPClassUID, DcmDataset *identifiers, OFString& key)
+{
+  OFString value;
+  key = SOPClassUID ? SOPClassUID : "";
+  key += "\n";
+  unsigned long count = identifiers->card();
+  for (unsigned long i = 0; i < count; i++)
+  {
+    DcmElement *elem = identifiers->getElement(i);
+    DcmTagKey tag = elem->getTag().getXTag();
+    value.clear();
+    if (elem->getLength() > 0) elem->getOFStringArray(value);
+    trimSpaces(value);
+    if (tag == DCM_QueryRetrieveLevel)
+    {
+      for (size_t j = 0; j < value.length(); j++)
+      {
+        if ((value[j] >= 'a') && (value[j] <= 'z')) value[j] = 'A' - 'a' + value[j];
+      }
+    }
+    key += makeRestriction(tag, value.c_str());
+    key += "\n";
+  }
+}
+
+void DcmQueryRetrieveFindCache::getRestrictions(DcmDataset *identifiers, OFList<OFString>& restrictions)
+{
+  static const DcmTagKey uniqueKeys[] = { DCM_StudyInstanceUID, DCM_SeriesInstanceUID, DCM_SOPInstanceUID };
+  OFString value;
+  int level = 0;
+
+  restrictions.clear();
+  if (identifiers->findAndGetOFString(DCM_QueryRetrieveLevel, value).bad()) return;
+  trimSpaces(value);
+  if (value == "STUDY") level = 1;
+  else if (value == "SERIES") level = 2;
+  else if (value == "IMAGE") level = 3;
+
+  /* the unique key of level i + 1 is uniqueKeys[i] */
+  for (int i = 0; i < level; i++)
+  {
+    if (identifiers->findAndGetOFStringArray(uniqueKeys[i], value).good())
+    {
+      trimSpaces(value);
+      if (isSingleValue(value)) restrictions.push_back(makeRestriction(uniqueKeys[i], value.c_str()));
+    }
+  }
+}
+
+OFString DcmQueryRetrieveFindCache::makeRestriction(const DcmTagKey& tag, const char *value)
+{
+  OFString result(tag.toString());
+  result += "=";
+  if (value) result += value;
+  return result;
+}
+
+DcmQueryRetrieveFindCacheArea *DcmQueryRetrieveFindCache::findArea(const OFString& storageArea)
+{
+  OFListIterator(DcmQueryRetrieveFindCacheArea *) area = areas_.begin();
+  while (area != areas_.end())
+  {
+    if ((*area)->storageArea == storageArea) return *area;
+    ++area;
+  }
+  return NULL;
+}
+
+OFBool DcmQueryRetrieveFindCache::synchronize(const OFString& storageArea, unsigned long generation)
+{
+  DcmQueryRetrieveFindCacheArea *area = findArea(storageArea);
+  if (area == NULL)
+  {
+    areas_.push_back(new DcmQueryRetrieveFindCacheArea(storageArea, generation));
+    return OFFalse;
+  }
+  if (area->generation == generation) return OFTrue;
+
+  /* the database has been modified behind our back, forget everything */
+  area->generation = generation;
+  OFListIterator(DcmQueryRetrieveFindCacheEntry *) entry = entries_.begin();
+  while (entry != entries_.end())
+  {
+    if ((*entry)->storageArea == storageArea)
+    {
+      delete *entry;
+      entry = entries_.erase(entry);
+      invalidated_++;
+    }
+    else ++entry;
+  }
+  return OFFalse;
+}
+
+OFBool DcmQueryRetrieveFindCache::lookup(const OFString& storageArea, unsigned long generation,
+  const OFString& key, DcmQueryRetrieveFindCacheResult& result)
+{
+  OFBool found = OFFalse;
+  mutex_.lock();
+  if (maxEntries_ > 0)
+  {
+    synchronize(storageArea, generation);
+    OFListIterator(DcmQueryRetrieveFindCacheEntry *) entry = entries_.begin();
+    while ((entry != entries_.end()) && (((*entry)->storageArea != storageArea) || ((*entry)->key != key))) ++entry;
+    if (entry != entries_.end())
+    {
+      DcmQueryRetrieveFindCacheEntry *hit = *entry;
+      copyResult(hit->result, result);
+      /* move to front */
+      entries_.erase(entry);
+      entries_.push_front(hit);
+      hits_++;
+      found = OFTrue;
+    }
+    else misses_++;
+  }
+  mutex_.unlock();
+  return found;
+}
+
+void DcmQueryRetrieveFindCache::insert(const OFString& storageArea, unsigned long generation,
+  const OFString& key, const OFList<OFString>& restrictions,
+  const DcmQueryRetrieveFindCacheResult& result)
+{
+  mutex_.lock();
+  DcmQueryRetrieveFindCacheArea *area = findArea(storageArea);
+  if ((maxEntries_ > 0) && (result.responses.size() <= maxResponses_) &&
+      (area != NULL) && (area->generation == generation))
+  {
+    /* another thread might have added the same result in the meantime */
+    OFListIterator(DcmQueryRetrieveFindCacheEntry *) entry = entries_.begin();
+    while ((entry != entries_.end()) && (((*entry)->storageArea != storageArea) || ((*entry)->key != key))) ++entry;
+    if (entry == entries_.end())
+    {
+      DcmQueryRetrieveFindCacheEntry *newEntry = new DcmQueryRetrieveFindCacheEntry(storageArea, key, restrictions);
+      copyResult(result, newEntry->result);
+      entries_.push_front(newEntry);
+      while (entries_.size() > maxEntries_)
+      {
+        delete entries_.back();
+        entries_.pop_back();
+      }
+    }
+  }
+  mutex_.unlock();
+}
+
+void DcmQueryRetrieveFindCache::invalidate(const OFString& storageArea, unsigned long oldGeneration,
+  unsigned long newGeneration, const OFList<OFString>& written)
+{
+  mutex_.lock();
+  if (synchronize(storageArea, oldGeneration))
+  {
+    OFListIterator(DcmQueryRetrieveFindCacheEntry *) entry = entries_.begin();
+    while (entry != entries_.end())
+    {
+      OFBool affected = ((*entry)->storageArea == storageArea);
+      OFListConstIterator(OFString) restriction = (*entry)->restrictions.begin();
+      while (affected && (restriction != (*entry)->restrictions.end()))
+      {
+        OFListConstIterator(OFString) uid = written.begin();
+        while ((uid != written.end()) && (*uid != *restriction)) ++uid;
+        affected = (uid != written.end());
+        ++restriction;
+      }
+      if (affected)
+      {
+        delete *entry;
+        entry = entries_.erase(entry);
+        invalidated_++;
+      }
+      else ++entry;
+    }
+  }
+  /* the remaining results are still valid in the new generation */
+  findArea(storageArea)->generation = newGeneration;
+  mutex_.unlock();
+}
+
+void DcmQueryRetrieveFindCache::getStatistics(unsigned long& hits, unsigned long& misses, unsigned long& invalidated)
+{
+  mutex_.lock();
+  hits = hits_;
+  misses = misses_;
+  invalidated = invalidated_;
+  mutex_.unlock();
+}
+
+
+/*
+ * CVS Log
+ * $Log$
+ *
+ */
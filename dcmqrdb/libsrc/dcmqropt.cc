@@ -33,6 +33,7 @@
 
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 #include "dcmtk/dcmqrdb/dcmqropt.h"
+#include "dcmtk/dcmqrdb/dcmqrfcc.h"
 
 #define INCLUDE_CSTDARG
 #include "dcmtk/ofstd/ofstdinc.h"
@@ -47,11 +48,14 @@ DcmQueryRetrieveOptions::DcmQueryRetrieveOptions()
 , debug_(OFFalse)
 , disableGetSupport_(OFFalse)
 , filepad_(0)
+, findCacheEntries_(DEFAULT_FINDCACHE_ENTRIES)
 , groupLength_(EGL_recalcGL)
 , ignoreStoreData_(OFFalse)
 , itempad_(0) 
 , maxAssociations_(20)
 , maxPDU_(ASC_DEFAULTMAXPDU)
+, moveAssociations_(1)
+, movePrefetch_(0)
 , net_(NULL)
 , networkTransferSyntax_(EXS_Unknown)
 #ifndef DISABLE_COMPRESSION_EXTENSION
@@ -71,6 +75,7 @@ DcmQueryRetrieveOptions::DcmQueryRetrieveOptions()
 #else
 , singleProcess_(OFTrue)
 #endif
+, multiThreaded_(OFFalse)
 , supportPatientRoot_(OFTrue)
 #ifdef NO_PATIENTSTUDYONLY_SUPPORT
 , supportPatientStudyOnly_(OFFalse)
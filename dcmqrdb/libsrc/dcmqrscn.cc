@@ -0,0 +1,334 @@
+/*
+ *
+ *  Copyright (C) 1993-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  agent
+ *
+ *  Purpose: class DcmQueryRetrieveStoreScanner
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/dcmqrdb/dcmqrscn.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcsequen.h"
+#include "dcmtk/dcmdata/dcvr.h"
+
+/// types of containers known to the scanner
+enum
+{
+  /// sequence of items
+  SC_Sequence,
+  /// item of a sequence
+  SC_Item,
+  /// encapsulated pixel data, consisting of items that are fragments
+  SC_PixelData
+};
+
+/** helper structure that describes a sequence, item or encapsulated pixel
+ *  data the scanner has entered. Internal use only.
+ */
+struct DcmQueryRetrieveStoreScannerContainer
+{
+  /// type of the container, SC_Sequence, SC_Item or SC_PixelData
+  int type;
+
+  /// true if the container has undefined length and ends with a delimitation item
+  OFBool undefinedLength;
+
+  /// position in the data set where the container ends if it has defined length
+  unsigned long end;
+
+  /// true if the container is the Digital Signatures Sequence
+  OFBool signatures;
+};
+
+
+DcmQueryRetrieveStoreScanner::DcmQueryRetrieveStoreScanner(E_TransferSyntax xfer, const OFList<DcmTagKey>& tags)
+: tags_(tags)
+, foundTags_()
+, foundValues_()
+, explicitVR_(OFTrue)
+, bigEndian_(OFFalse)
+, good_(OFTrue)
+, headerLength_(0)
+, valueRemaining_(0)
+, copyValue_(OFFalse)
+, value_()
+, valueTag_()
+, containers_(new DcmQueryRetrieveStoreScannerContainer[STORESCANNER_MAX_DEPTH])
+, depth_(0)
+, position_(0)
+, signed_(OFFalse)
+{
+  DcmXfer xferSyn(xfer);
+  explicitVR_ = xferSyn.isExplicitVR();
+  bigEndian_ = xferSyn.isBigEndian();
+
+  /* deflated data sets would have to be inflated first */
+  if ((xfer == EXS_Unknown) || (xferSyn.getStreamCompression() != ESC_none)) good_ = OFFalse;
+}
+
+DcmQueryRetrieveStoreScanner::~DcmQueryRetrieveStoreScanner()
+{
+  delete[] containers_;
+}
+
+void DcmQueryRetrieveStoreScanner::storeDataCallback(void *callbackData, const void *data, Uint32 length)
+{
+  if (callbackData) OFstatic_cast(DcmQueryRetrieveStoreScanner *, callbackData)->addFragment(data, length);
+}
+
+OFBool DcmQueryRetrieveStoreScanner::good() const
+{
+  return good_;
+}
+
+OFBool DcmQueryRetrieveStoreScanner::complete() const
+{
+  return good_ && (depth_ == 0) && (headerLength_ == 0) && (valueRemaining_ == 0);
+}
+
+void DcmQueryRetrieveStoreScanner::addFragment(const void *data, Uint32 length)
+{
+  const Uint8 *p = OFstatic_cast(const Uint8 *, data);
+  while (good_ && (length > 0))
+  {
+    if (valueRemaining_ > 0)
+    {
+      /* skip or copy (the next part of) the value of the current element */
+      Uint32 count = (valueRemaining_ < length) ? valueRemaining_ : length;
+      if (copyValue_) value_.append(OFreinterpret_cast(const char *, p), count);
+      p += count;
+      length -= count;
+      position_ += count;
+      valueRemaining_ -= count;
+      if (valueRemaining_ == 0)
+      {
+        if (copyValue_)
+        {
+          foundTags_.push_back(valueTag_);
+          foundValues_.push_back(value_);
+          copyValue_ = OFFalse;
+        }
+        popComplete();
+      }
+    }
+    else
+    {
+      /* element headers are small, collect them byte by byte */
+      header_[headerLength_++] = *p++;
+      length--;
+      position_++;
+      if (parseHeader())
+      {
+        headerLength_ = 0;
+        if (valueRemaining_ == 0) popComplete();
+      }
+    }
+  }
+}
+
+Uint16 DcmQueryRetrieveStoreScanner::getUint16(size_t offset) const
+{
+  if (bigEndian_) return OFstatic_cast(Uint16, (header_[offset] << 8) | header_[offset + 1]);
+  return OFstatic_cast(Uint16, header_[offset] | (header_[offset + 1] << 8));
+}
+
+Uint32 DcmQueryRetrieveStoreScanner::getUint32(size_t offset) const
+{
+  if (bigEndian_) return (OFstatic_cast(Uint32, getUint16(offset)) << 16) | getUint16(offset + 2);
+  return OFstatic_cast(Uint32, getUint16(offset)) | (OFstatic_cast(Uint32, getUint16(offset + 2)) << 16);
+}
+
+OFBool DcmQueryRetrieveStoreScanner::isSelected(const DcmTagKey& tag) const
+{
+  OFListConstIterator(DcmTagKey) first = tags_.begin();
+  OFListConstIterator(DcmTagKey) last = tags_.end();
+  while (first != last)
+  {
+    if (*first == tag) return OFTrue;
+    ++first;
+  }
+  return OFFalse;
+}
+
+void DcmQueryRetrieveStoreScanner::push(int type, Uint32 length, OFBool signatures)
+{
+  if (depth_ == STORESCANNER_MAX_DEPTH)
+  {
+    good_ = OFFalse;
+    return;
+  }
+  DcmQueryRetrieveStoreScannerContainer& container = containers_[depth_++];
+  container.type = type;
+  container.undefinedLength = (length == DCM_UndefinedLength);
+  container.end = position_ + ((container.undefinedLength) ? 0 : length);
+  container.signatures = signatures;
+}
+
+void DcmQueryRetrieveStoreScanner::popComplete()
+{
+  while (good_ && (depth_ > 0) && (! containers_[depth_ - 1].undefinedLength) && (position_ >= containers_[depth_ - 1].end))
+  {
+    /* a value must not exceed the sequence or item it belongs to */
+    if (position_ > containers_[depth_ - 1].end) good_ = OFFalse;
+    else depth_--;
+  }
+}
+
+OFBool DcmQueryRetrieveStoreScanner::parseHeader()
+{
+  /* all headers consist of at least tag and length field */
+  if (headerLength_ < 8) return OFFalse;
+
+  int parent = (depth_ > 0) ? containers_[depth_ - 1].type : SC_Item;
+  Uint16 group = getUint16(0);
+  Uint16 element = getUint16(2);
+  Uint32 length = 0;
+
+  if (group == 0xfffe)
+  {
+    /* items and delimitation items are always encoded with a 32 bit length field */
+    length = getUint32(4);
+    if ((element == 0xe000) && (parent == SC_PixelData) && (length != DCM_UndefinedLength))
+    {
+      /* pixel data fragment */
+      valueRemaining_ = length;
+    }
+    else if ((element == 0xe000) && (parent == SC_Sequence))
+    {
+      if (containers_[depth_ - 1].signatures) signed_ = OFTrue;
+      push(SC_Item, length, OFFalse);
+    }
+    else if ((element == 0xe00d) && (parent == SC_Item) && (depth_ > 0) && containers_[depth_ - 1].undefinedLength)
+    {
+      depth_--;
+    }
+    else if ((element == 0xe0dd) && (parent != SC_Item) && containers_[depth_ - 1].undefinedLength)
+    {
+      depth_--;
+    }
+    else good_ = OFFalse;
+    return OFTrue;
+  }
+
+  /* sequences and encapsulated pixel data may only contain items */
+  if (parent != SC_Item)
+  {
+    good_ = OFFalse;
+    return OFTrue;
+  }
+
+  DcmTagKey tag(group, element);
+  DcmVR vr;
+  if (explicitVR_)
+  {
+    char vrName[3];
+    vrName[0] = OFstatic_cast(char, header_[4]);
+    vrName[1] = OFstatic_cast(char, header_[5]);
+    vrName[2] = '\0';
+    vr.setVR(vrName);
+    if (vr.usesExtendedLengthEncoding())
+    {
+      if (headerLength_ < 12) return OFFalse;
+      length = getUint32(8);
+    }
+    else length = getUint16(6);
+
+    /* undefined length UN elements contain an implicit VR little endian sequence */
+    if ((vr.getEVR() == EVR_UN) && (length == DCM_UndefinedLength))
+    {
+      good_ = OFFalse;
+      return OFTrue;
+    }
+  }
+  else
+  {
+    length = getUint32(4);
+    vr = DcmTag(tag).getVR();
+    /* only sequences and pixel data may have undefined length */
+    if ((length == DCM_UndefinedLength) && (tag != DCM_PixelData)) vr.setVR(EVR_SQ);
+  }
+
+  if (vr.getEVR() == EVR_SQ)
+  {
+    push(SC_Sequence, length, (tag == DCM_DigitalSignaturesSequence));
+    /* a sequence of defined length greater than zero contains at least one item */
+    if ((tag == DCM_DigitalSignaturesSequence) && (length > 0) && (length != DCM_UndefinedLength)) signed_ = OFTrue;
+  }
+  else if (length == DCM_UndefinedLength)
+  {
+    push(SC_PixelData, length, OFFalse);
+  }
+  else
+  {
+    valueRemaining_ = length;
+    if ((depth_ == 0) && vr.isaString() && (length <= STORESCANNER_MAX_VALUE_LENGTH) && isSelected(tag))
+    {
+      valueTag_ = tag;
+      value_.clear();
+      if (length == 0)
+      {
+        foundTags_.push_back(valueTag_);
+        foundValues_.push_back(value_);
+      }
+      else copyValue_ = OFTrue;
+    }
+  }
+  return OFTrue;
+}
+
+DcmDataset *DcmQueryRetrieveStoreScanner::createDataset() const
+{
+  if (! complete()) return NULL;
+
+  DcmDataset *dset = new DcmDataset();
+  OFListConstIterator(DcmTagKey) tag = foundTags_.begin();
+  OFListConstIterator(OFString) value = foundValues_.begin();
+  while (tag != foundTags_.end())
+  {
+    /* the value is converted exactly as if read from file */
+    dset->putAndInsertString(*tag, (*value).c_str());
+    ++tag;
+    ++value;
+  }
+  if (signed_)
+  {
+    DcmSequenceOfItems *seq = new DcmSequenceOfItems(DCM_DigitalSignaturesSequence);
+    seq->insert(new DcmItem());
+    dset->insert(seq, OFTrue);
+  }
+  return dset;
+}
+
+
+/*
+ * CVS Log
+ * $Log$
+ *
+ */
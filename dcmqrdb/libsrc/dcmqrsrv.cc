@@ -35,11 +35,43 @@
 #include "dcmtk/dcmqrdb/dcmqrsrv.h"
 #include "dcmtk/dcmqrdb/dcmqropt.h"
 #include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
 #include "dcmtk/dcmqrdb/dcmqrdba.h"
 #include "dcmtk/dcmqrdb/dcmqrcbf.h"    /* for class DcmQueryRetrieveFindContext */
 #include "dcmtk/dcmqrdb/dcmqrcbm.h"    /* for class DcmQueryRetrieveMoveContext */
 #include "dcmtk/dcmqrdb/dcmqrcbg.h"    /* for class DcmQueryRetrieveGetContext */
 #include "dcmtk/dcmqrdb/dcmqrcbs.h"    /* for class DcmQueryRetrieveStoreContext */
+#include "dcmtk/dcmqrdb/dcmqrscn.h"    /* for class DcmQueryRetrieveStoreScanner */
+
+
+/** worker thread serving associations queued by DcmQueryRetrieveSCP
+ *  in multi-threaded mode. Internal use only.
+ */
+class DcmQueryRetrieveSCPWorker: public OFThread
+{
+public:
+  /** constructor
+   *  @param scp SCP whose queued associations are served
+   */
+  DcmQueryRetrieveSCPWorker(DcmQueryRetrieveSCP& scp)
+  : OFThread()
+  , scp_(scp)
+  {
+  }
+
+protected:
+  /// thread main function
+  virtual void run()
+  {
+#ifdef WITH_THREADS
+    scp_.runWorker();
+#endif
+  }
+
+private:
+  /// SCP whose queued associations are served
+  DcmQueryRetrieveSCP& scp_;
+};
 
 
 static void findCallback(
@@ -116,9 +148,103 @@ DcmQueryRetrieveSCP::DcmQueryRetrieveSCP(
 , dbDebug_(OFFalse)
 , factory_(factory)
 , options_(options)
+#ifdef WITH_THREADS
+, workers_()
+, pendingJobs_()
+, finishedJobs_()
+, nextJobId_(1)
+, jobMutex_()
+, jobSemaphore_(0)
+#endif
+{
+}
+
+
+DcmQueryRetrieveSCP::~DcmQueryRetrieveSCP()
+{
+#ifdef WITH_THREADS
+    /* one terminating job per worker, queued behind all pending associations */
+    OFListIterator(DcmQueryRetrieveSCPWorker *) first = workers_.begin();
+    OFListIterator(DcmQueryRetrieveSCPWorker *) last = workers_.end();
+    while (first != last)
+    {
+        queueAssociation(NULL);
+        ++first;
+    }
+    first = workers_.begin();
+    while (first != last)
+    {
+        (*first)->join();
+        delete (*first);
+        first = workers_.erase(first);
+    }
+#endif
+}
+
+
+#ifdef WITH_THREADS
+
+void DcmQueryRetrieveSCP::startWorkers()
+{
+    while (workers_.size() < OFstatic_cast(size_t, options_.maxAssociations_))
+    {
+        DcmQueryRetrieveSCPWorker *worker = new DcmQueryRetrieveSCPWorker(*this);
+        int result = worker->start();
+        if (result != 0)
+        {
+            OFString err;
+            OFThread::errorstr(err, result);
+            DcmQueryRetrieveOptions::errmsg("Cannot create worker thread: %s", err.c_str());
+            delete worker;
+            break;
+        }
+        workers_.push_back(worker);
+    }
+}
+
+
+void DcmQueryRetrieveSCP::queueAssociation(T_ASC_Association *assoc)
+{
+    WorkerJob job;
+    job.assoc = assoc;
+    job.id = 0;
+
+    jobMutex_.lock();
+    if (assoc)
+    {
+        job.id = nextJobId_++;
+        /* the main thread is the only one accessing the process table */
+        processtable_.addProcessToTable(job.id, assoc);
+    }
+    pendingJobs_.push_back(job);
+    jobMutex_.unlock();
+    jobSemaphore_.post();
+}
+
+
+void DcmQueryRetrieveSCP::runWorker()
 {
+    for (;;)
+    {
+        jobSemaphore_.wait();
+        jobMutex_.lock();
+        WorkerJob job = pendingJobs_.front();
+        pendingJobs_.pop_front();
+        jobMutex_.unlock();
+
+        if (job.assoc == NULL) break;
+
+        handleAssociation(job.assoc, options_.correctUIDPadding_);
+
+        /* the main thread removes the entry from the process table in cleanChildren() */
+        jobMutex_.lock();
+        finishedJobs_.push_back(job.id);
+        jobMutex_.unlock();
+    }
 }
 
+#endif
+
 
 OFCondition DcmQueryRetrieveSCP::dispatch(T_ASC_Association *assoc, OFBool correctUIDPadding)
 {
@@ -427,9 +553,24 @@ OFCondition DcmQueryRetrieveSCP::storeSCP(T_ASC_Association * assoc, T_DIMSE_C_S
     /* we must still retrieve the data set even if some error has occured */
 
     if (options_.bitPreserving_) { /* the bypass option can be set on the command line */
+        /* extract the attributes to be registered while the data set is written to file */
+        DcmQueryRetrieveStoreScanner *scanner = NULL;
+        T_ASC_PresentationContext presentationContext;
+        OFList<DcmTagKey> tags;
+        if (!options_.ignoreStoreData_) dbHandle.getStoreAttributes(tags);
+        if (!tags.empty() && ASC_findAcceptedPresentationContext(assoc->params, presId, &presentationContext).good())
+        {
+            tags.push_back(DCM_SOPClassUID);
+            tags.push_back(DCM_SOPInstanceUID);
+            scanner = new DcmQueryRetrieveStoreScanner(DcmXfer(presentationContext.acceptedTransferSyntax).getXfer(), tags);
+            context.setScanner(scanner);
+        }
         cond = DIMSE_storeProvider(assoc, presId, request, imageFileName, (int)options_.useMetaheader_,
                                    NULL, storeCallback,
-                                   (void*)&context, options_.blockMode_, options_.dimse_timeout_);
+                                   (void*)&context, options_.blockMode_, options_.dimse_timeout_,
+                                   (scanner) ? DcmQueryRetrieveStoreScanner::storeDataCallback : NULL, scanner);
+        context.setScanner(NULL);
+        delete scanner;
     } else {
         cond = DIMSE_storeProvider(assoc, presId, request, (char *)NULL, (int)options_.useMetaheader_,
                                    &dset, storeCallback,
@@ -1044,6 +1185,23 @@ OFCondition DcmQueryRetrieveSCP::waitForAssociation(T_ASC_Network * theNet)
             /* don't spawn a sub-process to handle the association */
             cond = handleAssociation(assoc, options_.correctUIDPadding_);
         }
+#ifdef WITH_THREADS
+        else if (options_.multiThreaded_)
+        {
+            /* hand the association over to a worker thread */
+            startWorkers();
+            if (workers_.size() == 0)
+            {
+                cond = refuseAssociation(&assoc, CTN_CannotFork);
+                go_cleanup = OFTrue;
+            }
+            else
+            {
+                queueAssociation(assoc);
+                assoc = NULL;
+            }
+        }
+#endif
 #ifdef HAVE_FORK
         else
         {
@@ -1074,7 +1232,7 @@ OFCondition DcmQueryRetrieveSCP::waitForAssociation(T_ASC_Network * theNet)
 
     // cleanup code
     OFCondition oldcond = cond;    /* store condition flag for later use */
-    if (!options_.singleProcess_ && (cond != ASC_SHUTDOWNAPPLICATION))
+    if (!options_.singleProcess_ && (cond != ASC_SHUTDOWNAPPLICATION) && (assoc != NULL))
     {
         /* the child will handle the association, we can drop it */
         cond = ASC_dropAssociation(assoc);
@@ -1098,6 +1256,27 @@ OFCondition DcmQueryRetrieveSCP::waitForAssociation(T_ASC_Network * theNet)
 
 void DcmQueryRetrieveSCP::cleanChildren(OFBool verbose)
 {
+#ifdef WITH_THREADS
+  if (options_.multiThreaded_)
+  {
+    /* remove associations completed by the worker threads */
+    jobMutex_.lock();
+    while (finishedJobs_.size() > 0)
+    {
+      int id = finishedJobs_.front();
+      finishedJobs_.pop_front();
+      if (verbose)
+      {
+        time_t t = time(NULL);
+        ofConsole.lockCerr() << "Cleaned up after worker association (" << id << ") " << ctime(&t) << endl;
+        ofConsole.unlockCerr();
+      }
+      processtable_.removeProcessFromTable(id);
+    }
+    jobMutex_.unlock();
+    return;
+  }
+#endif
   processtable_.cleanChildren(verbose);
 }
 
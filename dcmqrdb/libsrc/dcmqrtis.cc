@@ -99,7 +99,8 @@ TI_getInfoFromImage(char *imgFile, DIC_PN patientsName, DIC_CS studyId,
     DIC_IS seriesNumber, DIC_CS modality, DIC_IS imageNumber)
 {
     DcmFileFormat dcmff;
-    if (dcmff.loadFile(imgFile).bad())
+    if (dcmff.loadFile(imgFile, EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+                       ERM_autoDetect, OFFalse, DCM_PixelData).bad())
     {
         DcmQueryRetrieveOptions::errmsg("Help!, cannot open image file: %s", imgFile);
         return;
@@ -0,0 +1,303 @@
+/*
+ *
+ *  Copyright (C) 1993-2005, OFFIS
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    Kuratorium OFFIS e.V.
+ *    Healthcare Information and Communication Systems
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *  THIS SOFTWARE IS MADE AVAILABLE,  AS IS,  AND OFFIS MAKES NO  WARRANTY
+ *  REGARDING  THE  SOFTWARE,  ITS  PERFORMANCE,  ITS  MERCHANTABILITY  OR
+ *  FITNESS FOR ANY PARTICULAR USE, FREEDOM FROM ANY COMPUTER DISEASES  OR
+ *  ITS CONFORMITY TO ANY SPECIFICATION. THE ENTIRE RISK AS TO QUALITY AND
+ *  PERFORMANCE OF THE SOFTWARE IS WITH THE USER.
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  agent
+ *
+ *  Purpose: stress benchmark for the index file database: measures the
+ *           throughput of concurrent store, find and move operations on
+ *           one storage area, each operation running in its own process
+ *           like the associations of dcmqrscp.
+ *
+ *  Usage:   tdbstres storage-area [writers [finders [movers [seconds
+ *             [move-delay-ms [prefill]]]]]]
+ *
+ *  Last Update:      $Author$
+ *  Update Date:      $Date$
+ *  Source File:      $Source$
+ *  CVS/RCS Revision: $Revision$
+ *  Status:           $State$
+ *
+ *  CVS/RCS Log at end of file
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#define INCLUDE_CSTDLIB
+#define INCLUDE_CSTDIO
+#define INCLUDE_CSTRING
+#define INCLUDE_UNISTD
+#include "dcmtk/ofstd/ofstdinc.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+END_EXTERN_C
+
+#include "dcmtk/ofstd/ofconsol.h"
+#include "dcmtk/ofstd/oftimer.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmdata/dcdict.h"
+#include "dcmtk/dcmqrdb/dcmqrdbi.h"
+#include "dcmtk/dcmqrdb/dcmqrdbs.h"
+
+#define STUDIES_PER_WRITER 10
+#define IMAGES_PER_STUDY   20
+
+static const char *storageArea = NULL;
+
+static void bailout(const char *message, int line)
+{
+  CERR << "[" << line << "]: " << message << endl;
+  exit(10);
+}
+
+static void makeUIDs(int writer, int image, char *patientID, char *studyUID, char *seriesUID, char *sopUID)
+{
+  int study = (image / IMAGES_PER_STUDY) % STUDIES_PER_WRITER;
+  sprintf(patientID, "W%dP%d", writer, study % 3);
+  sprintf(studyUID, "%s.9999.%d.%d", SITE_STUDY_UID_ROOT, writer, study);
+  sprintf(seriesUID, "%s.9999.%d.%d", SITE_SERIES_UID_ROOT, writer, study);
+  sprintf(sopUID, "%s.9999.%d.%d", SITE_INSTANCE_UID_ROOT, writer, image);
+}
+
+/* store one image, returns OFTrue if the database accepted it */
+static OFBool storeImage(DcmQueryRetrieveIndexDatabaseHandle& dbHandle, int writer, int image)
+{
+  char patientID[64], studyUID[128], seriesUID[128], sopUID[128], filename[1024];
+  makeUIDs(writer, image, patientID, studyUID, seriesUID, sopUID);
+
+  DcmFileFormat fileformat;
+  DcmDataset *dset = fileformat.getDataset();
+  dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage);
+  dset->putAndInsertString(DCM_SOPInstanceUID, sopUID);
+  dset->putAndInsertString(DCM_StudyInstanceUID, studyUID);
+  dset->putAndInsertString(DCM_SeriesInstanceUID, seriesUID);
+  dset->putAndInsertString(DCM_PatientID, patientID);
+  dset->putAndInsertString(DCM_PatientsName, "Stress^Test");
+  dset->putAndInsertString(DCM_StudyDate, "20060101");
+  dset->putAndInsertString(DCM_Modality, "OT");
+
+  sprintf(filename, "%s%cSTRESS_%d_%d.dcm", storageArea, PATH_SEPARATOR, writer, image);
+  if (fileformat.saveFile(filename, EXS_LittleEndianExplicit).bad()) return OFFalse;
+
+  DcmQueryRetrieveDatabaseStatus status;
+  OFCondition cond = dbHandle.storeRequest(UID_SecondaryCaptureImageStorage, sopUID, filename, &status);
+  return cond.good() && (status.status() == STATUS_Success);
+}
+
+/* study root C-FIND on study level for one patient, returns number of responses */
+static int findStudies(DcmQueryRetrieveIndexDatabaseHandle& dbHandle, const char *patientID)
+{
+  DcmDataset query;
+  query.putAndInsertString(DCM_QueryRetrieveLevel, "STUDY");
+  query.putAndInsertString(DCM_PatientID, patientID);
+  query.putAndInsertString(DCM_StudyInstanceUID, "");
+  query.putAndInsertString(DCM_StudyDate, "");
+
+  DcmQueryRetrieveDatabaseStatus status;
+  int responses = 0;
+  OFCondition cond = dbHandle.startFindRequest(UID_FINDStudyRootQueryRetrieveInformationModel, &query, &status);
+  while (cond.good() && (status.status() == STATUS_Pending))
+  {
+    DcmDataset *response = NULL;
+    cond = dbHandle.nextFindResponse(&response, &status);
+    if (response)
+    {
+      responses++;
+      delete response;
+    }
+  }
+  return responses;
+}
+
+/* study root C-MOVE of one study, waiting delay ms per sub-operation, returns number of sub-operations */
+static int moveStudy(DcmQueryRetrieveIndexDatabaseHandle& dbHandle, const char *studyUID, int delay)
+{
+  DcmDataset query;
+  query.putAndInsertString(DCM_QueryRetrieveLevel, "STUDY");
+  query.putAndInsertString(DCM_StudyInstanceUID, studyUID);
+
+  DcmQueryRetrieveDatabaseStatus status;
+  int subOperations = 0;
+  OFCondition cond = dbHandle.startMoveRequest(UID_MOVEStudyRootQueryRetrieveInformationModel, &query, &status);
+  while (cond.good() && (status.status() == STATUS_Pending))
+  {
+    char sopClass[128], sopInstance[128], filename[1024];
+    unsigned short remaining = 0;
+    cond = dbHandle.nextMoveResponse(sopClass, sopInstance, filename, &remaining, &status);
+    if (cond.good() && (status.status() == STATUS_Pending))
+    {
+      subOperations++;
+      /* simulate the C-STORE sub-operation */
+#ifdef HAVE_USLEEP
+      if (delay > 0) usleep(delay * 1000);
+#else
+      if (delay > 0) OFStandard::sleep((delay + 999) / 1000);
+#endif
+    }
+  }
+  return subOperations;
+}
+
+/* run one benchmark process, write number of operations to fd */
+static void runWorker(char kind, int id, double seconds, int delay, int fd)
+{
+  OFCondition cond;
+  DcmQueryRetrieveIndexDatabaseHandle dbHandle(storageArea, -1, -1, cond);
+  if (cond.bad()) bailout("cannot open database handle", __LINE__);
+  dbHandle.enableQuotaSystem(OFFalse);
+
+  char patientID[64], studyUID[128], seriesUID[128], sopUID[128];
+  long operations = 0;
+  long items = 0;
+  OFTimer timer;
+  srand(OFstatic_cast(unsigned int, id * 7919 + 1));
+  while (timer.getDiff() < seconds)
+  {
+    int writer = rand() % 4;
+    int image = rand() % (STUDIES_PER_WRITER * IMAGES_PER_STUDY);
+    switch (kind)
+    {
+      case 'S':
+        /* writers register new images after the prefilled ones */
+        if (storeImage(dbHandle, 100 + id, OFstatic_cast(int, operations))) items++;
+        break;
+      case 'F':
+        makeUIDs(writer, image, patientID, studyUID, seriesUID, sopUID);
+        items += findStudies(dbHandle, patientID);
+        break;
+      case 'M':
+        makeUIDs(writer, image, patientID, studyUID, seriesUID, sopUID);
+        items += moveStudy(dbHandle, studyUID, delay);
+        break;
+    }
+    operations++;
+  }
+
+  char result[128];
+  sprintf(result, "%c %ld %ld %f\n", kind, operations, items, timer.getDiff());
+  write(fd, result, strlen(result));
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    CERR << "usage: " << argv[0] << " storage-area [writers [finders [movers [seconds [move-delay-ms [prefill]]]]]]" << endl;
+    return 1;
+  }
+  storageArea = argv[1];
+  int writers = (argc > 2) ? atoi(argv[2]) : 2;
+  int finders = (argc > 3) ? atoi(argv[3]) : 2;
+  int movers = (argc > 4) ? atoi(argv[4]) : 2;
+  double seconds = (argc > 5) ? atof(argv[5]) : 10.0;
+  int delay = (argc > 6) ? atoi(argv[6]) : 5;
+  int prefill = (argc > 7) ? atoi(argv[7]) : 4;
+
+  if (!dcmDataDict.isDictionaryLoaded())
+    bailout("no data dictionary loaded, check environment variable: " DCM_DICT_ENVIRONMENT_VARIABLE, __LINE__);
+
+#ifdef HAVE_FORK
+  /* prefill the database with the studies the readers look for */
+  {
+    OFCondition cond;
+    DcmQueryRetrieveIndexDatabaseHandle dbHandle(storageArea, -1, -1, cond);
+    if (cond.bad()) bailout("cannot open database handle", __LINE__);
+    dbHandle.enableQuotaSystem(OFFalse);
+    OFTimer timer;
+    int stored = 0;
+    for (int w = 0; w < prefill; w++)
+      for (int i = 0; i < STUDIES_PER_WRITER * IMAGES_PER_STUDY; i++)
+        if (storeImage(dbHandle, w, i)) stored++;
+    COUT << "prefill: " << stored << " images in " << timer.getDiff() << " s" << endl;
+  }
+
+  int fds[2];
+  if (pipe(fds) < 0) bailout("cannot create pipe", __LINE__);
+
+  int processes = 0;
+  const char kinds[3] = { 'S', 'F', 'M' };
+  const int counts[3] = { writers, finders, movers };
+  for (int k = 0; k < 3; k++)
+  {
+    for (int i = 0; i < counts[k]; i++)
+    {
+      pid_t pid = fork();
+      if (pid < 0) bailout("cannot fork", __LINE__);
+      if (pid == 0)
+      {
+        close(fds[0]);
+        runWorker(kinds[k], processes, seconds, delay, fds[1]);
+        close(fds[1]);
+        exit(0);
+      }
+      processes++;
+    }
+  }
+  close(fds[1]);
+
+  for (int p = 0; p < processes; p++) wait(NULL);
+
+  /* collect and print results */
+  long operations[3] = { 0, 0, 0 };
+  long items[3] = { 0, 0, 0 };
+  double elapsed = 0.0;
+  FILE *results = fdopen(fds[0], "r");
+  char kind;
+  long ops, its;
+  double secs;
+  while (results && (fscanf(results, " %c %ld %ld %lf", &kind, &ops, &its, &secs) == 4))
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      if (kinds[k] == kind)
+      {
+        operations[k] += ops;
+        items[k] += its;
+      }
+    }
+    if (secs > elapsed) elapsed = secs;
+  }
+  if (results) fclose(results);
+  if (elapsed <= 0.0) elapsed = seconds;
+
+  COUT << "processes: " << writers << " store, " << finders << " find, " << movers << " move; "
+       << seconds << " s, move delay " << delay << " ms" << endl;
+  COUT << "store: " << operations[0] << " images, " << operations[0] / elapsed << " per second" << endl;
+  COUT << "find:  " << operations[1] << " queries (" << items[1] << " responses), " << operations[1] / elapsed << " per second" << endl;
+  COUT << "move:  " << operations[2] << " requests (" << items[2] << " sub-operations), " << operations[2] / elapsed << " per second" << endl;
+  return 0;
+#else
+  CERR << "this benchmark requires fork()" << endl;
+  return 1;
+#endif
+}
+
+/*
+ * CVS/RCS Log:
+ * $Log$
+ *
+ */